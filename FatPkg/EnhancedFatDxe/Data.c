@@ -18,6 +18,12 @@ EFI_LOCK  FatFsLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_CALLBACK);
 
 EFI_LOCK  FatTaskLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
 
+//
+// FatCacheStatisticsIndex - Index of the cache statistics variable of the next volume,
+// below FAT_CACHE_STATISTICS_VARIABLES.
+//
+UINTN  FatCacheStatisticsIndex;
+
 //
 // Filesystem interface functions
 //
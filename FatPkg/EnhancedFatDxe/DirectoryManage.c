@@ -1234,6 +1234,7 @@ FatCloseDirEnt (
     RemoveEntryList (&OFile->ChildLink);
   }
 
+  FatFreeExtents (OFile);
   FreePool (OFile);
   DirEnt->OFile = NULL;
   if (DirEnt->Invalid == TRUE) {
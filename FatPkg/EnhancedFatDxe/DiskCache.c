@@ -8,6 +8,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "Fat.h"
 
+STATIC_ASSERT (CacheMaxType == FAT_CACHE_STATISTICS_CACHES, "FatCacheXXXX variables hold the statistics of each cache type");
+
 /**
   Helper function to clear the dirty state of the cache line.
 
@@ -255,6 +257,16 @@ FatFlushDataCacheRange (
   for (PageNo = StartPageNo; PageNo < EndPageNo; PageNo++) {
     GroupNo  = PageNo & GroupMask;
     CacheTag = &DiskCache->CacheTag[GroupNo];
+    if ((IoMode != ReadDisk) && (CacheTag->PageNo == PageNo)) {
+      //
+      // The page being read ahead may predate this write, drop it. The lock
+      // keeps the read ahead from completing while the slot changes hands.
+      //
+      EfiAcquireLock (&FatTaskLock);
+      CacheTag->ReadAheadRequest = NULL;
+      EfiReleaseLock (&FatTaskLock);
+    }
+
     if ((CacheTag->RealSize > 0) && (CacheTag->PageNo == PageNo)) {
       //
       // When reading data from disk directly, if some dirty data
@@ -352,6 +364,46 @@ FatExchangeCachePage (
   return EFI_SUCCESS;
 }
 
+/**
+
+  Write the dirty data cache pages in a range back to the disk, so a
+  non-blocking read of the range from the disk gets the current data.
+
+  @param  Volume                - FAT file system volume.
+  @param  StartPageNo           - First PageNo to be checked in the cache.
+  @param  EndPageNo             - Last PageNo to be checked in the cache.
+
+  @retval EFI_SUCCESS           - The dirty pages were written back.
+  @return Others                - An error occurred when writing a page back.
+
+**/
+STATIC
+EFI_STATUS
+FatWriteBackDataCacheRange (
+  IN FAT_VOLUME  *Volume,
+  IN UINTN       StartPageNo,
+  IN UINTN       EndPageNo
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       PageNo;
+  DISK_CACHE  *DiskCache;
+  CACHE_TAG   *CacheTag;
+
+  DiskCache = &Volume->DiskCache[CacheData];
+  for (PageNo = StartPageNo; PageNo < EndPageNo; PageNo++) {
+    CacheTag = &DiskCache->CacheTag[PageNo & DiskCache->GroupMask];
+    if ((CacheTag->RealSize > 0) && (CacheTag->PageNo == PageNo) && CacheTag->Dirty) {
+      Status = FatExchangeCachePage (Volume, CacheData, WriteDisk, CacheTag, NULL);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
 
   Get one cache page by specified PageNo.
@@ -376,15 +428,39 @@ FatGetCachePage (
 {
   EFI_STATUS  Status;
   UINTN       OldPageNo;
+  DISK_CACHE  *DiskCache;
 
+  //
+  // Take the page over from the read ahead request still loading it, if any.
+  // The request completes at TPL_NOTIFY and skips the pages it no longer owns,
+  // so the slot changes hands under FatTaskLock.
+  //
+  if (CacheTag->ReadAheadRequest != NULL) {
+    EfiAcquireLock (&FatTaskLock);
+    CacheTag->ReadAheadRequest = NULL;
+    EfiReleaseLock (&FatTaskLock);
+  }
+
+  DiskCache = &Volume->DiskCache[CacheDataType];
   OldPageNo = CacheTag->PageNo;
   if ((CacheTag->RealSize > 0) && (OldPageNo == PageNo)) {
     //
     // Cache Hit occurred
     //
+    DiskCache->Statistics.Hits++;
+    if (CacheTag->ReadAhead) {
+      DiskCache->Statistics.ReadAheadHits++;
+      CacheTag->ReadAhead = FALSE;
+    }
+
     return EFI_SUCCESS;
   }
 
+  DiskCache->Statistics.Misses++;
+  if (CacheTag->RealSize > 0) {
+    DiskCache->Statistics.Evictions++;
+  }
+
   //
   // Write dirty cache page back to disk
   //
@@ -398,8 +474,9 @@ FatGetCachePage (
   //
   // Load new data from disk;
   //
-  CacheTag->PageNo = PageNo;
-  Status           = FatExchangeCachePage (Volume, CacheDataType, ReadDisk, CacheTag, NULL);
+  CacheTag->PageNo    = PageNo;
+  CacheTag->ReadAhead = FALSE;
+  Status              = FatExchangeCachePage (Volume, CacheDataType, ReadDisk, CacheTag, NULL);
 
   return Status;
 }
@@ -460,6 +537,262 @@ FatAccessUnalignedCachePage (
   return Status;
 }
 
+/**
+
+  Copy one data page into Buffer if the data cache holds all of it.
+
+  @param  Volume                - FAT file system volume.
+  @param  PageNo                - The number of the data page.
+  @param  Buffer                - Buffer receiving the page.
+
+  @retval TRUE                  - The page was copied from the data cache.
+  @retval FALSE                 - The page is not in the data cache.
+
+**/
+STATIC
+BOOLEAN
+FatReadCachedDataPage (
+  IN  FAT_VOLUME  *Volume,
+  IN  UINTN       PageNo,
+  OUT UINT8       *Buffer
+  )
+{
+  DISK_CACHE  *DiskCache;
+  CACHE_TAG   *CacheTag;
+  UINTN       GroupNo;
+  UINTN       PageSize;
+
+  DiskCache = &Volume->DiskCache[CacheData];
+  GroupNo   = PageNo & DiskCache->GroupMask;
+  CacheTag  = &DiskCache->CacheTag[GroupNo];
+  PageSize  = (UINTN)1 << DiskCache->PageAlignment;
+  if ((CacheTag->RealSize != PageSize) || (CacheTag->PageNo != PageNo)) {
+    return FALSE;
+  }
+
+  CopyMem (Buffer, DiskCache->CacheBase + (GroupNo << DiskCache->PageAlignment), PageSize);
+  DiskCache->Statistics.Hits++;
+  if (CacheTag->ReadAhead) {
+    DiskCache->Statistics.ReadAheadHits++;
+    CacheTag->ReadAhead = FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+
+  The callback function when a read ahead request completes. The pages the
+  request still owns are moved into the data cache.
+
+  @param  Event                 - The event.
+  @param  Context               - The read ahead request.
+
+**/
+STATIC
+VOID
+EFIAPI
+FatOnReadAheadComplete (
+  IN  EFI_EVENT  Event,
+  IN  VOID       *Context
+  )
+{
+  FAT_READ_AHEAD  *ReadAhead;
+  DISK_CACHE      *DiskCache;
+  CACHE_TAG       *CacheTag;
+  UINTN           Index;
+  UINTN           GroupNo;
+  UINTN           PageSize;
+
+  ReadAhead = (FAT_READ_AHEAD *)Context;
+  ASSERT (ReadAhead->Signature == FAT_READ_AHEAD_SIGNATURE);
+
+  if (ReadAhead->Volume != NULL) {
+    DiskCache = &ReadAhead->Volume->DiskCache[CacheData];
+    PageSize  = (UINTN)1 << DiskCache->PageAlignment;
+    RemoveEntryList (&ReadAhead->Link);
+    for (Index = 0; Index < ReadAhead->PageCount; Index++) {
+      GroupNo  = (ReadAhead->PageNo + Index) & DiskCache->GroupMask;
+      CacheTag = &DiskCache->CacheTag[GroupNo];
+      if (CacheTag->ReadAheadRequest != ReadAhead) {
+        continue;
+      }
+
+      CacheTag->ReadAheadRequest = NULL;
+      if (!EFI_ERROR (ReadAhead->DiskIo2Token.TransactionStatus)) {
+        CopyMem (
+          DiskCache->CacheBase + (GroupNo << DiskCache->PageAlignment),
+          ReadAhead->Buffer + (Index << DiskCache->PageAlignment),
+          PageSize
+          );
+        CacheTag->RealSize  = PageSize;
+        CacheTag->ReadAhead = TRUE;
+      }
+    }
+  }
+
+  gBS->CloseEvent (Event);
+  FreePool (ReadAhead);
+}
+
+/**
+
+  Start reading the data pages from PageNo on into the data cache in the
+  background. The pages already cached or being read ahead are skipped, and
+  the read stops at the first dirty page so no cached write is ever lost.
+  Nothing is read ahead while non-blocking writes are in flight, as the read
+  could overtake them and cache the data they replace.
+
+  @param  Volume                - FAT file system volume.
+  @param  PageNo                - The first data page to read ahead.
+
+**/
+STATIC
+VOID
+FatStartReadAhead (
+  IN FAT_VOLUME  *Volume,
+  IN UINTN       PageNo
+  )
+{
+  EFI_STATUS      Status;
+  DISK_CACHE      *DiskCache;
+  CACHE_TAG       *CacheTag;
+  FAT_READ_AHEAD  *ReadAhead;
+  UINTN           GroupMask;
+  UINTN           MaxPageCount;
+  UINTN           PageCount;
+  UINTN           PendingWrites;
+  UINTN           Index;
+  UINT64          EntryPos;
+  UINT8           PageAlignment;
+
+  DiskCache     = &Volume->DiskCache[CacheData];
+  GroupMask     = DiskCache->GroupMask;
+  PageAlignment = DiskCache->PageAlignment;
+  MaxPageCount  = MIN (FAT_READ_AHEAD_MAX_PAGES, (GroupMask + 1) / 4);
+
+  //
+  // Writes are only submitted under the volume lock, which the caller holds,
+  // so none can be added until the read ahead is submitted.
+  //
+  EfiAcquireLock (&FatTaskLock);
+  PendingWrites = DiskCache->PendingWrites;
+  EfiReleaseLock (&FatTaskLock);
+  if (PendingWrites != 0) {
+    return;
+  }
+
+  //
+  // Skip the pages that are cached or being read ahead already
+  //
+  for (Index = 0; Index < MaxPageCount; Index++, PageNo++) {
+    CacheTag = &DiskCache->CacheTag[PageNo & GroupMask];
+    if ((CacheTag->PageNo != PageNo) || ((CacheTag->RealSize == 0) && (CacheTag->ReadAheadRequest == NULL))) {
+      break;
+    }
+  }
+
+  //
+  // Take the next pages whose cache slots are clean and follow each other,
+  // so they are loaded with one disk read
+  //
+  MaxPageCount -= Index;
+  EntryPos      = DiskCache->BaseAddress + LShiftU64 (PageNo, PageAlignment);
+  for (PageCount = 0; PageCount < MaxPageCount; PageCount++) {
+    CacheTag = &DiskCache->CacheTag[(PageNo + PageCount) & GroupMask];
+    if ((PageCount > 0) && (((PageNo + PageCount) & GroupMask) == 0)) {
+      break;
+    }
+
+    if ((CacheTag->RealSize > 0) && (CacheTag->Dirty || (CacheTag->PageNo == PageNo + PageCount))) {
+      break;
+    }
+
+    if ((CacheTag->ReadAheadRequest != NULL) && (CacheTag->PageNo == PageNo + PageCount)) {
+      break;
+    }
+
+    if (EntryPos + LShiftU64 (PageCount + 1, PageAlignment) > DiskCache->LimitAddress) {
+      break;
+    }
+  }
+
+  if (PageCount == 0) {
+    return;
+  }
+
+  ReadAhead = AllocatePool (sizeof (FAT_READ_AHEAD) + (PageCount << PageAlignment));
+  if (ReadAhead == NULL) {
+    return;
+  }
+
+  ReadAhead->Signature = FAT_READ_AHEAD_SIGNATURE;
+  ReadAhead->Volume    = Volume;
+  ReadAhead->PageNo    = PageNo;
+  ReadAhead->PageCount = PageCount;
+  ReadAhead->Buffer    = (UINT8 *)(ReadAhead + 1);
+  Status               = gBS->CreateEvent (
+                                EVT_NOTIFY_SIGNAL,
+                                TPL_NOTIFY,
+                                FatOnReadAheadComplete,
+                                ReadAhead,
+                                &ReadAhead->DiskIo2Token.Event
+                                );
+  if (EFI_ERROR (Status)) {
+    FreePool (ReadAhead);
+    return;
+  }
+
+  //
+  // Reserve the cache slots. The pages they held are clean, so dropping them is free.
+  // A slot may still belong to an older read ahead of another page, which must not
+  // complete between the stores below, so they are made under FatTaskLock.
+  //
+  EfiAcquireLock (&FatTaskLock);
+  for (Index = 0; Index < PageCount; Index++) {
+    CacheTag = &DiskCache->CacheTag[(PageNo + Index) & GroupMask];
+    if (CacheTag->RealSize > 0) {
+      DiskCache->Statistics.Evictions++;
+    }
+
+    CacheTag->PageNo           = PageNo + Index;
+    CacheTag->RealSize         = 0;
+    CacheTag->ReadAhead        = FALSE;
+    CacheTag->ReadAheadRequest = ReadAhead;
+  }
+
+  InsertTailList (&DiskCache->ReadAheadList, &ReadAhead->Link);
+  EfiReleaseLock (&FatTaskLock);
+  DiskCache->Statistics.ReadAheadPages += PageCount;
+
+  //
+  // The request may complete and free itself before ReadDiskEx returns
+  //
+  Status = Volume->DiskIo2->ReadDiskEx (
+                              Volume->DiskIo2,
+                              Volume->MediaId,
+                              EntryPos,
+                              &ReadAhead->DiskIo2Token,
+                              PageCount << PageAlignment,
+                              ReadAhead->Buffer
+                              );
+  if (EFI_ERROR (Status)) {
+    DiskCache->Statistics.ReadAheadPages -= PageCount;
+    EfiAcquireLock (&FatTaskLock);
+    for (Index = 0; Index < PageCount; Index++) {
+      CacheTag = &DiskCache->CacheTag[(PageNo + Index) & GroupMask];
+      if (CacheTag->ReadAheadRequest == ReadAhead) {
+        CacheTag->ReadAheadRequest = NULL;
+      }
+    }
+
+    RemoveEntryList (&ReadAhead->Link);
+    EfiReleaseLock (&FatTaskLock);
+    gBS->CloseEvent (ReadAhead->DiskIo2Token.Event);
+    FreePool (ReadAhead);
+  }
+}
+
 /**
 
   Read BufferSize bytes from the position of Offset into Buffer,
@@ -474,7 +807,10 @@ FatAccessUnalignedCachePage (
   2. Access of Data cache (CACHE_DATA):
      The access data will be divided into UnderRun data, Aligned data and OverRun data;
      The UnderRun data and OverRun data will be accessed by the Data cache,
-     but the Aligned data will be accessed with disk directly.
+     but the Aligned data will be accessed with disk directly, except for the leading
+     pages of a read that are in the Data cache already.
+     Once several reads in a row are sequential, the following pages are read ahead
+     into the Data cache in the background.
 
   @param  Volume                - FAT file system volume.
   @param  CacheDataType         - The type of cache: CACHE_DATA or CACHE_FAT.
@@ -511,11 +847,13 @@ FatAccessCache (
   UINTN       OverRunPageNo;
   DISK_CACHE  *DiskCache;
   UINT64      EntryPos;
+  UINT64      EndOffset;
   UINT8       PageAlignment;
 
   ASSERT (Volume->CacheBuffer != NULL);
 
   Status        = EFI_SUCCESS;
+  EndOffset     = Offset + BufferSize;
   DiskCache     = &Volume->DiskCache[CacheDataType];
   EntryPos      = Offset - DiskCache->BaseAddress;
   PageAlignment = DiskCache->PageAlignment;
@@ -544,26 +882,58 @@ FatAccessCache (
   //
   // The access of the Aligned data
   //
-  if (AlignedPageCount > 0) {
+  if ((AlignedPageCount > 0) && (CacheDataType == CacheFat)) {
     //
-    // Accessing fat table cannot have alignment data
+    // Accessing fat table always goes through the fat cache, one page at a time
     //
-    ASSERT (CacheDataType == CacheData);
+    for ( ; PageNo < OverRunPageNo; PageNo++) {
+      Status = FatAccessUnalignedCachePage (Volume, CacheDataType, IoMode, PageNo, 0, PageSize, Buffer);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
 
-    EntryPos    = Volume->RootPos + LShiftU64 (PageNo, PageAlignment);
-    AlignedSize = AlignedPageCount << PageAlignment;
-    Status      = FatDiskIo (Volume, IoMode, EntryPos, AlignedSize, Buffer, Task);
-    if (EFI_ERROR (Status)) {
-      return Status;
+      Buffer     += PageSize;
+      BufferSize -= PageSize;
     }
-
+  } else if (AlignedPageCount > 0) {
     //
-    // If these access data over laps the relative cache range, these cache pages need
-    // to be updated.
+    // Take the leading pages that are cached already, typically by read ahead,
+    // from the data cache
     //
-    FatFlushDataCacheRange (Volume, IoMode, PageNo, OverRunPageNo, Buffer);
-    Buffer     += AlignedSize;
-    BufferSize -= AlignedSize;
+    while ((IoMode == ReadDisk) && (PageNo < OverRunPageNo) && FatReadCachedDataPage (Volume, PageNo, Buffer)) {
+      Buffer     += PageSize;
+      BufferSize -= PageSize;
+      PageNo++;
+    }
+
+    AlignedPageCount = OverRunPageNo - PageNo;
+    if ((AlignedPageCount > 0) && (Task != NULL) && (IoMode == ReadDisk)) {
+      //
+      // A non-blocking read fills Buffer after the dirty cache pages would be
+      // copied over it below, so write them back to the disk first instead
+      //
+      Status = FatWriteBackDataCacheRange (Volume, PageNo, OverRunPageNo);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+    }
+
+    if (AlignedPageCount > 0) {
+      EntryPos    = Volume->RootPos + LShiftU64 (PageNo, PageAlignment);
+      AlignedSize = AlignedPageCount << PageAlignment;
+      Status      = FatDiskIo (Volume, IoMode, EntryPos, AlignedSize, Buffer, Task);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+
+      //
+      // If these access data over laps the relative cache range, these cache pages need
+      // to be updated.
+      //
+      FatFlushDataCacheRange (Volume, IoMode, PageNo, OverRunPageNo, Buffer);
+      Buffer     += AlignedSize;
+      BufferSize -= AlignedSize;
+    }
   }
 
   //
@@ -575,9 +945,28 @@ FatAccessCache (
     // Last read is not a complete page
     //
     Status = FatAccessUnalignedCachePage (Volume, CacheDataType, IoMode, OverRunPageNo, 0, OverRun, Buffer);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
   }
 
-  return Status;
+  //
+  // Read ahead once the data is read sequentially
+  //
+  if ((CacheDataType == CacheData) && (IoMode == ReadDisk) && (Volume->DiskIo2 != NULL)) {
+    if (Offset == DiskCache->SequentialEnd) {
+      DiskCache->SequentialCount++;
+    } else {
+      DiskCache->SequentialCount = 0;
+    }
+
+    DiskCache->SequentialEnd = EndOffset;
+    if (DiskCache->SequentialCount >= FAT_READ_AHEAD_THRESHOLD) {
+      FatStartReadAhead (Volume, (UINTN)RShiftU64 (EndOffset - DiskCache->BaseAddress, PageAlignment));
+    }
+  }
+
+  return EFI_SUCCESS;
 }
 
 /**
@@ -635,6 +1024,76 @@ FatVolumeFlushCache (
   return Status;
 }
 
+/**
+
+  Compute the number of data cache pages from the free memory, so the data
+  cache takes no more than 1 / (1 << FAT_DATACACHE_MEMORY_SHIFT) of it.
+
+  @param  PageAlignment         - The alignment of the data cache pages.
+
+  @return The number of data cache pages, a power of two between
+          FAT_DATACACHE_GROUP_COUNT and FAT_DATACACHE_GROUP_MAX_COUNT.
+
+**/
+STATIC
+UINTN
+FatGetDataCacheGroupCount (
+  IN UINT8  PageAlignment
+  )
+{
+  EFI_STATUS             Status;
+  EFI_MEMORY_DESCRIPTOR  *MemoryMap;
+  EFI_MEMORY_DESCRIPTOR  *Entry;
+  UINTN                  MemoryMapSize;
+  UINTN                  MapKey;
+  UINTN                  DescriptorSize;
+  UINT32                 DescriptorVersion;
+  UINT64                 FreePages;
+  UINT64                 CacheSize;
+  UINTN                  GroupCount;
+
+  MemoryMapSize = 0;
+  Status        = gBS->GetMemoryMap (&MemoryMapSize, NULL, &MapKey, &DescriptorSize, &DescriptorVersion);
+  if (Status != EFI_BUFFER_TOO_SMALL) {
+    return FAT_DATACACHE_GROUP_COUNT;
+  }
+
+  //
+  // Leave room for the descriptors the allocation of the map may add
+  //
+  MemoryMapSize += 2 * DescriptorSize;
+  MemoryMap      = AllocatePool (MemoryMapSize);
+  if (MemoryMap == NULL) {
+    return FAT_DATACACHE_GROUP_COUNT;
+  }
+
+  Status = gBS->GetMemoryMap (&MemoryMapSize, MemoryMap, &MapKey, &DescriptorSize, &DescriptorVersion);
+  if (EFI_ERROR (Status)) {
+    FreePool (MemoryMap);
+    return FAT_DATACACHE_GROUP_COUNT;
+  }
+
+  FreePages = 0;
+  for (Entry = MemoryMap;
+       (UINTN)Entry < (UINTN)MemoryMap + MemoryMapSize;
+       Entry = NEXT_MEMORY_DESCRIPTOR (Entry, DescriptorSize))
+  {
+    if (Entry->Type == EfiConventionalMemory) {
+      FreePages += Entry->NumberOfPages;
+    }
+  }
+
+  FreePool (MemoryMap);
+
+  CacheSize  = RShiftU64 (LShiftU64 (FreePages, EFI_PAGE_SHIFT), FAT_DATACACHE_MEMORY_SHIFT);
+  GroupCount = FAT_DATACACHE_GROUP_COUNT;
+  while ((GroupCount < FAT_DATACACHE_GROUP_MAX_COUNT) && (LShiftU64 (GroupCount * 2, PageAlignment) <= CacheSize)) {
+    GroupCount *= 2;
+  }
+
+  return GroupCount;
+}
+
 /**
 
   Initialize the disk cache according to Volume's FatType.
@@ -652,6 +1111,7 @@ FatInitializeDiskCache (
 {
   DISK_CACHE  *DiskCache;
   UINTN       FatCacheGroupCount;
+  UINTN       DataCacheGroupCount;
   UINTN       DataCacheSize;
   UINTN       FatCacheSize;
   UINT8       *CacheBuffer;
@@ -662,36 +1122,149 @@ FatInitializeDiskCache (
   //
   if (Volume->FatType == Fat12) {
     FatCacheGroupCount                 = FAT_FATCACHE_GROUP_MIN_COUNT;
+    DataCacheGroupCount                = FAT_DATACACHE_GROUP_COUNT;
     DiskCache[CacheFat].PageAlignment  = FAT_FATCACHE_PAGE_MIN_ALIGNMENT;
     DiskCache[CacheData].PageAlignment = FAT_DATACACHE_PAGE_MIN_ALIGNMENT;
   } else {
     FatCacheGroupCount                 = FAT_FATCACHE_GROUP_MAX_COUNT;
+    DataCacheGroupCount                = FatGetDataCacheGroupCount (FAT_DATACACHE_PAGE_MAX_ALIGNMENT);
     DiskCache[CacheFat].PageAlignment  = FAT_FATCACHE_PAGE_MAX_ALIGNMENT;
     DiskCache[CacheData].PageAlignment = FAT_DATACACHE_PAGE_MAX_ALIGNMENT;
   }
 
-  DiskCache[CacheData].GroupMask    = FAT_DATACACHE_GROUP_COUNT - 1;
-  DiskCache[CacheData].BaseAddress  = Volume->RootPos;
-  DiskCache[CacheData].LimitAddress = Volume->VolumeSize;
-  DiskCache[CacheFat].GroupMask     = FatCacheGroupCount - 1;
-  DiskCache[CacheFat].BaseAddress   = Volume->FatPos;
-  DiskCache[CacheFat].LimitAddress  = Volume->FatPos + Volume->FatSize;
-  FatCacheSize                      = FatCacheGroupCount << DiskCache[CacheFat].PageAlignment;
-  DataCacheSize                     = FAT_DATACACHE_GROUP_COUNT << DiskCache[CacheData].PageAlignment;
+  FatCacheSize = FatCacheGroupCount << DiskCache[CacheFat].PageAlignment;
   //
-  // Allocate the Fat Cache buffer
+  // Allocate the Fat Cache buffer, shrinking the data cache if the memory is short
   //
-  CacheBuffer = AllocateZeroPool (FatCacheSize + DataCacheSize);
+  for ( ; ; DataCacheGroupCount /= 2) {
+    DataCacheSize = DataCacheGroupCount << DiskCache[CacheData].PageAlignment;
+    CacheBuffer   = AllocateZeroPool (FatCacheSize + DataCacheSize);
+    if ((CacheBuffer != NULL) || (DataCacheGroupCount == FAT_DATACACHE_GROUP_COUNT)) {
+      break;
+    }
+  }
+
   if (CacheBuffer == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
 
+  DiskCache[CacheData].GroupMask    = DataCacheGroupCount - 1;
+  DiskCache[CacheData].BaseAddress  = Volume->RootPos;
+  DiskCache[CacheData].LimitAddress = Volume->VolumeSize;
+  DiskCache[CacheFat].GroupMask     = FatCacheGroupCount - 1;
+  DiskCache[CacheFat].BaseAddress   = Volume->FatPos;
+  DiskCache[CacheFat].LimitAddress  = Volume->FatPos + Volume->FatSize;
+
   Volume->CacheBuffer            = CacheBuffer;
   DiskCache[CacheFat].CacheBase  = CacheBuffer;
   DiskCache[CacheData].CacheBase = CacheBuffer + FatCacheSize;
 
+  DiskCache[CacheFat].CacheTag  = AllocateZeroPool (FatCacheGroupCount * sizeof (CACHE_TAG));
+  DiskCache[CacheData].CacheTag = AllocateZeroPool (DataCacheGroupCount * sizeof (CACHE_TAG));
+  if ((DiskCache[CacheFat].CacheTag == NULL) || (DiskCache[CacheData].CacheTag == NULL)) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  DEBUG ((DEBUG_INFO, "FatInitializeDiskCache: %d data cache pages\n", (UINT32)DataCacheGroupCount));
+
   DiskCache[CacheFat].BlockSize  = Volume->BlockIo->Media->BlockSize;
   DiskCache[CacheData].BlockSize = Volume->BlockIo->Media->BlockSize;
 
   return EFI_SUCCESS;
 }
+
+/**
+
+  Free the disk cache of the volume. Read ahead requests still in flight are
+  detached from the volume and free themselves when they complete.
+
+  @param  Volume                - FAT file system volume.
+
+**/
+VOID
+FatFreeDiskCache (
+  IN FAT_VOLUME  *Volume
+  )
+{
+  DISK_CACHE       *DiskCache;
+  FAT_READ_AHEAD   *ReadAhead;
+  CACHE_DATA_TYPE  CacheDataType;
+
+  FatPublishStatistics (Volume);
+
+  DiskCache = &Volume->DiskCache[CacheData];
+  EfiAcquireLock (&FatTaskLock);
+  while (!IsListEmpty (&DiskCache->ReadAheadList)) {
+    ReadAhead = READ_AHEAD_FROM_LINK (DiskCache->ReadAheadList.ForwardLink);
+    RemoveEntryList (&ReadAhead->Link);
+    ReadAhead->Volume = NULL;
+  }
+
+  EfiReleaseLock (&FatTaskLock);
+
+  for (CacheDataType = (CACHE_DATA_TYPE)0; CacheDataType < CacheMaxType; CacheDataType++) {
+    if (Volume->DiskCache[CacheDataType].CacheTag != NULL) {
+      FreePool (Volume->DiskCache[CacheDataType].CacheTag);
+    }
+  }
+
+  if (Volume->CacheBuffer != NULL) {
+    FreePool (Volume->CacheBuffer);
+  }
+}
+
+/**
+
+  Publish the disk cache and free space statistics of the volume in its
+  volatile FatCacheXXXX and FatSpaceXXXX variables, if they changed since they
+  were last published. Called when the volume is flushed, when its last file
+  handle is closed and when it is freed, not from the file read and write
+  paths: SetVariable() may be an SMI.
+
+  @param  Volume                - FAT file system volume.
+
+**/
+VOID
+FatPublishStatistics (
+  IN FAT_VOLUME  *Volume
+  )
+{
+  EFI_STATUS            Status;
+  FAT_CACHE_STATISTICS  Statistics[CacheMaxType];
+  CHAR16                VariableName[sizeof ("FatCacheXXXX")];
+  CACHE_DATA_TYPE       CacheDataType;
+
+  for (CacheDataType = (CACHE_DATA_TYPE)0; CacheDataType < CacheMaxType; CacheDataType++) {
+    Statistics[CacheDataType] = Volume->DiskCache[CacheDataType].Statistics;
+  }
+
+  if (CompareMem (Statistics, Volume->PublishedStatistics, sizeof (Statistics)) != 0) {
+    UnicodeSPrint (VariableName, sizeof (VariableName), L"FatCache%04X", (UINT32)(Volume->StatisticsIndex & 0xFFFF));
+
+    Status = gRT->SetVariable (
+                    VariableName,
+                    &gFatCacheStatisticsGuid,
+                    EFI_VARIABLE_BOOTSERVICE_ACCESS,
+                    sizeof (Statistics),
+                    Statistics
+                    );
+    if (!EFI_ERROR (Status)) {
+      CopyMem (Volume->PublishedStatistics, Statistics, sizeof (Statistics));
+    }
+  }
+
+  if (CompareMem (&Volume->SpaceStatistics, &Volume->PublishedSpaceStatistics, sizeof (FAT_FREE_SPACE_STATISTICS)) != 0) {
+    UnicodeSPrint (VariableName, sizeof (VariableName), L"FatSpace%04X", (UINT32)(Volume->StatisticsIndex & 0xFFFF));
+
+    Status = gRT->SetVariable (
+                    VariableName,
+                    &gFatCacheStatisticsGuid,
+                    EFI_VARIABLE_BOOTSERVICE_ACCESS,
+                    sizeof (FAT_FREE_SPACE_STATISTICS),
+                    &Volume->SpaceStatistics
+                    );
+    if (!EFI_ERROR (Status)) {
+      CopyMem (&Volume->PublishedSpaceStatistics, &Volume->SpaceStatistics, sizeof (FAT_FREE_SPACE_STATISTICS));
+    }
+  }
+}
@@ -14,6 +14,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Guid/FileInfo.h>
 #include <Guid/FileSystemInfo.h>
 #include <Guid/FileSystemVolumeLabelInfo.h>
+#include <Guid/FatCacheStatistics.h>
 #include <Protocol/BlockIo.h>
 #include <Protocol/DiskIo.h>
 #include <Protocol/DiskIo2.h>
@@ -25,6 +26,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/UefiLib.h>
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
+#include <Library/PrintLib.h>
+#include <Library/TimerLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiDriverEntryPoint.h>
 #include <Library/UefiBootServicesTableLib.h>
@@ -35,13 +38,14 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 //
 // The FAT signature
 //
-#define FAT_VOLUME_SIGNATURE   SIGNATURE_32 ('f', 'a', 't', 'v')
-#define FAT_IFILE_SIGNATURE    SIGNATURE_32 ('f', 'a', 't', 'i')
-#define FAT_ODIR_SIGNATURE     SIGNATURE_32 ('f', 'a', 't', 'd')
-#define FAT_DIRENT_SIGNATURE   SIGNATURE_32 ('f', 'a', 't', 'e')
-#define FAT_OFILE_SIGNATURE    SIGNATURE_32 ('f', 'a', 't', 'o')
-#define FAT_TASK_SIGNATURE     SIGNATURE_32 ('f', 'a', 't', 'T')
-#define FAT_SUBTASK_SIGNATURE  SIGNATURE_32 ('f', 'a', 't', 'S')
+#define FAT_VOLUME_SIGNATURE      SIGNATURE_32 ('f', 'a', 't', 'v')
+#define FAT_IFILE_SIGNATURE       SIGNATURE_32 ('f', 'a', 't', 'i')
+#define FAT_ODIR_SIGNATURE        SIGNATURE_32 ('f', 'a', 't', 'd')
+#define FAT_DIRENT_SIGNATURE      SIGNATURE_32 ('f', 'a', 't', 'e')
+#define FAT_OFILE_SIGNATURE       SIGNATURE_32 ('f', 'a', 't', 'o')
+#define FAT_TASK_SIGNATURE        SIGNATURE_32 ('f', 'a', 't', 'T')
+#define FAT_SUBTASK_SIGNATURE     SIGNATURE_32 ('f', 'a', 't', 'S')
+#define FAT_READ_AHEAD_SIGNATURE  SIGNATURE_32 ('f', 'a', 't', 'R')
 
 #define ASSERT_VOLUME_LOCKED(a)  ASSERT_LOCKED (&FatFsLock)
 
@@ -59,6 +63,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #define OFILE_FROM_CHILDLINK(a)  CR (a, FAT_OFILE, ChildLink, FAT_OFILE_SIGNATURE)
 
+#define READ_AHEAD_FROM_LINK(a)  CR (a, FAT_READ_AHEAD, Link, FAT_READ_AHEAD_SIGNATURE)
+
 //
 // Minimum sector size is 512B, Maximum sector size is 4096B
 // Max sectors per cluster is 128
@@ -84,6 +90,30 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define FAT_FATCACHE_GROUP_MIN_COUNT      1
 #define FAT_FATCACHE_GROUP_MAX_COUNT      16
 
+//
+// The data cache grows from FAT_DATACACHE_GROUP_COUNT up to
+// FAT_DATACACHE_GROUP_MAX_COUNT pages, using no more than
+// 1 / (1 << FAT_DATACACHE_MEMORY_SHIFT) of the free memory
+//
+#define FAT_DATACACHE_GROUP_MAX_COUNT  1024
+#define FAT_DATACACHE_MEMORY_SHIFT     8
+
+//
+// Data pages are read ahead once FAT_READ_AHEAD_THRESHOLD reads in a row
+// were sequential, at most FAT_READ_AHEAD_MAX_PAGES pages at a time
+//
+#define FAT_READ_AHEAD_THRESHOLD  2
+#define FAT_READ_AHEAD_MAX_PAGES  16
+
+//
+// The disk cache and free space statistics of the volumes are published in
+// the volatile variables FatCache0000 to FatCache000F and FatSpace0000 to
+// FatSpace000F, reused round robin. They are
+// only published when the volume is flushed, when its last file handle is
+// closed, and when it is freed.
+//
+#define FAT_CACHE_STATISTICS_VARIABLES  16
+
 // For cache block bits, use a UINT64
 typedef UINT64 DIRTY_BLOCKS;
 #define BITS_PER_BYTE         8
@@ -95,6 +125,13 @@ typedef UINT64 DIRTY_BLOCKS;
 // Number of DIRTY_BLOCKS to hold DIRTY_BITS bits.
 #define DIRTY_BLOCKS_SIZE  (DIRTY_BITS / sizeof (DIRTY_BLOCKS))
 
+//
+// Free cluster bitmap operations
+//
+#define FAT_FREE_BITMAP_SET(Bitmap, Index)    ((Bitmap)[(Index) >> 3] |= (UINT8)(1 << ((Index) & 7)))
+#define FAT_FREE_BITMAP_CLEAR(Bitmap, Index)  ((Bitmap)[(Index) >> 3] &= (UINT8)~(1 << ((Index) & 7)))
+#define FAT_FREE_BITMAP_TEST(Bitmap, Index)   (((Bitmap)[(Index) >> 3] & (1 << ((Index) & 7))) != 0)
+
 STATIC_ASSERT ((((1 << FAT_DATACACHE_PAGE_MAX_ALIGNMENT) / (1 << MIN_BLOCK_ALIGNMENT)) % sizeof (DIRTY_BLOCKS)) == 0, "DIRTY_BLOCKS not a proper size");
 
 //
@@ -159,18 +196,28 @@ typedef struct {
   UINTN           PageNo;
   UINTN           RealSize;
   BOOLEAN         Dirty;
+  BOOLEAN         ReadAhead;            // Loaded by read ahead and not accessed yet
+  VOID            *ReadAheadRequest;    // The read ahead request still loading this page
   DIRTY_BLOCKS    DirtyBlocks[DIRTY_BLOCKS_SIZE];
 } CACHE_TAG;
 
 typedef struct {
-  UINT64       BaseAddress;
-  UINT64       LimitAddress;
-  UINT8        *CacheBase;
-  UINT32       BlockSize;
-  BOOLEAN      Dirty;
-  UINT8        PageAlignment;
-  UINTN        GroupMask;
-  CACHE_TAG    CacheTag[FAT_DATACACHE_GROUP_COUNT];
+  UINT64                  BaseAddress;
+  UINT64                  LimitAddress;
+  UINT8                   *CacheBase;
+  UINT32                  BlockSize;
+  BOOLEAN                 Dirty;
+  UINT8                   PageAlignment;
+  UINTN                   GroupMask;
+  CACHE_TAG               *CacheTag;
+  //
+  // Sequential read detection and read ahead, data cache only
+  //
+  UINT64                  SequentialEnd;    // Disk offset right after the last read
+  UINTN                   SequentialCount;  // Number of sequential reads in a row
+  LIST_ENTRY              ReadAheadList;    // Read ahead requests in flight
+  UINTN                   PendingWrites;    // Non-blocking writes in flight, protected by FatTaskLock
+  FAT_CACHE_STATISTICS    Statistics;
 } DISK_CACHE;
 
 //
@@ -224,15 +271,27 @@ typedef struct {
   LIST_ENTRY           Link;                  // Link to other IFiles
 } FAT_IFILE;
 
+typedef struct _FAT_SUBTASK FAT_SUBTASK;
+
+//
+// A non-blocking request. Its subtasks are submitted to DiskIo2 while the
+// request is being mapped, and the token is signaled once the task is queued
+// and all of them completed. If the request fails after a subtask was
+// submitted, it still returns EFI_SUCCESS and the token is signaled with the
+// error once no subtask accesses the caller's buffer any more.
+//
 typedef struct {
   UINTN                Signature;
   EFI_FILE_IO_TOKEN    *FileIoToken;
   FAT_IFILE            *IFile;
   LIST_ENTRY           Subtasks;              // List of all FAT_SUBTASKs
   LIST_ENTRY           Link;                  // Link to other FAT_TASKs
+  FAT_SUBTASK          *PendingSubtask;       // The last subtask, held back so contiguous accesses merge into it
+  BOOLEAN              Queued;                // All the subtasks were created
+  EFI_STATUS           Status;                // The first error of the subtasks
 } FAT_TASK;
 
-typedef struct {
+struct _FAT_SUBTASK {
   UINTN                 Signature;
   EFI_DISK_IO2_TOKEN    DiskIo2Token;
   FAT_TASK              *Task;
@@ -241,7 +300,18 @@ typedef struct {
   VOID                  *Buffer;
   UINTN                 BufferSize;
   LIST_ENTRY            Link;
-} FAT_SUBTASK;
+};
+
+//
+// A run of contiguous clusters of a file
+//
+typedef struct {
+  UINTN    FileCluster;           // Index of the first cluster of the run within the file
+  UINTN    Cluster;               // First cluster of the run on the disk
+  UINTN    Length;                // Number of clusters in the run
+} FAT_EXTENT;
+
+#define FAT_EXTENT_INITIAL_COUNT  8
 
 //
 // FAT_OFILE - Each opened file
@@ -286,6 +356,15 @@ struct _FAT_OFILE {
   UINT64        PosDisk;        // on the disk
   UINTN         PosRem;         // remaining in this disk run
   //
+  // The cluster runs of the file, in file order. Only the first
+  // ExtentClusters clusters of the file are mapped, the rest of
+  // the cluster chain is mapped as it is accessed
+  //
+  FAT_EXTENT    *Extents;
+  UINTN         ExtentCount;
+  UINTN         ExtentMaxCount;
+  UINTN         ExtentClusters;
+  //
   // The opened parent, full path length and currently opened child files
   //
   FAT_OFILE     *Parent;
@@ -350,6 +429,15 @@ struct _FAT_VOLUME {
   UINTN                              FreeInfoPos;    // Pos with the free cluster info
   BOOLEAN                            FreeInfoValid;  // If free cluster info is valid
   //
+  // Free cluster bitmap, built lazily from the FAT a FAT cache page at a time
+  //
+  UINT8                              *FreeBitmap;     // One bit per cluster, set if the cluster is free
+  UINTN                              FreeBitmapLimit; // Clusters below this index are in the bitmap
+  //
+  // Free space statistics
+  //
+  FAT_FREE_SPACE_STATISTICS          SpaceStatistics;
+  //
   // Unpacked Fat BPB info
   //
   UINTN                              NumFats;
@@ -389,8 +477,32 @@ struct _FAT_VOLUME {
   //
   VOID                               *CacheBuffer;
   DISK_CACHE                         DiskCache[CacheMaxType];
+  //
+  // The disk cache and free space statistics are published in volatile
+  // variables named FatCacheXXXX and FatSpaceXXXX, XXXX being
+  // StatisticsIndex in hex
+  //
+  UINTN                              StatisticsIndex;
+  FAT_CACHE_STATISTICS               PublishedStatistics[CacheMaxType];
+  FAT_FREE_SPACE_STATISTICS          PublishedSpaceStatistics;
 };
 
+//
+// One read ahead request of consecutive data cache pages
+//
+typedef struct {
+  UINTN                 Signature;
+  LIST_ENTRY            Link;
+  EFI_DISK_IO2_TOKEN    DiskIo2Token;
+  //
+  // NULL once the volume is freed before the request completes
+  //
+  FAT_VOLUME            *Volume;
+  UINTN                 PageNo;
+  UINTN                 PageCount;
+  UINT8                 *Buffer;
+} FAT_READ_AHEAD;
+
 //
 // Function Prototypes
 //
@@ -783,6 +895,35 @@ FatVolumeFlushCache (
   IN FAT_TASK    *Task
   );
 
+/**
+
+  Free the disk cache of the volume. Read ahead requests still in flight are
+  detached from the volume and free themselves when they complete.
+
+  @param  Volume                - FAT file system volume.
+
+**/
+VOID
+FatFreeDiskCache (
+  IN FAT_VOLUME  *Volume
+  );
+
+/**
+
+  Publish the disk cache and free space statistics of the volume in its
+  volatile FatCacheXXXX and FatSpaceXXXX variables, if they changed since they
+  were last published. Called when the volume is flushed, when its last file
+  handle is closed and when it is freed, not from the file read and write
+  paths: SetVariable() may be an SMI.
+
+  @param  Volume                - FAT file system volume.
+
+**/
+VOID
+FatPublishStatistics (
+  IN FAT_VOLUME  *Volume
+  );
+
 //
 // Flush.c
 //
@@ -975,6 +1116,18 @@ FatComputeFreeInfo (
   IN FAT_VOLUME  *Volume
   );
 
+/**
+
+  Free the cluster runs cached for the open file.
+
+  @param  OFile                 - The open file.
+
+**/
+VOID
+FatFreeExtents (
+  IN FAT_OFILE  *OFile
+  );
+
 //
 // Init.c
 //
@@ -1055,14 +1208,25 @@ FatCreateTask (
 
 /**
 
-  Destroy the task.
+  Abort a task after an error, before it was queued.
+
+  If none of its subtasks was submitted, the task is freed and the error is
+  returned to the caller without signaling the token. Otherwise the disk may
+  still be accessing the caller's buffer: the submitted subtasks cannot be
+  canceled, so the token is kept and signaled with the error once the last
+  of them completes, and the request reports EFI_SUCCESS.
+
+  @param  Task                  - The task to be aborted.
+  @param  Status                - The error that stopped the task.
 
-  @param  Task                  - The task to be destroyed.
+  @retval EFI_SUCCESS           - The token will be signaled with Status.
+  @return Status                - The task was freed, the token is not signaled.
 
 **/
-VOID
-FatDestroyTask (
-  FAT_TASK  *Task
+EFI_STATUS
+FatAbortTask (
+  IN FAT_TASK    *Task,
+  IN EFI_STATUS  Status
   );
 
 /**
@@ -1093,13 +1257,14 @@ FatDestroySubtask (
 
 /**
 
-  Execute the task.
+  Execute the task. Submit its last subtask and signal the token once all the
+  subtasks complete, or right away if they are done already.
 
   @param  IFile                 - The instance of the open file.
   @param  Task                  - The task to be executed.
 
   @retval EFI_SUCCESS           - The task was executed successfully.
-  @return other                 - An error occurred when executing the task.
+  @return other                 - An error occurred when executing the task, see FatAbortTask().
 
 **/
 EFI_STATUS
@@ -1240,6 +1405,20 @@ FatFatTimeToEfiTime (
   OUT EFI_TIME      *ETime
   );
 
+/**
+
+  Return the time elapsed since a value of the performance counter.
+
+  @param  StartTick             - Value of the performance counter at the start.
+
+  @return The elapsed time in nanoseconds.
+
+**/
+UINT64
+FatGetElapsedTime (
+  IN UINT64  StartTick
+  );
+
 /**
 
   Get Current FAT time.
@@ -2029,6 +2208,7 @@ extern EFI_COMPONENT_NAME_PROTOCOL   gFatComponentName;
 extern EFI_COMPONENT_NAME2_PROTOCOL  gFatComponentName2;
 extern EFI_LOCK                      FatFsLock;
 extern EFI_LOCK                      FatTaskLock;
+extern UINTN                         FatCacheStatisticsIndex;
 extern EFI_FILE_PROTOCOL             FatFileInterface;
 
 #endif
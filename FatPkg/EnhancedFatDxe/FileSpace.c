@@ -72,33 +72,28 @@ FatLoadFatEntry (
 
 /**
 
-  Get the FAT entry value of the volume, which is identified with the Index.
+  Decode the FAT entry value of the volume from the buffer holding the entry.
 
   @param  Volume                - FAT file system volume.
   @param  Index                 - The index of the FAT entry of the volume.
+  @param  Pos                   - The buffer of the FAT entry.
 
   @return  The value of the FAT entry.
 
 **/
 STATIC
 UINTN
-FatGetFatEntry (
+FatDecodeFatEntry (
   IN FAT_VOLUME  *Volume,
-  IN UINTN       Index
+  IN UINTN       Index,
+  IN VOID        *Pos
   )
 {
-  VOID    *Pos;
   UINT8   *En12;
   UINT16  *En16;
   UINT32  *En32;
   UINTN   Accum;
 
-  Pos = FatLoadFatEntry (Volume, Index);
-
-  if (Index > (Volume->MaxCluster + 1)) {
-    return (UINTN)-1;
-  }
-
   switch (Volume->FatType) {
     case Fat12:
       En12  = Pos;
@@ -122,6 +117,317 @@ FatGetFatEntry (
   return Accum;
 }
 
+/**
+
+  Get the FAT entry value of the volume, which is identified with the Index.
+
+  @param  Volume                - FAT file system volume.
+  @param  Index                 - The index of the FAT entry of the volume.
+
+  @return  The value of the FAT entry.
+
+**/
+STATIC
+UINTN
+FatGetFatEntry (
+  IN FAT_VOLUME  *Volume,
+  IN UINTN       Index
+  )
+{
+  VOID  *Pos;
+
+  Pos = FatLoadFatEntry (Volume, Index);
+
+  if (Index > (Volume->MaxCluster + 1)) {
+    return (UINTN)-1;
+  }
+
+  return FatDecodeFatEntry (Volume, Index, Pos);
+}
+
+/**
+
+  Extend the free cluster bitmap of the volume until it covers the clusters
+  below Limit. The FAT is read a whole FAT cache page at a time, rather than
+  one entry at a time.
+
+  @param  Volume                - FAT file system volume.
+  @param  Limit                 - The clusters below Limit need to be in the bitmap.
+
+  @retval TRUE                  - The bitmap covers the clusters below Limit.
+  @retval FALSE                 - The bitmap could not be allocated or the FAT could not be read.
+
+**/
+STATIC
+BOOLEAN
+FatLoadFreeBitmap (
+  IN FAT_VOLUME  *Volume,
+  IN UINTN       Limit
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       *Buffer;
+  UINTN       PageSize;
+  UINTN       Index;
+  UINTN       End;
+  UINTN       Pos;
+  UINTN       Offset;
+  UINTN       Size;
+  UINT64      StartTick;
+
+  if (Limit > Volume->MaxCluster + 2) {
+    Limit = Volume->MaxCluster + 2;
+  }
+
+  if (Volume->FreeBitmapLimit >= Limit) {
+    return TRUE;
+  }
+
+  if (Volume->DiskError) {
+    return FALSE;
+  }
+
+  if (Volume->FreeBitmap == NULL) {
+    Volume->FreeBitmap = AllocateZeroPool ((Volume->MaxCluster + 2 + 7) / 8);
+    if (Volume->FreeBitmap == NULL) {
+      return FALSE;
+    }
+
+    Volume->FreeBitmapLimit = 0;
+  }
+
+  PageSize = (UINTN)1 << Volume->DiskCache[CacheFat].PageAlignment;
+  Buffer   = AllocatePool (PageSize);
+  if (Buffer == NULL) {
+    return FALSE;
+  }
+
+  StartTick = GetPerformanceCounter ();
+  while (Volume->FreeBitmapLimit < Limit) {
+    //
+    // Each chunk is one FAT cache page, the FAT12 table always fits in one page
+    //
+    Index = Volume->FreeBitmapLimit;
+    switch (Volume->FatType) {
+      case Fat12:
+        End  = Volume->MaxCluster + 2;
+        Pos  = 0;
+        Size = FAT_POS_FAT12 (End - 1) + sizeof (UINT16);
+        break;
+
+      default:
+        End = Index + PageSize / Volume->FatEntrySize;
+        if (End > Volume->MaxCluster + 2) {
+          End = Volume->MaxCluster + 2;
+        }
+
+        Pos  = Index * Volume->FatEntrySize;
+        Size = (End - Index) * Volume->FatEntrySize;
+    }
+
+    ASSERT (Size <= PageSize);
+    Status = FatDiskIo (Volume, ReadFat, Volume->FatPos + Pos, Size, Buffer, NULL);
+    if (EFI_ERROR (Status)) {
+      Volume->SpaceStatistics.FreeBitmapTime += FatGetElapsedTime (StartTick);
+      FreePool (Buffer);
+      return FALSE;
+    }
+
+    Volume->SpaceStatistics.FreeBitmapReads++;
+    for ( ; Index < End; Index++) {
+      if (Index < FAT_MIN_CLUSTER) {
+        continue;
+      }
+
+      if (Volume->FatType == Fat12) {
+        Offset = FAT_POS_FAT12 (Index);
+      } else {
+        Offset = Index * Volume->FatEntrySize - Pos;
+      }
+
+      if (FatDecodeFatEntry (Volume, Index, Buffer + Offset) == FAT_CLUSTER_FREE) {
+        FAT_FREE_BITMAP_SET (Volume->FreeBitmap, Index);
+      }
+    }
+
+    Volume->FreeBitmapLimit = End;
+  }
+
+  Volume->SpaceStatistics.FreeBitmapTime += FatGetElapsedTime (StartTick);
+  FreePool (Buffer);
+  return TRUE;
+}
+
+/**
+
+  Find the first free cluster at or after Cluster with the free cluster bitmap.
+
+  @param  Volume                - FAT file system volume.
+  @param  Cluster               - On input, the cluster to start looking at.
+                                  On output, the first free cluster, or MaxCluster + 2 if
+                                  there is no free cluster at or after the input cluster.
+
+  @retval TRUE                  - The free cluster bitmap was used to find the cluster.
+  @retval FALSE                 - The free cluster bitmap is not available.
+
+**/
+STATIC
+BOOLEAN
+FatFindFreeCluster (
+  IN     FAT_VOLUME  *Volume,
+  IN OUT UINTN       *Cluster
+  )
+{
+  UINTN  Index;
+
+  Index = *Cluster;
+  while (Index <= Volume->MaxCluster + 1) {
+    if ((Index >= Volume->FreeBitmapLimit) && !FatLoadFreeBitmap (Volume, Index + 1)) {
+      return FALSE;
+    }
+
+    //
+    // Skip eight allocated clusters at a time
+    //
+    if (((Index & 7) == 0) && (Index + 8 <= Volume->FreeBitmapLimit) && (Volume->FreeBitmap[Index >> 3] == 0)) {
+      Index += 8;
+      continue;
+    }
+
+    if (FAT_FREE_BITMAP_TEST (Volume->FreeBitmap, Index)) {
+      break;
+    }
+
+    Index++;
+  }
+
+  *Cluster = Index;
+  return TRUE;
+}
+
+/**
+
+  Get the number of consecutive free clusters starting at Cluster, up to Count.
+  The free cluster bitmap must cover the whole volume.
+
+  @param  Volume                - FAT file system volume.
+  @param  Cluster               - The first cluster of the run.
+  @param  Count                 - The maximum length of the run to return.
+
+  @return The number of consecutive free clusters.
+
+**/
+STATIC
+UINTN
+FatFreeRunLength (
+  IN FAT_VOLUME  *Volume,
+  IN UINTN       Cluster,
+  IN UINTN       Count
+  )
+{
+  UINTN  Length;
+
+  ASSERT (Volume->FreeBitmapLimit == Volume->MaxCluster + 2);
+
+  for (Length = 0; Length < Count; Length++) {
+    if ((Cluster + Length > Volume->MaxCluster + 1) ||
+        !FAT_FREE_BITMAP_TEST (Volume->FreeBitmap, Cluster + Length))
+    {
+      break;
+    }
+  }
+
+  return Length;
+}
+
+/**
+
+  Point the allocation hint of the volume at a run of Count free clusters, so that
+  growing a file by Count clusters allocates them contiguously.
+
+  The run right after LastCluster is preferred, so the file stays in one extent.
+  Otherwise the first run long enough from the current hint is used, or the longest
+  run if there is no run long enough.
+
+  @param  Volume                - FAT file system volume.
+  @param  LastCluster           - The last cluster of the file, or 0 if the file has no cluster.
+  @param  Count                 - The number of clusters the file is growing by.
+
+**/
+STATIC
+VOID
+FatSetAllocationHint (
+  IN FAT_VOLUME  *Volume,
+  IN UINTN       LastCluster,
+  IN UINTN       Count
+  )
+{
+  UINTN  Start;
+  UINTN  End;
+  UINTN  Index;
+  UINTN  Length;
+  UINTN  BestStart;
+  UINTN  BestLength;
+  UINTN  Pass;
+
+  if ((Count < 2) || !FatLoadFreeBitmap (Volume, Volume->MaxCluster + 2)) {
+    return;
+  }
+
+  if ((LastCluster >= FAT_MIN_CLUSTER) && (FatFreeRunLength (Volume, LastCluster + 1, Count) == Count)) {
+    Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32)(LastCluster + 1);
+    Volume->SpaceStatistics.ExtentAllocations++;
+    return;
+  }
+
+  //
+  // First pass looks from the hint to the end, second pass from the start to the hint
+  //
+  BestStart  = 0;
+  BestLength = 0;
+  Start      = Volume->FatInfoSector.FreeInfo.NextCluster;
+  End        = Volume->MaxCluster + 2;
+  if ((Start < FAT_MIN_CLUSTER) || (Start >= End)) {
+    Start = FAT_MIN_CLUSTER;
+  }
+
+  for (Pass = 0; (Pass < 2) && (BestLength < Count); Pass++) {
+    Index = Start;
+    while (Index < End) {
+      FatFindFreeCluster (Volume, &Index);
+      if (Index >= End) {
+        break;
+      }
+
+      Length = FatFreeRunLength (Volume, Index, Count);
+      if (Length > BestLength) {
+        BestStart  = Index;
+        BestLength = Length;
+        if (Length == Count) {
+          break;
+        }
+      }
+
+      Index += Length;
+    }
+
+    End   = Start;
+    Start = FAT_MIN_CLUSTER;
+  }
+
+  if (BestLength == 0) {
+    return;
+  }
+
+  if (BestLength == Count) {
+    Volume->SpaceStatistics.ExtentAllocations++;
+  } else {
+    Volume->SpaceStatistics.FragmentedAllocations++;
+  }
+
+  Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32)BestStart;
+}
+
 /**
 
   Set the FAT entry value of the volume, which is identified with the Index.
@@ -167,6 +473,17 @@ FatSetFatEntry (
     }
   }
 
+  //
+  // Keep the free cluster bitmap in sync with the FAT
+  //
+  if (Index < Volume->FreeBitmapLimit) {
+    if (Value == FAT_CLUSTER_FREE) {
+      FAT_FREE_BITMAP_SET (Volume->FreeBitmap, Index);
+    } else {
+      FAT_FREE_BITMAP_CLEAR (Volume->FreeBitmap, Index);
+    }
+  }
+
   //
   // Make sure the entry is in memory
   //
@@ -298,6 +615,19 @@ FatAllocateCluster (
       }
     }
 
+    //
+    // Skip the allocated clusters with the free cluster bitmap if it is available
+    //
+    Cluster = Volume->FatInfoSector.FreeInfo.NextCluster;
+    if (FatFindFreeCluster (Volume, &Cluster)) {
+      Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32)Cluster;
+      if (Cluster <= Volume->MaxCluster + 1) {
+        break;
+      }
+
+      continue;
+    }
+
     Cluster = FatGetFatEntry (Volume, Volume->FatInfoSector.FreeInfo.NextCluster);
     if (Cluster == FAT_CLUSTER_FREE) {
       break;
@@ -311,6 +641,7 @@ FatAllocateCluster (
 
   Cluster                                     = Volume->FatInfoSector.FreeInfo.NextCluster;
   Volume->FatInfoSector.FreeInfo.NextCluster += 1;
+  Volume->SpaceStatistics.ClusterAllocations++;
   return Cluster;
 }
 
@@ -341,6 +672,155 @@ FatSizeToClusters (
   return Clusters;
 }
 
+/**
+
+  Map the cluster chain of the open file into cluster runs until the first
+  Clusters clusters of the file are mapped, or the end of the chain is reached.
+
+  @param  OFile                 - The open file.
+  @param  Clusters              - The number of clusters of the file to map.
+
+  @retval EFI_SUCCESS           - The clusters are mapped, or the chain ends before them.
+  @retval EFI_OUT_OF_RESOURCES  - Can not allocate memory for the cluster runs.
+  @retval EFI_VOLUME_CORRUPTED  - The cluster chain is corrupt.
+
+**/
+STATIC
+EFI_STATUS
+FatExtendExtents (
+  IN FAT_OFILE  *OFile,
+  IN UINTN      Clusters
+  )
+{
+  FAT_VOLUME  *Volume;
+  FAT_EXTENT  *Extent;
+  FAT_EXTENT  *Extents;
+  UINTN       Cluster;
+
+  Volume = OFile->Volume;
+  while (OFile->ExtentClusters < Clusters) {
+    if (OFile->ExtentCount == 0) {
+      Cluster = OFile->FileCluster;
+      if (Cluster == FAT_CLUSTER_FREE) {
+        break;
+      }
+    } else {
+      Extent  = &OFile->Extents[OFile->ExtentCount - 1];
+      Cluster = FatGetFatEntry (Volume, Extent->Cluster + Extent->Length - 1);
+      if (FAT_END_OF_FAT_CHAIN (Cluster)) {
+        break;
+      }
+
+      if (Cluster == Extent->Cluster + Extent->Length) {
+        Extent->Length++;
+        OFile->ExtentClusters++;
+        continue;
+      }
+    }
+
+    if ((Cluster < FAT_MIN_CLUSTER) || (Cluster > Volume->MaxCluster + 1)) {
+      DEBUG ((DEBUG_INIT | DEBUG_ERROR, "FatExtendExtents: cluster chain corrupt\n"));
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    //
+    // Start a new run
+    //
+    if (OFile->ExtentCount == OFile->ExtentMaxCount) {
+      Extents = ReallocatePool (
+                  OFile->ExtentMaxCount * sizeof (FAT_EXTENT),
+                  MAX (OFile->ExtentMaxCount * 2, FAT_EXTENT_INITIAL_COUNT) * sizeof (FAT_EXTENT),
+                  OFile->Extents
+                  );
+      if (Extents == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+      }
+
+      OFile->Extents        = Extents;
+      OFile->ExtentMaxCount = MAX (OFile->ExtentMaxCount * 2, FAT_EXTENT_INITIAL_COUNT);
+    }
+
+    Extent              = &OFile->Extents[OFile->ExtentCount];
+    Extent->FileCluster = OFile->ExtentClusters;
+    Extent->Cluster     = Cluster;
+    Extent->Length      = 1;
+    OFile->ExtentCount++;
+    OFile->ExtentClusters++;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+
+  Find the cluster run holding the cluster of the file. The cluster must be mapped.
+
+  @param  OFile                 - The open file.
+  @param  FileCluster           - The index of the cluster within the file.
+
+  @return The cluster run holding the cluster.
+
+**/
+STATIC
+FAT_EXTENT *
+FatFindExtent (
+  IN FAT_OFILE  *OFile,
+  IN UINTN      FileCluster
+  )
+{
+  UINTN  Low;
+  UINTN  High;
+  UINTN  Middle;
+
+  ASSERT (FileCluster < OFile->ExtentClusters);
+
+  Low  = 0;
+  High = OFile->ExtentCount - 1;
+  while (Low < High) {
+    Middle = (Low + High + 1) / 2;
+    if (OFile->Extents[Middle].FileCluster <= FileCluster) {
+      Low = Middle;
+    } else {
+      High = Middle - 1;
+    }
+  }
+
+  return &OFile->Extents[Low];
+}
+
+/**
+
+  Drop the cluster runs beyond the first Clusters clusters of the file.
+
+  @param  OFile                 - The open file.
+  @param  Clusters              - The number of clusters of the file that are kept.
+
+**/
+STATIC
+VOID
+FatTruncateExtents (
+  IN FAT_OFILE  *OFile,
+  IN UINTN      Clusters
+  )
+{
+  FAT_EXTENT  *Extent;
+
+  while ((OFile->ExtentCount > 0) && (OFile->Extents[OFile->ExtentCount - 1].FileCluster >= Clusters)) {
+    OFile->ExtentCount--;
+  }
+
+  if (OFile->ExtentCount > 0) {
+    Extent = &OFile->Extents[OFile->ExtentCount - 1];
+    if (Extent->FileCluster + Extent->Length > Clusters) {
+      Extent->Length = Clusters - Extent->FileCluster;
+    }
+  }
+
+  if (OFile->ExtentClusters > Clusters) {
+    OFile->ExtentClusters = Clusters;
+  }
+}
+
 /**
 
   Shrink the end of the open file base on the file size.
@@ -366,6 +846,7 @@ FatShrinkEof (
   ASSERT_VOLUME_LOCKED (Volume);
 
   NewSize = FatSizeToClusters (Volume, OFile->FileSize);
+  FatTruncateExtents (OFile, NewSize);
 
   //
   // Find the address of the last cluster
@@ -439,6 +920,7 @@ FatGrowEof (
   UINTN       LastCluster;
   UINTN       NewCluster;
   UINTN       ClusterCount;
+  UINT64      StartTick;
 
   //
   // For FAT file system, the max file is 4GB.
@@ -491,7 +973,10 @@ FatGrowEof (
     //
     // Loop until we've allocated enough space
     //
+    Status      = EFI_SUCCESS;
     LastCluster = OFile->FileLastCluster;
+    StartTick   = GetPerformanceCounter ();
+    FatSetAllocationHint (Volume, LastCluster, NewSize - CurSize);
 
     while (CurSize < NewSize) {
       NewCluster = FatAllocateCluster (Volume);
@@ -502,12 +987,12 @@ FatGrowEof (
         }
 
         Status = EFI_VOLUME_FULL;
-        goto Done;
+        break;
       }
 
       if ((NewCluster < FAT_MIN_CLUSTER) || (NewCluster > Volume->MaxCluster + 1)) {
         Status = EFI_VOLUME_CORRUPTED;
-        goto Done;
+        break;
       }
 
       if (LastCluster != 0) {
@@ -534,6 +1019,11 @@ FatGrowEof (
       FatSetFatEntry (Volume, LastCluster, (UINTN)FAT_CLUSTER_LAST);
       OFile->FileLastCluster = LastCluster;
     }
+
+    Volume->SpaceStatistics.AllocationTime += FatGetElapsedTime (StartTick);
+    if (EFI_ERROR (Status)) {
+      goto Done;
+    }
   }
 
   OFile->FileSize = (UINTN)NewSizeInBytes;
@@ -566,8 +1056,12 @@ FatOFilePosition (
   )
 {
   FAT_VOLUME  *Volume;
+  FAT_EXTENT  *Extent;
+  EFI_STATUS  Status;
   UINTN       ClusterSize;
   UINTN       Cluster;
+  UINTN       FileCluster;
+  UINTN       Clusters;
   UINTN       StartPos;
   UINTN       Run;
 
@@ -576,6 +1070,24 @@ FatOFilePosition (
 
   ASSERT_VOLUME_LOCKED (Volume);
 
+  //
+  // Map the cluster chain up to the end of this access, so the position
+  // is found by a binary search and the access is split only where the
+  // file is fragmented on the disk
+  //
+  Status      = EFI_UNSUPPORTED;
+  FileCluster = Position >> Volume->ClusterAlignment;
+  if (!OFile->IsFixedRootDir) {
+    Clusters = MIN (
+                 FileCluster + FatSizeToClusters (Volume, PosLimit) + 1,
+                 FatSizeToClusters (Volume, OFile->FileSize)
+                 );
+    Status = FatExtendExtents (OFile, MAX (Clusters, FileCluster + 1));
+    if (Status == EFI_VOLUME_CORRUPTED) {
+      return Status;
+    }
+  }
+
   //
   // If this is the fixed root dir, then compute its position
   // from its fixed info in the fat bpb
@@ -583,6 +1095,21 @@ FatOFilePosition (
   if (OFile->IsFixedRootDir) {
     OFile->PosDisk = Volume->RootPos + Position;
     Run            = OFile->FileSize - Position;
+  } else if (!EFI_ERROR (Status) && (FileCluster < OFile->ExtentClusters)) {
+    Extent   = FatFindExtent (OFile, FileCluster);
+    Cluster  = Extent->Cluster + FileCluster - Extent->FileCluster;
+    StartPos = FileCluster << Volume->ClusterAlignment;
+
+    OFile->PosDisk = Volume->FirstClusterPos +
+                     LShiftU64 (Cluster - FAT_MIN_CLUSTER, Volume->ClusterAlignment) +
+                     Position - StartPos;
+    OFile->FileCurrentCluster = Cluster;
+    OFile->Position           = StartPos;
+
+    //
+    // The run lasts until the end of the cluster run
+    //
+    Run = ((Extent->FileCluster + Extent->Length) << Volume->ClusterAlignment) - Position;
   } else {
     //
     // Run the file's cluster chain to find the current position
@@ -729,14 +1256,23 @@ FatComputeFreeInfo (
   if (!Volume->FreeInfoValid) {
     Volume->FreeInfoValid                       = TRUE;
     Volume->FatInfoSector.FreeInfo.ClusterCount = 0;
-    for (Index = Volume->MaxCluster + 1; Index >= FAT_MIN_CLUSTER; Index--) {
-      if (Volume->DiskError) {
-        break;
+    if (FatLoadFreeBitmap (Volume, Volume->MaxCluster + 2)) {
+      for (Index = Volume->MaxCluster + 1; Index >= FAT_MIN_CLUSTER; Index--) {
+        if (FAT_FREE_BITMAP_TEST (Volume->FreeBitmap, Index)) {
+          Volume->FatInfoSector.FreeInfo.ClusterCount += 1;
+          Volume->FatInfoSector.FreeInfo.NextCluster   = (UINT32)Index;
+        }
       }
+    } else {
+      for (Index = Volume->MaxCluster + 1; Index >= FAT_MIN_CLUSTER; Index--) {
+        if (Volume->DiskError) {
+          break;
+        }
 
-      if (FatGetFatEntry (Volume, Index) == FAT_CLUSTER_FREE) {
-        Volume->FatInfoSector.FreeInfo.ClusterCount += 1;
-        Volume->FatInfoSector.FreeInfo.NextCluster   = (UINT32)Index;
+        if (FatGetFatEntry (Volume, Index) == FAT_CLUSTER_FREE) {
+          Volume->FatInfoSector.FreeInfo.ClusterCount += 1;
+          Volume->FatInfoSector.FreeInfo.NextCluster   = (UINT32)Index;
+        }
       }
     }
 
@@ -745,3 +1281,25 @@ FatComputeFreeInfo (
     Volume->FatInfoSector.InfoEndSignature   = FAT_INFO_END_SIGNATURE;
   }
 }
+
+/**
+
+  Free the cluster runs cached for the open file.
+
+  @param  OFile                 - The open file.
+
+**/
+VOID
+FatFreeExtents (
+  IN FAT_OFILE  *OFile
+  )
+{
+  if (OFile->Extents != NULL) {
+    FreePool (OFile->Extents);
+    OFile->Extents = NULL;
+  }
+
+  OFile->ExtentCount    = 0;
+  OFile->ExtentMaxCount = 0;
+  OFile->ExtentClusters = 0;
+}
@@ -80,6 +80,10 @@ FatFlushEx (
   //
   FatAcquireLock ();
   Status = FatOFileFlush (OFile);
+  if (!EFI_ERROR (Status)) {
+    FatPublishStatistics (Volume);
+  }
+
   Status = FatCleanupVolume (OFile->Volume, OFile, Status, Task);
   FatReleaseLock ();
 
@@ -87,7 +91,7 @@ FatFlushEx (
     if (!EFI_ERROR (Status)) {
       Status = FatQueueTask (IFile, Task);
     } else {
-      FatDestroyTask (Task);
+      Status = FatAbortTask (Task, Status);
     }
   }
 
@@ -431,6 +435,14 @@ FatCleanupVolume (
     if (EFI_ERROR (Status)) {
       return Status;
     }
+
+    //
+    // The last file handle of the volume was closed, publish the statistics
+    // so they can be read while the volume stays mounted
+    //
+    if (Volume->Root == NULL) {
+      FatPublishStatistics (Volume);
+    }
   }
 
   //
@@ -0,0 +1,898 @@
+/** @file
+  Unit tests for the non-blocking file access of the FAT driver.
+
+  The tests mount a small FAT12 image from a RAM disk whose DiskIo2 requests
+  stay in flight until the test completes them.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+#include <Library/GoogleTestLib.h>
+#include <GoogleTest/Library/MockUefiRuntimeServicesTableLib.h>
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+extern "C" {
+  #include "../Fat.h"
+
+  extern EFI_UNICODE_COLLATION_PROTOCOL  *mUnicodeCollationInterface;
+}
+
+using namespace testing;
+
+//
+// FAT12 image layout: 512 byte sectors, one reserved sector, one FAT sector,
+// a root directory of one 8K data cache page and 8K clusters, so that every
+// cluster fills exactly one data cache page.
+//
+#define TEST_SECTOR_SIZE          512
+#define TEST_SECTORS_PER_CLUSTER  16
+#define TEST_ROOT_ENTRIES         256
+#define TEST_CLUSTER_COUNT        8
+#define TEST_CLUSTER_SIZE         (TEST_SECTOR_SIZE * TEST_SECTORS_PER_CLUSTER)
+#define TEST_FAT_POS              TEST_SECTOR_SIZE
+#define TEST_ROOT_POS             (2 * TEST_SECTOR_SIZE)
+#define TEST_FIRST_CLUSTER_POS    (TEST_ROOT_POS + TEST_ROOT_ENTRIES * sizeof (FAT_DIRECTORY_ENTRY))
+#define TEST_DISK_SIZE            (TEST_FIRST_CLUSTER_POS + TEST_CLUSTER_COUNT * TEST_CLUSTER_SIZE)
+#define TEST_FAT12_EOC            0xFFF
+
+//
+// Boot services the driver relies on, with events and TPLs that behave like
+// the DXE core's: notifications are deferred while the TPL is at or above the
+// notification TPL of the event.
+//
+typedef struct {
+  UINT32              Type;
+  EFI_TPL             NotifyTpl;
+  EFI_EVENT_NOTIFY    NotifyFunction;
+  VOID                *NotifyContext;
+  BOOLEAN             Signaled;
+} TEST_EVENT;
+
+STATIC EFI_TPL                    mTpl = TPL_APPLICATION;
+STATIC std::vector<TEST_EVENT *>  mPendingNotifies;
+STATIC VOID                       *mInstalledVolumeInterface;
+
+STATIC
+VOID
+DispatchNotifies (
+  VOID
+  )
+{
+  TEST_EVENT  *Event;
+  EFI_TPL     OldTpl;
+  UINTN       Index;
+
+  for (Index = 0; Index < mPendingNotifies.size (); ) {
+    Event = mPendingNotifies[Index];
+    if (Event->NotifyTpl <= mTpl) {
+      Index++;
+      continue;
+    }
+
+    mPendingNotifies.erase (mPendingNotifies.begin () + Index);
+    OldTpl = mTpl;
+    mTpl   = Event->NotifyTpl;
+    Event->NotifyFunction ((EFI_EVENT)Event, Event->NotifyContext);
+    mTpl  = OldTpl;
+    Index = 0;
+  }
+}
+
+STATIC
+EFI_TPL
+EFIAPI
+TestRaiseTpl (
+  IN EFI_TPL  NewTpl
+  )
+{
+  EFI_TPL  OldTpl;
+
+  OldTpl = mTpl;
+  EXPECT_GE (NewTpl, OldTpl);
+  mTpl = NewTpl;
+  return OldTpl;
+}
+
+STATIC
+VOID
+EFIAPI
+TestRestoreTpl (
+  IN EFI_TPL  OldTpl
+  )
+{
+  EXPECT_LE (OldTpl, mTpl);
+  mTpl = OldTpl;
+  DispatchNotifies ();
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestCreateEvent (
+  IN  UINT32            Type,
+  IN  EFI_TPL           NotifyTpl,
+  IN  EFI_EVENT_NOTIFY  NotifyFunction OPTIONAL,
+  IN  VOID              *NotifyContext OPTIONAL,
+  OUT EFI_EVENT         *Event
+  )
+{
+  TEST_EVENT  *NewEvent;
+
+  NewEvent                 = new TEST_EVENT ();
+  NewEvent->Type           = Type;
+  NewEvent->NotifyTpl      = NotifyTpl;
+  NewEvent->NotifyFunction = NotifyFunction;
+  NewEvent->NotifyContext  = NotifyContext;
+  *Event                   = (EFI_EVENT)NewEvent;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestSignalEvent (
+  IN EFI_EVENT  Event
+  )
+{
+  TEST_EVENT  *TestEvent;
+
+  TestEvent = (TEST_EVENT *)Event;
+  if ((TestEvent->Type & EVT_NOTIFY_SIGNAL) == 0) {
+    TestEvent->Signaled = TRUE;
+    return EFI_SUCCESS;
+  }
+
+  if (std::find (mPendingNotifies.begin (), mPendingNotifies.end (), TestEvent) == mPendingNotifies.end ()) {
+    mPendingNotifies.push_back (TestEvent);
+    DispatchNotifies ();
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestCloseEvent (
+  IN EFI_EVENT  Event
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < mPendingNotifies.size (); Index++) {
+    if (mPendingNotifies[Index] == (TEST_EVENT *)Event) {
+      mPendingNotifies.erase (mPendingNotifies.begin () + Index);
+      break;
+    }
+  }
+
+  delete (TEST_EVENT *)Event;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestCheckEvent (
+  IN EFI_EVENT  Event
+  )
+{
+  TEST_EVENT  *TestEvent;
+
+  TestEvent = (TEST_EVENT *)Event;
+  if (!TestEvent->Signaled) {
+    return EFI_NOT_READY;
+  }
+
+  TestEvent->Signaled = FALSE;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestInstallMultipleProtocolInterfaces (
+  IN OUT EFI_HANDLE  *Handle,
+  ...
+  )
+{
+  VA_LIST  Args;
+
+  VA_START (Args, Handle);
+  VA_ARG (Args, EFI_GUID *);
+  mInstalledVolumeInterface = VA_ARG (Args, VOID *);
+  VA_END (Args);
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestUninstallMultipleProtocolInterfaces (
+  IN EFI_HANDLE  Handle,
+  ...
+  )
+{
+  mInstalledVolumeInterface = NULL;
+  return EFI_SUCCESS;
+}
+
+//
+// An ASCII only Unicode Collation protocol
+//
+STATIC
+INTN
+EFIAPI
+TestStriColl (
+  IN EFI_UNICODE_COLLATION_PROTOCOL  *This,
+  IN CHAR16                          *Str1,
+  IN CHAR16                          *Str2
+  )
+{
+  while ((*Str1 != L'\0') && (CharToUpper (*Str1) == CharToUpper (*Str2))) {
+    Str1++;
+    Str2++;
+  }
+
+  return CharToUpper (*Str1) - CharToUpper (*Str2);
+}
+
+STATIC
+BOOLEAN
+EFIAPI
+TestMetaiMatch (
+  IN EFI_UNICODE_COLLATION_PROTOCOL  *This,
+  IN CHAR16                          *String,
+  IN CHAR16                          *Pattern
+  )
+{
+  return FALSE;
+}
+
+STATIC
+VOID
+EFIAPI
+TestStrLwr (
+  IN EFI_UNICODE_COLLATION_PROTOCOL  *This,
+  IN OUT CHAR16                      *Str
+  )
+{
+  for ( ; *Str != L'\0'; Str++) {
+    if ((*Str >= L'A') && (*Str <= L'Z')) {
+      *Str = (CHAR16)(*Str - L'A' + L'a');
+    }
+  }
+}
+
+STATIC
+VOID
+EFIAPI
+TestStrUpr (
+  IN EFI_UNICODE_COLLATION_PROTOCOL  *This,
+  IN OUT CHAR16                      *Str
+  )
+{
+  for ( ; *Str != L'\0'; Str++) {
+    *Str = CharToUpper (*Str);
+  }
+}
+
+STATIC
+VOID
+EFIAPI
+TestFatToStr (
+  IN EFI_UNICODE_COLLATION_PROTOCOL  *This,
+  IN UINTN                           FatSize,
+  IN CHAR8                           *Fat,
+  OUT CHAR16                         *String
+  )
+{
+  while ((FatSize-- != 0) && (*Fat != '\0')) {
+    *String++ = (CHAR16)(UINT8)*Fat++;
+  }
+
+  *String = L'\0';
+}
+
+STATIC
+BOOLEAN
+EFIAPI
+TestStrToFat (
+  IN EFI_UNICODE_COLLATION_PROTOCOL  *This,
+  IN CHAR16                          *String,
+  IN UINTN                           FatSize,
+  OUT CHAR8                          *Fat
+  )
+{
+  for ( ; (*String != L'\0') && (FatSize != 0); String++) {
+    if ((*String != L'.') && (*String != L' ')) {
+      *Fat++ = (CHAR8)CharToUpper (*String);
+      FatSize--;
+    }
+  }
+
+  return FALSE;
+}
+
+STATIC EFI_UNICODE_COLLATION_PROTOCOL  mTestCollation = {
+  TestStriColl,
+  TestMetaiMatch,
+  TestStrLwr,
+  TestStrUpr,
+  TestFatToStr,
+  TestStrToFat,
+  (CHAR8 *)"en"
+};
+
+//
+// A RAM disk whose non-blocking requests complete when the test says so
+//
+typedef struct {
+  EFI_DISK_IO2_TOKEN    *Token;
+  BOOLEAN               Write;
+  UINT64                Offset;
+  UINTN                 BufferSize;
+  VOID                  *Buffer;
+} TEST_DISK_REQUEST;
+
+class RamDisk {
+public:
+  EFI_DISK_IO_PROTOCOL  DiskIo;
+  EFI_DISK_IO2_PROTOCOL DiskIo2;
+  EFI_BLOCK_IO_PROTOCOL BlockIo;
+  EFI_BLOCK_IO_MEDIA    Media;
+  std::vector<UINT8>    Image;
+  std::deque<TEST_DISK_REQUEST> Pending;
+  UINTN                 SubmittedRequests;
+  UINTN                 FailingRequest;
+
+  RamDisk (
+    ) : Image (TEST_DISK_SIZE), SubmittedRequests (0), FailingRequest (0)
+  {
+    ZeroMem (&Media, sizeof (Media));
+    Media.MediaId      = 1;
+    Media.MediaPresent = TRUE;
+    Media.BlockSize    = TEST_SECTOR_SIZE;
+    Media.LastBlock    = TEST_DISK_SIZE / TEST_SECTOR_SIZE - 1;
+
+    ZeroMem (&BlockIo, sizeof (BlockIo));
+    BlockIo.Revision    = EFI_BLOCK_IO_PROTOCOL_REVISION;
+    BlockIo.Media       = &Media;
+    BlockIo.FlushBlocks = FlushBlocks;
+
+    DiskIo.Revision  = EFI_DISK_IO_PROTOCOL_REVISION;
+    DiskIo.ReadDisk  = ReadDisk;
+    DiskIo.WriteDisk = WriteDisk;
+
+    DiskIo2.Revision    = EFI_DISK_IO2_PROTOCOL_REVISION;
+    DiskIo2.Cancel      = Cancel;
+    DiskIo2.ReadDiskEx  = ReadDiskEx;
+    DiskIo2.WriteDiskEx = WriteDiskEx;
+    DiskIo2.FlushDiskEx = FlushDiskEx;
+
+    mRamDisk = this;
+  }
+
+  ~RamDisk (
+    )
+  {
+    mRamDisk = NULL;
+  }
+
+  //
+  // Complete the requests in flight in the order they were submitted.
+  //
+  VOID
+  CompletePending (
+    )
+  {
+    TEST_DISK_REQUEST  Request;
+
+    while (!Pending.empty ()) {
+      Request = Pending.front ();
+      Pending.pop_front ();
+      Access (Request.Write, Request.Offset, Request.BufferSize, Request.Buffer);
+      Request.Token->TransactionStatus = EFI_SUCCESS;
+      gBS->SignalEvent (Request.Token->Event);
+    }
+  }
+
+private:
+  static RamDisk  *mRamDisk;
+
+  VOID
+  Access (
+    BOOLEAN  Write,
+    UINT64   Offset,
+    UINTN    BufferSize,
+    VOID     *Buffer
+    )
+  {
+    ASSERT_LE (Offset + BufferSize, Image.size ());
+    if (Write) {
+      CopyMem (&Image[(UINTN)Offset], Buffer, BufferSize);
+    } else {
+      CopyMem (Buffer, &Image[(UINTN)Offset], BufferSize);
+    }
+  }
+
+  static
+  EFI_STATUS
+  Submit (
+    BOOLEAN             Write,
+    UINT64              Offset,
+    EFI_DISK_IO2_TOKEN  *Token,
+    UINTN               BufferSize,
+    VOID                *Buffer
+    )
+  {
+    TEST_DISK_REQUEST  Request;
+
+    if ((Token == NULL) || (Token->Event == NULL)) {
+      mRamDisk->Access (Write, Offset, BufferSize, Buffer);
+      return EFI_SUCCESS;
+    }
+
+    if (++mRamDisk->SubmittedRequests == mRamDisk->FailingRequest) {
+      return EFI_DEVICE_ERROR;
+    }
+
+    Request.Token      = Token;
+    Request.Write      = Write;
+    Request.Offset     = Offset;
+    Request.BufferSize = BufferSize;
+    Request.Buffer     = Buffer;
+    mRamDisk->Pending.push_back (Request);
+    return EFI_SUCCESS;
+  }
+
+  static
+  EFI_STATUS
+  EFIAPI
+  ReadDisk (
+    IN EFI_DISK_IO_PROTOCOL  *This,
+    IN UINT32                MediaId,
+    IN UINT64                Offset,
+    IN UINTN                 BufferSize,
+    OUT VOID                 *Buffer
+    )
+  {
+    mRamDisk->Access (FALSE, Offset, BufferSize, Buffer);
+    return EFI_SUCCESS;
+  }
+
+  static
+  EFI_STATUS
+  EFIAPI
+  WriteDisk (
+    IN EFI_DISK_IO_PROTOCOL  *This,
+    IN UINT32                MediaId,
+    IN UINT64                Offset,
+    IN UINTN                 BufferSize,
+    IN VOID                  *Buffer
+    )
+  {
+    mRamDisk->Access (TRUE, Offset, BufferSize, Buffer);
+    return EFI_SUCCESS;
+  }
+
+  static
+  EFI_STATUS
+  EFIAPI
+  Cancel (
+    IN EFI_DISK_IO2_PROTOCOL  *This
+    )
+  {
+    return EFI_UNSUPPORTED;
+  }
+
+  static
+  EFI_STATUS
+  EFIAPI
+  ReadDiskEx (
+    IN EFI_DISK_IO2_PROTOCOL   *This,
+    IN UINT32                  MediaId,
+    IN UINT64                  Offset,
+    IN OUT EFI_DISK_IO2_TOKEN  *Token,
+    IN UINTN                   BufferSize,
+    OUT VOID                   *Buffer
+    )
+  {
+    return Submit (FALSE, Offset, Token, BufferSize, Buffer);
+  }
+
+  static
+  EFI_STATUS
+  EFIAPI
+  WriteDiskEx (
+    IN EFI_DISK_IO2_PROTOCOL   *This,
+    IN UINT32                  MediaId,
+    IN UINT64                  Offset,
+    IN OUT EFI_DISK_IO2_TOKEN  *Token,
+    IN UINTN                   BufferSize,
+    IN VOID                    *Buffer
+    )
+  {
+    return Submit (TRUE, Offset, Token, BufferSize, Buffer);
+  }
+
+  static
+  EFI_STATUS
+  EFIAPI
+  FlushDiskEx (
+    IN EFI_DISK_IO2_PROTOCOL   *This,
+    IN OUT EFI_DISK_IO2_TOKEN  *Token
+    )
+  {
+    return EFI_SUCCESS;
+  }
+
+  static
+  EFI_STATUS
+  EFIAPI
+  FlushBlocks (
+    IN EFI_BLOCK_IO_PROTOCOL  *This
+    )
+  {
+    return EFI_SUCCESS;
+  }
+};
+
+RamDisk  *RamDisk::mRamDisk = NULL;
+
+//
+// Needed by FileSpace.c and Misc.c. The performance counter advances by one
+// each time it is read, and a tick is a nanosecond.
+//
+STATIC UINT64  mPerformanceCounter;
+
+extern "C" {
+  UINT64
+  EFIAPI
+  GetPerformanceCounter (
+    VOID
+    )
+  {
+    return ++mPerformanceCounter;
+  }
+
+  UINT64
+  EFIAPI
+  GetPerformanceCounterProperties (
+    OUT UINT64  *StartValue  OPTIONAL,
+    OUT UINT64  *EndValue    OPTIONAL
+    )
+  {
+    if (StartValue != NULL) {
+      *StartValue = 0;
+    }
+
+    if (EndValue != NULL) {
+      *EndValue = MAX_UINT64;
+    }
+
+    return 1000000000;
+  }
+
+  UINT64
+  EFIAPI
+  GetTimeInNanoSecond (
+    IN UINT64  Ticks
+    )
+  {
+    return Ticks;
+  }
+}
+
+class FatNonBlockingTest : public Test {
+protected:
+  MockUefiRuntimeServicesTableLib RtServicesMock;
+  EFI_BOOT_SERVICES BootServices;
+  RamDisk Disk;
+  EFI_FILE_PROTOCOL *Root;
+  EFI_FILE_IO_TOKEN Token;
+  EFI_STATUS Status;
+
+  void
+  SetUp (
+    ) override
+  {
+    EFI_TIME  Time;
+
+    ZeroMem (&Time, sizeof (Time));
+    Time.Year  = 2026;
+    Time.Month = 1;
+    Time.Day   = 1;
+    EXPECT_CALL (RtServicesMock, gRT_GetTime)
+      .WillRepeatedly (DoAll (SetArgPointee<0>(Time), Return (EFI_SUCCESS)));
+    EXPECT_CALL (RtServicesMock, gRT_SetVariable)
+      .WillRepeatedly (Return (EFI_SUCCESS));
+
+    CopyMem (&BootServices, gBS, sizeof (BootServices));
+    gBS->RaiseTPL                          = TestRaiseTpl;
+    gBS->RestoreTPL                        = TestRestoreTpl;
+    gBS->CreateEvent                       = TestCreateEvent;
+    gBS->SignalEvent                       = TestSignalEvent;
+    gBS->CloseEvent                        = TestCloseEvent;
+    gBS->CheckEvent                        = TestCheckEvent;
+    gBS->InstallMultipleProtocolInterfaces = TestInstallMultipleProtocolInterfaces;
+    gBS->UninstallMultipleProtocolInterfaces = TestUninstallMultipleProtocolInterfaces;
+    mUnicodeCollationInterface = &mTestCollation;
+
+    Root = NULL;
+    ZeroMem (&Token, sizeof (Token));
+    ASSERT_EQ (gBS->CreateEvent (0, TPL_CALLBACK, NULL, NULL, &Token.Event), EFI_SUCCESS);
+  }
+
+  void
+  TearDown (
+    ) override
+  {
+    FAT_VOLUME  *Volume;
+
+    if (Root != NULL) {
+      Root->Close (Root);
+    }
+
+    if (mInstalledVolumeInterface != NULL) {
+      Volume = VOLUME_FROM_VOL_INTERFACE (mInstalledVolumeInterface);
+      FatAbandonVolume (Volume);
+    }
+
+    gBS->CloseEvent (Token.Event);
+    EXPECT_TRUE (mPendingNotifies.empty ());
+    EXPECT_EQ (mTpl, (EFI_TPL)TPL_APPLICATION);
+    CopyMem (gBS, &BootServices, sizeof (BootServices));
+    mUnicodeCollationInterface = NULL;
+  }
+
+  VOID
+  SetFatEntry (
+    UINTN   Cluster,
+    UINT16  Value
+    )
+  {
+    UINT8  *Entry;
+
+    Entry = &Disk.Image[TEST_FAT_POS + Cluster + Cluster / 2];
+    if ((Cluster & 1) != 0) {
+      Entry[0] = (UINT8)((Entry[0] & 0x0F) | ((Value & 0x0F) << 4));
+      Entry[1] = (UINT8)(Value >> 4);
+    } else {
+      Entry[0] = (UINT8)Value;
+      Entry[1] = (UINT8)((Entry[1] & 0xF0) | ((Value >> 8) & 0x0F));
+    }
+  }
+
+  //
+  // Format the RAM disk and mount it.
+  //
+  VOID
+  Mount (
+    BOOLEAN  Full
+    )
+  {
+    FAT_BOOT_SECTOR  *BootSector;
+    UINTN            Cluster;
+
+    BootSector                           = (FAT_BOOT_SECTOR *)&Disk.Image[0];
+    BootSector->FatBsb.Ia32Jump[0]       = 0xEB;
+    BootSector->FatBsb.Ia32Jump[1]       = 0x3C;
+    BootSector->FatBsb.Ia32Jump[2]       = 0x90;
+    BootSector->FatBsb.SectorSize        = TEST_SECTOR_SIZE;
+    BootSector->FatBsb.SectorsPerCluster = TEST_SECTORS_PER_CLUSTER;
+    BootSector->FatBsb.ReservedSectors   = 1;
+    BootSector->FatBsb.NumFats           = 1;
+    BootSector->FatBsb.RootEntries       = TEST_ROOT_ENTRIES;
+    BootSector->FatBsb.Sectors           = TEST_DISK_SIZE / TEST_SECTOR_SIZE;
+    BootSector->FatBsb.Media             = 0xF8;
+    BootSector->FatBsb.SectorsPerFat     = 1;
+    Disk.Image[510]                      = 0x55;
+    Disk.Image[511]                      = 0xAA;
+
+    SetFatEntry (0, 0xFF8);
+    SetFatEntry (1, TEST_FAT12_EOC);
+    if (Full) {
+      for (Cluster = 2; Cluster < TEST_CLUSTER_COUNT + 2; Cluster++) {
+        SetFatEntry (Cluster, TEST_FAT12_EOC);
+      }
+    }
+
+    ASSERT_EQ (FatAllocateVolume ((EFI_HANDLE)&Disk, &Disk.DiskIo, &Disk.DiskIo2, &Disk.BlockIo), EFI_SUCCESS);
+    ASSERT_NE (mInstalledVolumeInterface, (VOID *)NULL);
+    ASSERT_EQ (FatOpenVolume ((EFI_SIMPLE_FILE_SYSTEM_PROTOCOL *)mInstalledVolumeInterface, &Root), EFI_SUCCESS);
+  }
+
+  //
+  // Add a file to the root directory of the image before it is mounted.
+  //
+  VOID
+  AddFile (
+    CONST CHAR8   *Name,
+    UINTN         Index,
+    CONST UINT16  *Clusters,
+    UINTN         ClusterCount
+    )
+  {
+    FAT_DIRECTORY_ENTRY  *Entry;
+    UINTN                Offset;
+
+    Entry = (FAT_DIRECTORY_ENTRY *)&Disk.Image[TEST_ROOT_POS + Index * sizeof (FAT_DIRECTORY_ENTRY)];
+    CopyMem (Entry->FileName, Name, sizeof (Entry->FileName));
+    Entry->Attributes  = FAT_ATTRIBUTE_ARCHIVE;
+    Entry->FileCluster = Clusters[0];
+    Entry->FileSize    = (UINT32)(ClusterCount * TEST_CLUSTER_SIZE);
+    for (Offset = 0; Offset < ClusterCount; Offset++) {
+      SetFatEntry (Clusters[Offset], (Offset + 1 < ClusterCount) ? Clusters[Offset + 1] : TEST_FAT12_EOC);
+      SetMem (
+        &Disk.Image[TEST_FIRST_CLUSTER_POS + (Clusters[Offset] - 2) * TEST_CLUSTER_SIZE],
+        TEST_CLUSTER_SIZE,
+        (UINT8)(Offset + 1)
+        );
+    }
+  }
+};
+
+//
+// A non-blocking write that fails to grow the file must not leave its task
+// behind, or Close() waits for it forever.
+//
+TEST_F (FatNonBlockingTest, WriteExOnFullVolumeThenClose) {
+  EFI_FILE_PROTOCOL  *File;
+  FAT_IFILE          *IFile;
+  UINT8              Data;
+
+  Mount (TRUE);
+  Status = Root->Open (Root, &File, (CHAR16 *)L"NEW.TXT", EFI_FILE_MODE_CREATE | EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE, 0);
+  ASSERT_EQ (Status, EFI_SUCCESS);
+  ASSERT_EQ (File->Revision, EFI_FILE_PROTOCOL_REVISION2);
+
+  Data             = 0x5A;
+  Token.BufferSize = sizeof (Data);
+  Token.Buffer     = &Data;
+  Status           = File->WriteEx (File, &Token);
+  EXPECT_EQ (Status, EFI_VOLUME_FULL);
+  EXPECT_EQ (gBS->CheckEvent (Token.Event), EFI_NOT_READY);
+  IFile = IFILE_FROM_FHAND (File);
+  ASSERT_TRUE (IsListEmpty (&IFile->Tasks));
+  EXPECT_TRUE (Disk.Pending.empty ());
+
+  EXPECT_EQ (File->Close (File), EFI_SUCCESS);
+}
+
+//
+// A non-blocking read whose second disk request cannot be submitted reports
+// the error through the token, once the first request no longer accesses
+// the buffer.
+//
+TEST_F (FatNonBlockingTest, ReadExSubmitErrorSignalsTokenAfterInFlightRequests) {
+  STATIC CONST UINT16  Clusters[] = { 2, 4, 6 };
+  EFI_FILE_PROTOCOL    *File;
+  FAT_IFILE            *IFile;
+  std::vector<UINT8>   Buffer (ARRAY_SIZE (Clusters) * TEST_CLUSTER_SIZE);
+
+  AddFile ("DATA    BIN", 0, Clusters, ARRAY_SIZE (Clusters));
+  Mount (FALSE);
+  Status = Root->Open (Root, &File, (CHAR16 *)L"DATA.BIN", EFI_FILE_MODE_READ, 0);
+  ASSERT_EQ (Status, EFI_SUCCESS);
+
+  Disk.FailingRequest = 2;
+  Token.BufferSize    = Buffer.size ();
+  Token.Buffer        = Buffer.data ();
+  Status              = File->ReadEx (File, &Token);
+  EXPECT_EQ (Status, EFI_SUCCESS);
+  EXPECT_EQ (Disk.SubmittedRequests, 2U);
+  EXPECT_EQ (Disk.Pending.size (), 1U);
+  EXPECT_EQ (gBS->CheckEvent (Token.Event), EFI_NOT_READY);
+
+  Disk.CompletePending ();
+  EXPECT_EQ (gBS->CheckEvent (Token.Event), EFI_SUCCESS);
+  EXPECT_EQ (Token.Status, EFI_DEVICE_ERROR);
+  EXPECT_EQ (Buffer[0], 1);
+  IFile = IFILE_FROM_FHAND (File);
+  ASSERT_TRUE (IsListEmpty (&IFile->Tasks));
+
+  EXPECT_EQ (File->Close (File), EFI_SUCCESS);
+}
+
+//
+// A non-blocking read that succeeds signals the token once all its disk
+// requests complete.
+//
+TEST_F (FatNonBlockingTest, ReadExSignalsTokenAfterAllRequests) {
+  STATIC CONST UINT16  Clusters[] = { 2, 4, 6 };
+  EFI_FILE_PROTOCOL    *File;
+  std::vector<UINT8>   Buffer (ARRAY_SIZE (Clusters) * TEST_CLUSTER_SIZE);
+
+  AddFile ("DATA    BIN", 0, Clusters, ARRAY_SIZE (Clusters));
+  Mount (FALSE);
+  Status = Root->Open (Root, &File, (CHAR16 *)L"DATA.BIN", EFI_FILE_MODE_READ, 0);
+  ASSERT_EQ (Status, EFI_SUCCESS);
+
+  Token.BufferSize = Buffer.size ();
+  Token.Buffer     = Buffer.data ();
+  Status           = File->ReadEx (File, &Token);
+  EXPECT_EQ (Status, EFI_SUCCESS);
+  EXPECT_EQ (Disk.Pending.size (), ARRAY_SIZE (Clusters));
+  EXPECT_EQ (gBS->CheckEvent (Token.Event), EFI_NOT_READY);
+
+  Disk.CompletePending ();
+  EXPECT_EQ (gBS->CheckEvent (Token.Event), EFI_SUCCESS);
+  EXPECT_EQ (Token.Status, EFI_SUCCESS);
+  EXPECT_EQ (Buffer[0], 1);
+  EXPECT_EQ (Buffer[TEST_CLUSTER_SIZE], 2);
+  EXPECT_EQ (Buffer[2 * TEST_CLUSTER_SIZE], 3);
+
+  EXPECT_EQ (File->Close (File), EFI_SUCCESS);
+}
+
+//
+// The statistics are published when the last file handle of the volume is
+// closed, so that they can be read while the volume stays mounted.
+//
+TEST_F (FatNonBlockingTest, LastClosePublishesStatistics) {
+  EFI_FILE_PROTOCOL          *File;
+  std::vector<UINT8>         Buffer (2 * TEST_CLUSTER_SIZE, 0x5A);
+  UINTN                      BufferSize;
+  FAT_FREE_SPACE_STATISTICS  Space;
+  BOOLEAN                    CachePublished;
+  BOOLEAN                    SpacePublished;
+
+  CachePublished = FALSE;
+  SpacePublished = FALSE;
+  ZeroMem (&Space, sizeof (Space));
+  EXPECT_CALL (RtServicesMock, gRT_SetVariable)
+    .WillRepeatedly (
+       Invoke (
+         [&](CHAR16 *VariableName, EFI_GUID *VendorGuid, UINT32 Attributes, UINTN DataSize, VOID *Data) {
+      EXPECT_TRUE (CompareGuid (VendorGuid, &gFatCacheStatisticsGuid));
+      EXPECT_EQ (Attributes, (UINT32)EFI_VARIABLE_BOOTSERVICE_ACCESS);
+      if (StrnCmp (VariableName, (CHAR16 *)L"FatCache", 8) == 0) {
+        EXPECT_EQ (DataSize, FAT_CACHE_STATISTICS_CACHES * sizeof (FAT_CACHE_STATISTICS));
+        CachePublished = TRUE;
+      } else if (StrnCmp (VariableName, (CHAR16 *)L"FatSpace", 8) == 0) {
+        EXPECT_EQ (DataSize, sizeof (Space));
+        CopyMem (&Space, Data, sizeof (Space));
+        SpacePublished = TRUE;
+      } else {
+        ADD_FAILURE ();
+      }
+
+      return EFI_SUCCESS;
+    }
+         )
+       );
+
+  Mount (FALSE);
+  Status = Root->Open (Root, &File, (CHAR16 *)L"NEW.TXT", EFI_FILE_MODE_CREATE | EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE, 0);
+  ASSERT_EQ (Status, EFI_SUCCESS);
+
+  BufferSize = Buffer.size ();
+  EXPECT_EQ (File->Write (File, &BufferSize, Buffer.data ()), EFI_SUCCESS);
+  EXPECT_EQ (File->Close (File), EFI_SUCCESS);
+  EXPECT_FALSE (SpacePublished);
+
+  EXPECT_EQ (Root->Close (Root), EFI_SUCCESS);
+  Root = NULL;
+  EXPECT_TRUE (CachePublished);
+  ASSERT_TRUE (SpacePublished);
+  EXPECT_EQ (Space.ClusterAllocations, 2U);
+  EXPECT_EQ (Space.ExtentAllocations, 1U);
+  EXPECT_EQ (Space.FragmentedAllocations, 0U);
+  EXPECT_GE (Space.FreeBitmapReads, 1U);
+  EXPECT_GT (Space.FreeBitmapTime, 0U);
+  EXPECT_GT (Space.AllocationTime, Space.FreeBitmapTime);
+}
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  testing::InitGoogleTest (&argc, argv);
+  return RUN_ALL_TESTS ();
+}
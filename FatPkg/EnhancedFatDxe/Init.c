@@ -56,6 +56,9 @@ FatAllocateVolume (
   Volume->VolumeInterface.OpenVolume = FatOpenVolume;
   InitializeListHead (&Volume->CheckRef);
   InitializeListHead (&Volume->DirCacheList);
+  InitializeListHead (&Volume->DiskCache[CacheData].ReadAheadList);
+  Volume->StatisticsIndex = FatCacheStatisticsIndex;
+  FatCacheStatisticsIndex = (FatCacheStatisticsIndex + 1) % FAT_CACHE_STATISTICS_VARIABLES;
   //
   // Initialize Root Directory entry
   //
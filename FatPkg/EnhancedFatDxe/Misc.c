@@ -33,8 +33,16 @@ FatCreateTask (
     Task->Signature   = FAT_TASK_SIGNATURE;
     Task->IFile       = IFile;
     Task->FileIoToken = Token;
+    Task->Status      = EFI_SUCCESS;
     InitializeListHead (&Task->Subtasks);
-    InitializeListHead (&Task->Link);
+
+    //
+    // The subtasks are submitted while the task is being built, so the blocking
+    // requests have to wait for it from the start
+    //
+    EfiAcquireLock (&FatTaskLock);
+    InsertTailList (&IFile->Tasks, &Task->Link);
+    EfiReleaseLock (&FatTaskLock);
   }
 
   return Task;
@@ -42,26 +50,49 @@ FatCreateTask (
 
 /**
 
-  Destroy the task.
+  Abort a task after an error, before it was queued.
 
-  @param  Task                  - The task to be destroyed.
+  If none of its subtasks was submitted, the task is freed and the error is
+  returned to the caller without signaling the token. Otherwise the disk may
+  still be accessing the caller's buffer: the submitted subtasks cannot be
+  canceled, so the token is kept and signaled with the error once the last
+  of them completes, and the request reports EFI_SUCCESS.
+
+  @param  Task                  - The task to be aborted.
+  @param  Status                - The error that stopped the task.
+
+  @retval EFI_SUCCESS           - The token will be signaled with Status.
+  @return Status                - The task was freed, the token is not signaled.
 
 **/
-VOID
-FatDestroyTask (
-  FAT_TASK  *Task
+EFI_STATUS
+FatAbortTask (
+  IN FAT_TASK    *Task,
+  IN EFI_STATUS  Status
   )
 {
-  LIST_ENTRY   *Link;
-  FAT_SUBTASK  *Subtask;
+  ASSERT (EFI_ERROR (Status));
 
-  Link = GetFirstNode (&Task->Subtasks);
-  while (!IsNull (&Task->Subtasks, Link)) {
-    Subtask = CR (Link, FAT_SUBTASK, Link, FAT_SUBTASK_SIGNATURE);
-    Link    = FatDestroySubtask (Subtask);
+  EfiAcquireLock (&FatTaskLock);
+  if (Task->PendingSubtask != NULL) {
+    FatDestroySubtask (Task->PendingSubtask);
+    Task->PendingSubtask = NULL;
+  }
+
+  Task->Queued = TRUE;
+  if (IsListEmpty (&Task->Subtasks)) {
+    RemoveEntryList (&Task->Link);
+    FreePool (Task);
+  } else {
+    if (!EFI_ERROR (Task->Status)) {
+      Task->Status = Status;
+    }
+
+    Status = EFI_SUCCESS;
   }
 
-  FreePool (Task);
+  EfiReleaseLock (&FatTaskLock);
+  return Status;
 }
 
 /**
@@ -111,109 +142,123 @@ FatDestroySubtask (
 
 /**
 
-  Execute the task.
+  Submit the pending subtask of the task to DiskIo2.
 
-  @param  IFile                 - The instance of the open file.
-  @param  Task                  - The task to be executed.
+  @param  Task                  - The task whose pending subtask is submitted.
 
-  @retval EFI_SUCCESS           - The task was executed successfully.
-  @return other                 - An error occurred when executing the task.
+  @retval EFI_SUCCESS           - The subtask was submitted, or there was none.
+  @return other                 - The subtask could not be submitted and was destroyed.
 
 **/
+STATIC
 EFI_STATUS
-FatQueueTask (
-  IN FAT_IFILE  *IFile,
-  IN FAT_TASK   *Task
+FatSubmitSubtask (
+  IN FAT_TASK  *Task
   )
 {
-  EFI_STATUS   Status;
-  LIST_ENTRY   *Link;
-  LIST_ENTRY   *NextLink;
-  FAT_SUBTASK  *Subtask;
+  EFI_STATUS             Status;
+  FAT_SUBTASK            *Subtask;
+  FAT_VOLUME             *Volume;
+  EFI_DISK_IO2_PROTOCOL  *DiskIo2;
 
-  //
-  // Sometimes the Task doesn't contain any subtasks, signal the event directly.
-  //
-  if (IsListEmpty (&Task->Subtasks)) {
-    Task->FileIoToken->Status = EFI_SUCCESS;
-    gBS->SignalEvent (Task->FileIoToken->Event);
-    FreePool (Task);
+  Subtask = Task->PendingSubtask;
+  if (Subtask == NULL) {
     return EFI_SUCCESS;
   }
 
-  EfiAcquireLock (&FatTaskLock);
-  InsertTailList (&IFile->Tasks, &Task->Link);
-  EfiReleaseLock (&FatTaskLock);
-
-  Status = EFI_SUCCESS;
   //
-  // Use NextLink to store the next link of the list, because Link might be remove from the
-  // doubly-linked list and get freed in the end of current loop.
+  // The subtask may complete before the call returns, it is not pending anymore
   //
-  // Also, list operation APIs like IsNull() and GetNextNode() are avoided during the loop, since
-  // they may check the validity of doubly-linked lists by traversing them. These APIs cannot
-  // handle list elements being removed during the traverse.
-  //
-  for ( Link = GetFirstNode (&Task->Subtasks), NextLink = GetNextNode (&Task->Subtasks, Link)
-        ; Link != &Task->Subtasks
-        ; Link = NextLink, NextLink = Link->ForwardLink
-        )
-  {
-    Subtask = CR (Link, FAT_SUBTASK, Link, FAT_SUBTASK_SIGNATURE);
-    if (Subtask->Write) {
-      Status = IFile->OFile->Volume->DiskIo2->WriteDiskEx (
-                                                IFile->OFile->Volume->DiskIo2,
-                                                IFile->OFile->Volume->MediaId,
-                                                Subtask->Offset,
-                                                &Subtask->DiskIo2Token,
-                                                Subtask->BufferSize,
-                                                Subtask->Buffer
-                                                );
-    } else {
-      Status = IFile->OFile->Volume->DiskIo2->ReadDiskEx (
-                                                IFile->OFile->Volume->DiskIo2,
-                                                IFile->OFile->Volume->MediaId,
-                                                Subtask->Offset,
-                                                &Subtask->DiskIo2Token,
-                                                Subtask->BufferSize,
-                                                Subtask->Buffer
-                                                );
-    }
+  Task->PendingSubtask = NULL;
+  Volume               = Task->IFile->OFile->Volume;
+  DiskIo2              = Volume->DiskIo2;
+  if (Subtask->Write) {
+    //
+    // Keep the data cache from reading ahead until the write completes
+    //
+    EfiAcquireLock (&FatTaskLock);
+    Volume->DiskCache[CacheData].PendingWrites++;
+    EfiReleaseLock (&FatTaskLock);
 
-    if (EFI_ERROR (Status)) {
-      break;
-    }
+    Status = DiskIo2->WriteDiskEx (
+                        DiskIo2,
+                        Volume->MediaId,
+                        Subtask->Offset,
+                        &Subtask->DiskIo2Token,
+                        Subtask->BufferSize,
+                        Subtask->Buffer
+                        );
+  } else {
+    Status = DiskIo2->ReadDiskEx (
+                        DiskIo2,
+                        Volume->MediaId,
+                        Subtask->Offset,
+                        &Subtask->DiskIo2Token,
+                        Subtask->BufferSize,
+                        Subtask->Buffer
+                        );
   }
 
   if (EFI_ERROR (Status)) {
     EfiAcquireLock (&FatTaskLock);
-    //
-    // Remove all the remaining subtasks when failure.
-    // We shouldn't remove all the tasks because the non-blocking requests have
-    // been submitted and cannot be canceled.
-    //
-    while (!IsNull (&Task->Subtasks, Link)) {
-      Subtask = CR (Link, FAT_SUBTASK, Link, FAT_SUBTASK_SIGNATURE);
-      Link    = FatDestroySubtask (Subtask);
-    }
-
-    if (IsListEmpty (&Task->Subtasks)) {
-      RemoveEntryList (&Task->Link);
-      FreePool (Task);
-    } else {
-      //
-      // If one or more subtasks have been already submitted, set FileIoToken
-      // to NULL so that the callback won't signal the event.
-      //
-      Task->FileIoToken = NULL;
+    if (Subtask->Write) {
+      Volume->DiskCache[CacheData].PendingWrites--;
     }
 
+    FatDestroySubtask (Subtask);
     EfiReleaseLock (&FatTaskLock);
   }
 
   return Status;
 }
 
+/**
+
+  Execute the task. Submit its last subtask and signal the token once all the
+  subtasks complete, or right away if they are done already.
+
+  @param  IFile                 - The instance of the open file.
+  @param  Task                  - The task to be executed.
+
+  @retval EFI_SUCCESS           - The task was executed successfully.
+  @return other                 - An error occurred when executing the task, see FatAbortTask().
+
+**/
+EFI_STATUS
+FatQueueTask (
+  IN FAT_IFILE  *IFile,
+  IN FAT_TASK   *Task
+  )
+{
+  EFI_STATUS  Status;
+
+  ASSERT (Task->IFile == IFile);
+
+  //
+  // The other subtasks were submitted as soon as the next one was created
+  //
+  Status = FatSubmitSubtask (Task);
+  if (EFI_ERROR (Status)) {
+    return FatAbortTask (Task, Status);
+  }
+
+  EfiAcquireLock (&FatTaskLock);
+  Task->Queued = TRUE;
+  //
+  // Sometimes the Task doesn't contain any subtasks, or they completed while the
+  // task was being built, signal the event directly.
+  //
+  if (IsListEmpty (&Task->Subtasks)) {
+    Task->FileIoToken->Status = Task->Status;
+    gBS->SignalEvent (Task->FileIoToken->Event);
+    RemoveEntryList (&Task->Link);
+    FreePool (Task);
+  }
+
+  EfiReleaseLock (&FatTaskLock);
+  return EFI_SUCCESS;
+}
+
 /**
 
   Set the volume as dirty or not.
@@ -270,31 +315,121 @@ FatOnAccessComplete (
   ASSERT (Task->Signature    == FAT_TASK_SIGNATURE);
   ASSERT (Subtask->Signature == FAT_SUBTASK_SIGNATURE);
 
+  if (Subtask->Write) {
+    Task->IFile->OFile->Volume->DiskCache[CacheData].PendingWrites--;
+  }
+
   //
   // Remove the task unconditionally
   //
   FatDestroySubtask (Subtask);
+  if (EFI_ERROR (Status) && !EFI_ERROR (Task->Status)) {
+    Task->Status = Status;
+  }
 
   //
-  // Task->FileIoToken is NULL which means the task will be ignored (just recycle the subtask and task memory).
+  // While the task is still being built, FatQueueTask() or FatAbortTask()
+  // decides how its status is reported.
   //
-  if (Task->FileIoToken != NULL) {
-    if (IsListEmpty (&Task->Subtasks) || EFI_ERROR (Status)) {
-      Task->FileIoToken->Status = Status;
-      gBS->SignalEvent (Task->FileIoToken->Event);
-      //
-      // Mark Task->FileIoToken to NULL so that the subtasks belonging to the task will be ignored.
-      //
-      Task->FileIoToken = NULL;
-    }
+  if (!Task->Queued) {
+    return;
   }
 
+  //
+  // Signal the token with the first error once the last subtask completes, so
+  // the caller doesn't reuse its buffer while the disk still accesses it.
+  //
   if (IsListEmpty (&Task->Subtasks)) {
+    Task->FileIoToken->Status = Task->Status;
+    gBS->SignalEvent (Task->FileIoToken->Event);
     RemoveEntryList (&Task->Link);
     FreePool (Task);
   }
 }
 
+/**
+
+  Add a non-blocking disk access to the task. The access is merged into the
+  pending subtask when it follows it both on the disk and in the buffer.
+  Otherwise the pending subtask is submitted, so the disk works on it while
+  the rest of the request is mapped, and the access becomes the new pending
+  subtask.
+
+  @param  Task                  - The task the access belongs to.
+  @param  IoMode                - The access mode, ReadDisk or WriteDisk.
+  @param  Offset                - The starting byte offset on the disk.
+  @param  BufferSize            - Size of Buffer.
+  @param  Buffer                - Buffer containing read data.
+
+  @retval EFI_SUCCESS           - The access was added to the task.
+  @return Others                - A subtask of the task failed, or the access could not be added.
+
+**/
+STATIC
+EFI_STATUS
+FatQueueSubtask (
+  IN     FAT_TASK  *Task,
+  IN     IO_MODE   IoMode,
+  IN     UINT64    Offset,
+  IN     UINTN     BufferSize,
+  IN OUT VOID      *Buffer
+  )
+{
+  EFI_STATUS   Status;
+  FAT_SUBTASK  *Subtask;
+
+  //
+  // Stop building the task once one of its subtasks failed
+  //
+  if (EFI_ERROR (Task->Status)) {
+    return Task->Status;
+  }
+
+  Subtask = Task->PendingSubtask;
+  if ((Subtask != NULL) &&
+      (Subtask->Write == (BOOLEAN)(IoMode == WriteDisk)) &&
+      (Subtask->Offset + Subtask->BufferSize == Offset) &&
+      ((UINT8 *)Subtask->Buffer + Subtask->BufferSize == Buffer))
+  {
+    Subtask->BufferSize += BufferSize;
+    return EFI_SUCCESS;
+  }
+
+  Status = FatSubmitSubtask (Task);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Subtask = AllocateZeroPool (sizeof (*Subtask));
+  if (Subtask == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Subtask->Signature  = FAT_SUBTASK_SIGNATURE;
+  Subtask->Task       = Task;
+  Subtask->Write      = (BOOLEAN)(IoMode == WriteDisk);
+  Subtask->Offset     = Offset;
+  Subtask->Buffer     = Buffer;
+  Subtask->BufferSize = BufferSize;
+  Status              = gBS->CreateEvent (
+                               EVT_NOTIFY_SIGNAL,
+                               TPL_NOTIFY,
+                               FatOnAccessComplete,
+                               Subtask,
+                               &Subtask->DiskIo2Token.Event
+                               );
+  if (EFI_ERROR (Status)) {
+    FreePool (Subtask);
+    return Status;
+  }
+
+  EfiAcquireLock (&FatTaskLock);
+  InsertTailList (&Task->Subtasks, &Subtask->Link);
+  EfiReleaseLock (&FatTaskLock);
+  Task->PendingSubtask = Subtask;
+  return EFI_SUCCESS;
+}
+
 /**
 
   General disk access function.
@@ -324,7 +459,6 @@ FatDiskIo (
   EFI_STATUS            Status;
   EFI_DISK_IO_PROTOCOL  *DiskIo;
   EFI_DISK_READ         IoFunction;
-  FAT_SUBTASK           *Subtask;
 
   //
   // Verify the IO is in devices range
@@ -351,29 +485,7 @@ FatDiskIo (
         //
         // Non-blocking access
         //
-        Subtask = AllocateZeroPool (sizeof (*Subtask));
-        if (Subtask == NULL) {
-          Status = EFI_OUT_OF_RESOURCES;
-        } else {
-          Subtask->Signature  = FAT_SUBTASK_SIGNATURE;
-          Subtask->Task       = Task;
-          Subtask->Write      = (BOOLEAN)(IoMode == WriteDisk);
-          Subtask->Offset     = Offset;
-          Subtask->Buffer     = Buffer;
-          Subtask->BufferSize = BufferSize;
-          Status              = gBS->CreateEvent (
-                                       EVT_NOTIFY_SIGNAL,
-                                       TPL_NOTIFY,
-                                       FatOnAccessComplete,
-                                       Subtask,
-                                       &Subtask->DiskIo2Token.Event
-                                       );
-          if (!EFI_ERROR (Status)) {
-            InsertTailList (&Task->Subtasks, &Subtask->Link);
-          } else {
-            FreePool (Subtask);
-          }
-        }
+        Status = FatQueueSubtask (Task, IoMode, Offset, BufferSize, Buffer);
       }
     }
   }
@@ -461,11 +573,27 @@ FatFreeVolume (
   IN FAT_VOLUME  *Volume
   )
 {
+  DEBUG ((
+    DEBUG_INFO,
+    "FatFreeVolume: %d FAT pages read for free bitmap in %ld ns, %d clusters allocated in %ld ns, %d contiguous and %d fragmented growths\n",
+    (UINT32)Volume->SpaceStatistics.FreeBitmapReads,
+    Volume->SpaceStatistics.FreeBitmapTime,
+    (UINT32)Volume->SpaceStatistics.ClusterAllocations,
+    Volume->SpaceStatistics.AllocationTime,
+    (UINT32)Volume->SpaceStatistics.ExtentAllocations,
+    (UINT32)Volume->SpaceStatistics.FragmentedAllocations
+    ));
+
   //
   // Free disk cache
   //
-  if (Volume->CacheBuffer != NULL) {
-    FreePool (Volume->CacheBuffer);
+  FatFreeDiskCache (Volume);
+
+  //
+  // Free free cluster bitmap
+  //
+  if (Volume->FreeBitmap != NULL) {
+    FreePool (Volume->FreeBitmap);
   }
 
   //
@@ -532,6 +660,51 @@ FatFatTimeToEfiTime (
   ETime->Daylight   = 0;
 }
 
+/**
+
+  Return the time elapsed since a value of the performance counter.
+  The performance counter may be narrower than 64 bits, so the difference is
+  taken modulo its range.
+
+  @param  StartTick             - Value of the performance counter at the start.
+
+  @return The elapsed time in nanoseconds.
+
+**/
+UINT64
+FatGetElapsedTime (
+  IN UINT64  StartTick
+  )
+{
+  UINT64  StartValue;
+  UINT64  EndValue;
+  UINT64  CurrentTick;
+  INT64   Delta;
+  INT64   Cycle;
+
+  CurrentTick = GetPerformanceCounter ();
+  GetPerformanceCounterProperties (&StartValue, &EndValue);
+  Cycle = EndValue - StartValue;
+  if (Cycle < 0) {
+    Cycle = -Cycle;
+  }
+
+  Cycle++;
+  Delta = (INT64)(CurrentTick - StartTick);
+  if (StartValue > EndValue) {
+    //
+    // The performance counter counts down
+    //
+    Delta = -Delta;
+  }
+
+  if (Delta < 0) {
+    Delta += Cycle;
+  }
+
+  return GetTimeInNanoSecond ((UINT64)Delta);
+}
+
 /**
 
   Get Current FAT time.
@@ -287,7 +287,7 @@ FatOpenEx (
     if (!EFI_ERROR (Status)) {
       Status = FatQueueTask (IFile, Task);
     } else {
-      FatDestroyTask (Task);
+      Status = FatAbortTask (Task, Status);
     }
   }
 
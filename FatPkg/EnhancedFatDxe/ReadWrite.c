@@ -314,12 +314,12 @@ FatIFileAccess (
     }
   }
 
-  if (Token != NULL) {
-    if (!EFI_ERROR (Status)) {
-      Status = FatQueueTask (IFile, Task);
-    } else {
-      FatDestroyTask (Task);
-    }
+  if ((Token != NULL) && !EFI_ERROR (Status)) {
+    //
+    // The task is freed or owned by its subtasks from now on, also on error
+    //
+    Status = FatQueueTask (IFile, Task);
+    Task   = NULL;
   }
 
 Done:
@@ -334,6 +334,13 @@ Done:
   //
   if (EFI_ERROR (Status)) {
     Status = FatCleanupVolume (Volume, OFile, Status, NULL);
+    if (Task != NULL) {
+      //
+      // Every error path, including the FatGrowEof() failure, must take the
+      // task off IFile->Tasks, or FatWaitNonblockingTask() never returns.
+      //
+      Status = FatAbortTask (Task, Status);
+    }
   }
 
   FatReleaseLock ();
@@ -0,0 +1,51 @@
+/** @file
+  Statistics of the disk caches and of the free space management of the
+  volumes mounted by the FAT driver.
+
+  They are published in volatile variables of this vendor GUID, one pair per
+  volume reused round robin, so that they can be dumped from the shell with
+  dmpstore:
+  - FatCache0000 to FatCache000F hold
+    FAT_CACHE_STATISTICS[FAT_CACHE_STATISTICS_CACHES]: the FAT cache, then the
+    data cache.
+  - FatSpace0000 to FatSpace000F hold FAT_FREE_SPACE_STATISTICS.
+
+Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __FAT_CACHE_STATISTICS_GUID_H__
+#define __FAT_CACHE_STATISTICS_GUID_H__
+
+#define FAT_CACHE_STATISTICS_GUID \
+  { 0x41d45bdb, 0xa1e3, 0x4e3f, { 0xaf, 0x20, 0x51, 0xf8, 0x52, 0xc2, 0x63, 0x49 } }
+
+#define FAT_CACHE_STATISTICS_CACHES  2
+
+///
+/// Statistics of one disk cache of a volume
+///
+typedef struct {
+  UINT64    Hits;                       // Accesses served from a cache page
+  UINT64    Misses;                     // Accesses that had to load a cache page
+  UINT64    Evictions;                  // Valid cache pages replaced by another page
+  UINT64    ReadAheadPages;             // Cache pages loaded by read ahead
+  UINT64    ReadAheadHits;              // Read ahead pages that were accessed afterwards
+} FAT_CACHE_STATISTICS;
+
+///
+/// Free space statistics of a volume
+///
+typedef struct {
+  UINT64    FreeBitmapReads;            // FAT cache pages read to build the free cluster bitmap
+  UINT64    FreeBitmapTime;             // Time spent building the free cluster bitmap, in ns
+  UINT64    ClusterAllocations;         // Clusters allocated
+  UINT64    ExtentAllocations;          // File growths given one contiguous run
+  UINT64    FragmentedAllocations;      // File growths given a shorter run
+  UINT64    AllocationTime;             // Time spent allocating the clusters of file growths, in ns
+} FAT_FREE_SPACE_STATISTICS;
+
+extern EFI_GUID  gFatCacheStatisticsGuid;
+
+#endif
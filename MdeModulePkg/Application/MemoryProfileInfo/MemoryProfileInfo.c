@@ -638,6 +638,39 @@ DumpMemoryProfileMemoryRange (
   return (VOID *)Descriptor;
 }
 
+/**
+  Dump memory profile pool slab information.
+
+  @param[in] PoolSlab           Pointer to memory profile pool slab.
+
+  @return Pointer to next memory profile pool slab.
+
+**/
+MEMORY_PROFILE_POOL_SLAB *
+DumpMemoryProfilePoolSlab (
+  IN MEMORY_PROFILE_POOL_SLAB  *PoolSlab
+  )
+{
+  if (PoolSlab->Header.Signature != MEMORY_PROFILE_POOL_SLAB_SIGNATURE) {
+    return NULL;
+  }
+
+  Print (L"MEMORY_PROFILE_POOL_SLAB\n");
+  Print (L"  Signature                     - 0x%08x\n", PoolSlab->Header.Signature);
+  Print (L"  Length                        - 0x%04x\n", PoolSlab->Header.Length);
+  Print (L"  Revision                      - 0x%04x\n", PoolSlab->Header.Revision);
+  Print (L"  MemoryType                    - 0x%08x (%a)\n", PoolSlab->MemoryType, ProfileMemoryTypeToStr ((EFI_MEMORY_TYPE)PoolSlab->MemoryType));
+  Print (L"  ObjectSize                    - 0x%08x\n", PoolSlab->ObjectSize);
+  Print (L"  SlabSize                      - 0x%016lx\n", PoolSlab->SlabSize);
+  Print (L"  SlabCount                     - 0x%016lx\n", PoolSlab->SlabCount);
+  Print (L"  ObjectCount                   - 0x%016lx\n", PoolSlab->ObjectCount);
+  Print (L"  UsedObjectCount               - 0x%016lx\n", PoolSlab->UsedObjectCount);
+  Print (L"  PeakUsedObjectCount           - 0x%016lx\n", PoolSlab->PeakUsedObjectCount);
+  Print (L"  UnusedSize                    - 0x%016lx\n", MultU64x32 (PoolSlab->ObjectCount - PoolSlab->UsedObjectCount, PoolSlab->ObjectSize));
+
+  return (MEMORY_PROFILE_POOL_SLAB *)((UINTN)PoolSlab + PoolSlab->Header.Length);
+}
+
 /**
   Scan memory profile by Signature.
 
@@ -698,6 +731,7 @@ DumpMemoryProfile (
   MEMORY_PROFILE_CONTEXT       *Context;
   MEMORY_PROFILE_FREE_MEMORY   *FreeMemory;
   MEMORY_PROFILE_MEMORY_RANGE  *MemoryRange;
+  MEMORY_PROFILE_POOL_SLAB     *PoolSlab;
 
   Context = (MEMORY_PROFILE_CONTEXT *)ScanMemoryProfileBySignature (ProfileBuffer, ProfileSize, MEMORY_PROFILE_CONTEXT_SIGNATURE);
   if (Context != NULL) {
@@ -713,6 +747,11 @@ DumpMemoryProfile (
   if (MemoryRange != NULL) {
     DumpMemoryProfileMemoryRange (MemoryRange);
   }
+
+  PoolSlab = (MEMORY_PROFILE_POOL_SLAB *)ScanMemoryProfileBySignature (ProfileBuffer, ProfileSize, MEMORY_PROFILE_POOL_SLAB_SIGNATURE);
+  while ((PoolSlab != NULL) && ((UINTN)PoolSlab < (UINTN)(ProfileBuffer + ProfileSize))) {
+    PoolSlab = DumpMemoryProfilePoolSlab (PoolSlab);
+  }
 }
 
 /**
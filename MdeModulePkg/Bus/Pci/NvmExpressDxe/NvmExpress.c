@@ -554,9 +554,125 @@ UnregisterNvmeNamespace (
   return EFI_SUCCESS;
 }
 
+/**
+  Reap the completed commands of an asynchronous I/O completion queue.
+
+  @param[in]  Private   The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+  @param[in]  QueueId   The asynchronous I/O queue pair to reap.
+
+**/
+STATIC
+VOID
+NvmeReapAsyncQueue (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private,
+  IN UINT16                        QueueId
+  )
+{
+  EFI_PCI_IO_PROTOCOL       *PciIo;
+  NVME_CQ                   *Cq;
+  UINT32                    Data;
+  LIST_ENTRY                *Link;
+  LIST_ENTRY                *NextLink;
+  NVME_PASS_THRU_ASYNC_REQ  *AsyncRequest;
+  BOOLEAN                   HasNewItem;
+
+  Cq         = Private->CqBuffer[QueueId] + Private->CqHdbl[QueueId].Cqh;
+  HasNewItem = FALSE;
+  PciIo      = Private->PciIo;
+
+  while (Cq->Pt != Private->Pt[QueueId]) {
+    ASSERT (Cq->Sqid == QueueId);
+
+    HasNewItem = TRUE;
+
+    //
+    // Find the command with given Command Id.
+    //
+    for (Link = GetFirstNode (&Private->AsyncPassThruQueue);
+         !IsNull (&Private->AsyncPassThruQueue, Link);
+         Link = NextLink)
+    {
+      NextLink     = GetNextNode (&Private->AsyncPassThruQueue, Link);
+      AsyncRequest = NVME_PASS_THRU_ASYNC_REQ_FROM_THIS (Link);
+      if ((AsyncRequest->QueueId == QueueId) && (AsyncRequest->CommandId == Cq->Cid)) {
+        //
+        // Copy the Respose Queue entry for this command to the callers
+        // response buffer.
+        //
+        CopyMem (
+          AsyncRequest->Packet->NvmeCompletion,
+          Cq,
+          sizeof (EFI_NVM_EXPRESS_COMPLETION)
+          );
+
+        //
+        // Free the resources allocated before cmd submission
+        //
+        if (AsyncRequest->MapData != NULL) {
+          PciIo->Unmap (PciIo, AsyncRequest->MapData);
+        }
+
+        if (AsyncRequest->MapMeta != NULL) {
+          PciIo->Unmap (PciIo, AsyncRequest->MapMeta);
+        }
+
+        if (AsyncRequest->MapPrpList != NULL) {
+          PciIo->Unmap (PciIo, AsyncRequest->MapPrpList);
+        }
+
+        if (AsyncRequest->PrpListHost != NULL) {
+          PciIo->FreeBuffer (
+                   PciIo,
+                   AsyncRequest->PrpListNo,
+                   AsyncRequest->PrpListHost
+                   );
+        }
+
+        if (AsyncRequest->PrpPoolPages != 0) {
+          NvmeFreePooledPrpList (Private, AsyncRequest->PrpPoolPages);
+        }
+
+        RemoveEntryList (Link);
+        gBS->SignalEvent (AsyncRequest->CallerEvent);
+        FreePool (AsyncRequest);
+
+        //
+        // Update submission queue head.
+        //
+        Private->AsyncSqHead[QueueId] = Cq->Sqhd;
+        break;
+      }
+    }
+
+    Private->CqHdbl[QueueId].Cqh++;
+    if (Private->CqHdbl[QueueId].Cqh > MIN (NVME_ASYNC_CCQ_SIZE, Private->Cap.Mqes)) {
+      Private->CqHdbl[QueueId].Cqh = 0;
+      Private->Pt[QueueId]        ^= 1;
+    }
+
+    Cq = Private->CqBuffer[QueueId] + Private->CqHdbl[QueueId].Cqh;
+  }
+
+  if (HasNewItem) {
+    Data = ReadUnaligned32 ((UINT32 *)&Private->CqHdbl[QueueId]);
+    PciIo->Mem.Write (
+                 PciIo,
+                 EfiPciIoWidthUint32,
+                 NVME_BAR,
+                 NVME_CQHDBL_OFFSET (QueueId, Private->Cap.Dstrd),
+                 1,
+                 &Data
+                 );
+  }
+}
+
 /**
   Call back function when the timer event is signaled.
 
+  It is also called with TPL raised to TPL_NOTIFY and a NULL Event to start
+  new I/O, and to reap completions while waiting for the asynchronous queues
+  to drain, without waiting for the next timer tick.
+
   @param[in]  Event     The Event this notify function registered to.
   @param[in]  Context   Pointer to the context data registered to the
                         Event.
@@ -570,27 +686,26 @@ ProcessAsyncTaskList (
   )
 {
   NVME_CONTROLLER_PRIVATE_DATA  *Private;
-  EFI_PCI_IO_PROTOCOL           *PciIo;
-  NVME_CQ                       *Cq;
-  UINT16                        QueueId;
-  UINT32                        Data;
+  UINT16                        Index;
   LIST_ENTRY                    *Link;
   LIST_ENTRY                    *NextLink;
-  NVME_PASS_THRU_ASYNC_REQ      *AsyncRequest;
   NVME_BLKIO2_SUBTASK           *Subtask;
   NVME_BLKIO2_REQUEST           *BlkIo2Request;
   EFI_BLOCK_IO2_TOKEN           *Token;
-  BOOLEAN                       HasNewItem;
   EFI_STATUS                    Status;
 
-  Private    = (NVME_CONTROLLER_PRIVATE_DATA *)Context;
-  QueueId    = 2;
-  Cq         = Private->CqBuffer[QueueId] + Private->CqHdbl[QueueId].Cqh;
-  HasNewItem = FALSE;
-  PciIo      = Private->PciIo;
+  Private = (NVME_CONTROLLER_PRIVATE_DATA *)Context;
 
   //
-  // Submit asynchronous subtasks to the NVMe Submission Queue
+  // Reap the completions first, the submission queue entries they free are
+  // refilled by the subtasks submitted below.
+  //
+  for (Index = 0; Index < Private->AsyncQueueCount; Index++) {
+    NvmeReapAsyncQueue (Private, NVME_ASYNC_QUEUE_ID + Index);
+  }
+
+  //
+  // Submit asynchronous subtasks to the NVMe Submission Queues
   //
   for (Link = GetFirstNode (&Private->UnsubmittedSubtasks);
        !IsNull (&Private->UnsubmittedSubtasks, Link);
@@ -662,87 +777,6 @@ ProcessAsyncTaskList (
       }
     }
   }
-
-  while (Cq->Pt != Private->Pt[QueueId]) {
-    ASSERT (Cq->Sqid == QueueId);
-
-    HasNewItem = TRUE;
-
-    //
-    // Find the command with given Command Id.
-    //
-    for (Link = GetFirstNode (&Private->AsyncPassThruQueue);
-         !IsNull (&Private->AsyncPassThruQueue, Link);
-         Link = NextLink)
-    {
-      NextLink     = GetNextNode (&Private->AsyncPassThruQueue, Link);
-      AsyncRequest = NVME_PASS_THRU_ASYNC_REQ_FROM_THIS (Link);
-      if (AsyncRequest->CommandId == Cq->Cid) {
-        //
-        // Copy the Respose Queue entry for this command to the callers
-        // response buffer.
-        //
-        CopyMem (
-          AsyncRequest->Packet->NvmeCompletion,
-          Cq,
-          sizeof (EFI_NVM_EXPRESS_COMPLETION)
-          );
-
-        //
-        // Free the resources allocated before cmd submission
-        //
-        if (AsyncRequest->MapData != NULL) {
-          PciIo->Unmap (PciIo, AsyncRequest->MapData);
-        }
-
-        if (AsyncRequest->MapMeta != NULL) {
-          PciIo->Unmap (PciIo, AsyncRequest->MapMeta);
-        }
-
-        if (AsyncRequest->MapPrpList != NULL) {
-          PciIo->Unmap (PciIo, AsyncRequest->MapPrpList);
-        }
-
-        if (AsyncRequest->PrpListHost != NULL) {
-          PciIo->FreeBuffer (
-                   PciIo,
-                   AsyncRequest->PrpListNo,
-                   AsyncRequest->PrpListHost
-                   );
-        }
-
-        RemoveEntryList (Link);
-        gBS->SignalEvent (AsyncRequest->CallerEvent);
-        FreePool (AsyncRequest);
-
-        //
-        // Update submission queue head.
-        //
-        Private->AsyncSqHead = Cq->Sqhd;
-        break;
-      }
-    }
-
-    Private->CqHdbl[QueueId].Cqh++;
-    if (Private->CqHdbl[QueueId].Cqh > MIN (NVME_ASYNC_CCQ_SIZE, Private->Cap.Mqes)) {
-      Private->CqHdbl[QueueId].Cqh = 0;
-      Private->Pt[QueueId]        ^= 1;
-    }
-
-    Cq = Private->CqBuffer[QueueId] + Private->CqHdbl[QueueId].Cqh;
-  }
-
-  if (HasNewItem) {
-    Data = ReadUnaligned32 ((UINT32 *)&Private->CqHdbl[QueueId]);
-    PciIo->Mem.Write (
-                 PciIo,
-                 EfiPciIoWidthUint32,
-                 NVME_BAR,
-                 NVME_CQHDBL_OFFSET (QueueId, Private->Cap.Dstrd),
-                 1,
-                 &Data
-                 );
-  }
 }
 
 /**
@@ -1029,21 +1063,22 @@ NvmExpressDriverBindingStart (
     }
 
     //
-    // 6 x 4kB aligned buffers will be carved out of this buffer.
+    // NVME_QUEUE_BUFFER_PAGES x 4kB aligned buffers will be carved out of this buffer.
     // 1st 4kB boundary is the start of the admin submission queue.
     // 2nd 4kB boundary is the start of the admin completion queue.
     // 3rd 4kB boundary is the start of I/O submission queue #1.
     // 4th 4kB boundary is the start of I/O completion queue #1.
-    // 5th 4kB boundary is the start of I/O submission queue #2.
-    // 6th 4kB boundary is the start of I/O completion queue #2.
+    // The rest holds the submission & completion queues of the asynchronous
+    // I/O queue pairs #2, #3, ...
     //
-    // Allocate 6 pages of memory, then map it for bus master read and write.
+    // Allocate NVME_QUEUE_BUFFER_PAGES pages of memory, then map it for bus
+    // master read and write.
     //
     Status = PciIo->AllocateBuffer (
                       PciIo,
                       AllocateAnyPages,
                       EfiBootServicesData,
-                      6,
+                      NVME_QUEUE_BUFFER_PAGES,
                       (VOID **)&Private->Buffer,
                       0
                       );
@@ -1051,7 +1086,7 @@ NvmExpressDriverBindingStart (
       goto Exit;
     }
 
-    Bytes  = EFI_PAGES_TO_SIZE (6);
+    Bytes  = EFI_PAGES_TO_SIZE (NVME_QUEUE_BUFFER_PAGES);
     Status = PciIo->Map (
                       PciIo,
                       EfiPciIoOperationBusMasterCommonBuffer,
@@ -1061,7 +1096,7 @@ NvmExpressDriverBindingStart (
                       &Private->Mapping
                       );
 
-    if (EFI_ERROR (Status) || (Bytes != EFI_PAGES_TO_SIZE (6))) {
+    if (EFI_ERROR (Status) || (Bytes != EFI_PAGES_TO_SIZE (NVME_QUEUE_BUFFER_PAGES))) {
       goto Exit;
     }
 
@@ -1081,6 +1116,7 @@ NvmExpressDriverBindingStart (
     CopyMem (&Private->PassThruMode, &gEfiNvmExpressPassThruMode, sizeof (EFI_NVM_EXPRESS_PASS_THRU_MODE));
     InitializeListHead (&Private->AsyncPassThruQueue);
     InitializeListHead (&Private->UnsubmittedSubtasks);
+    NvmeCreatePrpPool (Private);
 
     Status = NvmeControllerInit (Private);
     if (EFI_ERROR (Status)) {
@@ -1171,7 +1207,7 @@ Exit:
   }
 
   if ((Private != NULL) && (Private->Buffer != NULL)) {
-    PciIo->FreeBuffer (PciIo, 6, Private->Buffer);
+    PciIo->FreeBuffer (PciIo, NVME_QUEUE_BUFFER_PAGES, Private->Buffer);
   }
 
   if ((Private != NULL) && (Private->ControllerData != NULL)) {
@@ -1179,6 +1215,8 @@ Exit:
   }
 
   if (Private != NULL) {
+    NvmeDestroyPrpPool (Private);
+
     if (Private->TimerEvent != NULL) {
       gBS->CloseEvent (Private->TimerEvent);
     }
@@ -1265,7 +1303,12 @@ NvmExpressDriverBindingStop (
       // Wait for the asynchronous PassThru queue to become empty.
       //
       while (TRUE) {
-        OldTpl  = gBS->RaiseTPL (TPL_NOTIFY);
+        OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+        //
+        // Reap the completions here instead of waiting for the next timer tick.
+        //
+        ProcessAsyncTaskList (NULL, Private);
         IsEmpty = IsListEmpty (&Private->AsyncPassThruQueue) &&
                   IsListEmpty (&Private->UnsubmittedSubtasks);
         gBS->RestoreTPL (OldTpl);
@@ -1293,9 +1336,11 @@ NvmExpressDriverBindingStop (
       }
 
       if (Private->Buffer != NULL) {
-        Private->PciIo->FreeBuffer (Private->PciIo, 6, Private->Buffer);
+        Private->PciIo->FreeBuffer (Private->PciIo, NVME_QUEUE_BUFFER_PAGES, Private->Buffer);
       }
 
+      NvmeDestroyPrpPool (Private);
+
       FreePool (Private->ControllerData);
       FreePool (Private);
     }
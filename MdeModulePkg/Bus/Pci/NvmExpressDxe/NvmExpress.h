@@ -42,6 +42,7 @@
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiDriverEntryPoint.h>
 #include <Library/ReportStatusCodeLib.h>
+#include <Library/PcdLib.h>
 
 #include <Guid/NVMeEventGroup.h>
 
@@ -69,16 +70,49 @@ extern EFI_DRIVER_SUPPORTED_EFI_VERSION_PROTOCOL  gNvmExpressDriverSupportedEfiV
 
 //
 // Number of asynchronous I/O submission queue entries, which is 0-based.
-// The asynchronous I/O submission queue size is 4kB in total.
+// The asynchronous I/O submission queue size is 16kB in total.
 //
-#define NVME_ASYNC_CSQ_SIZE  63
+#define NVME_ASYNC_CSQ_SIZE  255
 //
 // Number of asynchronous I/O completion queue entries, which is 0-based.
 // The asynchronous I/O completion queue size is 4kB in total.
 //
 #define NVME_ASYNC_CCQ_SIZE  255
 
-#define NVME_MAX_QUEUES  3                              // Number of queues supported by the driver
+//
+// Number of pages used by each asynchronous I/O submission & completion queue.
+//
+#define NVME_ASYNC_CSQ_PAGES  EFI_SIZE_TO_PAGES ((NVME_ASYNC_CSQ_SIZE + 1) * sizeof (NVME_SQ))
+#define NVME_ASYNC_CCQ_PAGES  EFI_SIZE_TO_PAGES ((NVME_ASYNC_CCQ_SIZE + 1) * sizeof (NVME_CQ))
+
+#define NVME_MAX_ASYNC_QUEUES  4                            // Number of asynchronous I/O queue pairs supported by the driver
+#define NVME_MAX_QUEUES        (NVME_MAX_ASYNC_QUEUES + 2)  // Number of queues supported by the driver
+
+//
+// Queue identifier of the first asynchronous I/O queue pair.
+//
+#define NVME_ASYNC_QUEUE_ID  2
+
+//
+// Number of pages of the buffer the admin & I/O queues are carved out of.
+//
+#define NVME_QUEUE_BUFFER_PAGES  (4 + NVME_MAX_ASYNC_QUEUES * (NVME_ASYNC_CSQ_PAGES + NVME_ASYNC_CCQ_PAGES))
+
+//
+// Number of pages in the pool the PRP lists are built in. Each page holds one
+// PRP list and is tracked by one bit of PrpPoolFree.
+//
+#define NVME_PRP_POOL_PAGES  64
+
+STATIC_ASSERT (
+  (NVME_PRP_POOL_PAGES > 0) && (NVME_PRP_POOL_PAGES <= 64),
+  "NVME_PRP_POOL_PAGES must fit in the UINT64 PrpPoolFree bitmap"
+  );
+
+//
+// Set Features Feature Identifier of the Number of Queues feature.
+//
+#define NVME_FEATURE_NUMBER_OF_QUEUES  0x07
 
 //
 // FormatNVM Admin Command LBA Format (LBAF) Mask
@@ -145,13 +179,14 @@ struct _NVME_CONTROLLER_PRIVATE_DATA {
   NVME_ADMIN_CONTROLLER_DATA            *ControllerData;
 
   //
-  // 6 x 4kB aligned buffers will be carved out of this buffer.
+  // NVME_QUEUE_BUFFER_PAGES x 4kB aligned buffers will be carved out of this buffer.
   // 1st 4kB boundary is the start of the admin submission queue.
   // 2nd 4kB boundary is the start of the admin completion queue.
   // 3rd 4kB boundary is the start of I/O submission queue #1.
   // 4th 4kB boundary is the start of I/O completion queue #1.
-  // 5th 4kB boundary is the start of I/O submission queue #2.
-  // 6th 4kB boundary is the start of I/O completion queue #2.
+  // Then each asynchronous I/O queue pair #2, #3, ... takes NVME_ASYNC_CSQ_PAGES
+  // for its submission queue followed by NVME_ASYNC_CCQ_PAGES for its completion
+  // queue.
   //
   UINT8          *Buffer;
   UINT8          *BufferPciAddr;
@@ -169,7 +204,14 @@ struct _NVME_CONTROLLER_PRIVATE_DATA {
   //
   NVME_SQTDBL    SqTdbl[NVME_MAX_QUEUES];
   NVME_CQHDBL    CqHdbl[NVME_MAX_QUEUES];
-  UINT16         AsyncSqHead;
+  UINT16         AsyncSqHead[NVME_MAX_QUEUES];
+
+  //
+  // Number of asynchronous I/O queue pairs created on the controller, and the
+  // one the next asynchronous command is submitted to first.
+  //
+  UINT16         AsyncQueueCount;
+  UINT16         NextAsyncQueue;
 
   //
   // Flag to indicate internal IO queue creation.
@@ -186,6 +228,15 @@ struct _NVME_CONTROLLER_PRIVATE_DATA {
 
   VOID           *Mapping;
 
+  //
+  // PRP list pages mapped for the lifetime of the controller, PrpPoolFree has
+  // a bit set for each page that is not in use.
+  //
+  UINT8          *PrpPool;
+  UINT8          *PrpPoolPciAddr;
+  VOID           *PrpPoolMapping;
+  UINT64         PrpPoolFree;
+
   //
   // For Non-blocking operations.
   //
@@ -329,10 +380,12 @@ typedef struct {
   LIST_ENTRY                                  Link;
 
   EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET    *Packet;
+  UINT16                                      QueueId;
   UINT16                                      CommandId;
   VOID                                        *MapPrpList;
   UINTN                                       PrpListNo;
   VOID                                        *PrpListHost;
+  UINT64                                      PrpPoolPages;
   VOID                                        *MapData;
   VOID                                        *MapMeta;
   EFI_EVENT                                   CallerEvent;
@@ -759,6 +812,62 @@ NvmeDumpStatus (
   IN NVME_CQ  *Cq
   );
 
+/**
+  Allocate and map the PRP list pool of a controller. PassThru allocates the
+  PRP lists of a command on its own when the pool cannot be created or is
+  exhausted.
+
+  @param[in]  Private   The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+**/
+VOID
+NvmeCreatePrpPool (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private
+  );
+
+/**
+  Unmap and free the PRP list pool of a controller.
+
+  @param[in]  Private   The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+**/
+VOID
+NvmeDestroyPrpPool (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private
+  );
+
+/**
+  Return the pages of the PRP list pool a command used.
+
+  @param[in]  Private   The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+  @param[in]  Pages     The bit mask of the pool pages to return.
+
+**/
+VOID
+NvmeFreePooledPrpList (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private,
+  IN UINT64                        Pages
+  );
+
+/**
+  Submit the pending asynchronous subtasks and reap the completed asynchronous
+  commands of a controller.
+
+  It is the notification function of the controller's periodic timer, and it
+  is also called with TPL raised to TPL_NOTIFY and a NULL Event to start new
+  I/O without waiting for the next timer tick.
+
+  @param[in]  Event     The Event this notify function registered to.
+  @param[in]  Context   The NVME_CONTROLLER_PRIVATE_DATA of the controller.
+
+**/
+VOID
+EFIAPI
+ProcessAsyncTaskList (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  );
+
 /**
   Register the shutdown notification through the ResetNotification protocol.
 
@@ -173,7 +173,12 @@ NvmeRead (
   // Wait for the device's asynchronous I/O queue to become empty.
   //
   while (TRUE) {
-    OldTpl  = gBS->RaiseTPL (TPL_NOTIFY);
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+    //
+    // Reap the completions here instead of waiting for the next timer tick.
+    //
+    ProcessAsyncTaskList (NULL, Device->Controller);
     IsEmpty = IsListEmpty (&Device->AsyncQueue);
     gBS->RestoreTPL (OldTpl);
 
@@ -259,7 +264,12 @@ NvmeWrite (
   // Wait for the device's asynchronous I/O queue to become empty.
   //
   while (TRUE) {
-    OldTpl  = gBS->RaiseTPL (TPL_NOTIFY);
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+    //
+    // Reap the completions here instead of waiting for the next timer tick.
+    //
+    ProcessAsyncTaskList (NULL, Device->Controller);
     IsEmpty = IsListEmpty (&Device->AsyncQueue);
     gBS->RestoreTPL (OldTpl);
 
@@ -813,6 +823,14 @@ NvmeAsyncRead (
     }
   }
 
+  //
+  // Submit the subtasks right away rather than on the next tick of the
+  // controller's timer.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  ProcessAsyncTaskList (NULL, Private);
+  gBS->RestoreTPL (OldTpl);
+
   DEBUG ((
     DEBUG_BLKIO,
     "%a: Lba = 0x%08Lx, Original = 0x%08Lx, "
@@ -941,6 +959,14 @@ NvmeAsyncWrite (
     }
   }
 
+  //
+  // Submit the subtasks right away rather than on the next tick of the
+  // controller's timer.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  ProcessAsyncTaskList (NULL, Private);
+  gBS->RestoreTPL (OldTpl);
+
   DEBUG ((
     DEBUG_BLKIO,
     "%a: Lba = 0x%08Lx, Original = 0x%08Lx, "
@@ -1246,7 +1272,12 @@ NvmeBlockIoResetEx (
   // Wait for the asynchronous PassThru queue to become empty.
   //
   while (TRUE) {
-    OldTpl  = gBS->RaiseTPL (TPL_NOTIFY);
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+    //
+    // Reap the completions here instead of waiting for the next timer tick.
+    //
+    ProcessAsyncTaskList (NULL, Private);
     IsEmpty = IsListEmpty (&Private->AsyncPassThruQueue) &&
               IsListEmpty (&Private->UnsubmittedSubtasks);
     gBS->RestoreTPL (OldTpl);
@@ -1544,7 +1575,12 @@ NvmeBlockIoFlushBlocksEx (
   // Wait for the asynchronous I/O queue to become empty.
   //
   while (TRUE) {
-    OldTpl  = gBS->RaiseTPL (TPL_NOTIFY);
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+    //
+    // Reap the completions here instead of waiting for the next timer tick.
+    //
+    ProcessAsyncTaskList (NULL, Device->Controller);
     IsEmpty = IsListEmpty (&Device->AsyncQueue);
     gBS->RestoreTPL (OldTpl);
 
@@ -314,6 +314,234 @@ EXIT:
   return NULL;
 }
 
+/**
+  Allocate and map the PRP list pool of a controller. PassThru allocates the
+  PRP lists of a command on its own when the pool cannot be created or is
+  exhausted.
+
+  @param[in]  Private   The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+**/
+VOID
+NvmeCreatePrpPool (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private
+  )
+{
+  EFI_PCI_IO_PROTOCOL   *PciIo;
+  EFI_PHYSICAL_ADDRESS  PhyAddr;
+  UINTN                 Bytes;
+  EFI_STATUS            Status;
+
+  PciIo  = Private->PciIo;
+  Status = PciIo->AllocateBuffer (
+                    PciIo,
+                    AllocateAnyPages,
+                    EfiBootServicesData,
+                    NVME_PRP_POOL_PAGES,
+                    (VOID **)&Private->PrpPool,
+                    0
+                    );
+  if (EFI_ERROR (Status)) {
+    Private->PrpPool = NULL;
+    return;
+  }
+
+  Bytes  = EFI_PAGES_TO_SIZE (NVME_PRP_POOL_PAGES);
+  Status = PciIo->Map (
+                    PciIo,
+                    EfiPciIoOperationBusMasterCommonBuffer,
+                    Private->PrpPool,
+                    &Bytes,
+                    &PhyAddr,
+                    &Private->PrpPoolMapping
+                    );
+  if (EFI_ERROR (Status) || (Bytes != EFI_PAGES_TO_SIZE (NVME_PRP_POOL_PAGES))) {
+    DEBUG ((DEBUG_WARN, "NvmeCreatePrpPool: map PRP pool failure!\n"));
+    if (!EFI_ERROR (Status)) {
+      PciIo->Unmap (PciIo, Private->PrpPoolMapping);
+    }
+
+    PciIo->FreeBuffer (PciIo, NVME_PRP_POOL_PAGES, Private->PrpPool);
+    Private->PrpPool        = NULL;
+    Private->PrpPoolMapping = NULL;
+    return;
+  }
+
+  Private->PrpPoolPciAddr = (UINT8 *)(UINTN)PhyAddr;
+  Private->PrpPoolFree    = MAX_UINT64 >> (64 - NVME_PRP_POOL_PAGES);
+}
+
+/**
+  Unmap and free the PRP list pool of a controller.
+
+  @param[in]  Private   The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+**/
+VOID
+NvmeDestroyPrpPool (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private
+  )
+{
+  if (Private->PrpPool == NULL) {
+    return;
+  }
+
+  Private->PciIo->Unmap (Private->PciIo, Private->PrpPoolMapping);
+  Private->PciIo->FreeBuffer (Private->PciIo, NVME_PRP_POOL_PAGES, Private->PrpPool);
+  Private->PrpPool        = NULL;
+  Private->PrpPoolMapping = NULL;
+  Private->PrpPoolFree    = 0;
+}
+
+/**
+  Build the PRP lists of a data buffer in pages of the PRP list pool.
+
+  The PRP lists do not need to be contiguous, the last entry of each full list
+  points to the next one.
+
+  @param[in]  Private       The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+  @param[in]  PhysicalAddr  The physical base address of the data buffer.
+  @param[in]  Pages         The number of pages to be transfered.
+  @param[out] PoolPages     The bit mask of the pool pages used.
+
+  @return The PCI address of the first PRP list, or 0 if the pool does not have
+          enough free pages.
+
+**/
+STATIC
+UINT64
+NvmeCreatePooledPrpList (
+  IN  NVME_CONTROLLER_PRIVATE_DATA  *Private,
+  IN  EFI_PHYSICAL_ADDRESS          PhysicalAddr,
+  IN  UINTN                         Pages,
+  OUT UINT64                        *PoolPages
+  )
+{
+  UINTN    PrpEntryNo;
+  UINTN    PrpListNo;
+  UINTN    EntryCount;
+  UINTN    Index;
+  UINTN    Entry;
+  UINT64   Used;
+  UINT64   *PrpList;
+  UINT64   *PrevPrpList;
+  UINT64   FirstPrpList;
+  UINT64   PrpListPciAddr;
+  EFI_TPL  OldTpl;
+
+  //
+  // Each PRP list but the last one holds PrpEntryNo - 1 data pages.
+  //
+  PrpEntryNo = EFI_PAGE_SIZE / sizeof (UINT64);
+  PrpListNo  = 1;
+  if (Pages > PrpEntryNo) {
+    PrpListNo += (Pages - 2) / (PrpEntryNo - 1);
+  }
+
+  if ((Private->PrpPool == NULL) || (PrpListNo > NVME_PRP_POOL_PAGES)) {
+    return 0;
+  }
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Used   = 0;
+  for (Index = 0, EntryCount = 0; (Index < NVME_PRP_POOL_PAGES) && (EntryCount < PrpListNo); Index++) {
+    if ((Private->PrpPoolFree & LShiftU64 (1, Index)) != 0) {
+      Used |= LShiftU64 (1, Index);
+      EntryCount++;
+    }
+  }
+
+  if (EntryCount < PrpListNo) {
+    gBS->RestoreTPL (OldTpl);
+    return 0;
+  }
+
+  Private->PrpPoolFree &= ~Used;
+  gBS->RestoreTPL (OldTpl);
+
+  FirstPrpList = 0;
+  PrevPrpList  = NULL;
+  for (Index = 0; (Index < NVME_PRP_POOL_PAGES) && (Pages > 0); Index++) {
+    if ((Used & LShiftU64 (1, Index)) == 0) {
+      continue;
+    }
+
+    PrpList        = (UINT64 *)(Private->PrpPool + Index * EFI_PAGE_SIZE);
+    PrpListPciAddr = (UINT64)(UINTN)(Private->PrpPoolPciAddr + Index * EFI_PAGE_SIZE);
+    if (PrevPrpList == NULL) {
+      FirstPrpList = PrpListPciAddr;
+    } else {
+      PrevPrpList[PrpEntryNo - 1] = PrpListPciAddr;
+    }
+
+    EntryCount = (Pages > PrpEntryNo) ? PrpEntryNo - 1 : Pages;
+    for (Entry = 0; Entry < EntryCount; Entry++) {
+      PrpList[Entry] = PhysicalAddr;
+      PhysicalAddr  += EFI_PAGE_SIZE;
+    }
+
+    Pages      -= EntryCount;
+    PrevPrpList = PrpList;
+  }
+
+  *PoolPages = Used;
+  return FirstPrpList;
+}
+
+/**
+  Return the pages of the PRP list pool a command used.
+
+  @param[in]  Private   The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+  @param[in]  Pages     The bit mask of the pool pages to return.
+
+**/
+VOID
+NvmeFreePooledPrpList (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private,
+  IN UINT64                        Pages
+  )
+{
+  EFI_TPL  OldTpl;
+
+  OldTpl                = gBS->RaiseTPL (TPL_NOTIFY);
+  Private->PrpPoolFree |= Pages;
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  Check whether the data buffer of an I/O command can be described by a single
+  SGL Data Block descriptor instead of PRPs.
+
+  @param[in]  Private         The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+  @param[in]  DataAddr        The PCI address of the mapped data buffer.
+  @param[in]  TransferLength  The size of the data buffer.
+
+  @retval TRUE                The controller supports SGLs for the buffer.
+  @retval FALSE               PRPs must be used.
+
+**/
+STATIC
+BOOLEAN
+NvmeUseSgl (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private,
+  IN UINT64                        DataAddr,
+  IN UINT32                        TransferLength
+  )
+{
+  UINT32  Sgls;
+
+  Sgls = Private->ControllerData->Sgls & NVME_CTRL_SGLS_SUPPORT_MASK;
+  if (Sgls == NVME_CTRL_SGLS_SUPPORTED) {
+    return TRUE;
+  }
+
+  if (Sgls == NVME_CTRL_SGLS_SUPPORTED_DWORD) {
+    return (BOOLEAN)(((DataAddr | TransferLength) & (sizeof (UINT32) - 1)) == 0);
+  }
+
+  return FALSE;
+}
+
 /**
   Aborts the asynchronous PassThru requests.
 
@@ -396,6 +624,10 @@ AbortAsyncPassThruTasks (
                );
     }
 
+    if (AsyncRequest->PrpPoolPages != 0) {
+      NvmeFreePooledPrpList (Private, AsyncRequest->PrpPoolPages);
+    }
+
     RemoveEntryList (Link);
     gBS->SignalEvent (AsyncRequest->CallerEvent);
     FreePool (AsyncRequest);
@@ -463,6 +695,7 @@ NvmExpressPassThru (
   volatile NVME_CQ               *Cq;
   UINT16                         QueueId;
   UINT16                         QueueSize;
+  UINT16                         Index;
   UINT32                         Bytes;
   UINT16                         Offset;
   EFI_EVENT                      TimerEvent;
@@ -475,6 +708,8 @@ NvmExpressPassThru (
   UINT64                         *Prp;
   VOID                           *PrpListHost;
   UINTN                          PrpListNo;
+  UINT64                         PrpPoolPages;
+  NVME_SGL_DESCRIPTOR            *Sgl;
   UINT32                         Attributes;
   UINT32                         IoAlign;
   UINT32                         MaxTransLen;
@@ -544,16 +779,17 @@ NvmExpressPassThru (
     }
   }
 
-  PciIo       = Private->PciIo;
-  MapData     = NULL;
-  MapMeta     = NULL;
-  MapPrpList  = NULL;
-  PrpListHost = NULL;
-  PrpListNo   = 0;
-  Prp         = NULL;
-  TimerEvent  = NULL;
-  Status      = EFI_SUCCESS;
-  QueueSize   = MIN (NVME_ASYNC_CSQ_SIZE, Private->Cap.Mqes) + 1;
+  PciIo        = Private->PciIo;
+  MapData      = NULL;
+  MapMeta      = NULL;
+  MapPrpList   = NULL;
+  PrpListHost  = NULL;
+  PrpListNo    = 0;
+  PrpPoolPages = 0;
+  Prp          = NULL;
+  TimerEvent   = NULL;
+  Status       = EFI_SUCCESS;
+  QueueSize    = MIN (NVME_ASYNC_CSQ_SIZE, Private->Cap.Mqes) + 1;
 
   if (Packet->QueueType == NVME_ADMIN_QUEUE) {
     QueueId = 0;
@@ -561,16 +797,28 @@ NvmExpressPassThru (
     if (Event == NULL) {
       QueueId = 1;
     } else {
-      QueueId = 2;
+      //
+      // Spread the non-blocking commands over the asynchronous I/O queues,
+      // skipping the full ones.
+      //
+      QueueId = NVME_ASYNC_QUEUE_ID;
+      for (Index = 0; Index < Private->AsyncQueueCount; Index++) {
+        QueueId = NVME_ASYNC_QUEUE_ID + (Private->NextAsyncQueue + Index) % Private->AsyncQueueCount;
+        if ((Private->SqTdbl[QueueId].Sqt + 1) % QueueSize !=
+            Private->AsyncSqHead[QueueId])
+        {
+          break;
+        }
+      }
 
       //
       // Submission queue full check.
       //
-      if ((Private->SqTdbl[QueueId].Sqt + 1) % QueueSize ==
-          Private->AsyncSqHead)
-      {
+      if (Index == Private->AsyncQueueCount) {
         return EFI_NOT_READY;
       }
+
+      Private->NextAsyncQueue = (QueueId - NVME_ASYNC_QUEUE_ID + 1) % Private->AsyncQueueCount;
     }
   }
 
@@ -587,15 +835,6 @@ NvmExpressPassThru (
   Sq->Cid  = Private->Cid[QueueId]++;
   Sq->Nsid = Packet->NvmeCmd->Nsid;
 
-  //
-  // Currently we only support PRP for data transfer, SGL is NOT supported.
-  //
-  ASSERT (Sq->Psdt == 0);
-  if (Sq->Psdt != 0) {
-    DEBUG ((DEBUG_ERROR, "NvmExpressPassThru: doesn't support SGL mechanism\n"));
-    return EFI_UNSUPPORTED;
-  }
-
   Sq->Prp[0] = (UINT64)(UINTN)Packet->TransferBuffer;
   if ((Packet->QueueType == NVME_ADMIN_QUEUE) &&
       ((Sq->Opc == NVME_ADMIN_CRIOCQ_CMD) || (Sq->Opc == NVME_ADMIN_CRIOSQ_CMD)))
@@ -669,24 +908,40 @@ NvmExpressPassThru (
   }
 
   //
-  // If the buffer size spans more than two memory pages (page size as defined in CC.Mps),
-  // then build a PRP list in the second PRP submission queue entry.
+  // If the controller supports SGLs, describe the mapped data buffer of an I/O
+  // command with a single Data Block descriptor, no PRP list is needed.
+  // Otherwise, if the buffer size spans more than two memory pages (page size
+  // as defined in CC.Mps), then build a PRP list in the second PRP submission
+  // queue entry.
   //
   Offset = ((UINT16)Sq->Prp[0]) & (EFI_PAGE_SIZE - 1);
   Bytes  = Packet->TransferLength;
 
-  if ((Offset + Bytes) > (EFI_PAGE_SIZE * 2)) {
+  if ((Packet->QueueType == NVME_IO_QUEUE) && (MapData != NULL) &&
+      NvmeUseSgl (Private, Sq->Prp[0], Bytes))
+  {
+    Sgl          = (NVME_SGL_DESCRIPTOR *)Sq->Prp;
+    Sgl->Address = Sq->Prp[0];
+    Sgl->Length  = Bytes;
+    Sgl->SubType = 0;
+    Sgl->Type    = NVME_SGL_TYPE_DATA_BLOCK;
+    Sq->Psdt     = NVME_PSDT_SGL_MPTR;
+  } else if ((Offset + Bytes) > (EFI_PAGE_SIZE * 2)) {
     //
-    // Create PrpList for remaining data buffer.
+    // Build the PrpList for remaining data buffer in the PRP list pool, or
+    // create it if the pool is exhausted.
     //
-    PhyAddr = (Sq->Prp[0] + EFI_PAGE_SIZE) & ~(EFI_PAGE_SIZE - 1);
-    Prp     = NvmeCreatePrpList (PciIo, PhyAddr, EFI_SIZE_TO_PAGES (Offset + Bytes) - 1, &PrpListHost, &PrpListNo, &MapPrpList);
-    if (Prp == NULL) {
-      Status = EFI_OUT_OF_RESOURCES;
-      goto EXIT;
-    }
+    PhyAddr    = (Sq->Prp[0] + EFI_PAGE_SIZE) & ~(EFI_PAGE_SIZE - 1);
+    Sq->Prp[1] = NvmeCreatePooledPrpList (Private, PhyAddr, EFI_SIZE_TO_PAGES (Offset + Bytes) - 1, &PrpPoolPages);
+    if (Sq->Prp[1] == 0) {
+      Prp = NvmeCreatePrpList (PciIo, PhyAddr, EFI_SIZE_TO_PAGES (Offset + Bytes) - 1, &PrpListHost, &PrpListNo, &MapPrpList);
+      if (Prp == NULL) {
+        Status = EFI_OUT_OF_RESOURCES;
+        goto EXIT;
+      }
 
-    Sq->Prp[1] = (UINT64)(UINTN)Prp;
+      Sq->Prp[1] = (UINT64)(UINTN)Prp;
+    }
   } else if ((Offset + Bytes) > EFI_PAGE_SIZE) {
     Sq->Prp[1] = (Sq->Prp[0] + EFI_PAGE_SIZE) & ~(EFI_PAGE_SIZE - 1);
   }
@@ -758,15 +1013,17 @@ NvmExpressPassThru (
       goto EXIT;
     }
 
-    AsyncRequest->Signature   = NVME_PASS_THRU_ASYNC_REQ_SIG;
-    AsyncRequest->Packet      = Packet;
-    AsyncRequest->CommandId   = Sq->Cid;
-    AsyncRequest->CallerEvent = Event;
-    AsyncRequest->MapData     = MapData;
-    AsyncRequest->MapMeta     = MapMeta;
-    AsyncRequest->MapPrpList  = MapPrpList;
-    AsyncRequest->PrpListNo   = PrpListNo;
-    AsyncRequest->PrpListHost = PrpListHost;
+    AsyncRequest->Signature    = NVME_PASS_THRU_ASYNC_REQ_SIG;
+    AsyncRequest->Packet       = Packet;
+    AsyncRequest->QueueId      = QueueId;
+    AsyncRequest->CommandId    = Sq->Cid;
+    AsyncRequest->CallerEvent  = Event;
+    AsyncRequest->MapData      = MapData;
+    AsyncRequest->MapMeta      = MapMeta;
+    AsyncRequest->MapPrpList   = MapPrpList;
+    AsyncRequest->PrpListNo    = PrpListNo;
+    AsyncRequest->PrpListHost  = PrpListHost;
+    AsyncRequest->PrpPoolPages = PrpPoolPages;
 
     OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
     InsertTailList (&Private->AsyncPassThruQueue, &AsyncRequest->Link);
@@ -918,6 +1175,10 @@ EXIT:
     PciIo->FreeBuffer (PciIo, PrpListNo, PrpListHost);
   }
 
+  if (PrpPoolPages != 0) {
+    NvmeFreePooledPrpList (Private, PrpPoolPages);
+  }
+
   if (TimerEvent != NULL) {
     gBS->CloseEvent (TimerEvent);
   }
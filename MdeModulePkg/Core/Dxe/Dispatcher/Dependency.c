@@ -11,6 +11,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 **/
 
 #include "DxeMain.h"
+#include "Hand/Handle.h"
 
 //
 // Global stack used to evaluate dependency expressions
@@ -431,3 +432,156 @@ CoreIsSchedulable (
 Done:
   return FALSE;
 }
+
+/**
+  Compile the Depex of DriverEntry into the dispatch graph. A waiter is linked
+  on the protocol entry of every protocol GUID the Depex pushes, so that an
+  install of one of those protocols marks DriverEntry for evaluation.
+
+  @param  DriverEntry           DriverEntry element to compile the Depex of.
+
+**/
+VOID
+CoreBuildDepexWaiters (
+  IN  EFI_CORE_DRIVER_ENTRY  *DriverEntry
+  )
+{
+  UINT8                  *Iterator;
+  UINT8                  *End;
+  EFI_GUID               ProtocolGuid;
+  PROTOCOL_ENTRY         *ProtEntry;
+  EFI_CORE_DEPEX_WAITER  *Waiter;
+
+  //
+  // The driver is evaluated at least once with its new Depex
+  //
+  DriverEntry->DepexStale = TRUE;
+
+  if (DriverEntry->Depex == NULL) {
+    //
+    // A NULL Depex waits on all the Architectural Protocols, it is evaluated
+    // on every pass until they are all available.
+    //
+    DriverEntry->DepexUntracked = TRUE;
+    return;
+  }
+
+  if (DriverEntry->Before || DriverEntry->After) {
+    //
+    // Scheduled by CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter ()
+    //
+    return;
+  }
+
+  Iterator = DriverEntry->Depex;
+  End      = Iterator + DriverEntry->DepexSize;
+
+  CoreAcquireProtocolLock ();
+
+  while ((Iterator < End) && (*Iterator != EFI_DEP_END)) {
+    if ((*Iterator == EFI_DEP_PUSH) || (*Iterator == EFI_DEP_REPLACE_TRUE)) {
+      if ((UINTN)(End - Iterator) < 1 + sizeof (EFI_GUID)) {
+        //
+        // Malformed Depex, CoreIsSchedulable () rejects it
+        //
+        break;
+      }
+
+      if (*Iterator == EFI_DEP_PUSH) {
+        CopyMem (&ProtocolGuid, Iterator + 1, sizeof (EFI_GUID));
+        ProtEntry = CoreFindProtocolEntry (&ProtocolGuid, TRUE);
+        Waiter    = AllocateZeroPool (sizeof (EFI_CORE_DEPEX_WAITER));
+        if ((ProtEntry == NULL) || (Waiter == NULL)) {
+          //
+          // Fall back to evaluating the Depex on every pass
+          //
+          if (Waiter != NULL) {
+            CoreFreePool (Waiter);
+          }
+
+          DriverEntry->DepexUntracked = TRUE;
+          break;
+        }
+
+        Waiter->Signature   = EFI_CORE_DEPEX_WAITER_SIGNATURE;
+        Waiter->DriverEntry = DriverEntry;
+        CopyGuid (&Waiter->ProtocolGuid, &ProtocolGuid);
+        if (!IsListEmpty (&ProtEntry->Protocols)) {
+          //
+          // Already installed when the driver was discovered
+          //
+          Waiter->Satisfied     = TRUE;
+          Waiter->SatisfiedTime = DriverEntry->DiscoveredTime;
+        }
+
+        InsertTailList (&ProtEntry->DepexWaiters, &Waiter->Link);
+        InsertTailList (&DriverEntry->DepexWaiters, &Waiter->DriverLink);
+      }
+
+      Iterator += sizeof (EFI_GUID);
+    }
+
+    Iterator++;
+  }
+
+  CoreReleaseProtocolLock ();
+}
+
+/**
+  Unlink the waiters of DriverEntry from the protocol entries once the driver
+  is scheduled. The waiters stay on DriverEntry->DepexWaiters to describe the
+  dispatch graph.
+
+  @param  DriverEntry           DriverEntry element being scheduled.
+
+**/
+VOID
+CoreReleaseDepexWaiters (
+  IN  EFI_CORE_DRIVER_ENTRY  *DriverEntry
+  )
+{
+  LIST_ENTRY             *Link;
+  EFI_CORE_DEPEX_WAITER  *Waiter;
+
+  CoreAcquireProtocolLock ();
+
+  for (Link = DriverEntry->DepexWaiters.ForwardLink; Link != &DriverEntry->DepexWaiters; Link = Link->ForwardLink) {
+    Waiter = CR (Link, EFI_CORE_DEPEX_WAITER, DriverLink, EFI_CORE_DEPEX_WAITER_SIGNATURE);
+    RemoveEntryList (&Waiter->Link);
+    InitializeListHead (&Waiter->Link);
+  }
+
+  CoreReleaseProtocolLock ();
+}
+
+/**
+  Mark for evaluation every driver waiting on a protocol that has just been
+  installed. Called with the protocol database lock held.
+
+  @param  WaiterList            The DepexWaiters list of the protocol entry.
+
+**/
+VOID
+CoreWakeDepexWaiters (
+  IN  LIST_ENTRY  *WaiterList
+  )
+{
+  LIST_ENTRY             *Link;
+  EFI_CORE_DEPEX_WAITER  *Waiter;
+  UINT64                 Now;
+
+  if (IsListEmpty (WaiterList)) {
+    return;
+  }
+
+  Now = CoreGetDispatchTimestamp ();
+  for (Link = WaiterList->ForwardLink; Link != WaiterList; Link = Link->ForwardLink) {
+    Waiter = CR (Link, EFI_CORE_DEPEX_WAITER, Link, EFI_CORE_DEPEX_WAITER_SIGNATURE);
+    Waiter->DriverEntry->DepexStale = TRUE;
+    if (!Waiter->Satisfied) {
+      Waiter->Satisfied     = TRUE;
+      Waiter->SatisfiedTime = Now;
+      Waiter->Producer      = gDispatchingDriver;
+    }
+  }
+}
@@ -60,6 +60,12 @@ EFI_LOCK  mDispatcherLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL);
 //
 BOOLEAN  gDispatcherRunning = FALSE;
 
+//
+// Driver being started by the DXE Dispatcher, used to record which driver
+// installed the protocols that the dependency expressions wait on.
+//
+EFI_CORE_DRIVER_ENTRY  *gDispatchingDriver = NULL;
+
 //
 // Module globals to manage the FwVol registration notification event
 //
@@ -219,6 +225,33 @@ CoreReleaseDispatcherLock (
   CoreReleaseLock (&mDispatcherLock);
 }
 
+/**
+  Return the current value of the timer used to timestamp the dispatch graph.
+
+  @return The CPU timer value, or 0 if the CPU Architectural Protocol is not
+          available yet.
+
+**/
+UINT64
+CoreGetDispatchTimestamp (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  UINT64      TimerValue;
+
+  if (gCpu == NULL) {
+    return 0;
+  }
+
+  Status = gCpu->GetTimerValue (gCpu, 0, &TimerValue, NULL);
+  if (EFI_ERROR (Status)) {
+    return 0;
+  }
+
+  return TimerValue;
+}
+
 /**
   Read Depex and pre-process the Depex for Before and After. If Section Extraction
   protocol returns an error via ReadSection defer the reading of the Depex.
@@ -269,6 +302,7 @@ CoreGetDepexSectionAndPreProccess (
       DriverEntry->Depex              = NULL;
       DriverEntry->Dependent          = TRUE;
       DriverEntry->DepexProtocolError = FALSE;
+      CoreBuildDepexWaiters (DriverEntry);
     }
   } else {
     //
@@ -277,6 +311,7 @@ CoreGetDepexSectionAndPreProccess (
     //
     CorePreProcessDepex (DriverEntry);
     DriverEntry->DepexProtocolError = FALSE;
+    CoreBuildDepexWaiters (DriverEntry);
   }
 
   return Status;
@@ -321,6 +356,7 @@ CoreSchedule (
       CoreAcquireDispatcherLock ();
       DriverEntry->Unrequested = FALSE;
       DriverEntry->Dependent   = TRUE;
+      DriverEntry->DepexStale  = TRUE;
       CoreReleaseDispatcherLock ();
 
       DEBUG ((DEBUG_DISPATCH, "Schedule FFS(%g) - EFI_SUCCESS\n", DriverName));
@@ -444,6 +480,12 @@ CoreDispatcher (
                       EFI_CORE_DRIVER_ENTRY_SIGNATURE
                       );
 
+      //
+      // Decompress the drivers queued behind this one on the APs while it is
+      // loaded and started.
+      //
+      CorePrefetchScheduledImages (&mScheduledQueue);
+
       //
       // Load the DXE Driver image into memory. If the Driver was transitioned from
       // Untrused to Scheduled it would have already been loaded so we may need to
@@ -459,6 +501,7 @@ CoreDispatcher (
                    0,
                    &DriverEntry->ImageHandle
                    );
+        CoreReleaseImagePrefetch (DriverEntry);
 
         //
         // Update the driver state to reflect that it's been loaded
@@ -501,6 +544,9 @@ CoreDispatcher (
 
       CoreReleaseDispatcherLock ();
 
+      gDispatchingDriver     = DriverEntry;
+      DriverEntry->StartTime = CoreGetDispatchTimestamp ();
+
       if (DriverEntry->IsFvImage) {
         //
         // Produce a firmware volume block protocol for FvImage so it gets dispatched from.
@@ -525,6 +571,9 @@ CoreDispatcher (
           );
       }
 
+      DriverEntry->EndTime = CoreGetDispatchTimestamp ();
+      gDispatchingDriver   = NULL;
+
       ReturnStatus = EFI_SUCCESS;
     }
 
@@ -552,6 +601,15 @@ CoreDispatcher (
       }
 
       if (DriverEntry->Dependent) {
+        if (!DriverEntry->DepexStale) {
+          //
+          // None of the protocols the Depex waits on has been installed since
+          // it was last evaluated, so the result cannot have changed.
+          //
+          continue;
+        }
+
+        DriverEntry->DepexStale = DriverEntry->DepexUntracked;
         if (CoreIsSchedulable (DriverEntry)) {
           CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter (DriverEntry);
           ReadyToRun = TRUE;
@@ -566,6 +624,11 @@ CoreDispatcher (
     }
   } while (ReadyToRun);
 
+  //
+  // Free the sections prefetched for drivers that were never loaded
+  //
+  CoreReleaseImagePrefetch (NULL);
+
   //
   // Close DXE dispatch Event
   //
@@ -617,13 +680,19 @@ CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter (
     }
   }
 
+  //
+  // The driver no longer waits on any protocol
+  //
+  CoreReleaseDepexWaiters (InsertedDriverEntry);
+
   //
   // Convert driver from Dependent to Scheduled state
   //
   CoreAcquireDispatcherLock ();
 
-  InsertedDriverEntry->Dependent = FALSE;
-  InsertedDriverEntry->Scheduled = TRUE;
+  InsertedDriverEntry->Dependent     = FALSE;
+  InsertedDriverEntry->Scheduled     = TRUE;
+  InsertedDriverEntry->ScheduledTime = CoreGetDispatchTimestamp ();
   InsertTailList (&mScheduledQueue, &InsertedDriverEntry->ScheduledLink);
 
   CoreReleaseDispatcherLock ();
@@ -877,6 +946,8 @@ CoreAddToDriverList (
   DriverEntry->FvHandle         = FvHandle;
   DriverEntry->Fv               = Fv;
   DriverEntry->FvFileDevicePath = CoreFvToDevicePath (Fv, FvHandle, DriverName);
+  DriverEntry->DiscoveredTime   = CoreGetDispatchTimestamp ();
+  InitializeListHead (&DriverEntry->DepexWaiters);
 
   CoreGetDepexSectionAndPreProccess (DriverEntry);
 
@@ -1482,3 +1553,124 @@ CoreDisplayDiscoveredNotDispatched (
     }
   }
 }
+
+/**
+  Convert a dispatch graph timestamp into microseconds since Base.
+
+  @param  Timestamp             Timestamp to convert, 0 if it was not recorded.
+  @param  Base                  Timestamp of the first discovered driver.
+  @param  TimerPeriod           Period of the CPU timer in femtoseconds.
+
+  @return Microseconds elapsed between Base and Timestamp.
+
+**/
+UINT64
+CoreDispatchTimestampToMicroseconds (
+  IN UINT64  Timestamp,
+  IN UINT64  Base,
+  IN UINT64  TimerPeriod
+  )
+{
+  if ((Timestamp == 0) || (Timestamp < Base)) {
+    return 0;
+  }
+
+  return DivU64x64Remainder (MultU64x64 (Timestamp - Base, TimerPeriod), 1000000000, NULL);
+}
+
+/**
+  Display the dispatch graph: for every dispatched driver the time it was
+  discovered, scheduled, started and returned, and for every protocol its
+  Depex waited on the time the protocol was installed and by which driver.
+  Only used in Debug Builds.
+
+**/
+VOID
+CoreDumpDispatchGraph (
+  VOID
+  )
+{
+  EFI_STATUS             Status;
+  LIST_ENTRY             *Link;
+  LIST_ENTRY             *WaiterLink;
+  EFI_CORE_DRIVER_ENTRY  *DriverEntry;
+  EFI_CORE_DEPEX_WAITER  *Waiter;
+  EFI_CORE_DEPEX_WAITER  *LastWaiter;
+  UINT64                 TimerValue;
+  UINT64                 TimerPeriod;
+  UINT64                 Base;
+
+  TimerPeriod = 0;
+  if (gCpu != NULL) {
+    Status = gCpu->GetTimerValue (gCpu, 0, &TimerValue, &TimerPeriod);
+    if (EFI_ERROR (Status)) {
+      TimerPeriod = 0;
+    }
+  }
+
+  Base = MAX_UINT64;
+  for (Link = mDiscoveredList.ForwardLink; Link != &mDiscoveredList; Link = Link->ForwardLink) {
+    DriverEntry = CR (Link, EFI_CORE_DRIVER_ENTRY, Link, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+    if ((DriverEntry->DiscoveredTime != 0) && (DriverEntry->DiscoveredTime < Base)) {
+      Base = DriverEntry->DiscoveredTime;
+    }
+  }
+
+  DEBUG ((DEBUG_INFO, "DXE dispatch graph (us since first discovered driver):\n"));
+  for (Link = mDiscoveredList.ForwardLink; Link != &mDiscoveredList; Link = Link->ForwardLink) {
+    DriverEntry = CR (Link, EFI_CORE_DRIVER_ENTRY, Link, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+    if (DriverEntry->Initialized) {
+      DEBUG ((
+        DEBUG_INFO,
+        "FFS(%g) discovered %ld scheduled %ld start %ld end %ld\n",
+        &DriverEntry->FileName,
+        CoreDispatchTimestampToMicroseconds (DriverEntry->DiscoveredTime, Base, TimerPeriod),
+        CoreDispatchTimestampToMicroseconds (DriverEntry->ScheduledTime, Base, TimerPeriod),
+        CoreDispatchTimestampToMicroseconds (DriverEntry->StartTime, Base, TimerPeriod),
+        CoreDispatchTimestampToMicroseconds (DriverEntry->EndTime, Base, TimerPeriod)
+        ));
+    } else {
+      DEBUG ((
+        DEBUG_INFO,
+        "FFS(%g) discovered %ld not dispatched\n",
+        &DriverEntry->FileName,
+        CoreDispatchTimestampToMicroseconds (DriverEntry->DiscoveredTime, Base, TimerPeriod)
+        ));
+    }
+
+    //
+    // The protocol installed last is the edge of the critical path into this driver
+    //
+    LastWaiter = NULL;
+    for (WaiterLink = DriverEntry->DepexWaiters.ForwardLink; WaiterLink != &DriverEntry->DepexWaiters; WaiterLink = WaiterLink->ForwardLink) {
+      Waiter = CR (WaiterLink, EFI_CORE_DEPEX_WAITER, DriverLink, EFI_CORE_DEPEX_WAITER_SIGNATURE);
+      if (Waiter->Satisfied && ((LastWaiter == NULL) || (Waiter->SatisfiedTime > LastWaiter->SatisfiedTime))) {
+        LastWaiter = Waiter;
+      }
+    }
+
+    for (WaiterLink = DriverEntry->DepexWaiters.ForwardLink; WaiterLink != &DriverEntry->DepexWaiters; WaiterLink = WaiterLink->ForwardLink) {
+      Waiter = CR (WaiterLink, EFI_CORE_DEPEX_WAITER, DriverLink, EFI_CORE_DEPEX_WAITER_SIGNATURE);
+      if (!Waiter->Satisfied) {
+        DEBUG ((DEBUG_INFO, "    GUID(%g) not installed\n", &Waiter->ProtocolGuid));
+      } else if (Waiter->Producer == NULL) {
+        DEBUG ((
+          DEBUG_INFO,
+          "  %a GUID(%g) installed %ld outside of dispatch\n",
+          (Waiter == LastWaiter) ? "*" : " ",
+          &Waiter->ProtocolGuid,
+          CoreDispatchTimestampToMicroseconds (Waiter->SatisfiedTime, Base, TimerPeriod)
+          ));
+      } else {
+        DEBUG ((
+          DEBUG_INFO,
+          "  %a GUID(%g) installed %ld by FFS(%g)\n",
+          (Waiter == LastWaiter) ? "*" : " ",
+          &Waiter->ProtocolGuid,
+          CoreDispatchTimestampToMicroseconds (Waiter->SatisfiedTime, Base, TimerPeriod),
+          &Waiter->Producer->FileName
+          ));
+      }
+    }
+  }
+}
@@ -0,0 +1,739 @@
+/** @file
+  DXE Dispatcher image prefetch.
+
+  While the DXE Dispatcher loads and starts the driver at the head of the
+  mScheduledQueue, the compressed sections of the drivers queued behind it are
+  decompressed on the Application Processors through the MP Services Protocol.
+  When the section extraction code later opens one of those sections, it takes
+  the decompressed stream instead of decompressing the section again on the BSP.
+  If the AP has not finished yet, the BSP does not wait for it and decompresses
+  the section itself.
+
+  Only the decompression runs on the APs, and only with decoders known to work
+  on the buffers the BSP allocated without calling any UEFI or library service
+  that is not MP safe: the EFI standard decompression and the LZMA GUIDed
+  sections. Standard compression sections are only prefetched while the
+  Decompress Protocol is the DXE Core's own, which uses the same decoder. Any
+  other section is decoded on the BSP as before. Reading the FV, relocating,
+  and authenticating the images, and calling their entry points, still happen
+  on the BSP one driver at a time in mScheduledQueue order.
+
+Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "DxeMain.h"
+
+#define IMAGE_PREFETCH_SIGNATURE  SIGNATURE_32('i','p','f','t')
+
+///
+/// A compressed section of a scheduled driver that is decompressed on an AP.
+///
+typedef struct {
+  UINTN                        Signature;
+  LIST_ENTRY                   Link;          // mImagePrefetchList
+  EFI_CORE_DRIVER_ENTRY        *DriverEntry;
+  ///
+  /// Copy of the FFS file read from the FV, Section points into it
+  ///
+  VOID                         *FileBuffer;
+  EFI_COMMON_SECTION_HEADER    *Section;
+  UINTN                        SectionSize;
+  VOID                         *OutputBuffer;
+  UINT32                       OutputSize;
+  VOID                         *ScratchBuffer;
+  UINT32                       AuthenticationStatus;
+  ///
+  /// Written by the AP, Done is set last
+  ///
+  EFI_STATUS                   Status;
+  volatile BOOLEAN             Done;
+} IMAGE_PREFETCH;
+
+///
+/// An AP used to decompress prefetched sections
+///
+typedef struct {
+  UINTN        ProcessorNumber;
+  EFI_EVENT    Event;
+  BOOLEAN      Busy;
+} IMAGE_PREFETCH_AP;
+
+//
+// Prefetched sections, list of IMAGE_PREFETCH. It is accessed by the
+// dispatcher and by the section extraction code, which may run from an event
+// notification function, so it is protected by a lock.
+//
+LIST_ENTRY  mImagePrefetchList = INITIALIZE_LIST_HEAD_VARIABLE (mImagePrefetchList);
+EFI_LOCK    mImagePrefetchLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL);
+
+//
+// Prefetched sections that are not needed any more but that an AP may still
+// be decompressing. They are freed once the AP is done, instead of waiting for
+// it. Protected by mImagePrefetchLock.
+//
+LIST_ENTRY  mImagePrefetchRetiredList = INITIALIZE_LIST_HEAD_VARIABLE (mImagePrefetchRetiredList);
+
+//
+// The driver being loaded by the dispatcher. Only its prefetched sections can
+// be taken by the section extraction code.
+//
+EFI_CORE_DRIVER_ENTRY  *mImagePrefetchDriver = NULL;
+
+//
+// APs available for prefetching, initialized once the MP Services Protocol
+// is installed.
+//
+EFI_MP_SERVICES_PROTOCOL  *mImagePrefetchMpServices = NULL;
+IMAGE_PREFETCH_AP         *mImagePrefetchAps        = NULL;
+UINTN                     mImagePrefetchApCount     = 0;
+
+//
+// GUIDed sections decoded on an AP. LzmaCustomDecompressLib handles them: it
+// allocates from the scratch buffer and calls no boot service. Other handlers,
+// such as the signed section or crypto extractors, allocate memory and print
+// debug messages, so their sections stay on the BSP.
+//
+EFI_GUID  *mImagePrefetchGuids[] = {
+  &gLzmaCustomDecompressGuid,
+  &gLzmaF86CustomDecompressGuid
+};
+
+/**
+  Locate the MP Services Protocol and collect the enabled APs.
+
+  @retval TRUE                  At least one AP can be used for prefetching.
+  @retval FALSE                 No AP is available.
+
+**/
+BOOLEAN
+CoreInitializeImagePrefetch (
+  VOID
+  )
+{
+  EFI_STATUS                 Status;
+  UINTN                      NumberOfProcessors;
+  UINTN                      NumberOfEnabledProcessors;
+  UINTN                      BspNumber;
+  UINTN                      Index;
+  EFI_PROCESSOR_INFORMATION  ProcessorInfo;
+  IMAGE_PREFETCH_AP          *Ap;
+
+  if (mImagePrefetchMpServices != NULL) {
+    return (BOOLEAN)(mImagePrefetchApCount != 0);
+  }
+
+  Status = CoreLocateProtocol (&gEfiMpServiceProtocolGuid, NULL, (VOID **)&mImagePrefetchMpServices);
+  if (EFI_ERROR (Status)) {
+    mImagePrefetchMpServices = NULL;
+    return FALSE;
+  }
+
+  Status = mImagePrefetchMpServices->GetNumberOfProcessors (
+                                       mImagePrefetchMpServices,
+                                       &NumberOfProcessors,
+                                       &NumberOfEnabledProcessors
+                                       );
+  if (EFI_ERROR (Status) || (NumberOfEnabledProcessors < 2)) {
+    return FALSE;
+  }
+
+  Status = mImagePrefetchMpServices->WhoAmI (mImagePrefetchMpServices, &BspNumber);
+  if (EFI_ERROR (Status)) {
+    return FALSE;
+  }
+
+  mImagePrefetchAps = AllocateZeroPool (NumberOfProcessors * sizeof (IMAGE_PREFETCH_AP));
+  if (mImagePrefetchAps == NULL) {
+    return FALSE;
+  }
+
+  for (Index = 0; Index < NumberOfProcessors; Index++) {
+    if (Index == BspNumber) {
+      continue;
+    }
+
+    Status = mImagePrefetchMpServices->GetProcessorInfo (mImagePrefetchMpServices, Index, &ProcessorInfo);
+    if (EFI_ERROR (Status) ||
+        ((ProcessorInfo.StatusFlag & (PROCESSOR_ENABLED_BIT | PROCESSOR_HEALTH_STATUS_BIT)) !=
+         (PROCESSOR_ENABLED_BIT | PROCESSOR_HEALTH_STATUS_BIT)))
+    {
+      continue;
+    }
+
+    Ap     = &mImagePrefetchAps[mImagePrefetchApCount];
+    Status = CoreCreateEvent (0, TPL_CALLBACK, NULL, NULL, &Ap->Event);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    Ap->ProcessorNumber = Index;
+    mImagePrefetchApCount++;
+  }
+
+  DEBUG ((DEBUG_DISPATCH, "Image prefetch uses %d APs\n", (UINT32)mImagePrefetchApCount));
+
+  return (BOOLEAN)(mImagePrefetchApCount != 0);
+}
+
+/**
+  AP procedure that decompresses a prefetched section into the buffers the BSP
+  allocated for it. It must not call any UEFI service or print debug messages.
+
+  @param  Buffer                The IMAGE_PREFETCH to decompress.
+
+**/
+VOID
+EFIAPI
+CoreImagePrefetchDecode (
+  IN OUT VOID  *Buffer
+  )
+{
+  IMAGE_PREFETCH  *Prefetch;
+  VOID            *OutputBuffer;
+  EFI_STATUS      Status;
+
+  Prefetch = (IMAGE_PREFETCH *)Buffer;
+
+  if (Prefetch->Section->Type == EFI_SECTION_COMPRESSION) {
+    if (IS_SECTION2 (Prefetch->Section)) {
+      Status = UefiDecompress (
+                 (UINT8 *)Prefetch->Section + sizeof (EFI_COMPRESSION_SECTION2),
+                 Prefetch->OutputBuffer,
+                 Prefetch->ScratchBuffer
+                 );
+    } else {
+      Status = UefiDecompress (
+                 (UINT8 *)Prefetch->Section + sizeof (EFI_COMPRESSION_SECTION),
+                 Prefetch->OutputBuffer,
+                 Prefetch->ScratchBuffer
+                 );
+    }
+  } else {
+    OutputBuffer = Prefetch->OutputBuffer;
+    Status       = ExtractGuidedSectionDecode (
+                     Prefetch->Section,
+                     &OutputBuffer,
+                     Prefetch->ScratchBuffer,
+                     &Prefetch->AuthenticationStatus
+                     );
+    if (!EFI_ERROR (Status) && (OutputBuffer != Prefetch->OutputBuffer)) {
+      //
+      // Same as CustomGuidedSectionExtract (), the caller expects the data in
+      // the buffer it allocated.
+      //
+      CopyMem (Prefetch->OutputBuffer, OutputBuffer, Prefetch->OutputSize);
+    }
+  }
+
+  Prefetch->Status = Status;
+  MemoryFence ();
+  Prefetch->Done = TRUE;
+}
+
+/**
+  Free a prefetched section. The AP must be done with it.
+
+  @param  Prefetch              The IMAGE_PREFETCH to free.
+  @param  FreeOutput            TRUE to also free the decompressed data.
+
+**/
+VOID
+CoreFreeImagePrefetch (
+  IN IMAGE_PREFETCH  *Prefetch,
+  IN BOOLEAN         FreeOutput
+  )
+{
+  if (FreeOutput && (Prefetch->OutputBuffer != NULL)) {
+    CoreFreePool (Prefetch->OutputBuffer);
+  }
+
+  if (Prefetch->ScratchBuffer != NULL) {
+    CoreFreePool (Prefetch->ScratchBuffer);
+  }
+
+  CoreFreePool (Prefetch->FileBuffer);
+  CoreFreePool (Prefetch);
+}
+
+/**
+  Free a prefetched section that is not needed any more. If the AP is still
+  decompressing it, it is freed later by CoreReapImagePrefetch().
+
+  @param  Prefetch              The IMAGE_PREFETCH to free, not on any list.
+
+**/
+VOID
+CoreRetireImagePrefetch (
+  IN IMAGE_PREFETCH  *Prefetch
+  )
+{
+  if (Prefetch->Done) {
+    MemoryFence ();
+    CoreFreeImagePrefetch (Prefetch, TRUE);
+    return;
+  }
+
+  CoreAcquireLock (&mImagePrefetchLock);
+  InsertTailList (&mImagePrefetchRetiredList, &Prefetch->Link);
+  CoreReleaseLock (&mImagePrefetchLock);
+}
+
+/**
+  Free the retired prefetched sections the APs are done with.
+
+**/
+VOID
+CoreReapImagePrefetch (
+  VOID
+  )
+{
+  LIST_ENTRY      *Link;
+  IMAGE_PREFETCH  *Prefetch;
+
+  do {
+    Prefetch = NULL;
+
+    CoreAcquireLock (&mImagePrefetchLock);
+    for (Link = mImagePrefetchRetiredList.ForwardLink; Link != &mImagePrefetchRetiredList; Link = Link->ForwardLink) {
+      Prefetch = CR (Link, IMAGE_PREFETCH, Link, IMAGE_PREFETCH_SIGNATURE);
+      if (Prefetch->Done) {
+        RemoveEntryList (&Prefetch->Link);
+        break;
+      }
+
+      Prefetch = NULL;
+    }
+
+    CoreReleaseLock (&mImagePrefetchLock);
+
+    if (Prefetch != NULL) {
+      MemoryFence ();
+      CoreFreeImagePrefetch (Prefetch, TRUE);
+    }
+  } while (Prefetch != NULL);
+}
+
+/**
+  Find the first section of an FFS file that can be decompressed on an AP.
+
+  @param  FileBuffer            The content of the FFS file.
+  @param  FileSize              The size of FileBuffer.
+  @param  Decompress            TRUE if standard compression sections can be
+                                decompressed on an AP.
+  @param  SectionSize           Return the size of the section found.
+
+  @return The section header, or NULL if the file has no such section.
+
+**/
+EFI_COMMON_SECTION_HEADER *
+CoreFindPrefetchSection (
+  IN  VOID     *FileBuffer,
+  IN  UINTN    FileSize,
+  IN  BOOLEAN  Decompress,
+  OUT UINTN    *SectionSize
+  )
+{
+  EFI_COMMON_SECTION_HEADER  *Section;
+  UINTN                      Offset;
+  UINTN                      Size;
+  UINTN                      HeaderSize;
+  UINT8                      CompressionType;
+  EFI_GUID                   *SectionGuid;
+  UINTN                      Index;
+
+  Offset = 0;
+  while (Offset + sizeof (EFI_COMMON_SECTION_HEADER) <= FileSize) {
+    Section = (EFI_COMMON_SECTION_HEADER *)((UINT8 *)FileBuffer + Offset);
+    if (IS_SECTION2 (Section)) {
+      if (Offset + sizeof (EFI_COMMON_SECTION_HEADER2) > FileSize) {
+        break;
+      }
+
+      Size = SECTION2_SIZE (Section);
+    } else {
+      Size = SECTION_SIZE (Section);
+    }
+
+    if ((Size < sizeof (EFI_COMMON_SECTION_HEADER)) || (Size > FileSize - Offset)) {
+      break;
+    }
+
+    if (Section->Type == EFI_SECTION_COMPRESSION) {
+      HeaderSize      = IS_SECTION2 (Section) ? sizeof (EFI_COMPRESSION_SECTION2) : sizeof (EFI_COMPRESSION_SECTION);
+      CompressionType = IS_SECTION2 (Section) ? ((EFI_COMPRESSION_SECTION2 *)Section)->CompressionType :
+                        ((EFI_COMPRESSION_SECTION *)Section)->CompressionType;
+      if (Decompress && (Size > HeaderSize) && (CompressionType == EFI_STANDARD_COMPRESSION)) {
+        *SectionSize = Size;
+        return Section;
+      }
+    } else if (Section->Type == EFI_SECTION_GUID_DEFINED) {
+      HeaderSize  = IS_SECTION2 (Section) ? sizeof (EFI_GUID_DEFINED_SECTION2) : sizeof (EFI_GUID_DEFINED_SECTION);
+      SectionGuid = IS_SECTION2 (Section) ? &((EFI_GUID_DEFINED_SECTION2 *)Section)->SectionDefinitionGuid :
+                    &((EFI_GUID_DEFINED_SECTION *)Section)->SectionDefinitionGuid;
+      if (Size > HeaderSize) {
+        for (Index = 0; Index < ARRAY_SIZE (mImagePrefetchGuids); Index++) {
+          if (CompareGuid (SectionGuid, mImagePrefetchGuids[Index])) {
+            *SectionSize = Size;
+            return Section;
+          }
+        }
+      }
+    }
+
+    Offset += ALIGN_VALUE (Size, 4);
+  }
+
+  return NULL;
+}
+
+/**
+  Read a scheduled driver from its FV and start decompressing its first
+  compressed section on an AP.
+
+  @param  DriverEntry           The scheduled driver.
+  @param  Ap                    An idle AP.
+  @param  Decompress            TRUE if standard compression sections can be
+                                decompressed on an AP.
+
+  @retval TRUE                  The section is being decompressed on Ap.
+  @retval FALSE                 Nothing was submitted to Ap.
+
+**/
+BOOLEAN
+CoreSubmitImagePrefetch (
+  IN EFI_CORE_DRIVER_ENTRY  *DriverEntry,
+  IN IMAGE_PREFETCH_AP      *Ap,
+  IN BOOLEAN                Decompress
+  )
+{
+  EFI_STATUS              Status;
+  IMAGE_PREFETCH          *Prefetch;
+  EFI_FV_FILETYPE         FoundType;
+  EFI_FV_FILE_ATTRIBUTES  FileAttributes;
+  UINTN                   FileSize;
+  UINT32                  AuthenticationStatus;
+  UINT32                  ScratchSize;
+  UINT32                  UncompressedLength;
+  UINT16                  SectionAttribute;
+  UINTN                   HeaderSize;
+
+  Prefetch = AllocateZeroPool (sizeof (IMAGE_PREFETCH));
+  if (Prefetch == NULL) {
+    return FALSE;
+  }
+
+  Prefetch->Signature   = IMAGE_PREFETCH_SIGNATURE;
+  Prefetch->DriverEntry = DriverEntry;
+
+  Status = DriverEntry->Fv->ReadFile (
+                              DriverEntry->Fv,
+                              &DriverEntry->FileName,
+                              &Prefetch->FileBuffer,
+                              &FileSize,
+                              &FoundType,
+                              &FileAttributes,
+                              &AuthenticationStatus
+                              );
+  if (EFI_ERROR (Status)) {
+    CoreFreePool (Prefetch);
+    return FALSE;
+  }
+
+  Prefetch->Section = CoreFindPrefetchSection (Prefetch->FileBuffer, FileSize, Decompress, &Prefetch->SectionSize);
+  if (Prefetch->Section == NULL) {
+    CoreFreeImagePrefetch (Prefetch, TRUE);
+    return FALSE;
+  }
+
+  //
+  // Size the buffers the same way the section extraction code does
+  //
+  ScratchSize = 0;
+  if (Prefetch->Section->Type == EFI_SECTION_COMPRESSION) {
+    if (IS_SECTION2 (Prefetch->Section)) {
+      HeaderSize         = sizeof (EFI_COMPRESSION_SECTION2);
+      UncompressedLength = ((EFI_COMPRESSION_SECTION2 *)Prefetch->Section)->UncompressedLength;
+    } else {
+      HeaderSize         = sizeof (EFI_COMPRESSION_SECTION);
+      UncompressedLength = ((EFI_COMPRESSION_SECTION *)Prefetch->Section)->UncompressedLength;
+    }
+
+    Status = UefiDecompressGetInfo (
+               (UINT8 *)Prefetch->Section + HeaderSize,
+               (UINT32)(Prefetch->SectionSize - HeaderSize),
+               &Prefetch->OutputSize,
+               &ScratchSize
+               );
+    if (!EFI_ERROR (Status) && ((Prefetch->OutputSize != UncompressedLength) || (UncompressedLength == 0))) {
+      Status = EFI_BAD_BUFFER_SIZE;
+    }
+  } else {
+    Status = ExtractGuidedSectionGetInfo (
+               Prefetch->Section,
+               &Prefetch->OutputSize,
+               &ScratchSize,
+               &SectionAttribute
+               );
+    if (!EFI_ERROR (Status) && (Prefetch->OutputSize == 0)) {
+      Status = EFI_BAD_BUFFER_SIZE;
+    }
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Prefetch->OutputBuffer = AllocatePool (Prefetch->OutputSize);
+    if (ScratchSize > 0) {
+      Prefetch->ScratchBuffer = AllocatePool (ScratchSize);
+    }
+
+    if ((Prefetch->OutputBuffer == NULL) || ((ScratchSize > 0) && (Prefetch->ScratchBuffer == NULL))) {
+      Status = EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  if (EFI_ERROR (Status)) {
+    CoreFreeImagePrefetch (Prefetch, TRUE);
+    return FALSE;
+  }
+
+  CoreAcquireLock (&mImagePrefetchLock);
+  InsertTailList (&mImagePrefetchList, &Prefetch->Link);
+  CoreReleaseLock (&mImagePrefetchLock);
+
+  Status = mImagePrefetchMpServices->StartupThisAP (
+                                       mImagePrefetchMpServices,
+                                       CoreImagePrefetchDecode,
+                                       Ap->ProcessorNumber,
+                                       Ap->Event,
+                                       0,
+                                       Prefetch,
+                                       NULL
+                                       );
+  if (EFI_ERROR (Status)) {
+    CoreAcquireLock (&mImagePrefetchLock);
+    RemoveEntryList (&Prefetch->Link);
+    CoreReleaseLock (&mImagePrefetchLock);
+    CoreFreeImagePrefetch (Prefetch, TRUE);
+    return FALSE;
+  }
+
+  Ap->Busy = TRUE;
+  return TRUE;
+}
+
+/**
+  Start decompressing the drivers queued behind the head of the scheduled
+  queue on the idle APs, up to PcdDxeImagePrefetchCount drivers ahead.
+
+  The head of the queue is the driver the dispatcher loads next. Until
+  CoreReleaseImagePrefetch() is called, the section extraction code can take
+  its prefetched sections.
+
+  @param  ScheduledQueue        The queue of drivers ready to dispatch.
+
+**/
+VOID
+CorePrefetchScheduledImages (
+  IN LIST_ENTRY  *ScheduledQueue
+  )
+{
+  LIST_ENTRY               *Link;
+  EFI_CORE_DRIVER_ENTRY    *DriverEntry;
+  UINTN                    Depth;
+  UINTN                    Index;
+  IMAGE_PREFETCH_AP        *Ap;
+  EFI_DECOMPRESS_PROTOCOL  *Decompress;
+
+  if ((PcdGet32 (PcdDxeImagePrefetchCount) == 0) || !CoreInitializeImagePrefetch ()) {
+    return;
+  }
+
+  //
+  // The APs decompress with the same library as the DXE Core's own Decompress
+  // Protocol. If a platform installed another one, the section extraction code
+  // uses it, so standard compression sections are not prefetched.
+  //
+  if (EFI_ERROR (CoreLocateProtocol (&gEfiDecompressProtocolGuid, NULL, (VOID **)&Decompress))) {
+    Decompress = NULL;
+  }
+
+  mImagePrefetchDriver = CR (GetFirstNode (ScheduledQueue), EFI_CORE_DRIVER_ENTRY, ScheduledLink, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+  CoreReapImagePrefetch ();
+
+  //
+  // Reclaim the APs that have finished their section
+  //
+  for (Index = 0; Index < mImagePrefetchApCount; Index++) {
+    if (mImagePrefetchAps[Index].Busy && !EFI_ERROR (CoreCheckEvent (mImagePrefetchAps[Index].Event))) {
+      mImagePrefetchAps[Index].Busy = FALSE;
+    }
+  }
+
+  //
+  // The head of the queue is loaded right away, so start with the next one
+  //
+  Index = 0;
+  Depth = 0;
+  Link  = GetFirstNode (ScheduledQueue)->ForwardLink;
+  for ( ; (Link != ScheduledQueue) && (Depth < PcdGet32 (PcdDxeImagePrefetchCount)); Link = Link->ForwardLink) {
+    DriverEntry = CR (Link, EFI_CORE_DRIVER_ENTRY, ScheduledLink, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+    Depth++;
+    if (DriverEntry->Prefetched || DriverEntry->IsFvImage || (DriverEntry->ImageHandle != NULL)) {
+      continue;
+    }
+
+    while ((Index < mImagePrefetchApCount) && mImagePrefetchAps[Index].Busy) {
+      Index++;
+    }
+
+    if (Index == mImagePrefetchApCount) {
+      break;
+    }
+
+    Ap                      = &mImagePrefetchAps[Index];
+    DriverEntry->Prefetched = TRUE;
+    if (CoreSubmitImagePrefetch (DriverEntry, Ap, (BOOLEAN)(Decompress == &gEfiDecompress))) {
+      DEBUG ((DEBUG_DISPATCH, "Prefetch FFS(%g) on AP %d\n", &DriverEntry->FileName, (UINT32)Ap->ProcessorNumber));
+    }
+  }
+}
+
+/**
+  Free the prefetched sections of a driver that have not been used by the
+  section extraction code, once the driver has been loaded. A section an AP
+  is still decompressing is freed later, once the AP is done with it.
+
+  @param  DriverEntry           The driver to release the prefetched sections
+                                of, or NULL to release all of them.
+
+**/
+VOID
+CoreReleaseImagePrefetch (
+  IN EFI_CORE_DRIVER_ENTRY  *DriverEntry OPTIONAL
+  )
+{
+  LIST_ENTRY      *Link;
+  IMAGE_PREFETCH  *Prefetch;
+
+  mImagePrefetchDriver = NULL;
+
+  do {
+    Prefetch = NULL;
+
+    CoreAcquireLock (&mImagePrefetchLock);
+    for (Link = mImagePrefetchList.ForwardLink; Link != &mImagePrefetchList; Link = Link->ForwardLink) {
+      Prefetch = CR (Link, IMAGE_PREFETCH, Link, IMAGE_PREFETCH_SIGNATURE);
+      if ((DriverEntry == NULL) || (Prefetch->DriverEntry == DriverEntry)) {
+        RemoveEntryList (&Prefetch->Link);
+        break;
+      }
+
+      Prefetch = NULL;
+    }
+
+    CoreReleaseLock (&mImagePrefetchLock);
+
+    if (Prefetch != NULL) {
+      CoreRetireImagePrefetch (Prefetch);
+    }
+  } while (Prefetch != NULL);
+
+  CoreReapImagePrefetch ();
+}
+
+/**
+  Take the decompressed content of an encapsulation section if the DXE
+  Dispatcher has prefetched it. Called by the section extraction code before
+  it decompresses a section.
+
+  @param  Section               The compression or GUIDed section to decompress.
+  @param  OutputBuffer          Return the decompressed data, allocated from pool.
+  @param  OutputSize            Return the size of the decompressed data.
+  @param  AuthenticationStatus  Return the authentication status reported by
+                                the GUIDed section handler.
+
+  @retval TRUE                  The section was prefetched, the caller owns
+                                *OutputBuffer.
+  @retval FALSE                 The section must be decompressed by the caller.
+
+**/
+BOOLEAN
+CoreTakePrefetchedSection (
+  IN  CONST VOID  *Section,
+  OUT VOID        **OutputBuffer,
+  OUT UINTN       *OutputSize,
+  OUT UINT32      *AuthenticationStatus
+  )
+{
+  LIST_ENTRY      *Link;
+  IMAGE_PREFETCH  *Prefetch;
+  UINTN           SectionSize;
+
+  if ((mImagePrefetchDriver == NULL) || IsListEmpty (&mImagePrefetchList)) {
+    return FALSE;
+  }
+
+  if (IS_SECTION2 (Section)) {
+    SectionSize = SECTION2_SIZE (Section);
+  } else {
+    SectionSize = SECTION_SIZE (Section);
+  }
+
+  //
+  // The section extraction code works on its own copy of the file, so the
+  // section is looked up by the driver being loaded and by its size. It is
+  // taken off the list while its content is compared outside the lock.
+  //
+  CoreAcquireLock (&mImagePrefetchLock);
+  for (Link = mImagePrefetchList.ForwardLink; Link != &mImagePrefetchList; Link = Link->ForwardLink) {
+    Prefetch = CR (Link, IMAGE_PREFETCH, Link, IMAGE_PREFETCH_SIGNATURE);
+    if ((Prefetch->DriverEntry == mImagePrefetchDriver) && (Prefetch->SectionSize == SectionSize)) {
+      RemoveEntryList (&Prefetch->Link);
+      break;
+    }
+  }
+
+  CoreReleaseLock (&mImagePrefetchLock);
+
+  if (Link == &mImagePrefetchList) {
+    return FALSE;
+  }
+
+  //
+  // The file may have other sections of the same size, such as a second
+  // compressed section, or the same section nested in another one. Only the
+  // same content gives the same decompressed data. Comparing it is much
+  // cheaper than decompressing it. On a mismatch the prefetched section stays
+  // on the list for the section it was decompressed from.
+  //
+  if (CompareMem (Prefetch->Section, Section, SectionSize) != 0) {
+    CoreAcquireLock (&mImagePrefetchLock);
+    InsertTailList (&mImagePrefetchList, &Prefetch->Link);
+    CoreReleaseLock (&mImagePrefetchLock);
+    return FALSE;
+  }
+
+  //
+  // Don't wait for an AP that is still decompressing the section: it has no
+  // time limit, and the BSP may be running at any TPL. The caller decompresses
+  // the section itself, and the AP's copy is freed once it is done.
+  //
+  if (!Prefetch->Done) {
+    CoreRetireImagePrefetch (Prefetch);
+    return FALSE;
+  }
+
+  MemoryFence ();
+  if (EFI_ERROR (Prefetch->Status)) {
+    CoreFreeImagePrefetch (Prefetch, TRUE);
+    return FALSE;
+  }
+
+  *OutputBuffer         = Prefetch->OutputBuffer;
+  *OutputSize           = Prefetch->OutputSize;
+  *AuthenticationStatus = Prefetch->AuthenticationStatus;
+  CoreFreeImagePrefetch (Prefetch, FALSE);
+
+  return TRUE;
+}
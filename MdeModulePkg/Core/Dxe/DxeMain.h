@@ -45,6 +45,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Protocol/HiiPackageList.h>
 #include <Protocol/SmmBase2.h>
 #include <Protocol/PeCoffImageEmulator.h>
+#include <Protocol/MpService.h>
 #include <Guid/MemoryTypeInformation.h>
 #include <Guid/FirmwareFileSystem2.h>
 #include <Guid/FirmwareFileSystem3.h>
@@ -84,7 +85,6 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/DxeServicesLib.h>
 #include <Library/DebugAgentLib.h>
 #include <Library/CpuExceptionHandlerLib.h>
-#include <Library/OrderedCollectionLib.h>
 
 //
 // attributes for reserved memory before it is promoted to system memory
@@ -134,7 +134,7 @@ typedef struct {
 } KNOWN_HANDLE;
 
 #define EFI_CORE_DRIVER_ENTRY_SIGNATURE  SIGNATURE_32('d','r','v','r')
-typedef struct {
+typedef struct _EFI_CORE_DRIVER_ENTRY {
   UINTN                            Signature;
   LIST_ENTRY                       Link;            // mDriverList
 
@@ -161,23 +161,79 @@ typedef struct {
 
   EFI_HANDLE                       ImageHandle;
   BOOLEAN                          IsFvImage;
+  ///
+  /// TRUE once the dispatcher has tried to prefetch the image on an AP
+  ///
+  BOOLEAN                          Prefetched;
+
+  ///
+  /// TRUE if a protocol the Depex pushes has been installed since the Depex
+  /// was last evaluated, so the dispatcher must evaluate it again.
+  ///
+  BOOLEAN                          DepexStale;
+  ///
+  /// TRUE if the Depex is not covered by the dispatch graph (no Depex, or the
+  /// waiters could not be allocated) and must be evaluated on every pass.
+  ///
+  BOOLEAN                          DepexUntracked;
+  ///
+  /// List of EFI_CORE_DEPEX_WAITER, one for each protocol pushed by the Depex
+  ///
+  LIST_ENTRY                       DepexWaiters;
+
+  ///
+  /// Timestamps of the dispatch of the driver, in CPU timer ticks
+  ///
+  UINT64                           DiscoveredTime;
+  UINT64                           ScheduledTime;
+  UINT64                           StartTime;
+  UINT64                           EndTime;
 } EFI_CORE_DRIVER_ENTRY;
 
+//
+// An edge of the dispatch graph: the driver DriverEntry has a Depex that
+// pushes ProtocolGuid. While the driver is waiting to be scheduled the
+// waiter is also linked on the protocol entry of ProtocolGuid, so that an
+// install of that protocol only marks the drivers that depend on it for
+// evaluation.
+//
+#define EFI_CORE_DEPEX_WAITER_SIGNATURE  SIGNATURE_32('d','p','x','w')
+typedef struct {
+  UINTN                            Signature;
+  LIST_ENTRY                       Link;            // PROTOCOL_ENTRY.DepexWaiters
+  LIST_ENTRY                       DriverLink;      // EFI_CORE_DRIVER_ENTRY.DepexWaiters
+  EFI_GUID                         ProtocolGuid;
+  EFI_CORE_DRIVER_ENTRY            *DriverEntry;
+  ///
+  /// Driver that was being started when ProtocolGuid was first installed,
+  /// or NULL if it was installed outside of the start of a driver.
+  ///
+  EFI_CORE_DRIVER_ENTRY            *Producer;
+  BOOLEAN                          Satisfied;
+  UINT64                           SatisfiedTime;
+} EFI_CORE_DEPEX_WAITER;
+
 //
 // The data structure of GCD memory map entry
 //
 #define EFI_GCD_MAP_SIGNATURE  SIGNATURE_32('g','c','d','m')
-typedef struct {
-  UINTN                   Signature;
-  LIST_ENTRY              Link;
-  EFI_PHYSICAL_ADDRESS    BaseAddress;
-  UINT64                  EndAddress;
-  UINT64                  Capabilities;
-  UINT64                  Attributes;
-  EFI_GCD_MEMORY_TYPE     GcdMemoryType;
-  EFI_GCD_IO_TYPE         GcdIoType;
-  EFI_HANDLE              ImageHandle;
-  EFI_HANDLE              DeviceHandle;
+typedef struct _EFI_GCD_MAP_ENTRY {
+  UINTN                        Signature;
+  LIST_ENTRY                   Link;
+  EFI_PHYSICAL_ADDRESS         BaseAddress;
+  UINT64                       EndAddress;
+  UINT64                       Capabilities;
+  UINT64                       Attributes;
+  EFI_GCD_MEMORY_TYPE          GcdMemoryType;
+  EFI_GCD_IO_TYPE              GcdIoType;
+  EFI_HANDLE                   ImageHandle;
+  EFI_HANDLE                   DeviceHandle;
+  ///
+  /// Node of the AVL tree that indexes the GCD map on BaseAddress
+  ///
+  struct _EFI_GCD_MAP_ENTRY    *Left;
+  struct _EFI_GCD_MAP_ENTRY    *Right;
+  UINTN                        Height;
 } EFI_GCD_MAP_ENTRY;
 
 #define LOADED_IMAGE_PRIVATE_DATA_SIGNATURE  SIGNATURE_32('l','d','r','i')
@@ -259,6 +315,7 @@ extern EFI_LOADED_IMAGE_PROTOCOL  *gDxeCoreLoadedImage;
 extern EFI_MEMORY_TYPE_INFORMATION  gMemoryTypeInformation[EfiMaxMemoryType + 1];
 
 extern BOOLEAN                    gDispatcherRunning;
+extern EFI_CORE_DRIVER_ENTRY      *gDispatchingDriver;
 extern EFI_RUNTIME_ARCH_PROTOCOL  gRuntimeTemplate;
 
 extern BOOLEAN  gMemoryAttributesTableForwardCfi;
@@ -484,6 +541,106 @@ CorePreProcessDepex (
   IN  EFI_CORE_DRIVER_ENTRY  *DriverEntry
   );
 
+/**
+  Compile the Depex of DriverEntry into the dispatch graph. A waiter is linked
+  on the protocol entry of every protocol GUID the Depex pushes, so that an
+  install of one of those protocols marks DriverEntry for evaluation.
+
+  @param  DriverEntry           DriverEntry element to compile the Depex of.
+
+**/
+VOID
+CoreBuildDepexWaiters (
+  IN  EFI_CORE_DRIVER_ENTRY  *DriverEntry
+  );
+
+/**
+  Unlink the waiters of DriverEntry from the protocol entries once the driver
+  is scheduled. The waiters stay on DriverEntry->DepexWaiters to describe the
+  dispatch graph.
+
+  @param  DriverEntry           DriverEntry element being scheduled.
+
+**/
+VOID
+CoreReleaseDepexWaiters (
+  IN  EFI_CORE_DRIVER_ENTRY  *DriverEntry
+  );
+
+/**
+  Mark for evaluation every driver waiting on a protocol that has just been
+  installed. Called with the protocol database lock held.
+
+  @param  WaiterList            The DepexWaiters list of the protocol entry.
+
+**/
+VOID
+CoreWakeDepexWaiters (
+  IN  LIST_ENTRY  *WaiterList
+  );
+
+/**
+  Return the current value of the timer used to timestamp the dispatch graph.
+
+  @return The CPU timer value, or 0 if the CPU Architectural Protocol is not
+          available yet.
+
+**/
+UINT64
+CoreGetDispatchTimestamp (
+  VOID
+  );
+
+/**
+  Start decompressing the drivers queued behind the head of the scheduled
+  queue on the idle APs, up to PcdDxeImagePrefetchCount drivers ahead.
+
+  @param  ScheduledQueue        The queue of drivers ready to dispatch.
+
+**/
+VOID
+CorePrefetchScheduledImages (
+  IN LIST_ENTRY  *ScheduledQueue
+  );
+
+/**
+  Free the prefetched sections of a driver that have not been used by the
+  section extraction code, once the driver has been loaded. A section an AP
+  is still decompressing is freed later, once the AP is done with it.
+
+  @param  DriverEntry           The driver to release the prefetched sections
+                                of, or NULL to release all of them.
+
+**/
+VOID
+CoreReleaseImagePrefetch (
+  IN EFI_CORE_DRIVER_ENTRY  *DriverEntry OPTIONAL
+  );
+
+/**
+  Take the decompressed content of an encapsulation section if the DXE
+  Dispatcher has prefetched it. Called by the section extraction code before
+  it decompresses a section.
+
+  @param  Section               The compression or GUIDed section to decompress.
+  @param  OutputBuffer          Return the decompressed data, allocated from pool.
+  @param  OutputSize            Return the size of the decompressed data.
+  @param  AuthenticationStatus  Return the authentication status reported by
+                                the GUIDed section handler.
+
+  @retval TRUE                  The section was prefetched, the caller owns
+                                *OutputBuffer.
+  @retval FALSE                 The section must be decompressed by the caller.
+
+**/
+BOOLEAN
+CoreTakePrefetchedSection (
+  IN  CONST VOID  *Section,
+  OUT VOID        **OutputBuffer,
+  OUT UINTN       *OutputSize,
+  OUT UINT32      *AuthenticationStatus
+  );
+
 /**
   Terminates all boot services.
 
@@ -2042,6 +2199,18 @@ CoreDisplayDiscoveredNotDispatched (
   VOID
   );
 
+/**
+  Display the dispatch graph: for every dispatched driver the time it was
+  discovered, scheduled, started and returned, and for every protocol its
+  Depex waited on the time the protocol was installed and by which driver.
+  Only used in Debug Builds.
+
+**/
+VOID
+CoreDumpDispatchGraph (
+  VOID
+  );
+
 /**
   Place holder function until all the Boot Services and Runtime Services are
   available.
@@ -2342,6 +2511,21 @@ CloseSectionStream (
   IN  BOOLEAN  FreeStreamBuffer
   );
 
+/**
+  Return the number of bytes held by the streams encapsulated in a section
+  stream, that is the data decompressed or extracted from its encapsulation
+  sections so far.
+
+  @param  SectionStreamHandle   The section stream to measure.
+
+  @return The size of the encapsulated streams, 0 if the handle does not exist.
+
+**/
+UINTN
+GetSectionStreamDecodedSize (
+  IN UINTN  SectionStreamHandle
+  );
+
 /**
   Creates and initializes the DebugImageInfo Table.  Also creates the configuration
   table and registers it into the system table.
@@ -2802,4 +2986,23 @@ CoreInitializeHandleServices (
   VOID
   );
 
+/**
+  Dump the protocol database lookup statistics gathered during boot.
+
+**/
+VOID
+CoreDumpProtocolDatabaseStatistics (
+  VOID
+  );
+
+/**
+  Dump the FV file lookup and section stream cache statistics gathered during
+  boot.
+
+**/
+VOID
+CoreDumpFwVolCacheStatistics (
+  VOID
+  );
+
 #endif
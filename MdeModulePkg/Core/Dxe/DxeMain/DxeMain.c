@@ -561,6 +561,7 @@ DxeMain (
   //
   DEBUG_CODE_BEGIN ();
   CoreDisplayDiscoveredNotDispatched ();
+  CoreDumpDispatchGraph ();
   DEBUG_CODE_END ();
 
   //
@@ -788,6 +789,11 @@ CoreExitBootServices (
   if (!mExitBootServicesCalled) {
     CoreNotifySignalList (&gEfiEventBeforeExitBootServicesGuid);
     mExitBootServicesCalled = TRUE;
+
+    DEBUG_CODE_BEGIN ();
+    CoreDumpProtocolDatabaseStatistics ();
+    CoreDumpFwVolCacheStatistics ();
+    DEBUG_CODE_END ();
   }
 
   //
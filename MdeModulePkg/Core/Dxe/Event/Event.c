@@ -450,6 +450,17 @@ CoreCreateEventInternal (
     return EFI_OUT_OF_RESOURCES;
   }
 
+  //
+  // Make sure setting the timer of the event never has to grow the timer heap
+  //
+  if ((Type & EVT_TIMER) != 0) {
+    Status = CoreReserveEventTimer ();
+    if (EFI_ERROR (Status)) {
+      CoreFreePool (IEvent);
+      return Status;
+    }
+  }
+
   IEvent->Signature = EVENT_SIGNATURE;
   IEvent->Type      = Type;
 
@@ -719,6 +730,7 @@ CoreCloseEvent (
   //
   if ((Event->Type & EVT_TIMER) != 0) {
     CoreSetTimer (Event, TimerCancel, 0);
+    CoreUnreserveEventTimer ();
   }
 
   CoreAcquireEventLock ();
@@ -30,9 +30,12 @@ extern  UINTN  gEventPending;
 /// Timer event information
 ///
 typedef struct {
-  LIST_ENTRY    Link;
-  UINT64        TriggerTime;
-  UINT64        Period;
+  /// 1-based position of the event in the timer heap, 0 if the timer is not set
+  UINTN     HeapIndex;
+  /// Order in which the timer was set, breaks ties between equal TriggerTime
+  UINT64    Sequence;
+  UINT64    TriggerTime;
+  UINT64    Period;
 } TIMER_EVENT_INFO;
 
 #define EVENT_SIGNATURE  SIGNATURE_32('e','v','n','t')
@@ -60,6 +63,22 @@ typedef struct {
   TIMER_EVENT_INFO           Timer;
 } IEVENT;
 
+///
+/// Binary min-heap of the set timer events, ordered on TriggerTime and then
+/// on the order the timers were set in.
+///
+typedef struct {
+  IEVENT    **Events;
+  UINTN     Count;
+  UINTN     Capacity;
+  UINT64    Sequence;
+} TIMER_HEAP;
+
+///
+/// Initial number of timer events the timer heap has room for
+///
+#define TIMER_HEAP_INITIAL_CAPACITY  64
+
 //
 // Internal prototypes
 //
@@ -85,4 +104,54 @@ CoreInitializeTimer (
   VOID
   );
 
+/**
+  Reserve room in the timer heap for a new timer event, so that setting the
+  timer never needs to allocate memory at a raised TPL.
+
+  @retval EFI_SUCCESS            Room for one more timer event was reserved.
+  @retval EFI_OUT_OF_RESOURCES   The timer heap could not be grown.
+
+**/
+EFI_STATUS
+CoreReserveEventTimer (
+  VOID
+  );
+
+/**
+  Give back the timer heap room reserved by CoreReserveEventTimer() for a
+  timer event that is being closed.
+
+**/
+VOID
+CoreUnreserveEventTimer (
+  VOID
+  );
+
+/**
+  Inserts an event into a timer heap. The event must not be in any timer
+  heap and the heap must have room for it.
+
+  @param  Heap                   The timer heap
+  @param  Event                  The timer event, with Timer.TriggerTime set
+
+**/
+VOID
+CoreTimerHeapInsert (
+  IN OUT TIMER_HEAP  *Heap,
+  IN     IEVENT      *Event
+  );
+
+/**
+  Removes an event from the timer heap it was inserted into.
+
+  @param  Heap                   The timer heap
+  @param  Event                  The timer event
+
+**/
+VOID
+CoreTimerHeapRemove (
+  IN OUT TIMER_HEAP  *Heap,
+  IN     IEVENT      *Event
+  );
+
 #endif
@@ -0,0 +1,205 @@
+/** @file
+  Unit tests and micro-benchmark for the DXE Core timer heap.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+#include <Library/GoogleTestLib.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+extern "C" {
+  #include <Uefi.h>
+  #include <Protocol/Runtime.h>
+  #include "../Event.h"
+}
+
+using namespace testing;
+
+//
+// Number of timers used by the benchmark
+//
+#define TIMER_BENCHMARK_COUNT  10000
+
+class TimerHeapTest : public Test {
+protected:
+  std::vector<IEVENT>    Events;
+  std::vector<IEVENT *>  Storage;
+  TIMER_HEAP             Heap;
+
+  void
+  Init (
+    UINTN  Count
+    )
+  {
+    Events.assign (Count, IEVENT ());
+    Storage.assign (Count, NULL);
+
+    Heap.Events   = Storage.data ();
+    Heap.Count    = 0;
+    Heap.Capacity = Count;
+    Heap.Sequence = 0;
+  }
+
+  IEVENT *
+  PopFirst (
+    )
+  {
+    IEVENT  *Event;
+
+    Event = Heap.Events[0];
+    CoreTimerHeapRemove (&Heap, Event);
+    return Event;
+  }
+
+  // Check that every event sits where its HeapIndex says, and that no child
+  // expires before its parent.
+  void
+  CheckHeap (
+    )
+  {
+    for (UINTN Index = 0; Index < Heap.Count; Index++) {
+      ASSERT_EQ (Heap.Events[Index]->Timer.HeapIndex, Index + 1);
+      if (Index > 0) {
+        IEVENT  *Parent = Heap.Events[(Index - 1) / 2];
+        IEVENT  *Child  = Heap.Events[Index];
+        ASSERT_TRUE (
+          (Parent->Timer.TriggerTime < Child->Timer.TriggerTime) ||
+          ((Parent->Timer.TriggerTime == Child->Timer.TriggerTime) &&
+           (Parent->Timer.Sequence < Child->Timer.Sequence))
+          );
+      }
+    }
+  }
+};
+
+// Timers must fire in trigger time order, and timers with the same trigger
+// time must fire in the order they were set, as with the sorted timer list.
+TEST_F (TimerHeapTest, FiresInTriggerTimeThenSetOrder) {
+  std::mt19937          Random (1);
+  std::vector<IEVENT *> Expected;
+
+  Init (1000);
+  for (UINTN Index = 0; Index < Events.size (); Index++) {
+    Events[Index].Timer.TriggerTime = Random () % 50;
+    CoreTimerHeapInsert (&Heap, &Events[Index]);
+    Expected.push_back (&Events[Index]);
+  }
+
+  CheckHeap ();
+
+  std::stable_sort (
+    Expected.begin (),
+    Expected.end (),
+    [](IEVENT *A, IEVENT *B) {
+    return A->Timer.TriggerTime < B->Timer.TriggerTime;
+  }
+    );
+  for (UINTN Index = 0; Index < Expected.size (); Index++) {
+    ASSERT_EQ (PopFirst (), Expected[Index]);
+  }
+
+  EXPECT_EQ (Heap.Count, (UINTN)0);
+}
+
+// Cancelling timers anywhere in the heap must keep it ordered and clear the
+// position of the cancelled events.
+TEST_F (TimerHeapTest, RemoveFromMiddle) {
+  std::mt19937  Random (2);
+  UINT64        Last;
+
+  Init (1000);
+  for (UINTN Index = 0; Index < Events.size (); Index++) {
+    Events[Index].Timer.TriggerTime = Random () % 10000;
+    CoreTimerHeapInsert (&Heap, &Events[Index]);
+  }
+
+  for (UINTN Index = 0; Index < Events.size (); Index += 3) {
+    CoreTimerHeapRemove (&Heap, &Events[Index]);
+    EXPECT_EQ (Events[Index].Timer.HeapIndex, (UINTN)0);
+  }
+
+  CheckHeap ();
+  EXPECT_EQ (Heap.Count, Events.size () - (Events.size () + 2) / 3);
+
+  Last = 0;
+  while (Heap.Count > 0) {
+    IEVENT  *Event = PopFirst ();
+    ASSERT_GE (Event->Timer.TriggerTime, Last);
+    Last = Event->Timer.TriggerTime;
+  }
+}
+
+// Re-arming a periodic timer after it fired must put it behind the timers
+// that are already due at its new trigger time.
+TEST_F (TimerHeapTest, PeriodicReinsertKeepsOrder) {
+  Init (3);
+  Events[0].Timer.TriggerTime = 10;
+  Events[1].Timer.TriggerTime = 20;
+  Events[2].Timer.TriggerTime = 20;
+  CoreTimerHeapInsert (&Heap, &Events[0]);
+  CoreTimerHeapInsert (&Heap, &Events[1]);
+  CoreTimerHeapInsert (&Heap, &Events[2]);
+
+  ASSERT_EQ (PopFirst (), &Events[0]);
+  Events[0].Timer.TriggerTime = 20;
+  CoreTimerHeapInsert (&Heap, &Events[0]);
+
+  EXPECT_EQ (PopFirst (), &Events[1]);
+  EXPECT_EQ (PopFirst (), &Events[2]);
+  EXPECT_EQ (PopFirst (), &Events[0]);
+}
+
+// Measure the cost of setting, firing and re-arming TIMER_BENCHMARK_COUNT
+// timers. The results are reported, not checked, as they depend on the host.
+TEST_F (TimerHeapTest, Benchmark10kTimers) {
+  std::mt19937  Random (3);
+  UINT64        Now;
+
+  Init (TIMER_BENCHMARK_COUNT);
+
+  auto  Start = std::chrono::steady_clock::now ();
+
+  for (UINTN Index = 0; Index < Events.size (); Index++) {
+    Events[Index].Timer.TriggerTime = Random () % 10000000;
+    Events[Index].Timer.Period      = 1 + Random () % 100000;
+    CoreTimerHeapInsert (&Heap, &Events[Index]);
+  }
+
+  auto  Inserted = std::chrono::steady_clock::now ();
+
+  //
+  // Fire every timer once, re-arming it as CoreCheckTimers() does for
+  // periodic timers.
+  //
+  for (UINTN Index = 0; Index < Events.size (); Index++) {
+    IEVENT  *Event = PopFirst ();
+    Now                      = Event->Timer.TriggerTime;
+    Event->Timer.TriggerTime = Now + Event->Timer.Period;
+    CoreTimerHeapInsert (&Heap, Event);
+  }
+
+  auto  Fired = std::chrono::steady_clock::now ();
+
+  CheckHeap ();
+
+  double  InsertNs = std::chrono::duration<double, std::nano>(Inserted - Start).count () / Events.size ();
+  double  FireNs   = std::chrono::duration<double, std::nano>(Fired - Inserted).count () / Events.size ();
+
+  std::printf ("[ BENCH    ] %d timers: %.1f ns per insert, %.1f ns per fire and re-arm\n", TIMER_BENCHMARK_COUNT, InsertNs, FireNs);
+  RecordProperty ("InsertNs", std::to_string (InsertNs));
+  RecordProperty ("FireNs", std::to_string (FireNs));
+}
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  testing::InitGoogleTest (&argc, argv);
+  return RUN_ALL_TESTS ();
+}
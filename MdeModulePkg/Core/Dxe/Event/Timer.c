@@ -13,7 +13,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 // Internal data
 //
 
-LIST_ENTRY  mEfiTimerList       = INITIALIZE_LIST_HEAD_VARIABLE (mEfiTimerList);
+TIMER_HEAP  mEfiTimerHeap       = { NULL, 0, 0, 0 };
+UINTN       mEfiTimerEventCount = 0;
 EFI_LOCK    mEfiTimerLock       = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL - 1);
 EFI_EVENT   mEfiCheckTimerEvent = NULL;
 
@@ -36,29 +37,92 @@ CoreInsertEventTimer (
   IN IEVENT  *Event
   )
 {
-  UINT64      TriggerTime;
-  LIST_ENTRY  *Link;
-  IEVENT      *Event2;
-
   ASSERT_LOCKED (&mEfiTimerLock);
 
   //
-  // Get the timer's trigger time
+  // Insert the timer into the timer database. Timers with the same trigger
+  // time keep the order they were inserted in.
   //
-  TriggerTime = Event->Timer.TriggerTime;
+  CoreTimerHeapInsert (&mEfiTimerHeap, Event);
+}
 
-  //
-  // Insert the timer into the timer database in assending sorted order
-  //
-  for (Link = mEfiTimerList.ForwardLink; Link != &mEfiTimerList; Link = Link->ForwardLink) {
-    Event2 = CR (Link, IEVENT, Timer.Link, EVENT_SIGNATURE);
+/**
+  Reserve room in the timer heap for a new timer event, so that setting the
+  timer never needs to allocate memory at a raised TPL.
 
-    if (Event2->Timer.TriggerTime > TriggerTime) {
-      break;
+  @retval EFI_SUCCESS            Room for one more timer event was reserved.
+  @retval EFI_OUT_OF_RESOURCES   The timer heap could not be grown.
+
+**/
+EFI_STATUS
+CoreReserveEventTimer (
+  VOID
+  )
+{
+  IEVENT  **Events;
+  IEVENT  **OldEvents;
+  UINTN   Capacity;
+
+  CoreAcquireLock (&mEfiTimerLock);
+
+  while (mEfiTimerEventCount >= mEfiTimerHeap.Capacity) {
+    Capacity = MAX (mEfiTimerHeap.Capacity * 2, TIMER_HEAP_INITIAL_CAPACITY);
+    CoreReleaseLock (&mEfiTimerLock);
+
+    //
+    // The timer lock is above TPL_NOTIFY, so allocate the larger heap array
+    // without holding it.
+    //
+    Events = AllocatePool (Capacity * sizeof (IEVENT *));
+    if (Events == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    CoreAcquireLock (&mEfiTimerLock);
+    if (Capacity > mEfiTimerHeap.Capacity) {
+      if (mEfiTimerHeap.Count > 0) {
+        CopyMem (Events, mEfiTimerHeap.Events, mEfiTimerHeap.Count * sizeof (IEVENT *));
+      }
+
+      OldEvents              = mEfiTimerHeap.Events;
+      mEfiTimerHeap.Events   = Events;
+      mEfiTimerHeap.Capacity = Capacity;
+    } else {
+      //
+      // The heap was grown by someone else in the meantime
+      //
+      OldEvents = Events;
+    }
+
+    CoreReleaseLock (&mEfiTimerLock);
+
+    if (OldEvents != NULL) {
+      CoreFreePool (OldEvents);
     }
+
+    CoreAcquireLock (&mEfiTimerLock);
   }
 
-  InsertTailList (Link, &Event->Timer.Link);
+  mEfiTimerEventCount++;
+  CoreReleaseLock (&mEfiTimerLock);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Give back the timer heap room reserved by CoreReserveEventTimer() for a
+  timer event that is being closed.
+
+**/
+VOID
+CoreUnreserveEventTimer (
+  VOID
+  )
+{
+  CoreAcquireLock (&mEfiTimerLock);
+  ASSERT (mEfiTimerEventCount > 0);
+  mEfiTimerEventCount--;
+  CoreReleaseLock (&mEfiTimerLock);
 }
 
 /**
@@ -82,7 +146,7 @@ CoreCurrentSystemTime (
 }
 
 /**
-  Checks the sorted timer list against the current system time.
+  Checks the timer heap against the current system time.
   Signals any expired event timer.
 
   @param  CheckEvent             Not used
@@ -105,8 +169,8 @@ CoreCheckTimers (
   CoreAcquireLock (&mEfiTimerLock);
   SystemTime = CoreCurrentSystemTime ();
 
-  while (!IsListEmpty (&mEfiTimerList)) {
-    Event = CR (mEfiTimerList.ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
+  while (mEfiTimerHeap.Count > 0) {
+    Event = mEfiTimerHeap.Events[0];
 
     //
     // If this timer is not expired, then we're done
@@ -119,8 +183,7 @@ CoreCheckTimers (
     // Remove this timer from the timer queue
     //
 
-    RemoveEntryList (&Event->Timer.Link);
-    Event->Timer.Link.ForwardLink = NULL;
+    CoreTimerHeapRemove (&mEfiTimerHeap, Event);
 
     //
     // Signal it
@@ -202,11 +265,11 @@ CoreTimerTick (
   mEfiSystemTime += Duration;
 
   //
-  // If the head of the list is expired, fire the timer event
+  // If the earliest timer is expired, fire the timer event
   // to process it
   //
-  if (!IsListEmpty (&mEfiTimerList)) {
-    Event = CR (mEfiTimerList.ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
+  if (mEfiTimerHeap.Count > 0) {
+    Event = mEfiTimerHeap.Events[0];
 
     if (Event->Timer.TriggerTime <= mEfiSystemTime) {
       CoreSignalEvent (mEfiCheckTimerEvent);
@@ -260,9 +323,8 @@ CoreSetTimer (
   //
   // If the timer is queued to the timer database, remove it
   //
-  if (Event->Timer.Link.ForwardLink != NULL) {
-    RemoveEntryList (&Event->Timer.Link);
-    Event->Timer.Link.ForwardLink = NULL;
+  if (Event->Timer.HeapIndex != 0) {
+    CoreTimerHeapRemove (&mEfiTimerHeap, Event);
   }
 
   Event->Timer.TriggerTime = 0;
@@ -0,0 +1,191 @@
+/** @file
+  Binary min-heap of the timer events, used by the core timer services.
+
+  The heap array is allocated by the caller. Inserting and removing events
+  never allocates memory, so both can be used at any TPL.
+
+Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "DxeMain.h"
+#include "Event.h"
+
+/**
+  Check whether an event expires before another one. Events with the same
+  trigger time expire in the order their timers were set.
+
+  @param  Event1                 The first timer event
+  @param  Event2                 The second timer event
+
+  @retval TRUE                   Event1 expires before Event2.
+  @retval FALSE                  Event1 expires at the same time as or after Event2.
+
+**/
+STATIC
+BOOLEAN
+TimerHeapIsBefore (
+  IN IEVENT  *Event1,
+  IN IEVENT  *Event2
+  )
+{
+  if (Event1->Timer.TriggerTime != Event2->Timer.TriggerTime) {
+    return (BOOLEAN)(Event1->Timer.TriggerTime < Event2->Timer.TriggerTime);
+  }
+
+  return (BOOLEAN)(Event1->Timer.Sequence < Event2->Timer.Sequence);
+}
+
+/**
+  Store an event at a position of the heap array.
+
+  @param  Heap                   The timer heap
+  @param  Index                  0-based position in the heap array
+  @param  Event                  The timer event
+
+**/
+STATIC
+VOID
+TimerHeapPlace (
+  IN OUT TIMER_HEAP  *Heap,
+  IN     UINTN       Index,
+  IN     IEVENT      *Event
+  )
+{
+  Heap->Events[Index]    = Event;
+  Event->Timer.HeapIndex = Index + 1;
+}
+
+/**
+  Move an event from a free position toward the root until its parent
+  expires before it.
+
+  @param  Heap                   The timer heap
+  @param  Index                  0-based free position to start from
+  @param  Event                  The timer event to place
+
+**/
+STATIC
+VOID
+TimerHeapSiftUp (
+  IN OUT TIMER_HEAP  *Heap,
+  IN     UINTN       Index,
+  IN     IEVENT      *Event
+  )
+{
+  UINTN  Parent;
+
+  while (Index > 0) {
+    Parent = (Index - 1) / 2;
+    if (!TimerHeapIsBefore (Event, Heap->Events[Parent])) {
+      break;
+    }
+
+    TimerHeapPlace (Heap, Index, Heap->Events[Parent]);
+    Index = Parent;
+  }
+
+  TimerHeapPlace (Heap, Index, Event);
+}
+
+/**
+  Move an event from a free position toward the leaves until no child
+  expires before it.
+
+  @param  Heap                   The timer heap
+  @param  Index                  0-based free position to start from
+  @param  Event                  The timer event to place
+
+**/
+STATIC
+VOID
+TimerHeapSiftDown (
+  IN OUT TIMER_HEAP  *Heap,
+  IN     UINTN       Index,
+  IN     IEVENT      *Event
+  )
+{
+  UINTN  Child;
+
+  for ( ; ;) {
+    Child = 2 * Index + 1;
+    if (Child >= Heap->Count) {
+      break;
+    }
+
+    if ((Child + 1 < Heap->Count) && TimerHeapIsBefore (Heap->Events[Child + 1], Heap->Events[Child])) {
+      Child++;
+    }
+
+    if (!TimerHeapIsBefore (Heap->Events[Child], Event)) {
+      break;
+    }
+
+    TimerHeapPlace (Heap, Index, Heap->Events[Child]);
+    Index = Child;
+  }
+
+  TimerHeapPlace (Heap, Index, Event);
+}
+
+/**
+  Inserts an event into a timer heap. The event must not be in any timer
+  heap and the heap must have room for it.
+
+  @param  Heap                   The timer heap
+  @param  Event                  The timer event, with Timer.TriggerTime set
+
+**/
+VOID
+CoreTimerHeapInsert (
+  IN OUT TIMER_HEAP  *Heap,
+  IN     IEVENT      *Event
+  )
+{
+  ASSERT (Event->Timer.HeapIndex == 0);
+  ASSERT (Heap->Count < Heap->Capacity);
+
+  Event->Timer.Sequence = Heap->Sequence++;
+  Heap->Count++;
+  TimerHeapSiftUp (Heap, Heap->Count - 1, Event);
+}
+
+/**
+  Removes an event from the timer heap it was inserted into.
+
+  @param  Heap                   The timer heap
+  @param  Event                  The timer event
+
+**/
+VOID
+CoreTimerHeapRemove (
+  IN OUT TIMER_HEAP  *Heap,
+  IN     IEVENT      *Event
+  )
+{
+  UINTN   Index;
+  IEVENT  *Last;
+
+  ASSERT (Event->Timer.HeapIndex != 0);
+  ASSERT (Event->Timer.HeapIndex <= Heap->Count);
+  ASSERT (Heap->Events[Event->Timer.HeapIndex - 1] == Event);
+
+  Index                  = Event->Timer.HeapIndex - 1;
+  Event->Timer.HeapIndex = 0;
+  Heap->Count--;
+
+  if (Index == Heap->Count) {
+    return;
+  }
+
+  //
+  // Fill the hole with the last event, and move that one to where it belongs
+  //
+  Last = Heap->Events[Heap->Count];
+  if ((Index > 0) && TimerHeapIsBefore (Last, Heap->Events[(Index - 1) / 2])) {
+    TimerHeapSiftUp (Heap, Index, Last);
+  } else {
+    TimerHeapSiftDown (Heap, Index, Last);
+  }
+}
@@ -266,7 +266,7 @@ FreeFvDeviceResource (
       //
       // Close stream and free resources from SEP
       //
-      CloseSectionStream (FfsFileEntry->StreamHandle, FALSE);
+      FvCloseSectionStream (FfsFileEntry);
     }
 
     if (FfsFileEntry->FileCached) {
@@ -281,6 +281,11 @@ FreeFvDeviceResource (
     FfsFileEntry = (FFS_FILE_LIST_ENTRY *)NextEntry;
   }
 
+  if (FvDevice->FileHashTable != NULL) {
+    CoreFreePool (FvDevice->FileHashTable);
+    FvDevice->FileHashTable = NULL;
+  }
+
   if (!FvDevice->IsMemoryMapped) {
     //
     // Free the cached FV buffer.
@@ -536,6 +541,7 @@ FvCheck (
       FfsFileEntry->FfsHeader  = CacheFfsHeader;
       FfsFileEntry->FileCached = FileCached;
       FileCached               = FALSE;
+      InitializeListHead (&FfsFileEntry->StreamLink);
       InsertTailList (&FvDevice->FfsFileListHeader, &FfsFileEntry->Link);
     }
 
@@ -559,11 +565,129 @@ Done:
     }
 
     FreeFvDeviceResource (FvDevice);
+  } else {
+    FvBuildFileHashTable (FvDevice);
   }
 
   return Status;
 }
 
+/**
+  Compute the FV_DEVICE.FileHashTable bucket index of a file name.
+
+  @param  FvDevice       The FV the file belongs to.
+  @param  NameGuid       The name of the file.
+
+  @return The bucket index.
+
+**/
+UINTN
+FvFileHashBucket (
+  IN FV_DEVICE       *FvDevice,
+  IN CONST EFI_GUID  *NameGuid
+  )
+{
+  UINT32  Hash;
+
+  //
+  // File names are generated GUIDs, so folding the four 32-bit words is
+  // enough to spread them.
+  //
+  Hash = ReadUnaligned32 ((CONST UINT32 *)NameGuid) ^
+         ReadUnaligned32 ((CONST UINT32 *)NameGuid + 1) ^
+         ReadUnaligned32 ((CONST UINT32 *)NameGuid + 2) ^
+         ReadUnaligned32 ((CONST UINT32 *)NameGuid + 3);
+  Hash ^= Hash >> 16;
+  Hash ^= Hash >> 8;
+
+  return (UINTN)(Hash & (FvDevice->FileHashBucketCount - 1));
+}
+
+/**
+  Build the GUID hash index of the files of an FV. If the index cannot be
+  allocated, files are found by walking FfsFileListHeader.
+
+  @param  FvDevice       The FV whose file list has been built.
+
+**/
+VOID
+FvBuildFileHashTable (
+  IN OUT FV_DEVICE  *FvDevice
+  )
+{
+  LIST_ENTRY           *Link;
+  FFS_FILE_LIST_ENTRY  *FfsFileEntry;
+  UINTN                Count;
+  UINTN                Index;
+
+  Count = 0;
+  for (Link = FvDevice->FfsFileListHeader.ForwardLink; Link != &FvDevice->FfsFileListHeader; Link = Link->ForwardLink) {
+    Count++;
+  }
+
+  FvDevice->FileHashBucketCount = MAX (GetPowerOfTwo32 ((UINT32)Count), FV_FILE_HASH_MIN_BUCKET_COUNT);
+  FvDevice->FileHashTable       = AllocatePool (FvDevice->FileHashBucketCount * sizeof (LIST_ENTRY));
+  if (FvDevice->FileHashTable == NULL) {
+    return;
+  }
+
+  for (Index = 0; Index < FvDevice->FileHashBucketCount; Index++) {
+    InitializeListHead (&FvDevice->FileHashTable[Index]);
+  }
+
+  //
+  // Insert in list order so that the first file of a given name wins, and
+  // leave out the pad files that FvGetNextFile () skips.
+  //
+  for (Link = FvDevice->FfsFileListHeader.ForwardLink; Link != &FvDevice->FfsFileListHeader; Link = Link->ForwardLink) {
+    FfsFileEntry = (FFS_FILE_LIST_ENTRY *)Link;
+    if (FfsFileEntry->FfsHeader->Type == EFI_FV_FILETYPE_FFS_PAD) {
+      InitializeListHead (&FfsFileEntry->HashLink);
+      continue;
+    }
+
+    InsertTailList (
+      &FvDevice->FileHashTable[FvFileHashBucket (FvDevice, &FfsFileEntry->FfsHeader->Name)],
+      &FfsFileEntry->HashLink
+      );
+  }
+}
+
+/**
+  Find a file of an FV by name through the GUID hash index.
+
+  @param  FvDevice       The FV to search. FvDevice->FileHashTable must not be NULL.
+  @param  NameGuid       The name of the file.
+
+  @return The file list entry, or NULL if the FV has no such file.
+
+**/
+FFS_FILE_LIST_ENTRY *
+FvFindFileEntry (
+  IN FV_DEVICE       *FvDevice,
+  IN CONST EFI_GUID  *NameGuid
+  )
+{
+  LIST_ENTRY           *Bucket;
+  LIST_ENTRY           *Link;
+  FFS_FILE_LIST_ENTRY  *FfsFileEntry;
+  UINTN                CompareCount;
+
+  CompareCount = 0;
+  Bucket       = &FvDevice->FileHashTable[FvFileHashBucket (FvDevice, NameGuid)];
+  for (Link = Bucket->ForwardLink; Link != Bucket; Link = Link->ForwardLink) {
+    CompareCount++;
+    FfsFileEntry = BASE_CR (Link, FFS_FILE_LIST_ENTRY, HashLink);
+    if (CompareGuid (&FfsFileEntry->FfsHeader->Name, NameGuid)) {
+      FvCountFileLookup (CompareCount, TRUE);
+      return FfsFileEntry;
+    }
+  }
+
+  FvCountFileLookup (CompareCount, FALSE);
+  return NULL;
+}
+
 /**
   This notification function is invoked when an instance of the
   EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL is produced.  It layers an instance of the
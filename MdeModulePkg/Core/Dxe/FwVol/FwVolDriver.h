@@ -20,8 +20,44 @@ typedef struct {
   EFI_FFS_FILE_HEADER    *FfsHeader;
   UINTN                  StreamHandle;
   BOOLEAN                FileCached;
+  ///
+  /// Link on the FV_DEVICE.FileHashTable bucket selected by the file name
+  ///
+  LIST_ENTRY             HashLink;
+  ///
+  /// Link on mFvSectionStreamLru while StreamHandle is open, and the number
+  /// of bytes decoded in the stream.
+  ///
+  LIST_ENTRY             StreamLink;
+  UINTN                  StreamSize;
+  ///
+  /// Number of FvReadFileSection() calls using StreamHandle. A pinned stream
+  /// is never evicted.
+  ///
+  UINTN                  StreamPinCount;
 } FFS_FILE_LIST_ENTRY;
 
+///
+/// Minimum number of buckets of the file name hash index of an FV.
+///
+#define FV_FILE_HASH_MIN_BUCKET_COUNT  16
+
+///
+/// Statistics of the file lookups and of the section stream cache of all the
+/// FVs, dumped by CoreDumpFwVolCacheStatistics().
+///
+typedef struct {
+  UINT64    FileLookupCount;
+  UINT64    FileLookupCompareCount;
+  UINT64    FileLookupMissCount;
+  UINT64    StreamHitCount;
+  UINT64    StreamMissCount;
+  UINT64    StreamEvictionCount;
+  UINTN     StreamCount;
+  UINTN     StreamCacheSize;
+  UINTN     StreamCachePeakSize;
+} FV_CACHE_STATISTICS;
+
 typedef struct {
   UINTN                                 Signature;
   EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL    *Fvb;
@@ -35,6 +71,11 @@ typedef struct {
   FFS_FILE_LIST_ENTRY                   *LastKey;
 
   LIST_ENTRY                            FfsFileListHeader;
+  ///
+  /// GUID hash index of FfsFileListHeader, NULL if it could not be allocated
+  ///
+  LIST_ENTRY                            *FileHashTable;
+  UINTN                                 FileHashBucketCount;
 
   UINT32                                AuthenticationStatus;
   UINT8                                 ErasePolarity;
@@ -384,4 +425,92 @@ IsValidFfsFile (
   IN EFI_FFS_FILE_HEADER  *FfsHeader
   );
 
+extern FV_CACHE_STATISTICS  mFvCacheStatistics;
+
+/**
+  Build the GUID hash index of the files of an FV. If the index cannot be
+  allocated, files are found by walking FfsFileListHeader.
+
+  @param  FvDevice       The FV whose file list has been built.
+
+**/
+VOID
+FvBuildFileHashTable (
+  IN OUT FV_DEVICE  *FvDevice
+  );
+
+/**
+  Find a file of an FV by name through the GUID hash index.
+
+  @param  FvDevice       The FV to search. FvDevice->FileHashTable must not be NULL.
+  @param  NameGuid       The name of the file.
+
+  @return The file list entry, or NULL if the FV has no such file.
+
+**/
+FFS_FILE_LIST_ENTRY *
+FvFindFileEntry (
+  IN FV_DEVICE       *FvDevice,
+  IN CONST EFI_GUID  *NameGuid
+  );
+
+/**
+  Account for a file lookup.
+
+  @param  CompareCount   The number of file names compared.
+  @param  Found          TRUE if the file was found.
+
+**/
+VOID
+FvCountFileLookup (
+  IN UINTN    CompareCount,
+  IN BOOLEAN  Found
+  );
+
+/**
+  Open the section stream of a file if it is not open yet, and pin it until
+  FvReleaseSectionStream() is called.
+
+  @param  FfsFileEntry   The file whose stream is used.
+  @param  FileSize       The size of the file data, without the file header.
+  @param  FileBuffer     The file data, without the file header.
+
+  @retval EFI_SUCCESS    FfsFileEntry->StreamHandle is open and pinned.
+  @retval others         The stream could not be opened. It is not pinned.
+
+**/
+EFI_STATUS
+FvOpenSectionStream (
+  IN FFS_FILE_LIST_ENTRY  *FfsFileEntry,
+  IN UINTN                FileSize,
+  IN VOID                 *FileBuffer
+  );
+
+/**
+  Unpin the section stream of a file, account for the sections it decoded,
+  make it the most recently used one, and close the least recently used
+  streams of any FV that are not pinned while the decoded bytes of all the
+  streams exceed CacheLimit.
+
+  @param  FfsFileEntry   The file whose section stream was just used.
+  @param  CacheLimit     The budget of decoded bytes, 0 for no limit.
+
+**/
+VOID
+FvReleaseSectionStream (
+  IN FFS_FILE_LIST_ENTRY  *FfsFileEntry,
+  IN UINTN                CacheLimit
+  );
+
+/**
+  Close the section stream of a file and drop it from the section stream cache.
+
+  @param  FfsFileEntry   The file whose stream is closed.
+
+**/
+VOID
+FvCloseSectionStream (
+  IN FFS_FILE_LIST_ENTRY  *FfsFileEntry
+  );
+
 #endif
@@ -285,6 +285,8 @@ FvReadFile (
   EFI_FFS_FILE_HEADER     *FfsHeader;
   UINTN                   InputBufferSize;
   UINTN                   WholeFileSize;
+  EFI_FV_ATTRIBUTES       FvAttributes;
+  FFS_FILE_LIST_ENTRY     *FfsFileEntry;
 
   if (NameGuid == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -292,25 +294,48 @@ FvReadFile (
 
   FvDevice = FV_DEVICE_FROM_THIS (This);
 
-  //
-  // Keep looking until we find the matching NameGuid.
-  // The Key is really a FfsFileEntry
-  //
-  FvDevice->LastKey = 0;
-  do {
-    LocalFoundType = 0;
-    Status         = FvGetNextFile (
-                       This,
-                       &FvDevice->LastKey,
-                       &LocalFoundType,
-                       &SearchNameGuid,
-                       &LocalAttributes,
-                       &FileSize
-                       );
-    if (EFI_ERROR (Status)) {
+  if (FvDevice->FileHashTable != NULL) {
+    //
+    // Look the file up in the GUID hash index, with the same checks that
+    // FvGetNextFile () would have made.
+    //
+    Status = FvGetVolumeAttributes (This, &FvAttributes);
+    if (EFI_ERROR (Status) || ((FvAttributes & EFI_FV2_READ_STATUS) == 0)) {
+      return EFI_NOT_FOUND;
+    }
+
+    FfsFileEntry = FvFindFileEntry (FvDevice, NameGuid);
+    if (FfsFileEntry == NULL) {
       return EFI_NOT_FOUND;
     }
-  } while (!CompareGuid (&SearchNameGuid, NameGuid));
+
+    FvDevice->LastKey = FfsFileEntry;
+    if (IS_FFS_FILE2 (FfsFileEntry->FfsHeader)) {
+      FileSize = FFS_FILE2_SIZE (FfsFileEntry->FfsHeader) - sizeof (EFI_FFS_FILE_HEADER2);
+    } else {
+      FileSize = FFS_FILE_SIZE (FfsFileEntry->FfsHeader) - sizeof (EFI_FFS_FILE_HEADER);
+    }
+  } else {
+    //
+    // Keep looking until we find the matching NameGuid.
+    // The Key is really a FfsFileEntry
+    //
+    FvDevice->LastKey = 0;
+    do {
+      LocalFoundType = 0;
+      Status         = FvGetNextFile (
+                         This,
+                         &FvDevice->LastKey,
+                         &LocalFoundType,
+                         &SearchNameGuid,
+                         &LocalAttributes,
+                         &FileSize
+                         );
+      if (EFI_ERROR (Status)) {
+        return EFI_NOT_FOUND;
+      }
+    } while (!CompareGuid (&SearchNameGuid, NameGuid));
+  }
 
   //
   // Get a pointer to the header
@@ -399,6 +424,39 @@ FvReadFile (
   return Status;
 }
 
+/**
+  Dump the FV file lookup and section stream cache statistics.
+
+**/
+VOID
+CoreDumpFwVolCacheStatistics (
+  VOID
+  )
+{
+  DEBUG ((
+    DEBUG_INFO,
+    "FwVol: %ld file lookups, %ld GUID compares, %ld misses\n",
+    mFvCacheStatistics.FileLookupCount,
+    mFvCacheStatistics.FileLookupCompareCount,
+    mFvCacheStatistics.FileLookupMissCount
+    ));
+  DEBUG ((
+    DEBUG_INFO,
+    "FwVol: section streams %ld hits, %ld misses, %ld evictions, %d open\n",
+    mFvCacheStatistics.StreamHitCount,
+    mFvCacheStatistics.StreamMissCount,
+    mFvCacheStatistics.StreamEvictionCount,
+    (UINT32)mFvCacheStatistics.StreamCount
+    ));
+  DEBUG ((
+    DEBUG_INFO,
+    "FwVol: section stream cache 0x%lx bytes, peak 0x%lx bytes, limit 0x%x bytes\n",
+    (UINT64)mFvCacheStatistics.StreamCacheSize,
+    (UINT64)mFvCacheStatistics.StreamCachePeakSize,
+    PcdGet32 (PcdFwVolDxeSectionStreamCacheSize)
+    ));
+}
+
 /**
   Locates a section in a given FFS File and
   copies it to the supplied buffer (not including section header).
@@ -491,15 +549,9 @@ FvReadFileSection (
   //
   // Use FfsEntry to cache Section Extraction Protocol Information
   //
-  if (FfsEntry->StreamHandle == 0) {
-    Status = OpenSectionStream (
-               FileSize,
-               FileBuffer,
-               &FfsEntry->StreamHandle
-               );
-    if (EFI_ERROR (Status)) {
-      goto Done;
-    }
+  Status = FvOpenSectionStream (FfsEntry, FileSize, FileBuffer);
+  if (EFI_ERROR (Status)) {
+    goto Done;
   }
 
   //
@@ -524,8 +576,10 @@ FvReadFileSection (
   }
 
   //
-  // Close of stream defered to close of FfsHeader list to allow SEP to cache data
+  // Close of stream defered to close of FfsHeader list to allow SEP to cache data,
+  // unless the section stream cache grew over its budget.
   //
+  FvReleaseSectionStream (FfsEntry, (UINTN)PcdGet32 (PcdFwVolDxeSectionStreamCacheSize));
 
 Done:
   return Status;
@@ -0,0 +1,226 @@
+/** @file
+  Section stream cache of the FV files.
+
+  FvReadFileSection() keeps the section stream of a file open, so that the
+  sections decoded from it are not decoded again. The streams of all the FVs
+  are kept on an LRU list, and the least recently used ones are closed while
+  the bytes decoded in them exceed a budget.
+
+  FvReadFileSection() may be reentered from the notification functions the
+  GUIDed section handlers signal, so the list and the statistics are only
+  changed at TPL_NOTIFY. A stream is pinned while a FvReadFileSection() call
+  uses it, and eviction skips the pinned streams.
+
+Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "DxeMain.h"
+#include "FwVolDriver.h"
+
+//
+// File lookup and section stream cache statistics of all the FVs.
+//
+FV_CACHE_STATISTICS  mFvCacheStatistics;
+
+//
+// Files of all the FVs with an open section stream, most recently used first.
+//
+LIST_ENTRY  mFvSectionStreamLru = INITIALIZE_LIST_HEAD_VARIABLE (mFvSectionStreamLru);
+
+/**
+  Account for a file lookup.
+
+  @param  CompareCount   The number of file names compared.
+  @param  Found          TRUE if the file was found.
+
+**/
+VOID
+FvCountFileLookup (
+  IN UINTN    CompareCount,
+  IN BOOLEAN  Found
+  )
+{
+  EFI_TPL  OldTpl;
+
+  OldTpl = CoreRaiseTpl (TPL_NOTIFY);
+
+  mFvCacheStatistics.FileLookupCount++;
+  mFvCacheStatistics.FileLookupCompareCount += CompareCount;
+  if (!Found) {
+    mFvCacheStatistics.FileLookupMissCount++;
+  }
+
+  CoreRestoreTpl (OldTpl);
+}
+
+/**
+  Open the section stream of a file if it is not open yet, and pin it until
+  FvReleaseSectionStream() is called.
+
+  @param  FfsFileEntry   The file whose stream is used.
+  @param  FileSize       The size of the file data, without the file header.
+  @param  FileBuffer     The file data, without the file header.
+
+  @retval EFI_SUCCESS    FfsFileEntry->StreamHandle is open and pinned.
+  @retval others         The stream could not be opened. It is not pinned.
+
+**/
+EFI_STATUS
+FvOpenSectionStream (
+  IN FFS_FILE_LIST_ENTRY  *FfsFileEntry,
+  IN UINTN                FileSize,
+  IN VOID                 *FileBuffer
+  )
+{
+  EFI_STATUS  Status;
+  EFI_TPL     OldTpl;
+  UINTN       StreamHandle;
+
+  OldTpl = CoreRaiseTpl (TPL_NOTIFY);
+
+  FfsFileEntry->StreamPinCount++;
+  if (FfsFileEntry->StreamHandle != 0) {
+    mFvCacheStatistics.StreamHitCount++;
+    CoreRestoreTpl (OldTpl);
+    return EFI_SUCCESS;
+  }
+
+  mFvCacheStatistics.StreamMissCount++;
+  CoreRestoreTpl (OldTpl);
+
+  Status = OpenSectionStream (FileSize, FileBuffer, &StreamHandle);
+
+  OldTpl = CoreRaiseTpl (TPL_NOTIFY);
+
+  if (EFI_ERROR (Status)) {
+    FfsFileEntry->StreamPinCount--;
+  } else if (FfsFileEntry->StreamHandle != 0) {
+    //
+    // A nested call opened the stream of the same file in the meantime
+    //
+    CloseSectionStream (StreamHandle, FALSE);
+  } else {
+    FfsFileEntry->StreamHandle = StreamHandle;
+    FfsFileEntry->StreamSize   = 0;
+    mFvCacheStatistics.StreamCount++;
+  }
+
+  CoreRestoreTpl (OldTpl);
+
+  return Status;
+}
+
+/**
+  Close the section stream of a file and drop it from the section stream
+  cache. The caller must have raised the TPL to TPL_NOTIFY.
+
+  @param  FfsFileEntry   The file whose stream is closed.
+
+**/
+STATIC
+VOID
+FvCloseSectionStreamLocked (
+  IN FFS_FILE_LIST_ENTRY  *FfsFileEntry
+  )
+{
+  if (!IsListEmpty (&FfsFileEntry->StreamLink)) {
+    RemoveEntryList (&FfsFileEntry->StreamLink);
+    InitializeListHead (&FfsFileEntry->StreamLink);
+  }
+
+  mFvCacheStatistics.StreamCacheSize -= FfsFileEntry->StreamSize;
+  mFvCacheStatistics.StreamCount--;
+  FfsFileEntry->StreamSize = 0;
+
+  CloseSectionStream (FfsFileEntry->StreamHandle, FALSE);
+  FfsFileEntry->StreamHandle = 0;
+}
+
+/**
+  Close the section stream of a file and drop it from the section stream cache.
+
+  @param  FfsFileEntry   The file whose stream is closed.
+
+**/
+VOID
+FvCloseSectionStream (
+  IN FFS_FILE_LIST_ENTRY  *FfsFileEntry
+  )
+{
+  EFI_TPL  OldTpl;
+
+  OldTpl = CoreRaiseTpl (TPL_NOTIFY);
+
+  if (FfsFileEntry->StreamHandle != 0) {
+    FvCloseSectionStreamLocked (FfsFileEntry);
+  }
+
+  CoreRestoreTpl (OldTpl);
+}
+
+/**
+  Unpin the section stream of a file, account for the sections it decoded,
+  make it the most recently used one, and close the least recently used
+  streams of any FV that are not pinned while the decoded bytes of all the
+  streams exceed CacheLimit.
+
+  @param  FfsFileEntry   The file whose section stream was just used.
+  @param  CacheLimit     The budget of decoded bytes, 0 for no limit.
+
+**/
+VOID
+FvReleaseSectionStream (
+  IN FFS_FILE_LIST_ENTRY  *FfsFileEntry,
+  IN UINTN                CacheLimit
+  )
+{
+  EFI_TPL              OldTpl;
+  UINTN                StreamSize;
+  LIST_ENTRY           *Link;
+  FFS_FILE_LIST_ENTRY  *Victim;
+
+  OldTpl = CoreRaiseTpl (TPL_NOTIFY);
+
+  ASSERT (FfsFileEntry->StreamPinCount > 0);
+  FfsFileEntry->StreamPinCount--;
+
+  if (FfsFileEntry->StreamHandle == 0) {
+    CoreRestoreTpl (OldTpl);
+    return;
+  }
+
+  StreamSize = GetSectionStreamDecodedSize (FfsFileEntry->StreamHandle);
+  mFvCacheStatistics.StreamCacheSize += StreamSize - FfsFileEntry->StreamSize;
+  FfsFileEntry->StreamSize            = StreamSize;
+  if (mFvCacheStatistics.StreamCacheSize > mFvCacheStatistics.StreamCachePeakSize) {
+    mFvCacheStatistics.StreamCachePeakSize = mFvCacheStatistics.StreamCacheSize;
+  }
+
+  if (!IsListEmpty (&FfsFileEntry->StreamLink)) {
+    RemoveEntryList (&FfsFileEntry->StreamLink);
+  }
+
+  InsertHeadList (&mFvSectionStreamLru, &FfsFileEntry->StreamLink);
+
+  //
+  // The stream just used stays open even if it alone is over the budget, so
+  // that a caller reading sections of one file in turn does not decode the
+  // file again for each section. The streams an outer call is still using
+  // stay open too.
+  //
+  Link = mFvSectionStreamLru.BackLink;
+  while ((CacheLimit != 0) && (mFvCacheStatistics.StreamCacheSize > CacheLimit) && (Link != &mFvSectionStreamLru)) {
+    Victim = BASE_CR (Link, FFS_FILE_LIST_ENTRY, StreamLink);
+    Link   = Link->BackLink;
+    if ((Victim == FfsFileEntry) || (Victim->StreamPinCount != 0)) {
+      continue;
+    }
+
+    mFvCacheStatistics.StreamEvictionCount++;
+    FvCloseSectionStreamLocked (Victim);
+  }
+
+  CoreRestoreTpl (OldTpl);
+}
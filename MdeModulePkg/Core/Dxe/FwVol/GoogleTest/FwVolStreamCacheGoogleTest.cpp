@@ -0,0 +1,311 @@
+/** @file
+  Unit tests for the DXE Core FV section stream cache.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+#include <Library/GoogleTestLib.h>
+#include <map>
+#include <set>
+#include <vector>
+
+extern "C" {
+  #include <PiDxe.h>
+  #include <Library/BaseLib.h>
+  #include <Library/BaseMemoryLib.h>
+  #include <Protocol/FirmwareVolume2.h>
+  #include <Protocol/FirmwareVolumeBlock.h>
+  #include "../FwVolDriver.h"
+
+  extern LIST_ENTRY  mFvSectionStreamLru;
+}
+
+using namespace testing;
+
+//
+// Section streams of the fake section extraction code, by handle: the number
+// of bytes decoded in each of them.
+//
+static std::map<UINTN, UINTN>  mStreams;
+static std::set<UINTN>         mClosedStreams;
+static UINTN                   mNextStreamHandle;
+static EFI_TPL                 mTpl;
+
+//
+// Called by the fake OpenSectionStream (), to run a nested
+// FvReadFileSection () before the stream handle is returned.
+//
+static void                    (*mOnOpen)(
+  VOID
+  );
+
+extern "C" {
+  EFI_TPL
+  EFIAPI
+  CoreRaiseTpl (
+    IN EFI_TPL  NewTpl
+    )
+  {
+    EFI_TPL  OldTpl;
+
+    EXPECT_GE (NewTpl, mTpl);
+    OldTpl = mTpl;
+    mTpl   = NewTpl;
+    return OldTpl;
+  }
+
+  VOID
+  EFIAPI
+  CoreRestoreTpl (
+    IN EFI_TPL  NewTpl
+    )
+  {
+    mTpl = NewTpl;
+  }
+
+  EFI_STATUS
+  EFIAPI
+  OpenSectionStream (
+    IN     UINTN  SectionStreamLength,
+    IN     VOID   *SectionStream,
+    OUT UINTN     *SectionStreamHandle
+    )
+  {
+    void  (*OnOpen)(
+      VOID
+      );
+
+    EXPECT_EQ (mTpl, (EFI_TPL)TPL_APPLICATION);
+
+    OnOpen  = mOnOpen;
+    mOnOpen = NULL;
+    if (OnOpen != NULL) {
+      OnOpen ();
+    }
+
+    *SectionStreamHandle           = ++mNextStreamHandle;
+    mStreams[*SectionStreamHandle] = 0;
+    return EFI_SUCCESS;
+  }
+
+  EFI_STATUS
+  EFIAPI
+  CloseSectionStream (
+    IN  UINTN    StreamHandleToClose,
+    IN  BOOLEAN  FreeStreamBuffer
+    )
+  {
+    EXPECT_EQ (mStreams.count (StreamHandleToClose), (size_t)1);
+    mStreams.erase (StreamHandleToClose);
+    mClosedStreams.insert (StreamHandleToClose);
+    return EFI_SUCCESS;
+  }
+
+  UINTN
+  GetSectionStreamDecodedSize (
+    IN UINTN  SectionStreamHandle
+    )
+  {
+    return mStreams[SectionStreamHandle];
+  }
+}
+
+class FwVolStreamCacheTest : public Test {
+public:
+  std::vector<FFS_FILE_LIST_ENTRY>  Files;
+
+protected:
+  void
+  SetUp (
+    ) override
+  {
+    mStreams.clear ();
+    mClosedStreams.clear ();
+    mNextStreamHandle = 0;
+    mTpl              = TPL_APPLICATION;
+    mOnOpen           = NULL;
+    ZeroMem (&mFvCacheStatistics, sizeof (mFvCacheStatistics));
+    InitializeListHead (&mFvSectionStreamLru);
+
+    Files.assign (4, FFS_FILE_LIST_ENTRY ());
+    for (UINTN Index = 0; Index < Files.size (); Index++) {
+      InitializeListHead (&Files[Index].StreamLink);
+    }
+  }
+
+public:
+  // Read a section of a file that decodes Size more bytes in its stream, as
+  // FvReadFileSection () does.
+  void
+  Read (
+    UINTN  Index,
+    UINTN  Size,
+    UINTN  CacheLimit
+    )
+  {
+    Open (Index);
+    Release (Index, Size, CacheLimit);
+  }
+
+  void
+  Open (
+    UINTN  Index
+    )
+  {
+    ASSERT_EQ (FvOpenSectionStream (&Files[Index], 0, NULL), EFI_SUCCESS);
+    ASSERT_NE (Files[Index].StreamHandle, (UINTN)0);
+  }
+
+  void
+  Release (
+    UINTN  Index,
+    UINTN  Size,
+    UINTN  CacheLimit
+    )
+  {
+    mStreams[Files[Index].StreamHandle] += Size;
+    FvReleaseSectionStream (&Files[Index], CacheLimit);
+    EXPECT_EQ (mTpl, (EFI_TPL)TPL_APPLICATION);
+  }
+};
+
+// The least recently used streams are closed once the decoded bytes exceed
+// the budget, and a stream used again moves to the front.
+TEST_F (FwVolStreamCacheTest, EvictsLeastRecentlyUsed) {
+  Read (0, 100, 250);
+  Read (1, 100, 250);
+  Read (0, 0, 250);
+  Read (2, 100, 250);
+
+  EXPECT_EQ (Files[1].StreamHandle, (UINTN)0);
+  EXPECT_NE (Files[0].StreamHandle, (UINTN)0);
+  EXPECT_NE (Files[2].StreamHandle, (UINTN)0);
+  EXPECT_EQ (mFvCacheStatistics.StreamEvictionCount, (UINT64)1);
+  EXPECT_EQ (mFvCacheStatistics.StreamCacheSize, (UINTN)200);
+  EXPECT_EQ (mFvCacheStatistics.StreamCount, (UINTN)2);
+  EXPECT_EQ (mFvCacheStatistics.StreamHitCount, (UINT64)1);
+  EXPECT_EQ (mFvCacheStatistics.StreamMissCount, (UINT64)3);
+}
+
+// The stream just used stays open even when it alone is over the budget.
+TEST_F (FwVolStreamCacheTest, KeepsStreamJustUsed) {
+  Read (0, 100, 150);
+  Read (1, 500, 150);
+
+  EXPECT_EQ (Files[0].StreamHandle, (UINTN)0);
+  EXPECT_NE (Files[1].StreamHandle, (UINTN)0);
+  EXPECT_EQ (mFvCacheStatistics.StreamCacheSize, (UINTN)500);
+}
+
+// A budget of 0 never closes a stream.
+TEST_F (FwVolStreamCacheTest, NoLimit) {
+  for (UINTN Index = 0; Index < Files.size (); Index++) {
+    Read (Index, 1000, 0);
+  }
+
+  EXPECT_TRUE (mClosedStreams.empty ());
+  EXPECT_EQ (mFvCacheStatistics.StreamCachePeakSize, (UINTN)4000);
+}
+
+// A nested read, such as one from a notification function signaled while
+// an outer read decodes its file, must not close the stream of the outer
+// read, even when it is the least recently used one.
+TEST_F (FwVolStreamCacheTest, NestedReadSkipsPinnedStream) {
+  Read (0, 100, 150);
+  Open (0);
+
+  Read (1, 100, 150);
+  EXPECT_NE (Files[0].StreamHandle, (UINTN)0);
+  EXPECT_NE (Files[1].StreamHandle, (UINTN)0);
+
+  Read (2, 100, 150);
+  EXPECT_NE (Files[0].StreamHandle, (UINTN)0);
+  EXPECT_EQ (Files[1].StreamHandle, (UINTN)0);
+
+  //
+  // Once the outer read is done, its stream can be evicted again
+  //
+  Release (0, 0, 150);
+  Read (3, 100, 150);
+  EXPECT_EQ (Files[0].StreamHandle, (UINTN)0);
+  EXPECT_EQ (Files[2].StreamHandle, (UINTN)0);
+  EXPECT_NE (Files[3].StreamHandle, (UINTN)0);
+  EXPECT_EQ (Files[0].StreamPinCount, (UINTN)0);
+}
+
+// A nested read of the same file keeps the stream pinned until the outer
+// read is done too.
+TEST_F (FwVolStreamCacheTest, NestedReadOfSameFile) {
+  Open (0);
+  Read (0, 100, 50);
+  EXPECT_EQ (Files[0].StreamPinCount, (UINTN)1);
+
+  Read (1, 100, 50);
+  EXPECT_NE (Files[0].StreamHandle, (UINTN)0);
+
+  Release (0, 0, 50);
+  EXPECT_EQ (Files[0].StreamPinCount, (UINTN)0);
+  EXPECT_EQ (Files[1].StreamHandle, (UINTN)0);
+}
+
+static FwVolStreamCacheTest  *mNestedTest;
+
+static void
+NestedOpenOfSameFile (
+  VOID
+  )
+{
+  mNestedTest->Read (0, 100, 0);
+}
+
+// If a nested read opens the stream of the same file while the outer read
+// is opening it, the outer read uses the stream of the nested read and
+// closes its own.
+TEST_F (FwVolStreamCacheTest, NestedOpenOfSameFile) {
+  mNestedTest = this;
+  mOnOpen     = NestedOpenOfSameFile;
+
+  Open (0);
+  EXPECT_EQ (Files[0].StreamHandle, (UINTN)1);
+  EXPECT_EQ (Files[0].StreamPinCount, (UINTN)1);
+  EXPECT_EQ (mClosedStreams.count (2), (size_t)1);
+
+  Release (0, 0, 0);
+  EXPECT_EQ (mFvCacheStatistics.StreamCount, (UINTN)1);
+  EXPECT_EQ (mFvCacheStatistics.StreamCacheSize, (UINTN)100);
+}
+
+// Closing a stream, as when the FV goes away, drops it from the cache.
+TEST_F (FwVolStreamCacheTest, Close) {
+  Read (0, 100, 0);
+  Read (1, 100, 0);
+  FvCloseSectionStream (&Files[0]);
+  FvCloseSectionStream (&Files[2]);
+
+  EXPECT_EQ (Files[0].StreamHandle, (UINTN)0);
+  EXPECT_TRUE (IsListEmpty (&Files[0].StreamLink));
+  EXPECT_EQ (mFvCacheStatistics.StreamCount, (UINTN)1);
+  EXPECT_EQ (mFvCacheStatistics.StreamCacheSize, (UINTN)100);
+  EXPECT_EQ (mTpl, (EFI_TPL)TPL_APPLICATION);
+}
+
+// File lookups are counted.
+TEST_F (FwVolStreamCacheTest, CountFileLookup) {
+  FvCountFileLookup (3, TRUE);
+  FvCountFileLookup (2, FALSE);
+
+  EXPECT_EQ (mFvCacheStatistics.FileLookupCount, (UINT64)2);
+  EXPECT_EQ (mFvCacheStatistics.FileLookupCompareCount, (UINT64)5);
+  EXPECT_EQ (mFvCacheStatistics.FileLookupMissCount, (UINT64)1);
+  EXPECT_EQ (mTpl, (EFI_TPL)TPL_APPLICATION);
+}
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  testing::InitGoogleTest (&argc, argv);
+  return RUN_ALL_TESTS ();
+}
@@ -46,6 +46,13 @@ EFI_LOCK    mGcdIoSpaceLock     = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
 LIST_ENTRY  mGcdMemorySpaceMap  = INITIALIZE_LIST_HEAD_VARIABLE (mGcdMemorySpaceMap);
 LIST_ENTRY  mGcdIoSpaceMap      = INITIALIZE_LIST_HEAD_VARIABLE (mGcdIoSpaceMap);
 
+//
+// Roots of the AVL trees that index the entries of mGcdMemorySpaceMap and
+// mGcdIoSpaceMap on their BaseAddress
+//
+EFI_GCD_MAP_ENTRY  *mGcdMemorySpaceTree = NULL;
+EFI_GCD_MAP_ENTRY  *mGcdIoSpaceTree     = NULL;
+
 EFI_GCD_MAP_ENTRY  mGcdMemorySpaceMapEntryTemplate = {
   EFI_GCD_MAP_SIGNATURE,
   {
@@ -59,7 +66,10 @@ EFI_GCD_MAP_ENTRY  mGcdMemorySpaceMapEntryTemplate = {
   EfiGcdMemoryTypeNonExistent,
   (EFI_GCD_IO_TYPE)0,
   NULL,
-  NULL
+  NULL,
+  NULL,
+  NULL,
+  0
 };
 
 EFI_GCD_MAP_ENTRY  mGcdIoSpaceMapEntryTemplate = {
@@ -75,7 +85,10 @@ EFI_GCD_MAP_ENTRY  mGcdIoSpaceMapEntryTemplate = {
   (EFI_GCD_MEMORY_TYPE)0,
   EfiGcdIoTypeNonExistent,
   NULL,
-  NULL
+  NULL,
+  NULL,
+  NULL,
+  0
 };
 
 GCD_ATTRIBUTE_CONVERSION_ENTRY  mAttributeConversionTable[] = {
@@ -430,6 +443,330 @@ CoreAllocateGcdMapEntry (
   return EFI_SUCCESS;
 }
 
+/**
+  Return the root of the tree that indexes a GCD map.
+
+  @param  Map                    The GCD map
+
+  @return Pointer to the root of the tree of Map
+
+**/
+STATIC
+EFI_GCD_MAP_ENTRY **
+CoreGcdMapTreeRoot (
+  IN LIST_ENTRY  *Map
+  )
+{
+  if (Map == &mGcdMemorySpaceMap) {
+    return &mGcdMemorySpaceTree;
+  }
+
+  ASSERT (Map == &mGcdIoSpaceMap);
+  return &mGcdIoSpaceTree;
+}
+
+/**
+  Return the height of a GCD map tree node.
+
+  @param  Node                   The tree node, or NULL
+
+  @return The height of the subtree rooted at Node
+
+**/
+STATIC
+UINTN
+CoreGcdMapTreeHeight (
+  IN EFI_GCD_MAP_ENTRY  *Node
+  )
+{
+  return (Node == NULL) ? 0 : Node->Height;
+}
+
+/**
+  Recompute the height of a GCD map tree node from its children.
+
+  @param  Node                   The tree node
+
+**/
+STATIC
+VOID
+CoreGcdMapTreeUpdateHeight (
+  IN EFI_GCD_MAP_ENTRY  *Node
+  )
+{
+  Node->Height = 1 + MAX (CoreGcdMapTreeHeight (Node->Left), CoreGcdMapTreeHeight (Node->Right));
+}
+
+/**
+  Rotate a GCD map subtree so that the left child of Node becomes its root.
+
+  @param  Node                   The root of the subtree
+
+  @return The new root of the subtree
+
+**/
+STATIC
+EFI_GCD_MAP_ENTRY *
+CoreGcdMapTreeRotateRight (
+  IN EFI_GCD_MAP_ENTRY  *Node
+  )
+{
+  EFI_GCD_MAP_ENTRY  *Pivot;
+
+  Pivot        = Node->Left;
+  Node->Left   = Pivot->Right;
+  Pivot->Right = Node;
+  CoreGcdMapTreeUpdateHeight (Node);
+  CoreGcdMapTreeUpdateHeight (Pivot);
+
+  return Pivot;
+}
+
+/**
+  Rotate a GCD map subtree so that the right child of Node becomes its root.
+
+  @param  Node                   The root of the subtree
+
+  @return The new root of the subtree
+
+**/
+STATIC
+EFI_GCD_MAP_ENTRY *
+CoreGcdMapTreeRotateLeft (
+  IN EFI_GCD_MAP_ENTRY  *Node
+  )
+{
+  EFI_GCD_MAP_ENTRY  *Pivot;
+
+  Pivot       = Node->Right;
+  Node->Right = Pivot->Left;
+  Pivot->Left = Node;
+  CoreGcdMapTreeUpdateHeight (Node);
+  CoreGcdMapTreeUpdateHeight (Pivot);
+
+  return Pivot;
+}
+
+/**
+  Restore the AVL balance of a GCD map subtree whose children are balanced
+  and differ in height by at most 2.
+
+  @param  Node                   The root of the subtree
+
+  @return The new root of the subtree
+
+**/
+STATIC
+EFI_GCD_MAP_ENTRY *
+CoreGcdMapTreeBalance (
+  IN EFI_GCD_MAP_ENTRY  *Node
+  )
+{
+  UINTN  LeftHeight;
+  UINTN  RightHeight;
+
+  CoreGcdMapTreeUpdateHeight (Node);
+  LeftHeight  = CoreGcdMapTreeHeight (Node->Left);
+  RightHeight = CoreGcdMapTreeHeight (Node->Right);
+
+  if (LeftHeight > RightHeight + 1) {
+    if (CoreGcdMapTreeHeight (Node->Left->Left) < CoreGcdMapTreeHeight (Node->Left->Right)) {
+      Node->Left = CoreGcdMapTreeRotateLeft (Node->Left);
+    }
+
+    return CoreGcdMapTreeRotateRight (Node);
+  }
+
+  if (RightHeight > LeftHeight + 1) {
+    if (CoreGcdMapTreeHeight (Node->Right->Right) < CoreGcdMapTreeHeight (Node->Right->Left)) {
+      Node->Right = CoreGcdMapTreeRotateRight (Node->Right);
+    }
+
+    return CoreGcdMapTreeRotateLeft (Node);
+  }
+
+  return Node;
+}
+
+/**
+  Insert an entry into a GCD map subtree. No other entry of the subtree may
+  have the same BaseAddress.
+
+  @param  Node                   The root of the subtree, or NULL
+  @param  Entry                  The entry to insert
+
+  @return The new root of the subtree
+
+**/
+STATIC
+EFI_GCD_MAP_ENTRY *
+CoreGcdMapTreeInsert (
+  IN EFI_GCD_MAP_ENTRY  *Node,
+  IN EFI_GCD_MAP_ENTRY  *Entry
+  )
+{
+  if (Node == NULL) {
+    Entry->Left   = NULL;
+    Entry->Right  = NULL;
+    Entry->Height = 1;
+    return Entry;
+  }
+
+  ASSERT (Entry->BaseAddress != Node->BaseAddress);
+  if (Entry->BaseAddress < Node->BaseAddress) {
+    Node->Left = CoreGcdMapTreeInsert (Node->Left, Entry);
+  } else {
+    Node->Right = CoreGcdMapTreeInsert (Node->Right, Entry);
+  }
+
+  return CoreGcdMapTreeBalance (Node);
+}
+
+/**
+  Detach the entry with the lowest BaseAddress from a GCD map subtree.
+
+  @param  Node                   The root of the subtree
+  @param  Min                    Returns the detached entry
+
+  @return The new root of the subtree
+
+**/
+STATIC
+EFI_GCD_MAP_ENTRY *
+CoreGcdMapTreeRemoveMin (
+  IN  EFI_GCD_MAP_ENTRY  *Node,
+  OUT EFI_GCD_MAP_ENTRY  **Min
+  )
+{
+  if (Node->Left == NULL) {
+    *Min = Node;
+    return Node->Right;
+  }
+
+  Node->Left = CoreGcdMapTreeRemoveMin (Node->Left, Min);
+  return CoreGcdMapTreeBalance (Node);
+}
+
+/**
+  Remove an entry from a GCD map subtree.
+
+  @param  Node                   The root of the subtree
+  @param  Entry                  The entry to remove. It must be in the subtree.
+
+  @return The new root of the subtree
+
+**/
+STATIC
+EFI_GCD_MAP_ENTRY *
+CoreGcdMapTreeRemove (
+  IN EFI_GCD_MAP_ENTRY  *Node,
+  IN EFI_GCD_MAP_ENTRY  *Entry
+  )
+{
+  EFI_GCD_MAP_ENTRY  *Min;
+  EFI_GCD_MAP_ENTRY  *Right;
+
+  ASSERT (Node != NULL);
+
+  if (Entry->BaseAddress < Node->BaseAddress) {
+    Node->Left = CoreGcdMapTreeRemove (Node->Left, Entry);
+  } else if (Entry->BaseAddress > Node->BaseAddress) {
+    Node->Right = CoreGcdMapTreeRemove (Node->Right, Entry);
+  } else {
+    ASSERT (Node == Entry);
+    if (Node->Right == NULL) {
+      return Node->Left;
+    }
+
+    Right      = CoreGcdMapTreeRemoveMin (Node->Right, &Min);
+    Min->Left  = Node->Left;
+    Min->Right = Right;
+    Node       = Min;
+  }
+
+  return CoreGcdMapTreeBalance (Node);
+}
+
+/**
+  Find the entry of a GCD map that covers an address.
+
+  @param  Map                    The GCD map
+  @param  Address                The address to look up
+
+  @return The entry that covers Address, or NULL if there is none
+
+**/
+STATIC
+EFI_GCD_MAP_ENTRY *
+CoreGcdMapTreeFind (
+  IN LIST_ENTRY            *Map,
+  IN EFI_PHYSICAL_ADDRESS  Address
+  )
+{
+  EFI_GCD_MAP_ENTRY  *Node;
+  EFI_GCD_MAP_ENTRY  *Floor;
+
+  //
+  // Find the entry with the highest BaseAddress that is not above Address
+  //
+  Floor = NULL;
+  Node  = *CoreGcdMapTreeRoot (Map);
+  while (Node != NULL) {
+    if (Address < Node->BaseAddress) {
+      Node = Node->Left;
+    } else {
+      Floor = Node;
+      Node  = Node->Right;
+    }
+  }
+
+  if ((Floor == NULL) || (Address > Floor->EndAddress)) {
+    return NULL;
+  }
+
+  return Floor;
+}
+
+/**
+  Add an entry to the tree index of a GCD map.
+
+  @param  Map                    The GCD map
+  @param  Entry                  The entry to add
+
+**/
+STATIC
+VOID
+CoreGcdMapTreeAdd (
+  IN LIST_ENTRY         *Map,
+  IN EFI_GCD_MAP_ENTRY  *Entry
+  )
+{
+  EFI_GCD_MAP_ENTRY  **Root;
+
+  Root  = CoreGcdMapTreeRoot (Map);
+  *Root = CoreGcdMapTreeInsert (*Root, Entry);
+}
+
+/**
+  Remove an entry from the tree index of a GCD map.
+
+  @param  Map                    The GCD map
+  @param  Entry                  The entry to remove
+
+**/
+STATIC
+VOID
+CoreGcdMapTreeDelete (
+  IN LIST_ENTRY         *Map,
+  IN EFI_GCD_MAP_ENTRY  *Entry
+  )
+{
+  EFI_GCD_MAP_ENTRY  **Root;
+
+  Root  = CoreGcdMapTreeRoot (Map);
+  *Root = CoreGcdMapTreeRemove (*Root, Entry);
+}
+
 /**
   Internal function.  Inserts a new descriptor into a sorted list
 
@@ -440,6 +777,7 @@ CoreAllocateGcdMapEntry (
   @param  Length                 The length of the new range in bytes
   @param  TopEntry               Top pad entry to insert if needed.
   @param  BottomEntry            Bottom pad entry to insert if needed.
+  @param  Map                    The GCD map Link is on.
 
   @retval EFI_SUCCESS            The new range was inserted into the linked list
 
@@ -451,7 +789,8 @@ CoreInsertGcdMapEntry (
   IN EFI_PHYSICAL_ADDRESS  BaseAddress,
   IN UINT64                Length,
   IN EFI_GCD_MAP_ENTRY     *TopEntry,
-  IN EFI_GCD_MAP_ENTRY     *BottomEntry
+  IN EFI_GCD_MAP_ENTRY     *BottomEntry,
+  IN LIST_ENTRY            *Map
   )
 {
   ASSERT (Length != 0);
@@ -459,10 +798,15 @@ CoreInsertGcdMapEntry (
   if (BaseAddress > Entry->BaseAddress) {
     ASSERT (BottomEntry->Signature == 0);
 
+    //
+    // Raising the BaseAddress of Entry within its own range keeps the tree
+    // ordered, and frees the old BaseAddress for BottomEntry.
+    //
     CopyMem (BottomEntry, Entry, sizeof (EFI_GCD_MAP_ENTRY));
     Entry->BaseAddress      = BaseAddress;
     BottomEntry->EndAddress = BaseAddress - 1;
     InsertTailList (Link, &BottomEntry->Link);
+    CoreGcdMapTreeAdd (Map, BottomEntry);
   }
 
   if ((BaseAddress + Length - 1) < Entry->EndAddress) {
@@ -472,6 +816,7 @@ CoreInsertGcdMapEntry (
     TopEntry->BaseAddress = BaseAddress + Length;
     Entry->EndAddress     = BaseAddress + Length - 1;
     InsertHeadList (Link, &TopEntry->Link);
+    CoreGcdMapTreeAdd (Map, TopEntry);
   }
 
   return EFI_SUCCESS;
@@ -543,6 +888,11 @@ CoreMergeGcdMapEntry (
     return EFI_UNSUPPORTED;
   }
 
+  //
+  // Drop AdjacentEntry from the tree before Entry takes over its BaseAddress
+  //
+  CoreGcdMapTreeDelete (Map, AdjacentEntry);
+
   if (Forward) {
     Entry->EndAddress = AdjacentEntry->EndAddress;
   } else {
@@ -629,20 +979,25 @@ CoreSearchGcdMapEntry (
   *StartLink = NULL;
   *EndLink   = NULL;
 
-  Link = Map->ForwardLink;
+  //
+  // Look up the entry that covers BaseAddress in the tree, then walk the
+  // sorted list from there to the entry that covers the end of the segment.
+  //
+  Entry = CoreGcdMapTreeFind (Map, BaseAddress);
+  if (Entry == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  *StartLink = &Entry->Link;
+
+  Link = *StartLink;
   while (Link != Map) {
     Entry = CR (Link, EFI_GCD_MAP_ENTRY, Link, EFI_GCD_MAP_SIGNATURE);
-    if ((BaseAddress >= Entry->BaseAddress) && (BaseAddress <= Entry->EndAddress)) {
-      *StartLink = Link;
-    }
-
-    if (*StartLink != NULL) {
-      if (((BaseAddress + Length - 1) >= Entry->BaseAddress) &&
-          ((BaseAddress + Length - 1) <= Entry->EndAddress))
-      {
-        *EndLink = Link;
-        return EFI_SUCCESS;
-      }
+    if (((BaseAddress + Length - 1) >= Entry->BaseAddress) &&
+        ((BaseAddress + Length - 1) <= Entry->EndAddress))
+    {
+      *EndLink = Link;
+      return EFI_SUCCESS;
     }
 
     Link = Link->ForwardLink;
@@ -951,7 +1306,7 @@ CoreConvertSpace (
   Link = StartLink;
   while (Link != EndLink->ForwardLink) {
     Entry = CR (Link, EFI_GCD_MAP_ENTRY, Link, EFI_GCD_MAP_SIGNATURE);
-    CoreInsertGcdMapEntry (Link, Entry, BaseAddress, Length, TopEntry, BottomEntry);
+    CoreInsertGcdMapEntry (Link, Entry, BaseAddress, Length, TopEntry, BottomEntry, Map);
     switch (Operation) {
       //
       // Add operations
@@ -1353,7 +1708,7 @@ CoreAllocateSpace (
   Link = StartLink;
   while (Link != EndLink->ForwardLink) {
     Entry = CR (Link, EFI_GCD_MAP_ENTRY, Link, EFI_GCD_MAP_SIGNATURE);
-    CoreInsertGcdMapEntry (Link, Entry, *BaseAddress, Length, TopEntry, BottomEntry);
+    CoreInsertGcdMapEntry (Link, Entry, *BaseAddress, Length, TopEntry, BottomEntry, Map);
     Entry->ImageHandle  = ImageHandle;
     Entry->DeviceHandle = DeviceHandle;
     Link                = Link->ForwardLink;
@@ -2637,6 +2992,7 @@ CoreInitializeGcdServices (
   Entry->EndAddress = LShiftU64 (1, SizeOfMemorySpace) - 1;
 
   InsertHeadList (&mGcdMemorySpaceMap, &Entry->Link);
+  CoreGcdMapTreeAdd (&mGcdMemorySpaceMap, Entry);
 
   CoreDumpGcdMemorySpaceMap (TRUE);
 
@@ -2649,6 +3005,7 @@ CoreInitializeGcdServices (
   Entry->EndAddress = LShiftU64 (1, SizeOfIoSpace) - 1;
 
   InsertHeadList (&mGcdIoSpaceMap, &Entry->Link);
+  CoreGcdMapTreeAdd (&mGcdIoSpaceMap, Entry);
 
   CoreDumpGcdIoSpaceMap (TRUE);
 
@@ -10,16 +10,40 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "Handle.h"
 
 //
-// mProtocolDatabase     - A list of all protocols in the system.  (simple list for now)
+// mProtocolDatabase     - A list of all protocols in the system, in creation order
+// mProtocolHashTable    - GUID hash index of the entries in mProtocolDatabase
 // gHandleList           - A list of all the handles in the system
+// mHandleTable          - Hash table of all the handles in gHandleList, keyed by address
 // gProtocolDatabaseLock - Lock to protect the mProtocolDatabase
 // gHandleDatabaseKey    -  The Key to show that the handle has been created/modified
 //
-LIST_ENTRY          mProtocolDatabase     = INITIALIZE_LIST_HEAD_VARIABLE (mProtocolDatabase);
-LIST_ENTRY          gHandleList           = INITIALIZE_LIST_HEAD_VARIABLE (gHandleList);
-EFI_LOCK            gProtocolDatabaseLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
-UINT64              gHandleDatabaseKey    = 0;
-ORDERED_COLLECTION  *gOrderedHandleList   = NULL;
+LIST_ENTRY  mProtocolDatabase     = INITIALIZE_LIST_HEAD_VARIABLE (mProtocolDatabase);
+LIST_ENTRY  mProtocolHashTable[PROTOCOL_HASH_BUCKET_COUNT];
+LIST_ENTRY  gHandleList           = INITIALIZE_LIST_HEAD_VARIABLE (gHandleList);
+LIST_ENTRY  *mHandleTable         = NULL;
+UINTN       mHandleTableBits      = 0;
+UINTN       mHandleCount          = 0;
+EFI_LOCK    gProtocolDatabaseLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
+UINT64      gHandleDatabaseKey    = 0;
+
+//
+// Protocol database lookup statistics.
+// mProtocolEntryCount           - Number of entries in mProtocolDatabase
+// mProtocolLookupCount          - Number of CoreFindProtocolEntry() calls
+// mProtocolLookupCompareCount   - GUID compares done through mProtocolHashTable
+// mProtocolLookupCompareSaved   - GUID compares a linear walk of mProtocolDatabase
+//                                 would have needed on top of the hashed ones
+//
+UINTN   mProtocolEntryCount         = 0;
+UINT64  mProtocolLookupCount        = 0;
+UINT64  mProtocolLookupCompareCount = 0;
+UINT64  mProtocolLookupCompareSaved = 0;
+
+//
+// Per-handle most recently used protocol interface cache statistics.
+//
+UINT64  mProtocolMruHitCount  = 0;
+UINT64  mProtocolMruMissCount = 0;
 
 /**
   Acquire lock on gProtocolDatabaseLock.
@@ -46,37 +70,130 @@ CoreReleaseProtocolLock (
 }
 
 /**
-  Comparator function for two opaque pointers, ordering on (unsigned) pointer
-  value itself.
-  Can be used as both Key and UserStruct comparator.
+  Compute the mProtocolHashTable bucket index of a protocol GUID.
+
+  @param  Protocol               The ID of the protocol
+
+  @return Index of the bucket that holds the protocol entry for Protocol
+
+**/
+STATIC
+UINTN
+CoreProtocolHashBucket (
+  IN CONST EFI_GUID  *Protocol
+  )
+{
+  UINT32  Hash;
+
+  Hash = ReadUnaligned32 ((CONST UINT32 *)Protocol) ^
+         ReadUnaligned32 ((CONST UINT32 *)Protocol + 1) ^
+         ReadUnaligned32 ((CONST UINT32 *)Protocol + 2) ^
+         ReadUnaligned32 ((CONST UINT32 *)Protocol + 3);
+  Hash ^= Hash >> 16;
+  Hash ^= Hash >> 8;
 
-  @param[in] Pointer1  First pointer.
+  return (UINTN)(Hash & (PROTOCOL_HASH_BUCKET_COUNT - 1));
+}
 
-  @param[in] Pointer2  Second pointer.
+/**
+  Compute the mHandleTable bucket index of a handle.
 
-  @retval <0  If Pointer1 compares less than Pointer2.
+  @param  Handle                 The handle
 
-  @retval  0  If Pointer1 compares equal to Pointer2.
+  @return Index of the bucket that holds Handle
 
-  @retval >0  If Pointer1 compares greater than Pointer2.
 **/
 STATIC
-INTN
-EFIAPI
-PointerCompare (
-  IN CONST VOID  *Pointer1,
-  IN CONST VOID  *Pointer2
+UINTN
+CoreHandleTableBucket (
+  IN CONST VOID  *Handle
   )
 {
-  if (Pointer1 == Pointer2) {
-    return 0;
+  UINT32  Hash;
+
+  //
+  // Handles are pool allocations, so the low bits of the address carry no
+  // information. Fibonacci hashing spreads the rest over the table.
+  //
+  Hash = (UINT32)((UINTN)Handle >> 3) * 0x9E3779B1;
+
+  return (UINTN)(Hash >> (32 - mHandleTableBits));
+}
+
+/**
+  Allocate a handle table of 2^Bits buckets and move all the handles of
+  gHandleList into it.
+  The gProtocolDatabaseLock must be owned, or the handle database must still
+  be empty.
+
+  @param  Bits                   Log2 of the number of buckets of the new table
+
+  @retval EFI_SUCCESS            The handle table was resized.
+  @retval EFI_OUT_OF_RESOURCES   No enough buffer to allocate. The current
+                                 handle table is left unchanged.
+
+**/
+STATIC
+EFI_STATUS
+CoreResizeHandleTable (
+  IN UINTN  Bits
+  )
+{
+  LIST_ENTRY  *Table;
+  LIST_ENTRY  *Link;
+  IHANDLE     *Handle;
+  UINTN       Index;
+
+  Table = AllocatePool (sizeof (LIST_ENTRY) << Bits);
+  if (Table == NULL) {
+    return EFI_OUT_OF_RESOURCES;
   }
 
-  if ((UINTN)Pointer1 < (UINTN)Pointer2) {
-    return -1;
+  for (Index = 0; Index < ((UINTN)1 << Bits); Index++) {
+    InitializeListHead (&Table[Index]);
   }
 
-  return 1;
+  if (mHandleTable != NULL) {
+    CoreFreePool (mHandleTable);
+  }
+
+  mHandleTable     = Table;
+  mHandleTableBits = Bits;
+
+  for (Link = gHandleList.ForwardLink; Link != &gHandleList; Link = Link->ForwardLink) {
+    Handle = CR (Link, IHANDLE, AllHandles, EFI_HANDLE_SIGNATURE);
+    InsertTailList (&mHandleTable[CoreHandleTableBucket (Handle)], &Handle->HashLink);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Add a new handle to the handle table. The handle table is grown first when
+  it is over its load factor; failing to grow it only makes the buckets
+  longer.
+  The gProtocolDatabaseLock must be owned.
+
+  @param  Handle                 The handle to add. It must not be in
+                                 gHandleList yet.
+
+**/
+STATIC
+VOID
+CoreAddHandleToTable (
+  IN IHANDLE  *Handle
+  )
+{
+  ASSERT_LOCKED (&gProtocolDatabaseLock);
+
+  if ((mHandleCount >= (HANDLE_TABLE_LOAD_FACTOR << mHandleTableBits)) &&
+      (mHandleTableBits < HANDLE_TABLE_MAX_BITS))
+  {
+    CoreResizeHandleTable (mHandleTableBits + 1);
+  }
+
+  InsertTailList (&mHandleTable[CoreHandleTableBucket (Handle)], &Handle->HashLink);
+  mHandleCount++;
 }
 
 /**
@@ -90,13 +207,13 @@ CoreInitializeHandleServices (
   VOID
   )
 {
-  gOrderedHandleList = OrderedCollectionInit (PointerCompare, PointerCompare);
+  UINTN  Index;
 
-  if (gOrderedHandleList == NULL) {
-    return EFI_OUT_OF_RESOURCES;
+  for (Index = 0; Index < PROTOCOL_HASH_BUCKET_COUNT; Index++) {
+    InitializeListHead (&mProtocolHashTable[Index]);
   }
 
-  return EFI_SUCCESS;
+  return CoreResizeHandleTable (HANDLE_TABLE_INITIAL_BITS);
 }
 
 /**
@@ -114,7 +231,8 @@ CoreValidateHandle (
   IN  EFI_HANDLE  UserHandle
   )
 {
-  ORDERED_COLLECTION_ENTRY  *Entry;
+  LIST_ENTRY  *Bucket;
+  LIST_ENTRY  *Link;
 
   if (UserHandle == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -122,9 +240,15 @@ CoreValidateHandle (
 
   ASSERT_LOCKED (&gProtocolDatabaseLock);
 
-  Entry = OrderedCollectionFind (gOrderedHandleList, UserHandle);
-  if (Entry != NULL) {
-    return EFI_SUCCESS;
+  //
+  // Only compare addresses, UserHandle must not be dereferenced before it is
+  // known to be valid.
+  //
+  Bucket = &mHandleTable[CoreHandleTableBucket (UserHandle)];
+  for (Link = Bucket->ForwardLink; Link != Bucket; Link = Link->ForwardLink) {
+    if (BASE_CR (Link, IHANDLE, HashLink) == (IHANDLE *)UserHandle) {
+      return EFI_SUCCESS;
+    }
   }
 
   return EFI_INVALID_PARAMETER;
@@ -146,22 +270,24 @@ CoreFindProtocolEntry (
   IN BOOLEAN   Create
   )
 {
+  LIST_ENTRY      *Bucket;
   LIST_ENTRY      *Link;
   PROTOCOL_ENTRY  *Item;
   PROTOCOL_ENTRY  *ProtEntry;
+  UINTN           Compares;
 
   ASSERT_LOCKED (&gProtocolDatabaseLock);
 
   //
-  // Search the database for the matching GUID
+  // Search the hash bucket of the GUID for the matching entry
   //
 
   ProtEntry = NULL;
-  for (Link = mProtocolDatabase.ForwardLink;
-       Link != &mProtocolDatabase;
-       Link = Link->ForwardLink)
-  {
-    Item = CR (Link, PROTOCOL_ENTRY, AllEntries, PROTOCOL_ENTRY_SIGNATURE);
+  Compares  = 0;
+  Bucket    = &mProtocolHashTable[CoreProtocolHashBucket (Protocol)];
+  for (Link = Bucket->ForwardLink; Link != Bucket; Link = Link->ForwardLink) {
+    Item = CR (Link, PROTOCOL_ENTRY, HashLink, PROTOCOL_ENTRY_SIGNATURE);
+    Compares++;
     if (CompareGuid (&Item->ProtocolID, Protocol)) {
       //
       // This is the protocol entry
@@ -172,6 +298,17 @@ CoreFindProtocolEntry (
     }
   }
 
+  //
+  // Account for the compares a walk of mProtocolDatabase would have done
+  //
+  mProtocolLookupCount++;
+  mProtocolLookupCompareCount += Compares;
+  if (ProtEntry != NULL) {
+    mProtocolLookupCompareSaved += ProtEntry->Ordinal + 1 - Compares;
+  } else {
+    mProtocolLookupCompareSaved += mProtocolEntryCount - Compares;
+  }
+
   //
   // If the protocol entry was not found and Create is TRUE, then
   // allocate a new entry
@@ -187,11 +324,14 @@ CoreFindProtocolEntry (
       CopyGuid ((VOID *)&ProtEntry->ProtocolID, Protocol);
       InitializeListHead (&ProtEntry->Protocols);
       InitializeListHead (&ProtEntry->Notify);
+      InitializeListHead (&ProtEntry->DepexWaiters);
 
       //
-      // Add it to protocol database
+      // Add it to protocol database and to its hash bucket
       //
+      ProtEntry->Ordinal = mProtocolEntryCount++;
       InsertTailList (&mProtocolDatabase, &ProtEntry->AllEntries);
+      InsertTailList (Bucket, &ProtEntry->HashLink);
     }
   }
 
@@ -505,14 +645,9 @@ CoreInstallProtocolInterfaceNotify (
     }
 
     //
-    // Add this handle to the ordered list of all handles
-    // in the system
+    // Add this handle to the handle table used to validate handles
     //
-    Status = OrderedCollectionInsert (gOrderedHandleList, NULL, Handle);
-    if (EFI_ERROR (Status)) {
-      CoreFreePool (Handle);
-      goto Done;
-    }
+    CoreAddHandleToTable (Handle);
 
     //
     // Initialize new handler structure
@@ -870,8 +1005,12 @@ CoreUninstallProtocolInterface (
     Handle->Key = gHandleDatabaseKey;
 
     //
-    // Remove the protocol interface from the handle
+    // Remove the protocol interface from the handle and its cache
     //
+    if (Handle->MruProtocol == &Prot->Link) {
+      Handle->MruProtocol = NULL;
+    }
+
     RemoveEntryList (&Prot->Link);
 
     //
@@ -887,11 +1026,8 @@ CoreUninstallProtocolInterface (
   //
   if (IsListEmpty (&Handle->Protocols)) {
     Handle->Signature = 0;
-    OrderedCollectionDelete (
-      gOrderedHandleList,
-      OrderedCollectionFind (gOrderedHandleList, Handle),
-      NULL
-      );
+    RemoveEntryList (&Handle->HashLink);
+    mHandleCount--;
     RemoveEntryList (&Handle->AllHandles);
     CoreFreePool (Handle);
   }
@@ -1006,13 +1142,37 @@ CoreGetProtocolInterface (
 
   Handle = (IHANDLE *)UserHandle;
 
+  //
+  // Drivers usually open the same protocol on a handle several times in a
+  // row, so check the most recently returned protocol interface first.
+  //
+  if (Handle->MruProtocol != NULL) {
+    Prot = CR (Handle->MruProtocol, PROTOCOL_INTERFACE, Link, PROTOCOL_INTERFACE_SIGNATURE);
+    if (CompareGuid (&Prot->Protocol->ProtocolID, Protocol)) {
+      mProtocolMruHitCount++;
+      return Prot;
+    }
+  }
+
+  mProtocolMruMissCount++;
+
+  //
+  // Resolve the GUID through the protocol database hash index once, so the
+  // walk of the handle's protocols only needs to compare entry pointers.
+  // A GUID that was never installed anywhere cannot be on this handle.
+  //
+  ProtEntry = CoreFindProtocolEntry (Protocol, FALSE);
+  if (ProtEntry == NULL) {
+    return NULL;
+  }
+
   //
   // Look at each protocol interface for a match
   //
   for (Link = Handle->Protocols.ForwardLink; Link != &Handle->Protocols; Link = Link->ForwardLink) {
-    Prot      = CR (Link, PROTOCOL_INTERFACE, Link, PROTOCOL_INTERFACE_SIGNATURE);
-    ProtEntry = Prot->Protocol;
-    if (CompareGuid (&ProtEntry->ProtocolID, Protocol)) {
+    Prot = CR (Link, PROTOCOL_INTERFACE, Link, PROTOCOL_INTERFACE_SIGNATURE);
+    if (Prot->Protocol == ProtEntry) {
+      Handle->MruProtocol = Link;
       return Prot;
     }
   }
@@ -1691,3 +1851,30 @@ CoreConnectHandlesByKey (
 
   CoreFreePool (HandleBuffer);
 }
+
+/**
+  Dump the protocol database lookup statistics gathered during boot.
+
+**/
+VOID
+CoreDumpProtocolDatabaseStatistics (
+  VOID
+  )
+{
+  DEBUG ((
+    DEBUG_INFO,
+    "Protocol database: %d entries, %ld lookups, %ld GUID compares, %ld compares saved by hash index\n",
+    mProtocolEntryCount,
+    mProtocolLookupCount,
+    mProtocolLookupCompareCount,
+    mProtocolLookupCompareSaved
+    ));
+  DEBUG ((
+    DEBUG_INFO,
+    "Handle database: %d handles in %d buckets, %ld protocol interface cache hits, %ld misses\n",
+    mHandleCount,
+    (UINTN)1 << mHandleTableBits,
+    mProtocolMruHitCount,
+    mProtocolMruMissCount
+    ));
+}
@@ -23,10 +23,23 @@ typedef struct {
   UINTN         LocateRequest;
   /// The Handle Database Key value when this handle was last created or modified
   UINT64        Key;
+  /// Link on the mHandleTable bucket selected by the address of this handle
+  LIST_ENTRY    HashLink;
+  /// PROTOCOL_INTERFACE.Link most recently returned for this handle, or NULL
+  LIST_ENTRY    *MruProtocol;
 } IHANDLE;
 
 #define ASSERT_IS_HANDLE(a)  ASSERT((a)->Signature == EFI_HANDLE_SIGNATURE)
 
+///
+/// The handle table starts with 2^HANDLE_TABLE_INITIAL_BITS buckets and is
+/// doubled whenever it holds more than HANDLE_TABLE_LOAD_FACTOR handles per
+/// bucket, up to 2^HANDLE_TABLE_MAX_BITS buckets.
+///
+#define HANDLE_TABLE_INITIAL_BITS  8
+#define HANDLE_TABLE_MAX_BITS      16
+#define HANDLE_TABLE_LOAD_FACTOR   2
+
 #define PROTOCOL_ENTRY_SIGNATURE  SIGNATURE_32('p','r','t','e')
 
 ///
@@ -38,14 +51,26 @@ typedef struct {
   UINTN         Signature;
   /// Link Entry inserted to mProtocolDatabase
   LIST_ENTRY    AllEntries;
+  /// Link Entry inserted to the mProtocolHashTable bucket selected by ProtocolID
+  LIST_ENTRY    HashLink;
+  /// Position of this entry in mProtocolDatabase, used for lookup statistics
+  UINTN         Ordinal;
   /// ID of the protocol
   EFI_GUID      ProtocolID;
   /// All protocol interfaces
   LIST_ENTRY    Protocols;
   /// Registerd notification handlers
   LIST_ENTRY    Notify;
+  /// Drivers whose Depex waits on this protocol, list of EFI_CORE_DEPEX_WAITER
+  LIST_ENTRY    DepexWaiters;
 } PROTOCOL_ENTRY;
 
+///
+/// Number of buckets in the GUID hash index of the protocol database.
+/// Must be a power of 2.
+///
+#define PROTOCOL_HASH_BUCKET_COUNT  128
+
 #define PROTOCOL_INTERFACE_SIGNATURE  SIGNATURE_32('p','i','f','c')
 
 ///
@@ -12,7 +12,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "Event.h"
 
 /**
-  Signal event for every protocol in protocol entry.
+  Signal event for every protocol in protocol entry, and mark the drivers whose
+  dependency expression waits on the protocol for evaluation.
 
   @param  ProtEntry              Protocol entry
 
@@ -31,6 +32,8 @@ CoreNotifyProtocolEntry (
     ProtNotify = CR (Link, PROTOCOL_NOTIFY, Link, PROTOCOL_NOTIFY_SIGNATURE);
     CoreSignalEvent (ProtNotify->Event);
   }
+
+  CoreWakeDepexWaiters (&ProtEntry->DepexWaiters);
 }
 
 /**
@@ -14,17 +14,27 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 //
 
 #define MEMORY_MAP_SIGNATURE  SIGNATURE_32('m','m','a','p')
-typedef struct {
-  UINTN              Signature;
-  LIST_ENTRY         Link;
-  BOOLEAN            FromPages;
-
-  EFI_MEMORY_TYPE    Type;
-  UINT64             Start;
-  UINT64             End;
-
-  UINT64             VirtualStart;
-  UINT64             Attribute;
+typedef struct _MEMORY_MAP {
+  UINTN                 Signature;
+  LIST_ENTRY            Link;
+  BOOLEAN               FromPages;
+
+  EFI_MEMORY_TYPE       Type;
+  UINT64                Start;
+  UINT64                End;
+
+  UINT64                VirtualStart;
+  UINT64                Attribute;
+
+  ///
+  /// Node of the AVL tree that indexes gMemoryMap on Start. Height is 0 when
+  /// the entry is not in the tree. MaxFreeBytes is the size of the largest
+  /// allocatable free range in the subtree rooted at this entry.
+  ///
+  struct _MEMORY_MAP    *Left;
+  struct _MEMORY_MAP    *Right;
+  UINTN                 Height;
+  UINT64                MaxFreeBytes;
 } MEMORY_MAP;
 
 //
@@ -99,6 +109,22 @@ CoreFreePoolI (
   OUT EFI_MEMORY_TYPE  *PoolType OPTIONAL
   );
 
+/**
+  Get the usage of the pool slabs, one record for each memory type and slab
+  size that has slabs.
+
+  @param  SlabInfo               Buffer to return the records, or NULL
+  @param  Count                  The number of records SlabInfo can hold
+
+  @return The number of records for the pool slabs
+
+**/
+UINTN
+CoreGetPoolSlabInfo (
+  OUT MEMORY_PROFILE_POOL_SLAB  *SlabInfo OPTIONAL,
+  IN  UINTN                     Count
+  );
+
 /**
   Enter critical section by gaining lock on gMemoryLock.
 
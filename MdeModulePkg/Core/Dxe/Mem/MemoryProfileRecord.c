@@ -1431,12 +1431,15 @@ CoreUpdateProfile (
 /**
   Get memory profile data size.
 
+  @param[out] SlabInfoCount   The number of pool slab records the size
+                              accounts for.
+
   @return Memory profile data size.
 
 **/
 UINTN
 MemoryProfileGetDataSize (
-  VOID
+  OUT UINTN  *SlabInfoCount
   )
 {
   MEMORY_PROFILE_CONTEXT_DATA      *ContextData;
@@ -1483,6 +1486,9 @@ MemoryProfileGetDataSize (
     }
   }
 
+  *SlabInfoCount = CoreGetPoolSlabInfo (NULL, 0);
+  TotalSize     += *SlabInfoCount * sizeof (MEMORY_PROFILE_POOL_SLAB);
+
   return TotalSize;
 }
 
@@ -1490,11 +1496,16 @@ MemoryProfileGetDataSize (
   Copy memory profile data.
 
   @param ProfileBuffer  The buffer to hold memory profile data.
+  @param SlabInfoCount  The number of pool slab records ProfileBuffer was
+                        sized for.
+
+  @return The size of the data copied to ProfileBuffer.
 
 **/
-VOID
+UINTN
 MemoryProfileCopyData (
-  IN VOID  *ProfileBuffer
+  IN VOID   *ProfileBuffer,
+  IN UINTN  SlabInfoCount
   )
 {
   MEMORY_PROFILE_CONTEXT           *Context;
@@ -1512,7 +1523,7 @@ MemoryProfileCopyData (
 
   ContextData = GetMemoryProfileContext ();
   if (ContextData == NULL) {
-    return;
+    return 0;
   }
 
   Context = ProfileBuffer;
@@ -1560,6 +1571,18 @@ MemoryProfileCopyData (
 
     DriverInfo = (MEMORY_PROFILE_DRIVER_INFO *)AllocInfo;
   }
+
+  //
+  // The pool slab records follow the last driver. Slabs may have been added
+  // or freed since the buffer was sized, so copy no more records than it has
+  // room for, and report only the records actually copied.
+  //
+  SlabInfoCount = MIN (
+                    SlabInfoCount,
+                    CoreGetPoolSlabInfo ((MEMORY_PROFILE_POOL_SLAB *)DriverInfo, SlabInfoCount)
+                    );
+
+  return (UINTN)DriverInfo + SlabInfoCount * sizeof (MEMORY_PROFILE_POOL_SLAB) - (UINTN)ProfileBuffer;
 }
 
 /**
@@ -1585,6 +1608,7 @@ ProfileProtocolGetData (
   )
 {
   UINTN                        Size;
+  UINTN                        SlabInfoCount;
   MEMORY_PROFILE_CONTEXT_DATA  *ContextData;
   BOOLEAN                      MemoryProfileGettingStatus;
 
@@ -1596,7 +1620,7 @@ ProfileProtocolGetData (
   MemoryProfileGettingStatus  = mMemoryProfileGettingStatus;
   mMemoryProfileGettingStatus = TRUE;
 
-  Size = MemoryProfileGetDataSize ();
+  Size = MemoryProfileGetDataSize (&SlabInfoCount);
 
   if (*ProfileSize < Size) {
     *ProfileSize                = Size;
@@ -1604,8 +1628,7 @@ ProfileProtocolGetData (
     return EFI_BUFFER_TOO_SMALL;
   }
 
-  *ProfileSize = Size;
-  MemoryProfileCopyData (ProfileBuffer);
+  *ProfileSize = MemoryProfileCopyData (ProfileBuffer, SlabInfoCount);
 
   mMemoryProfileGettingStatus = MemoryProfileGettingStatus;
   return EFI_SUCCESS;
@@ -45,6 +45,10 @@ UINTN       mFreeMapStack = 0;
 ///
 LIST_ENTRY  mFreeMemoryMapEntryList           = INITIALIZE_LIST_HEAD_VARIABLE (mFreeMemoryMapEntryList);
 BOOLEAN     mMemoryTypeInformationInitialized = FALSE;
+///
+/// mMemoryMapTree - root of the AVL tree that indexes the entries of gMemoryMap
+///
+MEMORY_MAP  *mMemoryMapTree = NULL;
 
 EFI_MEMORY_TYPE_STATISTICS  mMemoryTypeStatistics[EfiMaxMemoryType + 1] = {
   { 0, MAX_ALLOC_ADDRESS, 0, 0, EfiMaxMemoryType, TRUE,  FALSE },  // EfiReservedMemoryType
@@ -119,6 +123,368 @@ CoreReleaseMemoryLock (
   CoreReleaseLock (&gMemoryLock);
 }
 
+/**
+  Return the height of a memory map tree node.
+
+  @param  Node                   The tree node, or NULL
+
+  @return The height of the subtree rooted at Node
+
+**/
+STATIC
+UINTN
+CoreMemoryMapTreeHeight (
+  IN MEMORY_MAP  *Node
+  )
+{
+  return (Node == NULL) ? 0 : Node->Height;
+}
+
+/**
+  Return the size of the largest allocatable free range in a memory map subtree.
+
+  @param  Node                   The tree node, or NULL
+
+  @return The size in bytes of the largest free range under Node
+
+**/
+STATIC
+UINT64
+CoreMemoryMapTreeMaxFree (
+  IN MEMORY_MAP  *Node
+  )
+{
+  return (Node == NULL) ? 0 : Node->MaxFreeBytes;
+}
+
+/**
+  Recompute the height and the largest free range of a memory map tree node
+  from the node itself and its children.
+
+  @param  Node                   The tree node
+
+**/
+STATIC
+VOID
+CoreMemoryMapTreeUpdate (
+  IN MEMORY_MAP  *Node
+  )
+{
+  UINT64  MaxFree;
+
+  Node->Height = 1 + MAX (CoreMemoryMapTreeHeight (Node->Left), CoreMemoryMapTreeHeight (Node->Right));
+
+  //
+  // Only EfiConventionalMemory that is not Special-Purpose memory can be
+  // handed out by CoreFindFreePagesI()
+  //
+  MaxFree = 0;
+  if ((Node->Type == EfiConventionalMemory) && ((Node->Attribute & EFI_MEMORY_SP) == 0)) {
+    MaxFree = Node->End - Node->Start + 1;
+  }
+
+  MaxFree            = MAX (MaxFree, CoreMemoryMapTreeMaxFree (Node->Left));
+  Node->MaxFreeBytes = MAX (MaxFree, CoreMemoryMapTreeMaxFree (Node->Right));
+}
+
+/**
+  Rotate a memory map subtree so that the left child of Node becomes its root.
+
+  @param  Node                   The root of the subtree
+
+  @return The new root of the subtree
+
+**/
+STATIC
+MEMORY_MAP *
+CoreMemoryMapTreeRotateRight (
+  IN MEMORY_MAP  *Node
+  )
+{
+  MEMORY_MAP  *Pivot;
+
+  Pivot        = Node->Left;
+  Node->Left   = Pivot->Right;
+  Pivot->Right = Node;
+  CoreMemoryMapTreeUpdate (Node);
+  CoreMemoryMapTreeUpdate (Pivot);
+
+  return Pivot;
+}
+
+/**
+  Rotate a memory map subtree so that the right child of Node becomes its root.
+
+  @param  Node                   The root of the subtree
+
+  @return The new root of the subtree
+
+**/
+STATIC
+MEMORY_MAP *
+CoreMemoryMapTreeRotateLeft (
+  IN MEMORY_MAP  *Node
+  )
+{
+  MEMORY_MAP  *Pivot;
+
+  Pivot       = Node->Right;
+  Node->Right = Pivot->Left;
+  Pivot->Left = Node;
+  CoreMemoryMapTreeUpdate (Node);
+  CoreMemoryMapTreeUpdate (Pivot);
+
+  return Pivot;
+}
+
+/**
+  Restore the AVL balance of a memory map subtree whose children are balanced
+  and differ in height by at most 2.
+
+  @param  Node                   The root of the subtree
+
+  @return The new root of the subtree
+
+**/
+STATIC
+MEMORY_MAP *
+CoreMemoryMapTreeBalance (
+  IN MEMORY_MAP  *Node
+  )
+{
+  UINTN  LeftHeight;
+  UINTN  RightHeight;
+
+  CoreMemoryMapTreeUpdate (Node);
+  LeftHeight  = CoreMemoryMapTreeHeight (Node->Left);
+  RightHeight = CoreMemoryMapTreeHeight (Node->Right);
+
+  if (LeftHeight > RightHeight + 1) {
+    if (CoreMemoryMapTreeHeight (Node->Left->Left) < CoreMemoryMapTreeHeight (Node->Left->Right)) {
+      Node->Left = CoreMemoryMapTreeRotateLeft (Node->Left);
+    }
+
+    return CoreMemoryMapTreeRotateRight (Node);
+  }
+
+  if (RightHeight > LeftHeight + 1) {
+    if (CoreMemoryMapTreeHeight (Node->Right->Right) < CoreMemoryMapTreeHeight (Node->Right->Left)) {
+      Node->Right = CoreMemoryMapTreeRotateRight (Node->Right);
+    }
+
+    return CoreMemoryMapTreeRotateLeft (Node);
+  }
+
+  return Node;
+}
+
+/**
+  Insert an entry into a memory map subtree.
+
+  @param  Node                   The root of the subtree, or NULL
+  @param  Entry                  The entry to insert
+
+  @return The new root of the subtree
+
+**/
+STATIC
+MEMORY_MAP *
+CoreMemoryMapTreeInsert (
+  IN MEMORY_MAP  *Node,
+  IN MEMORY_MAP  *Entry
+  )
+{
+  if (Node == NULL) {
+    Entry->Left  = NULL;
+    Entry->Right = NULL;
+    CoreMemoryMapTreeUpdate (Entry);
+    return Entry;
+  }
+
+  ASSERT (Entry->Start != Node->Start);
+  if (Entry->Start < Node->Start) {
+    Node->Left = CoreMemoryMapTreeInsert (Node->Left, Entry);
+  } else {
+    Node->Right = CoreMemoryMapTreeInsert (Node->Right, Entry);
+  }
+
+  return CoreMemoryMapTreeBalance (Node);
+}
+
+/**
+  Detach the entry with the lowest Start from a memory map subtree.
+
+  @param  Node                   The root of the subtree
+  @param  Min                    Returns the detached entry
+
+  @return The new root of the subtree
+
+**/
+STATIC
+MEMORY_MAP *
+CoreMemoryMapTreeRemoveMin (
+  IN  MEMORY_MAP  *Node,
+  OUT MEMORY_MAP  **Min
+  )
+{
+  if (Node->Left == NULL) {
+    *Min = Node;
+    return Node->Right;
+  }
+
+  Node->Left = CoreMemoryMapTreeRemoveMin (Node->Left, Min);
+  return CoreMemoryMapTreeBalance (Node);
+}
+
+/**
+  Remove an entry from a memory map subtree.
+
+  @param  Node                   The root of the subtree
+  @param  Entry                  The entry to remove. It must be in the subtree.
+
+  @return The new root of the subtree
+
+**/
+STATIC
+MEMORY_MAP *
+CoreMemoryMapTreeRemove (
+  IN MEMORY_MAP  *Node,
+  IN MEMORY_MAP  *Entry
+  )
+{
+  MEMORY_MAP  *Min;
+  MEMORY_MAP  *Right;
+
+  ASSERT (Node != NULL);
+
+  if (Entry->Start < Node->Start) {
+    Node->Left = CoreMemoryMapTreeRemove (Node->Left, Entry);
+  } else if (Entry->Start > Node->Start) {
+    Node->Right = CoreMemoryMapTreeRemove (Node->Right, Entry);
+  } else {
+    ASSERT (Node == Entry);
+    if (Node->Right == NULL) {
+      return Node->Left;
+    }
+
+    Right      = CoreMemoryMapTreeRemoveMin (Node->Right, &Min);
+    Min->Left  = Node->Left;
+    Min->Right = Right;
+    Node       = Min;
+  }
+
+  return CoreMemoryMapTreeBalance (Node);
+}
+
+/**
+  Internal function.  Adds an entry of gMemoryMap to the tree index.
+
+  @param  Entry                  The entry to add
+
+**/
+STATIC
+VOID
+CoreMemoryMapTreeAdd (
+  IN MEMORY_MAP  *Entry
+  )
+{
+  ASSERT (Entry->Start <= Entry->End);
+  mMemoryMapTree = CoreMemoryMapTreeInsert (mMemoryMapTree, Entry);
+}
+
+/**
+  Internal function.  Removes an entry of gMemoryMap from the tree index.
+  Nothing is done if the entry is not in the tree.
+
+  @param  Entry                  The entry to remove
+
+**/
+STATIC
+VOID
+CoreMemoryMapTreeDelete (
+  IN MEMORY_MAP  *Entry
+  )
+{
+  if (Entry->Height == 0) {
+    return;
+  }
+
+  mMemoryMapTree = CoreMemoryMapTreeRemove (mMemoryMapTree, Entry);
+  Entry->Left    = NULL;
+  Entry->Right   = NULL;
+  Entry->Height  = 0;
+}
+
+/**
+  Internal function.  Finds the memory map entry that covers an address.
+
+  @param  Address                The address to look up
+
+  @return The entry that covers Address, or NULL if there is none
+
+**/
+STATIC
+MEMORY_MAP *
+CoreFindMemoryMapEntry (
+  IN UINT64  Address
+  )
+{
+  MEMORY_MAP  *Node;
+  MEMORY_MAP  *Floor;
+
+  //
+  // Find the entry with the highest Start that is not above Address
+  //
+  Floor = NULL;
+  Node  = mMemoryMapTree;
+  while (Node != NULL) {
+    if (Address < Node->Start) {
+      Node = Node->Left;
+    } else {
+      Floor = Node;
+      Node  = Node->Right;
+    }
+  }
+
+  if ((Floor == NULL) || (Address > Floor->End)) {
+    return NULL;
+  }
+
+  return Floor;
+}
+
+/**
+  Internal function.  Finds the entry of gMemoryMap with the lowest Start
+  above an address.
+
+  @param  Address                The address to look up
+
+  @return The next entry above Address, or NULL if there is none
+
+**/
+STATIC
+MEMORY_MAP *
+CoreFindNextMemoryMapEntry (
+  IN UINT64  Address
+  )
+{
+  MEMORY_MAP  *Node;
+  MEMORY_MAP  *Next;
+
+  Next = NULL;
+  Node = mMemoryMapTree;
+  while (Node != NULL) {
+    if (Address < Node->Start) {
+      Next = Node;
+      Node = Node->Left;
+    } else {
+      Node = Node->Right;
+    }
+  }
+
+  return Next;
+}
+
 /**
   Internal function.  Removes a descriptor entry.
 
@@ -130,6 +496,7 @@ RemoveMemoryMapEntry (
   IN OUT MEMORY_MAP  *Entry
   )
 {
+  CoreMemoryMapTreeDelete (Entry);
   RemoveEntryList (&Entry->Link);
   Entry->Link.ForwardLink = NULL;
 
@@ -161,7 +528,6 @@ CoreAddRange (
   IN UINT64                Attribute
   )
 {
-  LIST_ENTRY  *Link;
   MEMORY_MAP  *Entry;
 
   ASSERT ((Start & EFI_PAGE_MASK) == 0);
@@ -207,26 +573,22 @@ CoreAddRange (
   //
 
   // Two memory descriptors can only be merged if they have the same Type
-  // and the same Attribute
+  // and the same Attribute. The range does not overlap the map, so only the
+  // descriptors that cover Start - 1 and End + 1 can be adjoining.
   //
-
-  Link = gMemoryMap.ForwardLink;
-  while (Link != &gMemoryMap) {
-    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-    Link  = Link->ForwardLink;
-
-    if (Entry->Type != Type) {
-      continue;
-    }
-
-    if (Entry->Attribute != Attribute) {
-      continue;
-    }
-
-    if (Entry->End + 1 == Start) {
+  if (Start != 0) {
+    Entry = CoreFindMemoryMapEntry (Start - 1);
+    if ((Entry != NULL) && (Entry->Type == Type) && (Entry->Attribute == Attribute)) {
+      ASSERT (Entry->End + 1 == Start);
       Start = Entry->Start;
       RemoveMemoryMapEntry (Entry);
-    } else if (Entry->Start == End + 1) {
+    }
+  }
+
+  if (End != MAX_UINT64) {
+    Entry = CoreFindMemoryMapEntry (End + 1);
+    if ((Entry != NULL) && (Entry->Type == Type) && (Entry->Attribute == Attribute)) {
+      ASSERT (Entry->Start == End + 1);
       End = Entry->End;
       RemoveMemoryMapEntry (Entry);
     }
@@ -244,6 +606,7 @@ CoreAddRange (
   mMapStack[mMapDepth].VirtualStart = 0;
   mMapStack[mMapDepth].Attribute    = Attribute;
   InsertTailList (&gMemoryMap, &mMapStack[mMapDepth].Link);
+  CoreMemoryMapTreeAdd (&mMapStack[mMapDepth]);
 
   mMapDepth += 1;
   ASSERT (mMapDepth < MAX_MAP_DEPTH);
@@ -350,6 +713,7 @@ CoreFreeMemoryMapStack (
       //
       // Move this entry to general memory
       //
+      CoreMemoryMapTreeDelete (&mMapStack[mMapDepth]);
       RemoveEntryList (&mMapStack[mMapDepth].Link);
       mMapStack[mMapDepth].Link.ForwardLink = NULL;
 
@@ -357,16 +721,24 @@ CoreFreeMemoryMapStack (
       Entry->FromPages = TRUE;
 
       //
-      // Find insertion location
+      // Find insertion location, in front of the next descriptor in general
+      // memory. The descriptors in general memory are kept sorted on the list,
+      // so this is the lowest one above Entry in the tree that is not on the
+      // descriptor stack.
       //
-      for (Link2 = gMemoryMap.ForwardLink; Link2 != &gMemoryMap; Link2 = Link2->ForwardLink) {
-        Entry2 = CR (Link2, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-        if (Entry2->FromPages && (Entry2->Start > Entry->Start)) {
+      Link2  = &gMemoryMap;
+      Entry2 = CoreFindNextMemoryMapEntry (Entry->Start);
+      while (Entry2 != NULL) {
+        if (Entry2->FromPages) {
+          Link2 = &Entry2->Link;
           break;
         }
+
+        Entry2 = CoreFindNextMemoryMapEntry (Entry2->Start);
       }
 
       InsertTailList (Link2, &Entry->Link);
+      CoreMemoryMapTreeAdd (Entry);
     } else {
       //
       // This item of mMapStack[mMapDepth] has already been dequeued from gMemoryMap list,
@@ -843,7 +1215,6 @@ CoreConvertPagesEx (
   UINT64           RangeEnd;
   UINT64           Attribute;
   EFI_MEMORY_TYPE  MemType;
-  LIST_ENTRY       *Link;
   MEMORY_MAP       *Entry;
 
   Entry         = NULL;
@@ -868,15 +1239,8 @@ CoreConvertPagesEx (
     //
     // Find the entry that the covers the range
     //
-    for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-      Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-
-      if ((Entry->Start <= Start) && (Entry->End > Start)) {
-        break;
-      }
-    }
-
-    if (Link == &gMemoryMap) {
+    Entry = CoreFindMemoryMapEntry (Start);
+    if ((Entry == NULL) || (Entry->End <= Start)) {
       DEBUG ((DEBUG_ERROR | DEBUG_PAGE, "ConvertPages: failed to find range %lx - %lx\n", Start, End));
       return EFI_NOT_FOUND;
     }
@@ -955,8 +1319,10 @@ CoreConvertPagesEx (
     }
 
     //
-    // Pull range out of descriptor
+    // Pull range out of descriptor. The descriptor is taken out of the tree
+    // while it is resized, and is not put back if it becomes empty.
     //
+    CoreMemoryMapTreeDelete (Entry);
     if (Entry->Start == Start) {
       //
       // Clip start
@@ -988,6 +1354,7 @@ CoreConvertPagesEx (
 
       Entry->End = Start - 1;
       ASSERT (Entry->Start < Entry->End);
+      CoreMemoryMapTreeAdd (Entry);
 
       Entry = &mMapStack[mMapDepth];
       InsertTailList (&gMemoryMap, &Entry->Link);
@@ -996,6 +1363,10 @@ CoreConvertPagesEx (
       ASSERT (mMapDepth < MAX_MAP_DEPTH);
     }
 
+    if (Entry->Start <= Entry->End) {
+      CoreMemoryMapTreeAdd (Entry);
+    }
+
     //
     // The new range inherits the same Attribute as the Entry
     // it is being cut out of unless attributes are being changed
@@ -1112,6 +1483,159 @@ CoreUpdateMemoryAttributes (
   CoreReleaseMemoryLock ();
 }
 
+/**
+  Internal function. Checks if a free memory map descriptor can satisfy a page
+  allocation below the requested address.
+
+  @param  Entry                  The memory map descriptor to check
+  @param  MaxAddress             The address that the range must be below, which
+                                 is the last byte of a page
+  @param  MinAddress             The address that the range must be above
+  @param  NumberOfBytes          Number of bytes needed
+  @param  Alignment              Bits to align with
+  @param  NeedGuard              Flag to indicate Guard page is needed or not
+
+  @return The last address of the highest range in Entry that can be allocated,
+          or 0 if Entry cannot satisfy the allocation
+
+**/
+STATIC
+UINT64
+CoreCheckFreePagesEntry (
+  IN MEMORY_MAP  *Entry,
+  IN UINT64      MaxAddress,
+  IN UINT64      MinAddress,
+  IN UINT64      NumberOfBytes,
+  IN UINTN       Alignment,
+  IN BOOLEAN     NeedGuard
+  )
+{
+  UINT64  DescStart;
+  UINT64  DescEnd;
+  UINT64  DescNumberOfBytes;
+
+  //
+  // If it's not a free entry, don't bother with it
+  //
+  if (Entry->Type != EfiConventionalMemory) {
+    return 0;
+  }
+
+  //
+  // Don't allocate out of Special-Purpose memory.
+  //
+  if ((Entry->Attribute & EFI_MEMORY_SP) != 0) {
+    return 0;
+  }
+
+  DescStart = Entry->Start;
+  DescEnd   = Entry->End;
+
+  //
+  // If desc is past max allowed address or below min allowed address, skip it
+  //
+  if ((DescStart >= MaxAddress) || (DescEnd < MinAddress)) {
+    return 0;
+  }
+
+  //
+  // If desc ends past max allowed address, clip the end
+  //
+  if (DescEnd >= MaxAddress) {
+    DescEnd = MaxAddress;
+  }
+
+  DescEnd = ((DescEnd + 1) & (~((UINT64)Alignment - 1))) - 1;
+
+  // Skip if DescEnd is less than DescStart after alignment clipping
+  if (DescEnd < DescStart) {
+    return 0;
+  }
+
+  //
+  // Compute the number of bytes we can used from this
+  // descriptor, and see it's enough to satisfy the request
+  //
+  DescNumberOfBytes = DescEnd - DescStart + 1;
+
+  if (DescNumberOfBytes < NumberOfBytes) {
+    return 0;
+  }
+
+  //
+  // If the start of the allocated range is below the min address allowed, skip it
+  //
+  if ((DescEnd - NumberOfBytes + 1) < MinAddress) {
+    return 0;
+  }
+
+  if (NeedGuard) {
+    DescEnd = AdjustMemoryS (
+                DescEnd + 1 - DescNumberOfBytes,
+                DescNumberOfBytes,
+                NumberOfBytes
+                );
+  }
+
+  return DescEnd;
+}
+
+/**
+  Internal function. Finds the highest free page range below the requested
+  address in a memory map subtree.
+
+  The descriptors of the map do not overlap, and a range found in a descriptor
+  never extends below the start of that descriptor. So the first match in a
+  walk from the highest address down is the highest match, and subtrees that
+  are out of the address range or have no free range large enough are skipped.
+
+  @param  Node                   The root of the subtree, or NULL
+  @param  MaxAddress             The address that the range must be below, which
+                                 is the last byte of a page
+  @param  MinAddress             The address that the range must be above
+  @param  NumberOfBytes          Number of bytes needed
+  @param  Alignment              Bits to align with
+  @param  NeedGuard              Flag to indicate Guard page is needed or not
+
+  @return The last address of the range, or 0 if the range was not found
+
+**/
+STATIC
+UINT64
+CoreFindFreePagesInTree (
+  IN MEMORY_MAP  *Node,
+  IN UINT64      MaxAddress,
+  IN UINT64      MinAddress,
+  IN UINT64      NumberOfBytes,
+  IN UINTN       Alignment,
+  IN BOOLEAN     NeedGuard
+  )
+{
+  UINT64  Target;
+
+  if ((Node == NULL) || (Node->MaxFreeBytes < NumberOfBytes)) {
+    return 0;
+  }
+
+  if (Node->Start < MaxAddress) {
+    Target = CoreFindFreePagesInTree (Node->Right, MaxAddress, MinAddress, NumberOfBytes, Alignment, NeedGuard);
+    if (Target != 0) {
+      return Target;
+    }
+
+    Target = CoreCheckFreePagesEntry (Node, MaxAddress, MinAddress, NumberOfBytes, Alignment, NeedGuard);
+    if (Target != 0) {
+      return Target;
+    }
+  }
+
+  if (Node->Start <= MinAddress) {
+    return 0;
+  }
+
+  return CoreFindFreePagesInTree (Node->Left, MaxAddress, MinAddress, NumberOfBytes, Alignment, NeedGuard);
+}
+
 /**
   Internal function. Finds a consecutive free page range below
   the requested address.
@@ -1137,13 +1661,8 @@ CoreFindFreePagesI (
   IN BOOLEAN          NeedGuard
   )
 {
-  UINT64      NumberOfBytes;
-  UINT64      Target;
-  UINT64      DescStart;
-  UINT64      DescEnd;
-  UINT64      DescNumberOfBytes;
-  LIST_ENTRY  *Link;
-  MEMORY_MAP  *Entry;
+  UINT64  NumberOfBytes;
+  UINT64  Target;
 
   if ((MaxAddress < EFI_PAGE_MASK) || (NumberOfPages == 0)) {
     return 0;
@@ -1171,82 +1690,14 @@ CoreFindFreePagesI (
   }
 
   NumberOfBytes = LShiftU64 (NumberOfPages, EFI_PAGE_SHIFT);
-  Target        = 0;
-
-  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-
-    //
-    // If it's not a free entry, don't bother with it
-    //
-    if (Entry->Type != EfiConventionalMemory) {
-      continue;
-    }
-
-    //
-    // Don't allocate out of Special-Purpose memory.
-    //
-    if ((Entry->Attribute & EFI_MEMORY_SP) != 0) {
-      continue;
-    }
-
-    DescStart = Entry->Start;
-    DescEnd   = Entry->End;
-
-    //
-    // If desc is past max allowed address or below min allowed address, skip it
-    //
-    if ((DescStart >= MaxAddress) || (DescEnd < MinAddress)) {
-      continue;
-    }
-
-    //
-    // If desc ends past max allowed address, clip the end
-    //
-    if (DescEnd >= MaxAddress) {
-      DescEnd = MaxAddress;
-    }
-
-    DescEnd = ((DescEnd + 1) & (~((UINT64)Alignment - 1))) - 1;
-
-    // Skip if DescEnd is less than DescStart after alignment clipping
-    if (DescEnd < DescStart) {
-      continue;
-    }
-
-    //
-    // Compute the number of bytes we can used from this
-    // descriptor, and see it's enough to satisfy the request
-    //
-    DescNumberOfBytes = DescEnd - DescStart + 1;
-
-    if (DescNumberOfBytes >= NumberOfBytes) {
-      //
-      // If the start of the allocated range is below the min address allowed, skip it
-      //
-      if ((DescEnd - NumberOfBytes + 1) < MinAddress) {
-        continue;
-      }
-
-      //
-      // If this is the best match so far remember it
-      //
-      if (DescEnd > Target) {
-        if (NeedGuard) {
-          DescEnd = AdjustMemoryS (
-                      DescEnd + 1 - DescNumberOfBytes,
-                      DescNumberOfBytes,
-                      NumberOfBytes
-                      );
-          if (DescEnd == 0) {
-            continue;
-          }
-        }
-
-        Target = DescEnd;
-      }
-    }
-  }
+  Target        = CoreFindFreePagesInTree (
+                    mMemoryMapTree,
+                    MaxAddress,
+                    MinAddress,
+                    NumberOfBytes,
+                    Alignment,
+                    NeedGuard
+                    );
 
   //
   // If this is a grow down, adjust target to be the allocation base
@@ -1649,7 +2100,6 @@ CoreInternalFreePages (
   )
 {
   EFI_STATUS  Status;
-  LIST_ENTRY  *Link;
   MEMORY_MAP  *Entry;
   UINTN       Alignment;
   BOOLEAN     IsGuarded;
@@ -1663,21 +2113,8 @@ CoreInternalFreePages (
   // Find the entry that the covers the range
   //
   IsGuarded = FALSE;
-  Entry     = NULL;
-  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-    if ((Entry->Start <= Memory) && (Entry->End > Memory)) {
-      break;
-    }
-  }
-
-  if (Link == &gMemoryMap) {
-    Status = EFI_NOT_FOUND;
-    goto Done;
-  }
-
-  if (Entry == NULL) {
-    ASSERT (Entry != NULL);
+  Entry     = CoreFindMemoryMapEntry (Memory);
+  if ((Entry == NULL) || (Entry->End <= Memory)) {
     Status = EFI_NOT_FOUND;
     goto Done;
   }
@@ -59,6 +59,68 @@ STATIC CONST UINT16  mPoolSizeTable[] = {
 
 #define MAX_POOL_SIZE  (MAX_ADDRESS - POOL_OVERHEAD)
 
+//
+// Small allocations are served from slabs. A slab is a page carved into
+// objects of a single size class. The page starts with a POOL_SLAB header
+// that holds a bitmap of the objects in use, and each object is preceded by
+// a POOL_SLAB_HEAD only.
+//
+STATIC CONST UINT16  mPoolSlabSizeTable[] = {
+  16, 32, 48, 64, 96, 128, 192, 256
+};
+
+#define MAX_SLAB_LIST  (ARRAY_SIZE (mPoolSlabSizeTable))
+#define MAX_SLAB_SIZE  256
+
+//
+// The signature is what tells the two kinds of pool apart in CoreFreePoolI(),
+// so it overlaps a field of POOL_HEAD that can never hold its value: the
+// upper half of Size on 64-bit targets, and Type on 32-bit targets, where
+// Size is right in front of the data.
+//
+#define POOL_SLAB_HEAD_SIGNATURE  SIGNATURE_32('p','s','h','0')
+typedef struct {
+ #if defined (MDE_CPU_IA32) || defined (MDE_CPU_ARM)
+  UINT32    Signature;
+  UINT32    Index;
+ #else
+  UINT32    Index;
+  UINT32    Signature;
+ #endif
+  CHAR8     Data[1];
+} POOL_SLAB_HEAD;
+
+#define SIZE_OF_POOL_SLAB_HEAD  OFFSET_OF(POOL_SLAB_HEAD,Data)
+
+#define SLAB_OBJECT_SIZE(a)  (mPoolSlabSizeTable[a] + SIZE_OF_POOL_SLAB_HEAD)
+
+#define POOL_SLAB_MAX_OBJECTS  (EFI_PAGE_SIZE / (16 + SIZE_OF_POOL_SLAB_HEAD))
+
+#define POOL_SLAB_SIGNATURE  SIGNATURE_32('p','s','l','b')
+typedef struct {
+  UINT32             Signature;
+  UINT16             Index;
+  UINT16             FreeCount;
+  EFI_MEMORY_TYPE    Type;
+  LIST_ENTRY         Link;
+  UINT32             Bitmap[(POOL_SLAB_MAX_OBJECTS + 31) / 32];
+} POOL_SLAB;
+
+#define POOL_SLAB_DATA_OFFSET  ALIGN_VALUE (sizeof (POOL_SLAB), 8)
+
+#define SLAB_OBJECT_COUNT(a)  ((EFI_PAGE_SIZE - POOL_SLAB_DATA_OFFSET) / SLAB_OBJECT_SIZE (a))
+
+//
+// Slabs of one size class and memory type. FreeList holds the slabs that have
+// free objects.
+//
+typedef struct {
+  LIST_ENTRY    FreeList;
+  UINTN         SlabCount;
+  UINTN         UsedCount;
+  UINTN         PeakUsedCount;
+} POOL_SLAB_LIST;
+
 //
 // Globals
 //
@@ -69,6 +131,7 @@ typedef struct {
   UINTN              Used;
   EFI_MEMORY_TYPE    MemoryType;
   LIST_ENTRY         FreeList[MAX_POOL_LIST];
+  POOL_SLAB_LIST     SlabList[MAX_SLAB_LIST];
   LIST_ENTRY         Link;
 } POOL;
 
@@ -107,6 +170,53 @@ GetPoolIndexFromSize (
   return MAX_POOL_LIST;
 }
 
+/**
+  Get slab size table index from the specified size.
+
+  @param  Size          The specified size to get index from slab size table.
+
+  @return               The index of slab size table.
+
+**/
+STATIC
+UINTN
+GetSlabIndexFromSize (
+  UINTN  Size
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < MAX_SLAB_LIST; Index++) {
+    if (mPoolSlabSizeTable[Index] >= Size) {
+      return Index;
+    }
+  }
+
+  return MAX_SLAB_LIST;
+}
+
+/**
+  Initialize the slab lists of a pool.
+
+  @param  Pool          The pool to initialize.
+
+**/
+STATIC
+VOID
+InitializePoolSlabList (
+  IN POOL  *Pool
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < MAX_SLAB_LIST; Index++) {
+    InitializeListHead (&Pool->SlabList[Index].FreeList);
+    Pool->SlabList[Index].SlabCount     = 0;
+    Pool->SlabList[Index].UsedCount     = 0;
+    Pool->SlabList[Index].PeakUsedCount = 0;
+  }
+}
+
 /**
   Called to initialize the pool.
 
@@ -126,7 +236,12 @@ CoreInitializePool (
     for (Index = 0; Index < MAX_POOL_LIST; Index++) {
       InitializeListHead (&mPoolHead[Type].FreeList[Index]);
     }
+
+    InitializePoolSlabList (&mPoolHead[Type]);
   }
+
+  ASSERT (SLAB_OBJECT_COUNT (0) <= POOL_SLAB_MAX_OBJECTS);
+  ASSERT (mPoolSlabSizeTable[MAX_SLAB_LIST - 1] == MAX_SLAB_SIZE);
 }
 
 /**
@@ -175,6 +290,7 @@ LookupPoolHead (
       InitializeListHead (&Pool->FreeList[Index]);
     }
 
+    InitializePoolSlabList (Pool);
     InsertHeadList (&mPoolHeadList, &Pool->Link);
 
     return Pool;
@@ -336,6 +452,103 @@ CoreAllocatePoolPagesI (
   return Buffer;
 }
 
+/**
+  Internal function to allocate pool from a slab.
+  Caller must have the memory lock held
+
+  @param  Pool                   The pool to allocate from
+  @param  Size                   The amount of pool to allocate, which is no
+                                 more than MAX_SLAB_SIZE
+
+  @return The allocate pool, or NULL
+
+**/
+STATIC
+VOID *
+CoreAllocatePoolSlab (
+  IN POOL   *Pool,
+  IN UINTN  Size
+  )
+{
+  POOL_SLAB_LIST  *SlabList;
+  POOL_SLAB       *Slab;
+  POOL_SLAB_HEAD  *Head;
+  UINTN           Index;
+  UINTN           Word;
+  UINTN           Object;
+
+  ASSERT_LOCKED (&mPoolMemoryLock);
+
+  Index = GetSlabIndexFromSize (Size);
+  ASSERT (Index < MAX_SLAB_LIST);
+  SlabList = &Pool->SlabList[Index];
+
+  //
+  // If no slab of this size has a free object, go get another page
+  //
+  if (IsListEmpty (&SlabList->FreeList)) {
+    Slab = CoreAllocatePoolPagesI (Pool->MemoryType, EFI_SIZE_TO_PAGES (EFI_PAGE_SIZE), EFI_PAGE_SIZE, FALSE);
+    if (Slab == NULL) {
+      DEBUG ((DEBUG_ERROR | DEBUG_POOL, "AllocatePool: failed to allocate %ld bytes\n", (UINT64)Size));
+      return NULL;
+    }
+
+    ZeroMem (Slab, sizeof (POOL_SLAB));
+    Slab->Signature = POOL_SLAB_SIGNATURE;
+    Slab->Index     = (UINT16)Index;
+    Slab->FreeCount = (UINT16)SLAB_OBJECT_COUNT (Index);
+    Slab->Type      = Pool->MemoryType;
+    InsertHeadList (&SlabList->FreeList, &Slab->Link);
+    SlabList->SlabCount++;
+  }
+
+  Slab = CR (SlabList->FreeList.ForwardLink, POOL_SLAB, Link, POOL_SLAB_SIGNATURE);
+  ASSERT (Slab->FreeCount != 0);
+
+  //
+  // Take the first free object of the slab
+  //
+  for (Word = 0; Slab->Bitmap[Word] == MAX_UINT32; Word++) {
+    ASSERT (Word < ARRAY_SIZE (Slab->Bitmap));
+  }
+
+  Object = Word * 32 + (UINTN)LowBitSet32 (~Slab->Bitmap[Word]);
+  ASSERT (Object < SLAB_OBJECT_COUNT (Index));
+  Slab->Bitmap[Word] |= (UINT32)(1U << (Object % 32));
+
+  Slab->FreeCount--;
+  if (Slab->FreeCount == 0) {
+    RemoveEntryList (&Slab->Link);
+  }
+
+  //
+  // Account the allocation
+  //
+  SlabList->UsedCount++;
+  if (SlabList->UsedCount > SlabList->PeakUsedCount) {
+    SlabList->PeakUsedCount = SlabList->UsedCount;
+  }
+
+  Pool->Used += SLAB_OBJECT_SIZE (Index);
+
+  Head            = (POOL_SLAB_HEAD *)((UINTN)Slab + POOL_SLAB_DATA_OFFSET + Object * SLAB_OBJECT_SIZE (Index));
+  Head->Index     = (UINT32)Object;
+  Head->Signature = POOL_SLAB_HEAD_SIGNATURE;
+
+  DEBUG_CLEAR_MEMORY (Head->Data, mPoolSlabSizeTable[Index]);
+
+  DEBUG ((
+    DEBUG_POOL,
+    "AllocatePoolI: Type %x, Addr %p (len %lx) %,ld\n",
+    Pool->MemoryType,
+    Head->Data,
+    (UINT64)mPoolSlabSizeTable[Index],
+    (UINT64)Pool->Used
+    ));
+
+  return Head->Data;
+}
+
 /**
   Internal function to allocate pool of a particular type.
   Caller must have the memory lock held
@@ -406,6 +619,18 @@ CoreAllocatePoolI (
   //
   Size = ALIGN_VARIABLE (Size);
 
+  //
+  // Serve small allocations from a slab, unless a Guard is needed around
+  // them. Slabs are one page, so memory types with a larger granularity and
+  // OS/OEM specific memory types, whose pool head is freed when it becomes
+  // unused, keep using the pool lists.
+  //
+  if ((Size <= MAX_SLAB_SIZE) && !NeedGuard && !PageAsPool &&
+      (Granularity == EFI_PAGE_SIZE) && ((UINT32)PoolType < EfiMaxMemoryType))
+  {
+    return CoreAllocatePoolSlab (&mPoolHead[PoolType], Size);
+  }
+
   Size += POOL_OVERHEAD;
   Index = SIZE_TO_LIST (Size);
   Pool  = LookupPoolHead (PoolType);
@@ -676,6 +901,130 @@ CoreFreePoolPagesWithGuard (
   }
 }
 
+/**
+  Internal function to look up the slab of a pool entry.
+
+  @param  Buffer                 The allocated pool entry
+
+  @return The slab Buffer was allocated from, or NULL if Buffer was not
+          allocated from a slab
+
+**/
+STATIC
+POOL_SLAB *
+CoreLookupPoolSlab (
+  IN VOID  *Buffer
+  )
+{
+  POOL_SLAB_HEAD  *Head;
+  POOL_SLAB       *Slab;
+  UINTN           Object;
+
+  Head = BASE_CR (Buffer, POOL_SLAB_HEAD, Data);
+  if (Head->Signature != POOL_SLAB_HEAD_SIGNATURE) {
+    return NULL;
+  }
+
+  //
+  // Objects never cross a page, so the slab header is at the start of the
+  // page. Make sure it is a slab, and that Buffer is an object in use in it.
+  //
+  Slab = (POOL_SLAB *)((UINTN)Buffer & ~(UINTN)EFI_PAGE_MASK);
+  if ((Slab->Signature != POOL_SLAB_SIGNATURE) || (Slab->Index >= MAX_SLAB_LIST)) {
+    return NULL;
+  }
+
+  Object = Head->Index;
+  if ((Object >= SLAB_OBJECT_COUNT (Slab->Index)) ||
+      ((UINTN)Head != (UINTN)Slab + POOL_SLAB_DATA_OFFSET + Object * SLAB_OBJECT_SIZE (Slab->Index)) ||
+      ((Slab->Bitmap[Object / 32] & (1U << (Object % 32))) == 0))
+  {
+    return NULL;
+  }
+
+  return Slab;
+}
+
+/**
+  Internal function to free a pool entry allocated from a slab.
+  Caller must have the memory lock held
+
+  @param  Slab                   The slab of the pool entry
+  @param  Buffer                 The allocated pool entry to free
+  @param  PoolType               Pointer to pool type
+
+  @retval EFI_INVALID_PARAMETER  Buffer not valid
+  @retval EFI_SUCCESS            Buffer successfully freed.
+
+**/
+STATIC
+EFI_STATUS
+CoreFreePoolSlab (
+  IN  POOL_SLAB        *Slab,
+  IN  VOID             *Buffer,
+  OUT EFI_MEMORY_TYPE  *PoolType OPTIONAL
+  )
+{
+  POOL            *Pool;
+  POOL_SLAB_LIST  *SlabList;
+  POOL_SLAB_HEAD  *Head;
+  UINTN           Index;
+  UINTN           Object;
+
+  ASSERT_LOCKED (&mPoolMemoryLock);
+
+  Pool = LookupPoolHead (Slab->Type);
+  if (Pool == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Index    = Slab->Index;
+  SlabList = &Pool->SlabList[Index];
+  Head     = BASE_CR (Buffer, POOL_SLAB_HEAD, Data);
+  Object   = Head->Index;
+
+  Pool->Used -= SLAB_OBJECT_SIZE (Index);
+  SlabList->UsedCount--;
+  DEBUG ((DEBUG_POOL, "FreePool: %p (len %lx) %,ld\n", Buffer, (UINT64)mPoolSlabSizeTable[Index], (UINT64)Pool->Used));
+
+  if (PoolType != NULL) {
+    *PoolType = Slab->Type;
+  }
+
+  DEBUG_CLEAR_MEMORY (Buffer, mPoolSlabSizeTable[Index]);
+  Head->Signature = 0;
+
+  Slab->Bitmap[Object / 32] &= ~(UINT32)(1U << (Object % 32));
+  Slab->FreeCount++;
+
+  if (Slab->FreeCount == 1) {
+    //
+    // The slab was full. It has a free object again.
+    //
+    InsertHeadList (&SlabList->FreeList, &Slab->Link);
+  }
+
+  //
+  // Return the page of a slab with no object in use, unless it is the only
+  // slab of this size with free objects, so that a single object allocated
+  // and freed over and over does not keep allocating and freeing pages.
+  //
+  if ((Slab->FreeCount == SLAB_OBJECT_COUNT (Index)) &&
+      ((SlabList->FreeList.ForwardLink != &Slab->Link) || (SlabList->FreeList.BackLink != &Slab->Link)))
+  {
+    RemoveEntryList (&Slab->Link);
+    Slab->Signature = 0;
+    SlabList->SlabCount--;
+    CoreFreePoolPagesI (
+      Pool->MemoryType,
+      (EFI_PHYSICAL_ADDRESS)(UINTN)Slab,
+      EFI_SIZE_TO_PAGES (EFI_PAGE_SIZE)
+      );
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
   Internal function to free a pool entry.
   Caller must have the memory lock held
@@ -707,8 +1056,18 @@ CoreFreePoolI (
   BOOLEAN    IsGuarded;
   BOOLEAN    HasPoolTail;
   BOOLEAN    PageAsPool;
+  POOL_SLAB  *Slab;
 
   ASSERT (Buffer != NULL);
+
+  //
+  // Check if the pool entry was allocated from a slab
+  //
+  Slab = CoreLookupPoolSlab (Buffer);
+  if (Slab != NULL) {
+    return CoreFreePoolSlab (Slab, Buffer, PoolType);
+  }
+
   //
   // Get the head & tail of the pool entry
   //
@@ -880,3 +1239,54 @@ CoreFreePoolI (
 
   return EFI_SUCCESS;
 }
+
+/**
+  Get the usage of the pool slabs, one record for each memory type and slab
+  size that has slabs.
+
+  @param  SlabInfo               Buffer to return the records, or NULL
+  @param  Count                  The number of records SlabInfo can hold
+
+  @return The number of records for the pool slabs
+
+**/
+UINTN
+CoreGetPoolSlabInfo (
+  OUT MEMORY_PROFILE_POOL_SLAB  *SlabInfo OPTIONAL,
+  IN  UINTN                     Count
+  )
+{
+  POOL_SLAB_LIST  *SlabList;
+  UINTN           Type;
+  UINTN           Index;
+  UINTN           Number;
+
+  Number = 0;
+  CoreAcquireLock (&mPoolMemoryLock);
+  for (Type = 0; Type < EfiMaxMemoryType; Type++) {
+    for (Index = 0; Index < MAX_SLAB_LIST; Index++) {
+      SlabList = &mPoolHead[Type].SlabList[Index];
+      if (SlabList->SlabCount == 0) {
+        continue;
+      }
+
+      if ((SlabInfo != NULL) && (Number < Count)) {
+        SlabInfo[Number].Header.Signature    = MEMORY_PROFILE_POOL_SLAB_SIGNATURE;
+        SlabInfo[Number].Header.Length       = sizeof (MEMORY_PROFILE_POOL_SLAB);
+        SlabInfo[Number].Header.Revision     = MEMORY_PROFILE_POOL_SLAB_REVISION;
+        SlabInfo[Number].MemoryType          = (UINT32)Type;
+        SlabInfo[Number].ObjectSize          = mPoolSlabSizeTable[Index];
+        SlabInfo[Number].SlabSize            = EFI_PAGE_SIZE;
+        SlabInfo[Number].SlabCount           = SlabList->SlabCount;
+        SlabInfo[Number].ObjectCount         = SlabList->SlabCount * SLAB_OBJECT_COUNT (Index);
+        SlabInfo[Number].UsedObjectCount     = SlabList->UsedCount;
+        SlabInfo[Number].PeakUsedObjectCount = SlabList->PeakUsedCount;
+      }
+
+      Number++;
+    }
+  }
+
+  CoreReleaseLock (&mPoolMemoryLock);
+  return Number;
+}
@@ -740,10 +740,25 @@ CreateChildNode (
         CompressionType       = CompressionHeader->CompressionType;
       }
 
+      Decompress = NULL;
+      if ((UncompressedLength > 0) && (CompressionType == EFI_STANDARD_COMPRESSION)) {
+        Status = CoreLocateProtocol (&gEfiDecompressProtocolGuid, NULL, (VOID **)&Decompress);
+        ASSERT_EFI_ERROR (Status);
+        ASSERT (Decompress != NULL);
+      }
+
       //
       // Allocate space for the new stream
       //
-      if (UncompressedLength > 0) {
+      if ((Decompress == &gEfiDecompress) &&
+          CoreTakePrefetchedSection (SectionHeader, &NewStreamBuffer, &NewStreamBufferSize, &AuthenticationStatus))
+      {
+        //
+        // The DXE Dispatcher already decompressed the stream on an AP, with
+        // the same decoder as the DXE Core's Decompress Protocol.
+        //
+        ASSERT (NewStreamBufferSize == UncompressedLength);
+      } else if (UncompressedLength > 0) {
         NewStreamBufferSize = UncompressedLength;
         NewStreamBuffer     = AllocatePool (NewStreamBufferSize);
         if (NewStreamBuffer == NULL) {
@@ -764,10 +779,6 @@ CreateChildNode (
           //
           // Decompress the stream
           //
-          Status = CoreLocateProtocol (&gEfiDecompressProtocolGuid, NULL, (VOID **)&Decompress);
-          ASSERT_EFI_ERROR (Status);
-          ASSERT (Decompress != NULL);
-
           Status = Decompress->GetInfo (
                                  Decompress,
                                  CompressionSource,
@@ -1399,6 +1410,71 @@ FreeChildNode (
   CoreFreePool (ChildNode);
 }
 
+/**
+  Worker function. Sum the lengths of the streams encapsulated in a section
+  stream, recursively.
+
+  @param  Stream                 The section stream to measure.
+
+  @return The size of the encapsulated streams.
+
+**/
+UINTN
+GetEncapsulatedStreamSize (
+  IN CORE_SECTION_STREAM_NODE  *Stream
+  )
+{
+  LIST_ENTRY                *Link;
+  CORE_SECTION_CHILD_NODE   *ChildNode;
+  CORE_SECTION_STREAM_NODE  *ChildStream;
+  UINTN                     Size;
+
+  Size = 0;
+  for (Link = GetFirstNode (&Stream->Children); !IsNull (&Stream->Children, Link); Link = GetNextNode (&Stream->Children, Link)) {
+    ChildNode = CHILD_SECTION_NODE_FROM_LINK (Link);
+    if (ChildNode->EncapsulatedStreamHandle == NULL_STREAM_HANDLE) {
+      continue;
+    }
+
+    if (!EFI_ERROR (FindStreamNode (ChildNode->EncapsulatedStreamHandle, &ChildStream))) {
+      Size += ChildStream->StreamLength + GetEncapsulatedStreamSize (ChildStream);
+    }
+  }
+
+  return Size;
+}
+
+/**
+  Return the number of bytes held by the streams encapsulated in a section
+  stream, that is the data decompressed or extracted from its encapsulation
+  sections so far.
+
+  @param  SectionStreamHandle   The section stream to measure.
+
+  @return The size of the encapsulated streams, 0 if the handle does not exist.
+
+**/
+UINTN
+GetSectionStreamDecodedSize (
+  IN UINTN  SectionStreamHandle
+  )
+{
+  CORE_SECTION_STREAM_NODE  *StreamNode;
+  EFI_TPL                   OldTpl;
+  UINTN                     Size;
+
+  OldTpl = CoreRaiseTpl (TPL_NOTIFY);
+
+  Size = 0;
+  if (!EFI_ERROR (FindStreamNode (SectionStreamHandle, &StreamNode))) {
+    Size = GetEncapsulatedStreamSize (StreamNode);
+  }
+
+  CoreRestoreTpl (OldTpl);
+
+  return Size;
+}
+
 /**
   SEP member function.  Deletes an existing section stream
 
@@ -1562,6 +1638,13 @@ CustomGuidedSectionExtract (
   ScratchBuffer         = NULL;
   AllocatedOutputBuffer = NULL;
 
+  //
+  // Use the data if the DXE Dispatcher already decoded the section on an AP
+  //
+  if (CoreTakePrefetchedSection (InputSection, OutputBuffer, OutputSize, AuthenticationStatus)) {
+    return EFI_SUCCESS;
+  }
+
   //
   // Call GetInfo to get the size and attribute of input guided section data.
   //
@@ -271,6 +271,8 @@ FindFileEx (
   IN OUT    EFI_PEI_FILE_HANDLE  *AprioriFile  OPTIONAL
   )
 {
+  EFI_STATUS                      Status;
+  PEI_CORE_FV_HANDLE              *CoreFvHandle;
   EFI_FIRMWARE_VOLUME_HEADER      *FwVolHeader;
   EFI_FIRMWARE_VOLUME_EXT_HEADER  *FwVolExtHeader;
   EFI_FFS_FILE_HEADER             **FileHeader;
@@ -284,6 +286,18 @@ FindFileEx (
   UINT8                           DataCheckSum;
   BOOLEAN                         IsFfs3Fv;
 
+  //
+  // Answer from the file index of the volume if it has one, so that the
+  // volume is not walked again.
+  //
+  CoreFvHandle = FvHandleToCoreHandle (FvHandle);
+  if ((CoreFvHandle != NULL) && (CoreFvHandle->FileIndex != NULL)) {
+    Status = FindFileInIndex (CoreFvHandle->FileIndex, FvHandle, FileName, SearchType, FileHandle, AprioriFile);
+    if (Status != EFI_UNSUPPORTED) {
+      return Status;
+    }
+  }
+
   //
   // Convert the handle of FV to FV header for memory-mapped firmware volume
   //
@@ -455,6 +469,218 @@ FindFileEx (
   return EFI_NOT_FOUND;
 }
 
+/**
+  Search the file index of a firmware volume the way FindFileEx() searches
+  the volume itself.
+
+  @param FileIndex       The file index of the volume to search.
+  @param FvHandle        Pointer to the FV header of the volume to search.
+  @param FileName        File name.
+  @param SearchType      Filter to find only files of this type.
+                         Type EFI_FV_FILETYPE_ALL causes no filtering to be done.
+  @param FileHandle      The file to start the search after, or NULL to start
+                         at the beginning of the volume. Updated on return.
+  @param AprioriFile     Pointer to AprioriFile image in this FV if has.
+
+  @retval EFI_SUCCESS      Success to search given file.
+  @retval EFI_NOT_FOUND    No files matching the search criteria were found.
+  @retval EFI_UNSUPPORTED  FileHandle is not an indexed file, the volume has
+                           to be walked.
+
+**/
+EFI_STATUS
+FindFileInIndex (
+  IN  CONST PEI_CORE_FV_FILE_INDEX  *FileIndex,
+  IN  CONST EFI_PEI_FV_HANDLE       FvHandle,
+  IN  CONST EFI_GUID                *FileName    OPTIONAL,
+  IN        EFI_FV_FILETYPE         SearchType,
+  IN OUT    EFI_PEI_FILE_HANDLE     *FileHandle,
+  IN OUT    EFI_PEI_FILE_HANDLE     *AprioriFile  OPTIONAL
+  )
+{
+  PEI_CORE_FV_FILE_INDEX_ENTRY  *Entry;
+  UINT32                        *NameOrder;
+  UINTN                         Low;
+  UINTN                         High;
+  UINTN                         Middle;
+  UINTN                         Index;
+  UINTN                         Offset;
+
+  Entry     = PEI_CORE_FV_FILE_INDEX_ENTRIES (FileIndex);
+  NameOrder = PEI_CORE_FV_FILE_INDEX_NAME_ORDER (FileIndex);
+
+  if (FileName != NULL) {
+    //
+    // Find the first file of this name in NameOrder, which is the first one
+    // in the volume as files of the same name are kept in volume order.
+    //
+    Low  = 0;
+    High = FileIndex->FileCount;
+    while (Low < High) {
+      Middle = (Low + High) / 2;
+      if (CompareMem (&Entry[NameOrder[Middle]].Name, FileName, sizeof (EFI_GUID)) < 0) {
+        Low = Middle + 1;
+      } else {
+        High = Middle;
+      }
+    }
+
+    if ((Low < FileIndex->FileCount) && CompareGuid (&Entry[NameOrder[Low]].Name, FileName)) {
+      *FileHandle = (EFI_PEI_FILE_HANDLE)((UINT8 *)FvHandle + Entry[NameOrder[Low]].Offset);
+      return EFI_SUCCESS;
+    }
+
+    *FileHandle = NULL;
+    return EFI_NOT_FOUND;
+  }
+
+  if (*FileHandle == NULL) {
+    Index = 0;
+  } else {
+    //
+    // Find the file to start after. Entries are in ascending offset order.
+    //
+    Offset = (UINTN)*FileHandle - (UINTN)FvHandle;
+    Low    = 0;
+    High   = FileIndex->FileCount;
+    while (Low < High) {
+      Middle = (Low + High) / 2;
+      if (Entry[Middle].Offset < Offset) {
+        Low = Middle + 1;
+      } else {
+        High = Middle;
+      }
+    }
+
+    if ((Low == FileIndex->FileCount) || (Entry[Low].Offset != Offset)) {
+      return EFI_UNSUPPORTED;
+    }
+
+    Index = Low + 1;
+  }
+
+  for ( ; Index < FileIndex->FileCount; Index++) {
+    if (SearchType == PEI_CORE_INTERNAL_FFS_FILE_DISPATCH_TYPE) {
+      if ((Entry[Index].Type == EFI_FV_FILETYPE_PEIM) ||
+          (Entry[Index].Type == EFI_FV_FILETYPE_COMBINED_PEIM_DRIVER) ||
+          (Entry[Index].Type == EFI_FV_FILETYPE_FIRMWARE_VOLUME_IMAGE))
+      {
+        *FileHandle = (EFI_PEI_FILE_HANDLE)((UINT8 *)FvHandle + Entry[Index].Offset);
+        return EFI_SUCCESS;
+      } else if (AprioriFile != NULL) {
+        if ((Entry[Index].Type == EFI_FV_FILETYPE_FREEFORM) &&
+            CompareGuid (&Entry[Index].Name, &gPeiAprioriFileNameGuid))
+        {
+          *AprioriFile = (EFI_PEI_FILE_HANDLE)((UINT8 *)FvHandle + Entry[Index].Offset);
+        }
+      }
+    } else if ((SearchType == Entry[Index].Type) || (SearchType == EFI_FV_FILETYPE_ALL)) {
+      *FileHandle = (EFI_PEI_FILE_HANDLE)((UINT8 *)FvHandle + Entry[Index].Offset);
+      return EFI_SUCCESS;
+    }
+  }
+
+  *FileHandle = NULL;
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Build the file index of a firmware volume processed by the FFS2 or FFS3
+  EFI_PEI_FIRMWARE_VOLUME_PPI of the PEI Core, and keep it in the PEI heap
+  for the later searches of the volume.
+
+  @param CoreFvHandle    The volume to index.
+
+**/
+VOID
+PeiBuildFvFileIndex (
+  IN OUT PEI_CORE_FV_HANDLE  *CoreFvHandle
+  )
+{
+  PEI_CORE_FV_FILE_INDEX        *FileIndex;
+  PEI_CORE_FV_FILE_INDEX_ENTRY  *Entry;
+  UINT32                        *NameOrder;
+  EFI_FFS_FILE_HEADER           *FfsFileHeader;
+  UINTN                         FileCount;
+  UINTN                         Index;
+  UINTN                         Position;
+
+  if (!FeaturePcdGet (PcdPeiCoreFvFileIndexEnable)) {
+    return;
+  }
+
+  //
+  // Only the volumes searched by FindFileEx () can be indexed.
+  //
+  if ((CoreFvHandle->FvPpi != &mPeiFfs2FwVol.Fv) && (CoreFvHandle->FvPpi != &mPeiFfs3FwVol.Fv)) {
+    return;
+  }
+
+  ASSERT (CoreFvHandle->FileIndex == NULL);
+
+  //
+  // Walk the volume once to size the index. Pad files are never returned by
+  // EFI_FV_FILETYPE_ALL searches and are left out of the index.
+  //
+  FileCount     = 0;
+  FfsFileHeader = NULL;
+  while (!EFI_ERROR (FindFileEx (CoreFvHandle->FvHandle, NULL, EFI_FV_FILETYPE_ALL, (EFI_PEI_FILE_HANDLE *)&FfsFileHeader, NULL))) {
+    FileCount++;
+  }
+
+  //
+  // The PEI heap cannot hold the index of a volume with too many files, keep
+  // walking such a volume.
+  //
+  FileIndex = AllocatePool (sizeof (PEI_CORE_FV_FILE_INDEX) + FileCount * (sizeof (PEI_CORE_FV_FILE_INDEX_ENTRY) + sizeof (UINT32)));
+  if (FileIndex == NULL) {
+    return;
+  }
+
+  FileIndex->FileCount = (UINT32)FileCount;
+  Entry                = PEI_CORE_FV_FILE_INDEX_ENTRIES (FileIndex);
+  NameOrder            = PEI_CORE_FV_FILE_INDEX_NAME_ORDER (FileIndex);
+
+  //
+  // Walk it again to fill the entries, and insert each of them in NameOrder
+  // after the files of the same name already there.
+  //
+  FfsFileHeader = NULL;
+  for (Index = 0; Index < FileCount; Index++) {
+    if (EFI_ERROR (FindFileEx (CoreFvHandle->FvHandle, NULL, EFI_FV_FILETYPE_ALL, (EFI_PEI_FILE_HANDLE *)&FfsFileHeader, NULL))) {
+      ASSERT (FALSE);
+      FileIndex->FileCount = (UINT32)Index;
+      break;
+    }
+
+    CopyGuid (&Entry[Index].Name, &FfsFileHeader->Name);
+    Entry[Index].Offset = (UINT32)((UINTN)FfsFileHeader - (UINTN)CoreFvHandle->FvHandle);
+    Entry[Index].Type   = FfsFileHeader->Type;
+    ZeroMem (Entry[Index].Reserved, sizeof (Entry[Index].Reserved));
+
+    for (Position = Index; Position > 0; Position--) {
+      if (CompareMem (&Entry[NameOrder[Position - 1]].Name, &Entry[Index].Name, sizeof (EFI_GUID)) <= 0) {
+        break;
+      }
+
+      NameOrder[Position] = NameOrder[Position - 1];
+    }
+
+    NameOrder[Position] = (UINT32)Index;
+  }
+
+  //
+  // The NameOrder array follows FileCount entries, move it down if the
+  // second walk ended early.
+  //
+  if (FileIndex->FileCount != FileCount) {
+    CopyMem (PEI_CORE_FV_FILE_INDEX_NAME_ORDER (FileIndex), NameOrder, FileIndex->FileCount * sizeof (UINT32));
+  }
+
+  CoreFvHandle->FileIndex = FileIndex;
+  DEBUG ((DEBUG_INFO, "Indexed %d files of the FV at 0x%p\n", FileIndex->FileCount, CoreFvHandle->FvHeader));
+}
+
 /**
   Initialize PeiCore FV List.
 
@@ -517,6 +743,7 @@ PeiInitializeFv (
   PrivateData->Fv[PrivateData->FvCount].FvPpi                = FvPpi;
   PrivateData->Fv[PrivateData->FvCount].FvHandle             = FvHandle;
   PrivateData->Fv[PrivateData->FvCount].AuthenticationStatus = 0;
+  PeiBuildFvFileIndex (&PrivateData->Fv[PrivateData->FvCount]);
   DEBUG ((
     DEBUG_INFO,
     "The %dth FV start address is 0x%11p, size is 0x%08x, handle is 0x%p\n",
@@ -659,6 +886,7 @@ FirmwareVolumeInfoPpiNotifyCallback (
     PrivateData->Fv[PrivateData->FvCount].FvHandle             = FvHandle;
     PrivateData->Fv[PrivateData->FvCount].AuthenticationStatus = FvInfo2Ppi.AuthenticationStatus;
     CurFvCount                                                 = PrivateData->FvCount;
+    PeiBuildFvFileIndex (&PrivateData->Fv[CurFvCount]);
     DEBUG ((
       DEBUG_INFO,
       "The %dth FV start address is 0x%11p, size is 0x%08x, handle is 0x%p\n",
@@ -300,6 +300,48 @@ FindFileEx (
   IN OUT    EFI_PEI_FILE_HANDLE  *AprioriFile  OPTIONAL
   );
 
+/**
+  Search the file index of a firmware volume the way FindFileEx() searches
+  the volume itself.
+
+  @param FileIndex       The file index of the volume to search.
+  @param FvHandle        Pointer to the FV header of the volume to search.
+  @param FileName        File name.
+  @param SearchType      Filter to find only files of this type.
+                         Type EFI_FV_FILETYPE_ALL causes no filtering to be done.
+  @param FileHandle      The file to start the search after, or NULL to start
+                         at the beginning of the volume. Updated on return.
+  @param AprioriFile     Pointer to AprioriFile image in this FV if has.
+
+  @retval EFI_SUCCESS      Success to search given file.
+  @retval EFI_NOT_FOUND    No files matching the search criteria were found.
+  @retval EFI_UNSUPPORTED  FileHandle is not an indexed file, the volume has
+                           to be walked.
+
+**/
+EFI_STATUS
+FindFileInIndex (
+  IN  CONST PEI_CORE_FV_FILE_INDEX  *FileIndex,
+  IN  CONST EFI_PEI_FV_HANDLE       FvHandle,
+  IN  CONST EFI_GUID                *FileName    OPTIONAL,
+  IN        EFI_FV_FILETYPE         SearchType,
+  IN OUT    EFI_PEI_FILE_HANDLE     *FileHandle,
+  IN OUT    EFI_PEI_FILE_HANDLE     *AprioriFile  OPTIONAL
+  );
+
+/**
+  Build the file index of a firmware volume processed by the FFS2 or FFS3
+  EFI_PEI_FIRMWARE_VOLUME_PPI of the PEI Core, and keep it in the PEI heap
+  for the later searches of the volume.
+
+  @param CoreFvHandle    The volume to index.
+
+**/
+VOID
+PeiBuildFvFileIndex (
+  IN OUT PEI_CORE_FV_HANDLE  *CoreFvHandle
+  );
+
 /**
   Report the information for a newly discovered FV in an unknown format.
 
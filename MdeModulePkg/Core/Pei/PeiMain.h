@@ -137,6 +137,35 @@ typedef struct {
 //
 #define FV_GROWTH_STEP  8
 
+///
+/// One file of an indexed FV. Pad files and files that would not be returned
+/// by a search of the volume (deleted, under construction, FFS3 files in an
+/// FFS2 volume) are not indexed.
+///
+typedef struct {
+  EFI_GUID    Name;
+  UINT32      Offset;       // Offset of the FFS header from the FV base
+  UINT8       Type;         // EFI_FV_FILETYPE of the file
+  UINT8       Reserved[3];
+} PEI_CORE_FV_FILE_INDEX_ENTRY;
+
+///
+/// File index of an FV. Files are recorded in volume order, which is also
+/// ascending Offset order, and NameOrder lists them by ascending name so that
+/// a file can be found by binary search.
+///
+typedef struct {
+  UINT32    FileCount;
+  // PEI_CORE_FV_FILE_INDEX_ENTRY    Entry[FileCount];
+  // UINT32                          NameOrder[FileCount];
+} PEI_CORE_FV_FILE_INDEX;
+
+#define PEI_CORE_FV_FILE_INDEX_ENTRIES(Index) \
+  ((PEI_CORE_FV_FILE_INDEX_ENTRY *)((PEI_CORE_FV_FILE_INDEX *)(Index) + 1))
+
+#define PEI_CORE_FV_FILE_INDEX_NAME_ORDER(Index) \
+  ((UINT32 *)(PEI_CORE_FV_FILE_INDEX_ENTRIES (Index) + ((PEI_CORE_FV_FILE_INDEX *)(Index))->FileCount))
+
 typedef struct {
   EFI_FIRMWARE_VOLUME_HEADER     *FvHeader;
   EFI_PEI_FIRMWARE_VOLUME_PPI    *FvPpi;
@@ -152,6 +181,10 @@ typedef struct {
   EFI_PEI_FILE_HANDLE            *FvFileHandles;
   BOOLEAN                        ScanFv;
   UINT32                         AuthenticationStatus;
+  //
+  // File index of the FV, in the PEI heap. NULL if the FV is not indexed.
+  //
+  PEI_CORE_FV_FILE_INDEX         *FileIndex;
 } PEI_CORE_FV_HANDLE;
 
 typedef struct {
@@ -179,6 +179,25 @@ typedef struct {
   // MEMORY_PROFILE_DESCRIPTOR     MemoryDescriptor[MemoryRangeCount];
 } MEMORY_PROFILE_MEMORY_RANGE;
 
+#define MEMORY_PROFILE_POOL_SLAB_SIGNATURE  SIGNATURE_32 ('M','P','P','S')
+#define MEMORY_PROFILE_POOL_SLAB_REVISION   0x0001
+
+//
+// Usage of the slabs that serve small pool allocations of one size and
+// memory type. (ObjectCount - UsedObjectCount) * ObjectSize bytes are held
+// in the slabs but not in use.
+//
+typedef struct {
+  MEMORY_PROFILE_COMMON_HEADER    Header;
+  UINT32                          MemoryType;
+  UINT32                          ObjectSize;
+  UINT64                          SlabSize;
+  UINT64                          SlabCount;
+  UINT64                          ObjectCount;
+  UINT64                          UsedObjectCount;
+  UINT64                          PeakUsedObjectCount;
+} MEMORY_PROFILE_POOL_SLAB;
+
 //
 // UEFI memory profile layout:
 // +--------------------------------+
@@ -196,6 +215,10 @@ typedef struct {
 // +--------------------------------+
 // | ALLOC_INFO(n, mn)              |
 // +--------------------------------+
+// | POOL_SLAB(1)                   |
+// +--------------------------------+
+// | POOL_SLAB(k)                   |
+// +--------------------------------+
 //
 
 typedef struct _EDKII_MEMORY_PROFILE_PROTOCOL EDKII_MEMORY_PROFILE_PROTOCOL;
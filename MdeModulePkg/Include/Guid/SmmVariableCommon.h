@@ -77,6 +77,10 @@ typedef struct {
 // The payload for this function is SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO
 //
 #define SMM_VARIABLE_FUNCTION_GET_RUNTIME_CACHE_INFO  14
+//
+// The payload for this function is SMM_VARIABLE_COMMUNICATE_BATCH_ACCESS_VARIABLE
+//
+#define SMM_VARIABLE_FUNCTION_BATCH_ACCESS_VARIABLE  15
 
 ///
 /// Size of SMM communicate header, without including the payload.
@@ -147,4 +151,34 @@ typedef struct {
   BOOLEAN    AuthenticatedVariableUsage;
 } SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO;
 
+///
+/// This structure describes one GetVariable or SetVariable request in a batch.
+/// Function is SMM_VARIABLE_FUNCTION_GET_VARIABLE or SMM_VARIABLE_FUNCTION_SET_VARIABLE,
+/// and EntrySize is the UINTN aligned size of the entry, including the name and the
+/// data buffer that follow Access.Name. EntrySize is not updated by the SMI handler,
+/// so the entries can still be walked after GetVariable has updated Access.DataSize.
+///
+typedef struct {
+  UINTN                                       Function;
+  EFI_STATUS                                  ReturnStatus;
+  UINTN                                       EntrySize;
+  SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE    Access;
+} SMM_VARIABLE_COMMUNICATE_BATCH_ENTRY;
+
+///
+/// This structure is used to communicate with SMI handler by batched GetVariable and
+/// SetVariable. Count SMM_VARIABLE_COMMUNICATE_BATCH_ENTRY structures follow the header
+/// and are processed in order.
+///
+typedef struct {
+  UINTN    Count;
+  UINT8    Entry[1];
+} SMM_VARIABLE_COMMUNICATE_BATCH_ACCESS_VARIABLE;
+
+///
+/// Size of a batch entry, without including the variable name and data.
+///
+#define SMM_VARIABLE_BATCH_ENTRY_HEADER_SIZE \
+  (OFFSET_OF (SMM_VARIABLE_COMMUNICATE_BATCH_ENTRY, Access) + OFFSET_OF (SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE, Name))
+
 #endif // _SMM_VARIABLE_COMMON_H_
@@ -0,0 +1,96 @@
+/** @file
+  Variable Batch Protocol is related to EDK II-specific implementation of variables
+  and intended for use as a means to get and set several variables with a single
+  request to the variable driver. When the variable services are provided by SMM,
+  the requests are carried to SMM in as few SMIs as the communicate buffer allows.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __VARIABLE_BATCH_H__
+#define __VARIABLE_BATCH_H__
+
+#define EDKII_VARIABLE_BATCH_PROTOCOL_GUID \
+  { \
+    0x50fd14d2, 0x2051, 0x486f, { 0x84, 0x42, 0xfa, 0xee, 0x6b, 0x23, 0xcd, 0x71 } \
+  }
+
+typedef struct _EDKII_VARIABLE_BATCH_PROTOCOL EDKII_VARIABLE_BATCH_PROTOCOL;
+
+typedef enum {
+  EdkiiVariableBatchGetVariable,
+  EdkiiVariableBatchSetVariable
+} EDKII_VARIABLE_BATCH_OPERATION;
+
+///
+/// One GetVariable or SetVariable request in a batch.
+///
+typedef struct {
+  ///
+  /// The service to invoke for this entry.
+  ///
+  EDKII_VARIABLE_BATCH_OPERATION    Operation;
+  ///
+  /// A Null-terminated string that is the name of the vendor's variable.
+  ///
+  CHAR16                            *VariableName;
+  ///
+  /// A unique identifier for the vendor.
+  ///
+  EFI_GUID                          *VendorGuid;
+  ///
+  /// For SetVariable, the attributes to set. For GetVariable, the attributes of
+  /// the variable are returned here.
+  ///
+  UINT32                            Attributes;
+  ///
+  /// For SetVariable, the size of Data. For GetVariable, the size of the Data
+  /// buffer on input and the size of the variable data (or the size needed) on output.
+  ///
+  UINTN                             DataSize;
+  ///
+  /// The variable data to set, or the buffer to return the variable data in.
+  ///
+  VOID                              *Data;
+  ///
+  /// The status GetVariable() or SetVariable() returned for this entry.
+  ///
+  EFI_STATUS                        Status;
+} EDKII_VARIABLE_BATCH_ENTRY;
+
+/**
+  Get or set a list of variables with one request.
+
+  The entries are processed in order, so a GetVariable entry observes the result of
+  any SetVariable entry before it. Each entry reports the status its GetVariable() or
+  SetVariable() call would have returned in its Status field; one entry failing does
+  not stop the entries after it.
+
+  @param[in]      This          The EDKII_VARIABLE_BATCH_PROTOCOL instance.
+  @param[in]      Count         The number of entries in Entries.
+  @param[in, out] Entries       The GetVariable and SetVariable requests to process.
+
+  @retval EFI_SUCCESS           All entries were processed. Check the Status of each entry.
+  @retval EFI_INVALID_PARAMETER Count is not zero and Entries is NULL.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_VARIABLE_BATCH_PROTOCOL_ACCESS)(
+  IN CONST EDKII_VARIABLE_BATCH_PROTOCOL  *This,
+  IN       UINTN                          Count,
+  IN OUT   EDKII_VARIABLE_BATCH_ENTRY     *Entries
+  );
+
+///
+/// Variable Batch Protocol is related to EDK II-specific implementation of variables
+/// and intended for use as a means to get and set several variables with one request.
+///
+struct _EDKII_VARIABLE_BATCH_PROTOCOL {
+  EDKII_VARIABLE_BATCH_PROTOCOL_ACCESS    Access;
+};
+
+extern EFI_GUID  gEdkiiVariableBatchProtocolGuid;
+
+#endif
@@ -92,8 +92,13 @@ GetLbaAndOffsetByAddress (
   volume block device. The destination is specified by parameter
   VariableBase. Fault Tolerant Write protocol is used for writing.
 
+  Only the given range of the variable store is written, so that a reclaim
+  does not rewrite the blocks it leaves unchanged.
+
   @param  VariableBase   Base address of variable to write
   @param  VariableBuffer Point to the variable data buffer.
+  @param  Offset         Offset of the range of the variable store to write.
+  @param  Length         Length of the range of the variable store to write.
 
   @retval EFI_SUCCESS    The function completed successfully.
   @retval EFI_NOT_FOUND  Fail to locate Fault Tolerant Write protocol.
@@ -103,14 +108,15 @@ GetLbaAndOffsetByAddress (
 EFI_STATUS
 FtwVariableSpace (
   IN EFI_PHYSICAL_ADDRESS   VariableBase,
-  IN VARIABLE_STORE_HEADER  *VariableBuffer
+  IN VARIABLE_STORE_HEADER  *VariableBuffer,
+  IN UINTN                  Offset,
+  IN UINTN                  Length
   )
 {
   EFI_STATUS                         Status;
   EFI_HANDLE                         FvbHandle;
   EFI_LBA                            VarLba;
   UINTN                              VarOffset;
-  UINTN                              FtwBufferSize;
   EFI_FAULT_TOLERANT_WRITE_PROTOCOL  *FtwProtocol;
 
   //
@@ -132,25 +138,25 @@ FtwVariableSpace (
   //
   // Get LBA and Offset by address.
   //
-  Status = GetLbaAndOffsetByAddress (VariableBase, &VarLba, &VarOffset);
+  Status = GetLbaAndOffsetByAddress (VariableBase + Offset, &VarLba, &VarOffset);
   if (EFI_ERROR (Status)) {
     return EFI_ABORTED;
   }
 
-  FtwBufferSize = ((VARIABLE_STORE_HEADER *)((UINTN)VariableBase))->Size;
-  ASSERT (FtwBufferSize == VariableBuffer->Size);
+  ASSERT (((VARIABLE_STORE_HEADER *)((UINTN)VariableBase))->Size == VariableBuffer->Size);
+  ASSERT (Offset + Length <= VariableBuffer->Size);
 
   //
   // FTW write record.
   //
   Status = FtwProtocol->Write (
                           FtwProtocol,
-                          VarLba,                // LBA
-                          VarOffset,             // Offset
-                          FtwBufferSize,         // NumBytes
-                          NULL,                  // PrivateData NULL
-                          FvbHandle,             // Fvb Handle
-                          (VOID *)VariableBuffer // write buffer
+                          VarLba,                                    // LBA
+                          VarOffset,                                 // Offset
+                          Length,                                    // NumBytes
+                          NULL,                                      // PrivateData NULL
+                          FvbHandle,                                 // Fvb Handle
+                          (VOID *)((UINT8 *)VariableBuffer + Offset) // write buffer
                           );
 
   return Status;
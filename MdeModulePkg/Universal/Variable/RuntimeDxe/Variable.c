@@ -341,8 +341,8 @@ RecordVarErrorFlag (
       *VarErrFlag = TempFlag;
       Status      =  SynchronizeRuntimeVariableCache (
                        &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeNvCache,
-                       0,
-                       mNvVariableCache->Size
+                       (UINTN)VarErrFlag - (UINTN)mNvVariableCache,
+                       sizeof (TempFlag)
                        );
       ASSERT_EFI_ERROR (Status);
     }
@@ -497,6 +497,88 @@ InitializeVariableQuota (
   CalculateCommonUserVariableTotalSize ();
 }
 
+/**
+  Return the time elapsed since a value of the performance counter.
+
+  The performance counter may be narrower than 64 bits, such as a 24-bit
+  ACPI timer, so the difference is taken modulo its range. The time measured
+  must be shorter than one period of the counter.
+
+  @param[in]  StartTick         Value of the performance counter at the start.
+
+  @return The elapsed time in nanoseconds.
+
+**/
+UINT64
+GetVariableElapsedTime (
+  IN UINT64  StartTick
+  )
+{
+  UINT64  StartValue;
+  UINT64  EndValue;
+  UINT64  CurrentTick;
+  INT64   Delta;
+  INT64   Cycle;
+
+  CurrentTick = GetPerformanceCounter ();
+  GetPerformanceCounterProperties (&StartValue, &EndValue);
+  Cycle = EndValue - StartValue;
+  if (Cycle < 0) {
+    Cycle = -Cycle;
+  }
+
+  Cycle++;
+  Delta = (INT64)(CurrentTick - StartTick);
+  if (StartValue > EndValue) {
+    //
+    // The performance counter counts down.
+    //
+    Delta = -Delta;
+  }
+
+  if (Delta < 0) {
+    Delta += Cycle;
+  }
+
+  return GetTimeInNanoSecond ((UINT64)Delta);
+}
+
+/**
+  Get the range of a variable store that a reclaim changes.
+
+  @param[in]  Store             The variable store before the reclaim.
+  @param[in]  Buffer            The reclaimed variable store.
+  @param[in]  BufferSize        Size of Buffer. The reclaimed variable store is
+                                erased beyond it.
+  @param[out] Offset            Offset of the first byte that changes.
+  @param[out] End               Offset of the byte after the last one that changes.
+                                It is equal to Offset if nothing changes.
+
+**/
+VOID
+GetReclaimChangedRange (
+  IN  VARIABLE_STORE_HEADER  *Store,
+  IN  UINT8                  *Buffer,
+  IN  UINTN                  BufferSize,
+  OUT UINTN                  *Offset,
+  OUT UINTN                  *End
+  )
+{
+  *Offset = sizeof (VARIABLE_STORE_HEADER);
+  *End    = Store->Size;
+  while ((*Offset < *End) &&
+         (((*Offset < BufferSize) ? Buffer[*Offset] : 0xff) == ((UINT8 *)Store)[*Offset]))
+  {
+    (*Offset)++;
+  }
+
+  while ((*End > *Offset) &&
+         (((*End - 1 < BufferSize) ? Buffer[*End - 1] : 0xff) == ((UINT8 *)Store)[*End - 1]))
+  {
+    (*End)--;
+  }
+}
+
 /**
 
   Variable store garbage collection and reclaim operation.
@@ -545,6 +627,15 @@ Reclaim (
   VARIABLE_HEADER        *UpdatingVariable;
   VARIABLE_HEADER        *UpdatingInDeletedTransition;
   BOOLEAN                AuthFormat;
+  UINTN                  DirtyOffset;
+  UINTN                  DirtyEnd;
+  UINT64                 StartTick;
+  UINT64                 ReclaimTime;
+
+  StartTick = 0;
+  if (FeaturePcdGet (PcdVariableCollectStatistics)) {
+    StartTick = GetPerformanceCounter ();
+  }
 
   AuthFormat                  = mVariableModuleGlobal->VariableGlobal.AuthFormat;
   UpdatingVariable            = NULL;
@@ -555,6 +646,8 @@ Reclaim (
   }
 
   VariableStoreHeader = (VARIABLE_STORE_HEADER *)((UINTN)VariableBase);
+  DirtyOffset         = 0;
+  DirtyEnd            = VariableStoreHeader->Size;
 
   CommonVariableTotalSize     = 0;
   CommonUserVariableTotalSize = 0;
@@ -741,6 +834,7 @@ Reclaim (
     //
     // If volatile/emulated non-volatile variable store, just copy valid buffer.
     //
+    GetReclaimChangedRange (VariableStoreHeader, ValidBuffer, (UINTN)CurrPtr - (UINTN)ValidBuffer, &DirtyOffset, &DirtyEnd);
     SetMem ((UINT8 *)(UINTN)VariableBase, VariableStoreHeader->Size, 0xff);
     CopyMem ((UINT8 *)(UINTN)VariableBase, ValidBuffer, (UINTN)CurrPtr - (UINTN)ValidBuffer);
     *LastVariableOffset = (UINTN)CurrPtr - (UINTN)ValidBuffer;
@@ -757,11 +851,21 @@ Reclaim (
   } else {
     //
     // If non-volatile variable store, perform FTW here.
+    // The variables before the first one dropped or promoted keep their place,
+    // and the end of the store stays erased, so only write the range between.
     //
-    Status = FtwVariableSpace (
-               VariableBase,
-               (VARIABLE_STORE_HEADER *)ValidBuffer
-               );
+    GetReclaimChangedRange (VariableStoreHeader, ValidBuffer, MaximumBufferSize, &DirtyOffset, &DirtyEnd);
+    Status = EFI_SUCCESS;
+    if (DirtyEnd > DirtyOffset) {
+      Status = FtwVariableSpace (
+                 VariableBase,
+                 (VARIABLE_STORE_HEADER *)ValidBuffer,
+                 DirtyOffset,
+                 DirtyEnd - DirtyOffset
+                 );
+      mVariableModuleGlobal->ReclaimBytes += DirtyEnd - DirtyOffset;
+    }
+
     if (!EFI_ERROR (Status)) {
       *LastVariableOffset                                = (UINTN)CurrPtr - (UINTN)ValidBuffer;
       mVariableModuleGlobal->HwErrVariableTotalSize      = HwErrVariableTotalSize;
@@ -792,26 +896,43 @@ Reclaim (
   }
 
 Done:
-  DoneStatus = EFI_SUCCESS;
+  //
+  // The variables have moved, the index of the store is rebuilt by the next lookup.
+  //
+  VariableStoreIndexInvalidate ((VARIABLE_STORE_HEADER *)(UINTN)VariableBase);
+  if (!IsVolatile) {
+    VariableStoreIndexInvalidate (mNvVariableCache);
+  }
+
   if (IsVolatile || mVariableModuleGlobal->VariableGlobal.EmuNvMode) {
-    DoneStatus = SynchronizeRuntimeVariableCache (
-                   &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeVolatileCache,
-                   0,
-                   VariableStoreHeader->Size
-                   );
-    ASSERT_EFI_ERROR (DoneStatus);
     FreePool (ValidBuffer);
   } else {
     //
     // For NV variable reclaim, we use mNvVariableCache as the buffer, so copy the data back.
     //
     CopyMem (mNvVariableCache, (UINT8 *)(UINTN)VariableBase, VariableStoreHeader->Size);
-    DoneStatus = SynchronizeRuntimeVariableCache (
-                   &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeNvCache,
-                   0,
-                   VariableStoreHeader->Size
-                   );
-    ASSERT_EFI_ERROR (DoneStatus);
+  }
+
+  //
+  // Only the range the reclaim changed needs to reach the runtime cache.
+  //
+  DoneStatus = SynchronizeRuntimeVariableCache (
+                 IsVolatile ?
+                 &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeVolatileCache :
+                 &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeNvCache,
+                 DirtyOffset,
+                 DirtyEnd - DirtyOffset
+                 );
+  ASSERT_EFI_ERROR (DoneStatus);
+
+  if (!IsVolatile) {
+    mVariableModuleGlobal->ReclaimCount++;
+    if (FeaturePcdGet (PcdVariableCollectStatistics)) {
+      ReclaimTime = GetVariableElapsedTime (StartTick);
+      if (ReclaimTime > mVariableModuleGlobal->MaxReclaimTime) {
+        mVariableModuleGlobal->MaxReclaimTime = ReclaimTime;
+      }
+    }
   }
 
   if (!EFI_ERROR (Status) && EFI_ERROR (DoneStatus)) {
@@ -1710,6 +1831,11 @@ UpdateVariable (
   BOOLEAN                             IsCommonUserVariable;
   AUTHENTICATED_VARIABLE_HEADER       *AuthVariable;
   BOOLEAN                             AuthFormat;
+  UINTN                               SyncStoreBase;
+  UINTN                               *LastVariableOffset;
+  UINTN                               SyncLastVariableOffset;
+  VARIABLE_HEADER                     *UpdatedVariable;
+  VARIABLE_HEADER                     *UpdatedInDeletedTransition;
 
   if ((mVariableModuleGlobal->FvbInstance == NULL) && !mVariableModuleGlobal->VariableGlobal.EmuNvMode) {
     //
@@ -1786,6 +1912,23 @@ UpdateVariable (
     Variable->Volatile = FALSE;
   }
 
+  //
+  // Remember the records this update may change: the state of the existing
+  // variable and the end of the store where the new one is appended. Only
+  // they are synchronized with the runtime cache.
+  //
+  if (((Variable->CurrPtr != NULL) && !Variable->Volatile) || ((Attributes & EFI_VARIABLE_NON_VOLATILE) != 0)) {
+    SyncStoreBase      = (UINTN)mVariableModuleGlobal->VariableGlobal.NonVolatileVariableBase;
+    LastVariableOffset = &mVariableModuleGlobal->NonVolatileLastVariableOffset;
+  } else {
+    SyncStoreBase      = (UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase;
+    LastVariableOffset = &mVariableModuleGlobal->VolatileLastVariableOffset;
+  }
+
+  SyncLastVariableOffset     = *LastVariableOffset;
+  UpdatedVariable            = Variable->CurrPtr;
+  UpdatedInDeletedTransition = Variable->InDeletedTransitionPtr;
+
   Fvb = mVariableModuleGlobal->FvbInstance;
 
   //
@@ -2357,12 +2500,35 @@ Done:
     }
 
     if (VolatileCacheInstance->Store != NULL) {
-      Status =  SynchronizeRuntimeVariableCache (
-                  VolatileCacheInstance,
-                  0,
-                  VolatileCacheInstance->Store->Size
-                  );
-      ASSERT_EFI_ERROR (Status);
+      //
+      // A reclaim has already synchronized the range it changed.
+      //
+      if (UpdatedVariable != NULL) {
+        Status = SynchronizeRuntimeVariableCache (
+                   VolatileCacheInstance,
+                   (UINTN)UpdatedVariable - SyncStoreBase,
+                   GetVariableHeaderSize (AuthFormat)
+                   );
+        ASSERT_EFI_ERROR (Status);
+      }
+
+      if (UpdatedInDeletedTransition != NULL) {
+        Status = SynchronizeRuntimeVariableCache (
+                   VolatileCacheInstance,
+                   (UINTN)UpdatedInDeletedTransition - SyncStoreBase,
+                   GetVariableHeaderSize (AuthFormat)
+                   );
+        ASSERT_EFI_ERROR (Status);
+      }
+
+      if (*LastVariableOffset > SyncLastVariableOffset) {
+        Status = SynchronizeRuntimeVariableCache (
+                   VolatileCacheInstance,
+                   SyncLastVariableOffset,
+                   *LastVariableOffset - SyncLastVariableOffset
+                   );
+        ASSERT_EFI_ERROR (Status);
+      }
     }
   } else if (Status == EFI_OUT_OF_RESOURCES) {
     DEBUG ((DEBUG_WARN, "UpdateVariable failed: Out of flash space\n"));
@@ -2623,6 +2789,8 @@ VariableServiceSetVariable (
   EFI_PHYSICAL_ADDRESS    Point;
   UINTN                   PayloadSize;
   BOOLEAN                 AuthFormat;
+  UINT64                  StartTick;
+  UINT64                  SetVariableTime;
 
   AuthFormat = mVariableModuleGlobal->VariableGlobal.AuthFormat;
 
@@ -2842,6 +3010,11 @@ VariableServiceSetVariable (
 
   AcquireLockOnlyAtBootTime (&mVariableModuleGlobal->VariableGlobal.VariableServicesLock);
 
+  StartTick = 0;
+  if (FeaturePcdGet (PcdVariableCollectStatistics)) {
+    StartTick = GetPerformanceCounter ();
+  }
+
   //
   // Consider reentrant in MCA/INIT/NMI. It needs be reupdated.
   //
@@ -2901,6 +3074,20 @@ VariableServiceSetVariable (
   }
 
 Done:
+  if (FeaturePcdGet (PcdVariableCollectStatistics)) {
+    SetVariableTime = GetVariableElapsedTime (StartTick);
+    if (SetVariableTime > mVariableModuleGlobal->MaxSetVariableTime) {
+      mVariableModuleGlobal->MaxSetVariableTime = SetVariableTime;
+      DEBUG ((
+        DEBUG_INFO,
+        "Variable: Worst case SetVariable() latency is now %ld us - %g:%s\n",
+        DivU64x32 (SetVariableTime, 1000),
+        VendorGuid,
+        VariableName
+        ));
+    }
+  }
+
   InterlockedDecrement (&mVariableModuleGlobal->VariableGlobal.ReentrantState);
   ReleaseLockOnlyAtBootTime (&mVariableModuleGlobal->VariableGlobal.VariableServicesLock);
 
@@ -3203,10 +3390,14 @@ ReclaimForOS (
   VOID
   )
 {
-  EFI_STATUS      Status;
-  UINTN           RemainingCommonRuntimeVariableSpace;
-  UINTN           RemainingHwErrVariableSpace;
-  STATIC BOOLEAN  Reclaimed;
+  EFI_STATUS             Status;
+  UINTN                  RemainingCommonRuntimeVariableSpace;
+  UINTN                  RemainingHwErrVariableSpace;
+  UINTN                  FreeVariableSpace;
+  UINTN                  UsedVariableSpace;
+  UINTN                  ReclaimableSpace;
+  VARIABLE_STORE_HEADER  *VariableStoreHeader;
+  STATIC BOOLEAN         Reclaimed;
 
   //
   // This function will be called only once at EndOfDxe or ReadyToBoot event.
@@ -3228,12 +3419,36 @@ ReclaimForOS (
   RemainingHwErrVariableSpace = PcdGet32 (PcdHwErrStorageSize) - mVariableModuleGlobal->HwErrVariableTotalSize;
 
   //
-  // Check if the free area is below a threshold.
+  // Space left at the end of the variable log, and space held by deleted variables.
+  //
+  VariableStoreHeader = (VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.NonVolatileVariableBase;
+  FreeVariableSpace   = VariableStoreHeader->Size - mVariableModuleGlobal->NonVolatileLastVariableOffset;
+  UsedVariableSpace   = (UINTN)GetStartPointer (VariableStoreHeader) - (UINTN)VariableStoreHeader +
+                        mVariableModuleGlobal->CommonVariableTotalSize + mVariableModuleGlobal->HwErrVariableTotalSize;
+  ReclaimableSpace    = 0;
+  if (mVariableModuleGlobal->NonVolatileLastVariableOffset > UsedVariableSpace) {
+    ReclaimableSpace = mVariableModuleGlobal->NonVolatileLastVariableOffset - UsedVariableSpace;
+  }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "Variable: %d NV reclaims wrote 0x%x bytes, worst case %ld us, worst case SetVariable() %ld us\n",
+    (UINT32)mVariableModuleGlobal->ReclaimCount,
+    (UINT32)mVariableModuleGlobal->ReclaimBytes,
+    DivU64x32 (mVariableModuleGlobal->MaxReclaimTime, 1000),
+    DivU64x32 (mVariableModuleGlobal->MaxSetVariableTime, 1000)
+    ));
+
+  //
+  // Check if the free area is below a threshold. Reclaiming now, before the OS
+  // runs, spares a SetVariable() at runtime the latency of the reclaim.
   //
   if (((RemainingCommonRuntimeVariableSpace < mVariableModuleGlobal->MaxVariableSize) ||
        (RemainingCommonRuntimeVariableSpace < mVariableModuleGlobal->MaxAuthVariableSize)) ||
       ((PcdGet32 (PcdHwErrStorageSize) != 0) &&
-       (RemainingHwErrVariableSpace < PcdGet32 (PcdMaxHardwareErrorVariableSize))))
+       (RemainingHwErrVariableSpace < PcdGet32 (PcdMaxHardwareErrorVariableSize))) ||
+      ((ReclaimableSpace != 0) &&
+       ((UINT64)FreeVariableSpace * 100 < (UINT64)VariableStoreHeader->Size * PcdGet32 (PcdVariableReclaimFreeSpaceThreshold))))
   {
     Status = Reclaim (
                mVariableModuleGlobal->VariableGlobal.NonVolatileVariableBase,
@@ -3398,6 +3613,7 @@ FlushHobVariableToFlash (
       }
 
       if (!AtRuntime ()) {
+        VariableStoreIndexDestroy (VariableStoreTypeHob);
         FreePool ((VOID *)VariableStoreHeader);
       }
     }
@@ -3796,6 +4012,20 @@ VariableCommonInitialize (
   VolatileVariableStore->Reserved  = 0;
   VolatileVariableStore->Reserved1 = 0;
 
+  //
+  // Index the variable stores by name and GUID. A store without an index is
+  // walked for each lookup, so failing to allocate one is not fatal.
+  //
+  VariableStoreIndexCreate (VariableStoreTypeVolatile, VolatileVariableStore, mVariableModuleGlobal->VariableGlobal.AuthFormat);
+  VariableStoreIndexCreate (VariableStoreTypeNv, mNvVariableCache, mVariableModuleGlobal->VariableGlobal.AuthFormat);
+  if (mVariableModuleGlobal->VariableGlobal.HobVariableBase != 0) {
+    VariableStoreIndexCreate (
+      VariableStoreTypeHob,
+      (VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.HobVariableBase,
+      mVariableModuleGlobal->VariableGlobal.AuthFormat
+      );
+  }
+
   return EFI_SUCCESS;
 }
 
@@ -33,6 +33,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/VarCheckLib.h>
 #include <Library/VariableFlashInfoLib.h>
 #include <Library/SafeIntLib.h>
+#include <Library/TimerLib.h>
 #include <Guid/GlobalVariable.h>
 #include <Guid/EventGroup.h>
 #include <Guid/VariableFormat.h>
@@ -61,10 +62,21 @@ typedef enum {
   VariableStoreTypeMax
 } VARIABLE_STORE_TYPE;
 
+///
+/// Maximum number of ranges of a runtime variable cache waiting to be updated.
+/// Beyond it, the closest ranges are merged.
+///
+#define VARIABLE_RUNTIME_CACHE_MAX_PENDING_UPDATES  8
+
 typedef struct {
-  UINT32                   PendingUpdateOffset;
-  UINT32                   PendingUpdateLength;
-  VARIABLE_STORE_HEADER    *Store;
+  UINT32    Offset;
+  UINT32    Length;
+} VARIABLE_RUNTIME_CACHE_UPDATE;
+
+typedef struct {
+  UINT32                           PendingUpdateCount;
+  VARIABLE_RUNTIME_CACHE_UPDATE    PendingUpdate[VARIABLE_RUNTIME_CACHE_MAX_PENDING_UPDATES];
+  VARIABLE_STORE_HEADER            *Store;
 } VARIABLE_RUNTIME_CACHE;
 
 typedef struct {
@@ -121,6 +133,13 @@ typedef struct {
   CHAR8                                 *PlatformLang;
   CHAR8                                 Lang[ISO_639_2_ENTRY_SIZE + 1];
   EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL    *FvbInstance;
+  //
+  // Reclaim statistics. The times are only measured when PcdVariableCollectStatistics is TRUE.
+  //
+  UINT64                                MaxSetVariableTime; // Worst case SetVariable(), in ns
+  UINT64                                MaxReclaimTime;     // Worst case NV variable reclaim, in ns
+  UINTN                                 ReclaimCount;       // NV variable reclaims
+  UINTN                                 ReclaimBytes;       // Bytes written by the NV variable reclaims
 } VARIABLE_MODULE_GLOBAL;
 
 /**
@@ -145,6 +164,8 @@ FlushHobVariableToFlash (
 
   @param  VariableBase   Base address of the variable to write.
   @param  VariableBuffer Point to the variable data buffer.
+  @param  Offset         Offset of the range of the variable store to write.
+  @param  Length         Length of the range of the variable store to write.
 
   @retval EFI_SUCCESS    The function completed successfully.
   @retval EFI_NOT_FOUND  Fail to locate Fault Tolerant Write protocol.
@@ -154,7 +175,22 @@ FlushHobVariableToFlash (
 EFI_STATUS
 FtwVariableSpace (
   IN EFI_PHYSICAL_ADDRESS   VariableBase,
-  IN VARIABLE_STORE_HEADER  *VariableBuffer
+  IN VARIABLE_STORE_HEADER  *VariableBuffer,
+  IN UINTN                  Offset,
+  IN UINTN                  Length
+  );
+
+/**
+  Return the time elapsed since a value of the performance counter.
+
+  @param[in]  StartTick         Value of the performance counter at the start.
+
+  @return The elapsed time in nanoseconds.
+
+**/
+UINT64
+GetVariableElapsedTime (
+  IN UINT64  StartTick
   );
 
 /**
@@ -9,6 +9,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "VariableParsing.h"
 
+VARIABLE_STORE_INDEX  *mVariableStoreIndex[VariableStoreTypeMax];
+
 /**
 
   This code checks if variable header is valid or not.
@@ -445,6 +447,338 @@ VariableCompareTimeStampInternal (
   return (BOOLEAN)(FirstTime->Second <= SecondTime->Second);
 }
 
+/**
+  Compute the hash of a variable name and GUID.
+
+  @param[in]  VariableName      Name of the variable.
+  @param[in]  NameLength        Maximum number of characters of VariableName to hash.
+  @param[in]  VendorGuid        Vendor GUID of the variable.
+
+  @return The hash.
+
+**/
+UINT32
+VariableIndexHash (
+  IN  CONST CHAR16    *VariableName,
+  IN  UINTN           NameLength,
+  IN  CONST EFI_GUID  *VendorGuid
+  )
+{
+  UINT32  Hash;
+  UINTN   Index;
+
+  //
+  // FNV-1a over the characters of the name and the words of the GUID.
+  //
+  Hash = 0x811C9DC5;
+  for (Index = 0; (Index < NameLength) && (VariableName[Index] != 0); Index++) {
+    Hash = (Hash ^ VariableName[Index]) * 0x01000193;
+  }
+
+  for (Index = 0; Index < sizeof (EFI_GUID) / sizeof (UINT32); Index++) {
+    Hash = (Hash ^ ReadUnaligned32 ((CONST UINT32 *)VendorGuid + Index)) * 0x01000193;
+  }
+
+  return Hash;
+}
+
+/**
+  Find the index of the variable store a variable pointer track searches.
+
+  @param[in]  StartPtr          Start of the variables of the store.
+
+  @return The index, or NULL if the store is not indexed or the index overflowed.
+
+**/
+VARIABLE_STORE_INDEX *
+VariableStoreIndexFind (
+  IN  VARIABLE_HEADER  *StartPtr
+  )
+{
+  VARIABLE_STORE_TYPE  StoreType;
+
+  for (StoreType = (VARIABLE_STORE_TYPE)0; StoreType < VariableStoreTypeMax; StoreType++) {
+    if ((mVariableStoreIndex[StoreType] != NULL) &&
+        (GetStartPointer (mVariableStoreIndex[StoreType]->Store) == StartPtr))
+    {
+      return mVariableStoreIndex[StoreType]->Overflow ? NULL : mVariableStoreIndex[StoreType];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Index the variables appended to a variable store since the last lookup.
+
+  Variables are indexed whatever their state, as the state of a variable being
+  added only becomes VAR_ADDED after its header is written. Lookups check the
+  state of the variables they find.
+
+  @param[in, out]  StoreIndex   The index of the variable store.
+
+**/
+VOID
+VariableStoreIndexSync (
+  IN OUT VARIABLE_STORE_INDEX  *StoreIndex
+  )
+{
+  VARIABLE_HEADER       *Variable;
+  VARIABLE_HEADER       *EndPtr;
+  VARIABLE_INDEX_ENTRY  *Entry;
+  UINT32                *Bucket;
+  UINT32                EntryIndex;
+  UINT32                Hash;
+
+  Bucket   = VARIABLE_INDEX_BUCKETS (StoreIndex);
+  Entry    = VARIABLE_INDEX_ENTRIES (StoreIndex);
+  EndPtr   = GetEndPointer (StoreIndex->Store);
+  Variable = (VARIABLE_HEADER *)((UINTN)StoreIndex->Store + StoreIndex->IndexedOffset);
+
+  while (IsValidVariableHeader (Variable, EndPtr)) {
+    if (StoreIndex->FreeEntry != VARIABLE_INDEX_END) {
+      EntryIndex            = StoreIndex->FreeEntry;
+      StoreIndex->FreeEntry = Entry[EntryIndex].Next;
+    } else if (StoreIndex->UsedCount < StoreIndex->EntryCount) {
+      EntryIndex = StoreIndex->UsedCount++;
+    } else {
+      //
+      // Cannot happen with an entry per minimum sized variable, but do not
+      // return wrong answers if it does.
+      //
+      DEBUG ((DEBUG_ERROR, "Variable store index of %p is full, lookups walk the store\n", StoreIndex->Store));
+      StoreIndex->Overflow = TRUE;
+      return;
+    }
+
+    Hash = VariableIndexHash (
+             GetVariableNamePtr (Variable, StoreIndex->AuthFormat),
+             NameSizeOfVariable (Variable, StoreIndex->AuthFormat) / sizeof (CHAR16),
+             GetVendorGuidPtr (Variable, StoreIndex->AuthFormat)
+             );
+    Entry[EntryIndex].Offset = (UINT32)((UINTN)Variable - (UINTN)StoreIndex->Store);
+    Entry[EntryIndex].Hash   = Hash;
+    Entry[EntryIndex].Next   = Bucket[Hash & (StoreIndex->BucketCount - 1)];
+
+    Bucket[Hash & (StoreIndex->BucketCount - 1)] = EntryIndex;
+
+    Variable                  = GetNextVariablePtr (Variable, StoreIndex->AuthFormat);
+    StoreIndex->IndexedOffset = (UINT32)((UINTN)Variable - (UINTN)StoreIndex->Store);
+  }
+}
+
+/**
+  Find a variable through the index of its variable store, with the same
+  result as walking the store in FindVariableEx().
+
+  @param[in]       StoreIndex    The index of the variable store.
+  @param[in]       VariableName  Name of the variable to be found, not empty.
+  @param[in]       VendorGuid    Vendor GUID to be found.
+  @param[in]       IgnoreRtCheck Ignore EFI_VARIABLE_RUNTIME_ACCESS attribute
+                                 check at runtime when searching variable.
+  @param[in, out]  PtrTrack      Variable Track Pointer structure that contains Variable Information.
+
+  @retval          EFI_SUCCESS   Variable found successfully
+  @retval          EFI_NOT_FOUND Variable not found
+**/
+EFI_STATUS
+FindVariableInIndex (
+  IN OUT VARIABLE_STORE_INDEX    *StoreIndex,
+  IN     CHAR16                  *VariableName,
+  IN     EFI_GUID                *VendorGuid,
+  IN     BOOLEAN                 IgnoreRtCheck,
+  IN OUT VARIABLE_POINTER_TRACK  *PtrTrack
+  )
+{
+  VARIABLE_INDEX_ENTRY  *Entry;
+  UINT32                *Link;
+  UINT32                EntryIndex;
+  UINT32                Hash;
+  VARIABLE_HEADER       *Variable;
+  VARIABLE_HEADER       *AddedVariable;
+  VARIABLE_HEADER       *InDeletedVariable;
+  BOOLEAN               AuthFormat;
+  UINTN                 Pass;
+
+  VariableStoreIndexSync (StoreIndex);
+  if (StoreIndex->Overflow) {
+    return EFI_UNSUPPORTED;
+  }
+
+  AuthFormat        = StoreIndex->AuthFormat;
+  Entry             = VARIABLE_INDEX_ENTRIES (StoreIndex);
+  Hash              = VariableIndexHash (VariableName, MAX_UINTN, VendorGuid);
+  AddedVariable     = NULL;
+  InDeletedVariable = NULL;
+
+  //
+  // The walk of the store returns the first ADDED variable, and the last
+  // IN_DELETED_TRANSITION one before it. The first pass finds the former, the
+  // second pass the latter.
+  //
+  for (Pass = 0; Pass < 2; Pass++) {
+    Link = &VARIABLE_INDEX_BUCKETS (StoreIndex)[Hash & (StoreIndex->BucketCount - 1)];
+    while (*Link != VARIABLE_INDEX_END) {
+      EntryIndex = *Link;
+      Variable   = (VARIABLE_HEADER *)((UINTN)StoreIndex->Store + Entry[EntryIndex].Offset);
+      if ((Variable->State & (UINT8)(~VAR_DELETED)) == 0) {
+        //
+        // Drop the entries of deleted variables, they never come back.
+        //
+        *Link                 = Entry[EntryIndex].Next;
+        Entry[EntryIndex].Next = StoreIndex->FreeEntry;
+        StoreIndex->FreeEntry  = EntryIndex;
+        continue;
+      }
+
+      Link = &Entry[EntryIndex].Next;
+      if ((Entry[EntryIndex].Hash != Hash) ||
+          ((Variable->State != VAR_ADDED) && (Variable->State != (VAR_IN_DELETED_TRANSITION & VAR_ADDED))))
+      {
+        continue;
+      }
+
+      if (!IgnoreRtCheck && AtRuntime () && ((Variable->Attributes & EFI_VARIABLE_RUNTIME_ACCESS) == 0)) {
+        continue;
+      }
+
+      if (!CompareGuid (VendorGuid, GetVendorGuidPtr (Variable, AuthFormat))) {
+        continue;
+      }
+
+      ASSERT (NameSizeOfVariable (Variable, AuthFormat) != 0);
+      if (CompareMem (VariableName, GetVariableNamePtr (Variable, AuthFormat), NameSizeOfVariable (Variable, AuthFormat)) != 0) {
+        continue;
+      }
+
+      if (Pass == 0) {
+        if ((Variable->State == VAR_ADDED) && ((AddedVariable == NULL) || (Variable < AddedVariable))) {
+          AddedVariable = Variable;
+        }
+      } else if ((Variable->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) &&
+                 ((AddedVariable == NULL) || (Variable < AddedVariable)) &&
+                 ((InDeletedVariable == NULL) || (Variable > InDeletedVariable)))
+      {
+        InDeletedVariable = Variable;
+      }
+    }
+  }
+
+  if (AddedVariable != NULL) {
+    PtrTrack->CurrPtr                = AddedVariable;
+    PtrTrack->InDeletedTransitionPtr = InDeletedVariable;
+    return EFI_SUCCESS;
+  }
+
+  PtrTrack->CurrPtr                = InDeletedVariable;
+  PtrTrack->InDeletedTransitionPtr = NULL;
+  return (PtrTrack->CurrPtr == NULL) ? EFI_NOT_FOUND : EFI_SUCCESS;
+}
+
+/**
+  Create the name and GUID hash index of a variable store. FindVariableEx()
+  uses it for every lookup in the store from then on.
+
+  @param[in]  StoreType         The type of the variable store.
+  @param[in]  Store             The variable store to index.
+  @param[in]  AuthFormat        TRUE indicates authenticated variables are used.
+                                FALSE indicates authenticated variables are not used.
+
+  @retval EFI_SUCCESS           The index is created.
+  @retval EFI_OUT_OF_RESOURCES  The index could not be allocated, the store is
+                                walked for each lookup.
+
+**/
+EFI_STATUS
+VariableStoreIndexCreate (
+  IN  VARIABLE_STORE_TYPE    StoreType,
+  IN  VARIABLE_STORE_HEADER  *Store,
+  IN  BOOLEAN                AuthFormat
+  )
+{
+  VARIABLE_STORE_INDEX  *StoreIndex;
+  UINTN                 EntryCount;
+  UINTN                 BucketCount;
+
+  ASSERT (StoreType < VariableStoreTypeMax);
+  VariableStoreIndexDestroy (StoreType);
+
+  //
+  // One entry per variable of the smallest size the store can hold, so the
+  // index cannot run out of entries before the store runs out of space.
+  //
+  EntryCount  = Store->Size / HEADER_ALIGN (GetVariableHeaderSize (AuthFormat) + sizeof (CHAR16)) + 1;
+  BucketCount = MAX (GetPowerOfTwo32 ((UINT32)(EntryCount / 4)), VARIABLE_INDEX_MIN_BUCKET_COUNT);
+
+  //
+  // The index is used at runtime, after ExitBootServices ().
+  //
+  StoreIndex = AllocateRuntimePool (
+                 sizeof (VARIABLE_STORE_INDEX) +
+                 BucketCount * sizeof (UINT32) +
+                 EntryCount * sizeof (VARIABLE_INDEX_ENTRY)
+                 );
+  if (StoreIndex == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  StoreIndex->Store       = Store;
+  StoreIndex->BucketCount = (UINT32)BucketCount;
+  StoreIndex->EntryCount  = (UINT32)EntryCount;
+  StoreIndex->AuthFormat  = AuthFormat;
+
+  mVariableStoreIndex[StoreType] = StoreIndex;
+  VariableStoreIndexInvalidate (Store);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Free the index of a variable store before the store itself is freed.
+
+  @param[in]  StoreType         The type of the variable store.
+
+**/
+VOID
+VariableStoreIndexDestroy (
+  IN  VARIABLE_STORE_TYPE  StoreType
+  )
+{
+  if (mVariableStoreIndex[StoreType] != NULL) {
+    FreePool (mVariableStoreIndex[StoreType]);
+    mVariableStoreIndex[StoreType] = NULL;
+  }
+}
+
+/**
+  Empty the index of a variable store whose variables have been moved, as a
+  reclaim does. It is rebuilt by the next lookup in the store.
+
+  @param[in]  Store             The variable store.
+
+**/
+VOID
+VariableStoreIndexInvalidate (
+  IN  VARIABLE_STORE_HEADER  *Store
+  )
+{
+  VARIABLE_STORE_TYPE   StoreType;
+  VARIABLE_STORE_INDEX  *StoreIndex;
+
+  for (StoreType = (VARIABLE_STORE_TYPE)0; StoreType < VariableStoreTypeMax; StoreType++) {
+    StoreIndex = mVariableStoreIndex[StoreType];
+    if ((StoreIndex == NULL) || (StoreIndex->Store != Store)) {
+      continue;
+    }
+
+    SetMem32 (VARIABLE_INDEX_BUCKETS (StoreIndex), StoreIndex->BucketCount * sizeof (UINT32), VARIABLE_INDEX_END);
+    StoreIndex->UsedCount     = 0;
+    StoreIndex->FreeEntry     = VARIABLE_INDEX_END;
+    StoreIndex->IndexedOffset = (UINT32)((UINTN)GetStartPointer (Store) - (UINTN)Store);
+    StoreIndex->Overflow      = FALSE;
+  }
+}
+
 /**
   Find the variable in the specified variable store.
 
@@ -468,11 +802,28 @@ FindVariableEx (
   IN     BOOLEAN                 AuthFormat
   )
 {
-  VARIABLE_HEADER  *InDeletedVariable;
-  VOID             *Point;
+  EFI_STATUS            Status;
+  VARIABLE_HEADER       *InDeletedVariable;
+  VOID                  *Point;
+  VARIABLE_STORE_INDEX  *StoreIndex;
 
   PtrTrack->InDeletedTransitionPtr = NULL;
 
+  //
+  // Look a named variable up in the index of the store if it has one.
+  //
+  if (VariableName[0] != 0) {
+    StoreIndex = VariableStoreIndexFind (PtrTrack->StartPtr);
+    if ((StoreIndex != NULL) && (StoreIndex->AuthFormat == AuthFormat) &&
+        (PtrTrack->EndPtr == GetEndPointer (StoreIndex->Store)))
+    {
+      Status = FindVariableInIndex (StoreIndex, VariableName, VendorGuid, IgnoreRtCheck, PtrTrack);
+      if (Status != EFI_UNSUPPORTED) {
+        return Status;
+      }
+    }
+  }
+
   //
   // Find the variable by walk through HOB, volatile and non-volatile variable store.
   //
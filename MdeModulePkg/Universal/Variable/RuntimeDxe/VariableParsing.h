@@ -13,6 +13,52 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Guid/ImageAuthentication.h>
 #include "Variable.h"
 
+///
+/// Terminator of the bucket chains and of the free list of a variable store index.
+///
+#define VARIABLE_INDEX_END  MAX_UINT32
+
+///
+/// Minimum number of buckets of a variable store index.
+///
+#define VARIABLE_INDEX_MIN_BUCKET_COUNT  64
+
+typedef struct {
+  UINT32    Next;                       // Next entry in the bucket chain or in the free list
+  UINT32    Offset;                     // Offset of the variable header from the variable store header
+  UINT32    Hash;                       // Hash of the name and GUID of the variable
+} VARIABLE_INDEX_ENTRY;
+
+///
+/// Name and GUID hash index of the variables of a variable store.
+///
+/// The index only holds offsets, so it stays valid after SetVirtualAddressMap()
+/// once Store has been converted. Variables appended to the store are indexed by
+/// the next lookup, from IndexedOffset on. Entries of deleted variables are
+/// dropped by the lookups that walk past them. A reclaim rewrites the store and
+/// must call VariableStoreIndexInvalidate() so that the index is rebuilt.
+///
+typedef struct {
+  VARIABLE_STORE_HEADER    *Store;
+  UINT32                   BucketCount;   // Power of two
+  UINT32                   EntryCount;    // Entries allocated
+  UINT32                   UsedCount;     // Entries handed out, free list excluded
+  UINT32                   FreeEntry;     // Head of the free list
+  UINT32                   IndexedOffset; // Offset of the first variable not indexed yet
+  BOOLEAN                  AuthFormat;
+  BOOLEAN                  Overflow;      // Out of entries, lookups walk the store
+  // UINT32                Bucket[BucketCount];
+  // VARIABLE_INDEX_ENTRY  Entry[EntryCount];
+} VARIABLE_STORE_INDEX;
+
+#define VARIABLE_INDEX_BUCKETS(Index)  ((UINT32 *)((VARIABLE_STORE_INDEX *)(Index) + 1))
+#define VARIABLE_INDEX_ENTRIES(Index)  ((VARIABLE_INDEX_ENTRY *)(VARIABLE_INDEX_BUCKETS (Index) + (Index)->BucketCount))
+
+///
+/// Indexes of the variable stores of the variable driver, by VARIABLE_STORE_TYPE.
+///
+extern VARIABLE_STORE_INDEX  *mVariableStoreIndex[VariableStoreTypeMax];
+
 /**
 
   This code checks if variable header is valid or not.
@@ -311,6 +357,50 @@ VariableServiceGetNextVariableInternal (
   IN  BOOLEAN                AuthFormat
   );
 
+/**
+  Create the name and GUID hash index of a variable store. FindVariableEx()
+  uses it for every lookup in the store from then on.
+
+  @param[in]  StoreType         The type of the variable store.
+  @param[in]  Store             The variable store to index.
+  @param[in]  AuthFormat        TRUE indicates authenticated variables are used.
+                                FALSE indicates authenticated variables are not used.
+
+  @retval EFI_SUCCESS           The index is created.
+  @retval EFI_OUT_OF_RESOURCES  The index could not be allocated, the store is
+                                walked for each lookup.
+
+**/
+EFI_STATUS
+VariableStoreIndexCreate (
+  IN  VARIABLE_STORE_TYPE    StoreType,
+  IN  VARIABLE_STORE_HEADER  *Store,
+  IN  BOOLEAN                AuthFormat
+  );
+
+/**
+  Free the index of a variable store before the store itself is freed.
+
+  @param[in]  StoreType         The type of the variable store.
+
+**/
+VOID
+VariableStoreIndexDestroy (
+  IN  VARIABLE_STORE_TYPE  StoreType
+  );
+
+/**
+  Empty the index of a variable store whose variables have been moved, as a
+  reclaim does. It is rebuilt by the next lookup in the store.
+
+  @param[in]  Store             The variable store.
+
+**/
+VOID
+VariableStoreIndexInvalidate (
+  IN  VARIABLE_STORE_HEADER  *Store
+  );
+
 /**
   Routine used to track statistical information about variable usage.
   The data is stored in the EFI system table so it can be accessed later.
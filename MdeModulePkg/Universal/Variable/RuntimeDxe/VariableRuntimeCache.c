@@ -18,6 +18,106 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 extern VARIABLE_MODULE_GLOBAL  *mVariableModuleGlobal;
 extern VARIABLE_STORE_HEADER   *mNvVariableCache;
 
+/**
+  Copies the pending updates of a runtime variable cache from its variable store.
+
+  @param[in, out] VariableRuntimeCache Variable runtime cache structure for the runtime cache being updated.
+  @param[in]      Store                Variable store that the runtime cache mirrors.
+
+**/
+VOID
+FlushRuntimeVariableCacheUpdates (
+  IN OUT VARIABLE_RUNTIME_CACHE  *VariableRuntimeCache,
+  IN     VARIABLE_STORE_HEADER   *Store
+  )
+{
+  UINT32  Index;
+
+  for (Index = 0; Index < VariableRuntimeCache->PendingUpdateCount; Index++) {
+    CopyMem (
+      (UINT8 *)VariableRuntimeCache->Store + VariableRuntimeCache->PendingUpdate[Index].Offset,
+      (UINT8 *)Store + VariableRuntimeCache->PendingUpdate[Index].Offset,
+      VariableRuntimeCache->PendingUpdate[Index].Length
+      );
+  }
+
+  VariableRuntimeCache->PendingUpdateCount = 0;
+}
+
+/**
+  Adds a range to the pending updates of a runtime variable cache.
+
+  Ranges that overlap or touch are merged. When all the entries are in use, the
+  two closest ranges are merged, so the updates copied may cover some bytes
+  that did not change.
+
+  @param[in, out] VariableRuntimeCache Variable runtime cache structure for the runtime cache being updated.
+  @param[in]      Offset               Offset in bytes of the update.
+  @param[in]      Length               Length of data in bytes of the update.
+
+**/
+VOID
+AddRuntimeVariableCacheUpdate (
+  IN OUT VARIABLE_RUNTIME_CACHE  *VariableRuntimeCache,
+  IN     UINTN                   Offset,
+  IN     UINTN                   Length
+  )
+{
+  VARIABLE_RUNTIME_CACHE_UPDATE  *Update;
+  UINTN                          End;
+  UINTN                          Index;
+  UINTN                          Merge;
+  UINTN                          Gap;
+  UINTN                          MinGap;
+
+  Update = VariableRuntimeCache->PendingUpdate;
+  End    = Offset + Length;
+
+  //
+  // Absorb the pending updates that overlap or touch the new one.
+  //
+  Index = 0;
+  while (Index < VariableRuntimeCache->PendingUpdateCount) {
+    if ((Update[Index].Offset <= End) && (Offset <= (UINTN)Update[Index].Offset + Update[Index].Length)) {
+      End    = MAX (End, (UINTN)Update[Index].Offset + Update[Index].Length);
+      Offset = MIN (Offset, (UINTN)Update[Index].Offset);
+      VariableRuntimeCache->PendingUpdateCount--;
+      Update[Index] = Update[VariableRuntimeCache->PendingUpdateCount];
+    } else {
+      Index++;
+    }
+  }
+
+  if (VariableRuntimeCache->PendingUpdateCount == VARIABLE_RUNTIME_CACHE_MAX_PENDING_UPDATES) {
+    //
+    // Merge the new update with the pending update closest to it.
+    //
+    Merge  = 0;
+    MinGap = MAX_UINTN;
+    for (Index = 0; Index < VariableRuntimeCache->PendingUpdateCount; Index++) {
+      if (Update[Index].Offset > End) {
+        Gap = Update[Index].Offset - End;
+      } else {
+        Gap = Offset - ((UINTN)Update[Index].Offset + Update[Index].Length);
+      }
+
+      if (Gap < MinGap) {
+        MinGap = Gap;
+        Merge  = Index;
+      }
+    }
+
+    End    = MAX (End, (UINTN)Update[Merge].Offset + Update[Merge].Length);
+    Offset = MIN (Offset, (UINTN)Update[Merge].Offset);
+    VariableRuntimeCache->PendingUpdateCount--;
+    Update[Merge] = Update[VariableRuntimeCache->PendingUpdateCount];
+  }
+
+  Update[VariableRuntimeCache->PendingUpdateCount].Offset = (UINT32)Offset;
+  Update[VariableRuntimeCache->PendingUpdateCount].Length = (UINT32)(End - Offset);
+  VariableRuntimeCache->PendingUpdateCount++;
+}
+
 /**
   Copies any pending updates to runtime variable caches.
 
@@ -45,49 +145,21 @@ FlushPendingRuntimeVariableCacheUpdates (
     if ((VariableRuntimeCacheContext->VariableRuntimeHobCache.Store != NULL) &&
         (mVariableModuleGlobal->VariableGlobal.HobVariableBase > 0))
     {
-      CopyMem (
-        (VOID *)(
-                 ((UINT8 *)(UINTN)VariableRuntimeCacheContext->VariableRuntimeHobCache.Store) +
-                 VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateOffset
-                 ),
-        (VOID *)(
-                 ((UINT8 *)(UINTN)mVariableModuleGlobal->VariableGlobal.HobVariableBase) +
-                 VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateOffset
-                 ),
-        VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateLength
+      FlushRuntimeVariableCacheUpdates (
+        &VariableRuntimeCacheContext->VariableRuntimeHobCache,
+        (VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.HobVariableBase
         );
-      VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateLength = 0;
-      VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateOffset = 0;
     }
 
-    CopyMem (
-      (VOID *)(
-               ((UINT8 *)(UINTN)VariableRuntimeCacheContext->VariableRuntimeNvCache.Store) +
-               VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateOffset
-               ),
-      (VOID *)(
-               ((UINT8 *)(UINTN)mNvVariableCache) +
-               VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateOffset
-               ),
-      VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateLength
+    FlushRuntimeVariableCacheUpdates (
+      &VariableRuntimeCacheContext->VariableRuntimeNvCache,
+      mNvVariableCache
       );
-    VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateLength = 0;
-    VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateOffset = 0;
-
-    CopyMem (
-      (VOID *)(
-               ((UINT8 *)(UINTN)VariableRuntimeCacheContext->VariableRuntimeVolatileCache.Store) +
-               VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateOffset
-               ),
-      (VOID *)(
-               ((UINT8 *)(UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase) +
-               VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateOffset
-               ),
-      VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateLength
+    FlushRuntimeVariableCacheUpdates (
+      &VariableRuntimeCacheContext->VariableRuntimeVolatileCache,
+      (VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase
       );
-    VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateLength = 0;
-    VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateOffset = 0;
-    *(VariableRuntimeCacheContext->PendingUpdate)                                 = FALSE;
+    *(VariableRuntimeCacheContext->PendingUpdate) = FALSE;
   }
 
   return EFI_SUCCESS;
@@ -101,6 +173,9 @@ FlushPendingRuntimeVariableCacheUpdates (
   update is added as a pending update for the given variable store and it will be flushed to the runtime cache
   at the next opportunity the ReadLock is available.
 
+  Only the ranges given are copied, so callers should pass the records they changed rather than the
+  whole store.
+
   @param[in] VariableRuntimeCache Variable runtime cache structure for the runtime cache being synchronized.
   @param[in] Offset               Offset in bytes to apply the update.
   @param[in] Length               Length of data in bytes of the update.
@@ -131,21 +206,12 @@ SynchronizeRuntimeVariableCache (
     return EFI_UNSUPPORTED;
   }
 
-  if (*(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.PendingUpdate) &&
-      (VariableRuntimeCache->PendingUpdateLength > 0))
-  {
-    VariableRuntimeCache->PendingUpdateLength =
-      (UINT32)(
-               MAX (
-                 (UINTN)(VariableRuntimeCache->PendingUpdateOffset + VariableRuntimeCache->PendingUpdateLength),
-                 Offset + Length
-                 ) - MIN ((UINTN)VariableRuntimeCache->PendingUpdateOffset, Offset)
-               );
-    VariableRuntimeCache->PendingUpdateOffset =
-      (UINT32)MIN ((UINTN)VariableRuntimeCache->PendingUpdateOffset, Offset);
-  } else {
-    VariableRuntimeCache->PendingUpdateLength = (UINT32)Length;
-    VariableRuntimeCache->PendingUpdateOffset = (UINT32)Offset;
+  if (!*(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.PendingUpdate)) {
+    VariableRuntimeCache->PendingUpdateCount = 0;
+  }
+
+  if (Length > 0) {
+    AddRuntimeVariableCacheUpdate (VariableRuntimeCache, Offset, Length);
   }
 
   *(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.PendingUpdate) = TRUE;
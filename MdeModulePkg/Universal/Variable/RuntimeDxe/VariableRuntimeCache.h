@@ -32,6 +32,9 @@ FlushPendingRuntimeVariableCacheUpdates (
   update is added as a pending update for the given variable store and it will be flushed to the runtime cache
   at the next opportunity the ReadLock is available.
 
+  Only the ranges given are copied, so callers should pass the records they changed rather than the
+  whole store.
+
   @param[in] VariableRuntimeCache Variable runtime cache structure for the runtime cache being synchronized.
   @param[in] Offset               Offset in bytes to apply the update.
   @param[in] Length               Length of data in bytes of the update.
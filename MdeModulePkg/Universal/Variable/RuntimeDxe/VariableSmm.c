@@ -424,6 +424,108 @@ SmmVariableGetStatistics (
   return EFI_SUCCESS;
 }
 
+/**
+  Process the GetVariable and SetVariable requests of a batch in order.
+
+  Caution: This function may receive untrusted input.
+  The batch is external input, so the whole batch is validated before any entry is
+  processed. The per entry result is returned in the ReturnStatus of the entry.
+
+  @param[in, out] Batch          The batch copied from the communicate buffer into SMRAM.
+  @param[in]      BatchSize      The size of Batch in bytes.
+
+  @retval EFI_SUCCESS            All entries were processed.
+  @retval EFI_ACCESS_DENIED      An entry exceeds the batch, no entry was processed.
+
+**/
+EFI_STATUS
+SmmVariableBatchAccess (
+  IN OUT SMM_VARIABLE_COMMUNICATE_BATCH_ACCESS_VARIABLE  *Batch,
+  IN     UINTN                                           BatchSize
+  )
+{
+  SMM_VARIABLE_COMMUNICATE_BATCH_ENTRY  *Entry;
+  UINTN                                 Index;
+  UINTN                                 Offset;
+  UINTN                                 EntrySize;
+
+  Offset = OFFSET_OF (SMM_VARIABLE_COMMUNICATE_BATCH_ACCESS_VARIABLE, Entry);
+  for (Index = 0; Index < Batch->Count; Index++) {
+    if (BatchSize - Offset < SMM_VARIABLE_BATCH_ENTRY_HEADER_SIZE) {
+      return EFI_ACCESS_DENIED;
+    }
+
+    Entry     = (SMM_VARIABLE_COMMUNICATE_BATCH_ENTRY *)((UINT8 *)Batch + Offset);
+    EntrySize = Entry->EntrySize;
+    if ((EntrySize < SMM_VARIABLE_BATCH_ENTRY_HEADER_SIZE) ||
+        (EntrySize > BatchSize - Offset) ||
+        ((EntrySize & (sizeof (UINTN) - 1)) != 0))
+    {
+      return EFI_ACCESS_DENIED;
+    }
+
+    //
+    // Entry->EntrySize >= SMM_VARIABLE_BATCH_ENTRY_HEADER_SIZE + NameSize + DataSize
+    // without any overflow.
+    //
+    if ((Entry->Access.NameSize > EntrySize - SMM_VARIABLE_BATCH_ENTRY_HEADER_SIZE) ||
+        (Entry->Access.DataSize > EntrySize - SMM_VARIABLE_BATCH_ENTRY_HEADER_SIZE - Entry->Access.NameSize))
+    {
+      return EFI_ACCESS_DENIED;
+    }
+
+    Offset += EntrySize;
+  }
+
+  //
+  // The VariableSpeculationBarrier() call here is to ensure the previous
+  // range/content checks for the batch have been completed before the
+  // subsequent consumption of the batch content.
+  //
+  VariableSpeculationBarrier ();
+
+  Offset = OFFSET_OF (SMM_VARIABLE_COMMUNICATE_BATCH_ACCESS_VARIABLE, Entry);
+  for (Index = 0; Index < Batch->Count; Index++) {
+    Entry   = (SMM_VARIABLE_COMMUNICATE_BATCH_ENTRY *)((UINT8 *)Batch + Offset);
+    Offset += Entry->EntrySize;
+
+    if ((Entry->Access.NameSize < sizeof (CHAR16)) || (Entry->Access.Name[Entry->Access.NameSize/sizeof (CHAR16) - 1] != L'\0')) {
+      //
+      // Make sure VariableName is A Null-terminated string.
+      //
+      Entry->ReturnStatus = EFI_ACCESS_DENIED;
+      continue;
+    }
+
+    switch (Entry->Function) {
+      case SMM_VARIABLE_FUNCTION_GET_VARIABLE:
+        Entry->ReturnStatus = VariableServiceGetVariable (
+                                Entry->Access.Name,
+                                &Entry->Access.Guid,
+                                &Entry->Access.Attributes,
+                                &Entry->Access.DataSize,
+                                (UINT8 *)Entry->Access.Name + Entry->Access.NameSize
+                                );
+        break;
+
+      case SMM_VARIABLE_FUNCTION_SET_VARIABLE:
+        Entry->ReturnStatus = VariableServiceSetVariable (
+                                Entry->Access.Name,
+                                &Entry->Access.Guid,
+                                Entry->Access.Attributes,
+                                Entry->Access.DataSize,
+                                (UINT8 *)Entry->Access.Name + Entry->Access.NameSize
+                                );
+        break;
+
+      default:
+        Entry->ReturnStatus = EFI_UNSUPPORTED;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
   Communication service SMI Handler entry.
 
@@ -561,6 +663,28 @@ SmmVariableHandler (
       CopyMem (SmmVariableFunctionHeader->Data, mVariableBufferPayload, CommBufferPayloadSize);
       break;
 
+    case SMM_VARIABLE_FUNCTION_BATCH_ACCESS_VARIABLE:
+      if (CommBufferPayloadSize < OFFSET_OF (SMM_VARIABLE_COMMUNICATE_BATCH_ACCESS_VARIABLE, Entry)) {
+        DEBUG ((DEBUG_ERROR, "BatchAccessVariable: SMM communication buffer size invalid!\n"));
+        return EFI_SUCCESS;
+      }
+
+      //
+      // Copy the input communicate buffer payload to pre-allocated SMM variable buffer payload.
+      //
+      CopyMem (mVariableBufferPayload, SmmVariableFunctionHeader->Data, CommBufferPayloadSize);
+      Status = SmmVariableBatchAccess (
+                 (SMM_VARIABLE_COMMUNICATE_BATCH_ACCESS_VARIABLE *)mVariableBufferPayload,
+                 CommBufferPayloadSize
+                 );
+      if (EFI_ERROR (Status)) {
+        DEBUG ((DEBUG_ERROR, "BatchAccessVariable: Entry size exceed communication buffer size limit!\n"));
+        goto EXIT;
+      }
+
+      CopyMem (SmmVariableFunctionHeader->Data, mVariableBufferPayload, CommBufferPayloadSize);
+      break;
+
     case SMM_VARIABLE_FUNCTION_GET_NEXT_VARIABLE_NAME:
       if (CommBufferPayloadSize < OFFSET_OF (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME, Name)) {
         DEBUG ((DEBUG_ERROR, "GetNextVariableName: SMM communication buffer size invalid!\n"));
@@ -933,24 +1057,27 @@ SmmVariableHandler (
       VariableCacheContext->HobFlushComplete                   = RuntimeVariableCacheContext->HobFlushComplete;
 
       // Set up the intial pending request since the RT cache needs to be in sync with SMM cache
-      VariableCacheContext->VariableRuntimeHobCache.PendingUpdateOffset = 0;
-      VariableCacheContext->VariableRuntimeHobCache.PendingUpdateLength = 0;
+      VariableCacheContext->VariableRuntimeHobCache.PendingUpdateCount = 0;
       if ((mVariableModuleGlobal->VariableGlobal.HobVariableBase > 0) &&
           (VariableCacheContext->VariableRuntimeHobCache.Store != NULL))
       {
-        VariableCache                                                     = (VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.HobVariableBase;
-        VariableCacheContext->VariableRuntimeHobCache.PendingUpdateLength = (UINT32)((UINTN)GetEndPointer (VariableCache) - (UINTN)VariableCache);
+        VariableCache                                                         = (VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.HobVariableBase;
+        VariableCacheContext->VariableRuntimeHobCache.PendingUpdateCount      = 1;
+        VariableCacheContext->VariableRuntimeHobCache.PendingUpdate[0].Offset = 0;
+        VariableCacheContext->VariableRuntimeHobCache.PendingUpdate[0].Length = (UINT32)((UINTN)GetEndPointer (VariableCache) - (UINTN)VariableCache);
         CopyGuid (&(VariableCacheContext->VariableRuntimeHobCache.Store->Signature), &(VariableCache->Signature));
       }
 
-      VariableCache                                                          = (VARIABLE_STORE_HEADER  *)(UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase;
-      VariableCacheContext->VariableRuntimeVolatileCache.PendingUpdateOffset = 0;
-      VariableCacheContext->VariableRuntimeVolatileCache.PendingUpdateLength = (UINT32)((UINTN)GetEndPointer (VariableCache) - (UINTN)VariableCache);
+      VariableCache                                                              = (VARIABLE_STORE_HEADER  *)(UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase;
+      VariableCacheContext->VariableRuntimeVolatileCache.PendingUpdateCount      = 1;
+      VariableCacheContext->VariableRuntimeVolatileCache.PendingUpdate[0].Offset = 0;
+      VariableCacheContext->VariableRuntimeVolatileCache.PendingUpdate[0].Length = (UINT32)((UINTN)GetEndPointer (VariableCache) - (UINTN)VariableCache);
       CopyGuid (&(VariableCacheContext->VariableRuntimeVolatileCache.Store->Signature), &(VariableCache->Signature));
 
-      VariableCache                                                    = (VARIABLE_STORE_HEADER  *)(UINTN)mNvVariableCache;
-      VariableCacheContext->VariableRuntimeNvCache.PendingUpdateOffset = 0;
-      VariableCacheContext->VariableRuntimeNvCache.PendingUpdateLength = (UINT32)((UINTN)GetEndPointer (VariableCache) - (UINTN)VariableCache);
+      VariableCache                                                        = (VARIABLE_STORE_HEADER  *)(UINTN)mNvVariableCache;
+      VariableCacheContext->VariableRuntimeNvCache.PendingUpdateCount      = 1;
+      VariableCacheContext->VariableRuntimeNvCache.PendingUpdate[0].Offset = 0;
+      VariableCacheContext->VariableRuntimeNvCache.PendingUpdate[0].Length = (UINT32)((UINTN)GetEndPointer (VariableCache) - (UINTN)VariableCache);
       CopyGuid (&(VariableCacheContext->VariableRuntimeNvCache.Store->Signature), &(VariableCache->Signature));
 
       *(VariableCacheContext->PendingUpdate)    = TRUE;
@@ -25,6 +25,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Protocol/SmmVariable.h>
 #include <Protocol/VariableLock.h>
 #include <Protocol/VarCheck.h>
+#include <Protocol/VariableBatch.h>
 
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
@@ -57,6 +58,7 @@ BOOLEAN                         mVariableAuthFormat;
 EFI_LOCK                        mVariableServicesLock;
 EDKII_VARIABLE_LOCK_PROTOCOL    mVariableLock;
 EDKII_VAR_CHECK_PROTOCOL        mVarCheck;
+EDKII_VARIABLE_BATCH_PROTOCOL   mVariableBatch;
 VARIABLE_RUNTIME_CACHE_INFO     mVariableRtCacheInfo;
 BOOLEAN                         mIsRuntimeCacheEnabled = FALSE;
 
@@ -1072,6 +1074,72 @@ RuntimeServiceGetNextVariableName (
   return Status;
 }
 
+/**
+  Sets a variable through a single SMM_VARIABLE_FUNCTION_SET_VARIABLE request.
+
+  The caller must hold mVariableServicesLock.
+
+  @param[in] VariableName       Name of Variable to be set.
+  @param[in] VendorGuid         Variable vendor GUID.
+  @param[in] Attributes         Attribute value of the variable.
+  @param[in] DataSize           Size of Data.
+  @param[in] Data               Data pointer.
+
+  @retval EFI_INVALID_PARAMETER The variable does not fit in the communicate buffer.
+  @retval Others                The status returned by SetVariable() in SMM.
+
+**/
+EFI_STATUS
+SetVariableInSmm (
+  IN CHAR16    *VariableName,
+  IN EFI_GUID  *VendorGuid,
+  IN UINT32    Attributes,
+  IN UINTN     DataSize,
+  IN VOID      *Data
+  )
+{
+  EFI_STATUS                                Status;
+  UINTN                                     PayloadSize;
+  SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE  *SmmVariableHeader;
+  UINTN                                     VariableNameSize;
+
+  VariableNameSize  = StrSize (VariableName);
+  SmmVariableHeader = NULL;
+
+  //
+  // If VariableName or DataSize exceeds SMM payload limit. Return failure
+  //
+  if ((VariableNameSize > mVariableBufferPayloadSize - OFFSET_OF (SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE, Name)) ||
+      (DataSize > mVariableBufferPayloadSize - OFFSET_OF (SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE, Name) - VariableNameSize))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Init the communicate buffer. The buffer data size is:
+  // SMM_COMMUNICATE_HEADER_SIZE + SMM_VARIABLE_COMMUNICATE_HEADER_SIZE + PayloadSize.
+  //
+  PayloadSize = OFFSET_OF (SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE, Name) + VariableNameSize + DataSize;
+  Status      = InitCommunicateBuffer ((VOID **)&SmmVariableHeader, PayloadSize, SMM_VARIABLE_FUNCTION_SET_VARIABLE);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  ASSERT (SmmVariableHeader != NULL);
+
+  CopyGuid ((EFI_GUID *)&SmmVariableHeader->Guid, VendorGuid);
+  SmmVariableHeader->DataSize   = DataSize;
+  SmmVariableHeader->NameSize   = VariableNameSize;
+  SmmVariableHeader->Attributes = Attributes;
+  CopyMem (SmmVariableHeader->Name, VariableName, SmmVariableHeader->NameSize);
+  CopyMem ((UINT8 *)SmmVariableHeader->Name + SmmVariableHeader->NameSize, Data, DataSize);
+
+  //
+  // Send data to SMM.
+  //
+  return SendCommunicateBuffer (PayloadSize);
+}
+
 /**
   This code sets variable in storage blocks (Volatile or Non-Volatile).
 
@@ -1114,10 +1182,7 @@ RuntimeServiceSetVariable (
   IN VOID      *Data
   )
 {
-  EFI_STATUS                                Status;
-  UINTN                                     PayloadSize;
-  SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE  *SmmVariableHeader;
-  UINTN                                     VariableNameSize;
+  EFI_STATUS  Status;
 
   //
   // Check input parameters.
@@ -1130,57 +1195,286 @@ RuntimeServiceSetVariable (
     return EFI_INVALID_PARAMETER;
   }
 
-  VariableNameSize  = StrSize (VariableName);
-  SmmVariableHeader = NULL;
+  AcquireLockOnlyAtBootTime (&mVariableServicesLock);
 
-  //
-  // If VariableName or DataSize exceeds SMM payload limit. Return failure
-  //
-  if ((VariableNameSize > mVariableBufferPayloadSize - OFFSET_OF (SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE, Name)) ||
-      (DataSize > mVariableBufferPayloadSize - OFFSET_OF (SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE, Name) - VariableNameSize))
-  {
-    return EFI_INVALID_PARAMETER;
+  Status = SetVariableInSmm (VariableName, VendorGuid, Attributes, DataSize, Data);
+
+  ReleaseLockOnlyAtBootTime (&mVariableServicesLock);
+
+  if (!EfiAtRuntime ()) {
+    if (!EFI_ERROR (Status)) {
+      SecureBootHook (
+        VariableName,
+        VendorGuid
+        );
+    }
   }
 
-  AcquireLockOnlyAtBootTime (&mVariableServicesLock);
+  return Status;
+}
 
-  //
-  // Init the communicate buffer. The buffer data size is:
-  // SMM_COMMUNICATE_HEADER_SIZE + SMM_VARIABLE_COMMUNICATE_HEADER_SIZE + PayloadSize.
-  //
-  PayloadSize = OFFSET_OF (SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE, Name) + VariableNameSize + DataSize;
-  Status      = InitCommunicateBuffer ((VOID **)&SmmVariableHeader, PayloadSize, SMM_VARIABLE_FUNCTION_SET_VARIABLE);
-  if (EFI_ERROR (Status)) {
-    goto Done;
+/**
+  Send the SMM_VARIABLE_FUNCTION_BATCH_ACCESS_VARIABLE request in the communicate buffer
+  to SMM, and return the per entry results to the entries packed into it.
+
+  The entries packed into the request are the ones in [FirstIndex, EndIndex) whose
+  Status is EFI_NOT_READY, in order.
+
+  @param[in]      BatchSize     The size of the batch payload in the communicate buffer.
+  @param[in, out] Entries       The entries of the batch request.
+  @param[in]      FirstIndex    The index of the first entry packed into the request.
+  @param[in]      EndIndex      The index after the last entry packed into the request.
+
+**/
+VOID
+SendVariableBatch (
+  IN     UINTN                       BatchSize,
+  IN OUT EDKII_VARIABLE_BATCH_ENTRY  *Entries,
+  IN     UINTN                       FirstIndex,
+  IN     UINTN                       EndIndex
+  )
+{
+  EFI_STATUS                                      Status;
+  SMM_VARIABLE_COMMUNICATE_BATCH_ACCESS_VARIABLE  *Batch;
+  SMM_VARIABLE_COMMUNICATE_BATCH_ENTRY            *BatchEntry;
+  EDKII_VARIABLE_BATCH_ENTRY                      *Entry;
+  UINTN                                           Index;
+  UINTN                                           Offset;
+
+  Batch  = NULL;
+  Status = InitCommunicateBuffer ((VOID **)&Batch, BatchSize, SMM_VARIABLE_FUNCTION_BATCH_ACCESS_VARIABLE);
+  if (!EFI_ERROR (Status)) {
+    Status = SendCommunicateBuffer (BatchSize);
   }
 
-  ASSERT (SmmVariableHeader != NULL);
+  Offset = OFFSET_OF (SMM_VARIABLE_COMMUNICATE_BATCH_ACCESS_VARIABLE, Entry);
+  for (Index = FirstIndex; Index < EndIndex; Index++) {
+    Entry = &Entries[Index];
+    if (Entry->Status != EFI_NOT_READY) {
+      continue;
+    }
 
-  CopyGuid ((EFI_GUID *)&SmmVariableHeader->Guid, VendorGuid);
-  SmmVariableHeader->DataSize   = DataSize;
-  SmmVariableHeader->NameSize   = VariableNameSize;
-  SmmVariableHeader->Attributes = Attributes;
-  CopyMem (SmmVariableHeader->Name, VariableName, SmmVariableHeader->NameSize);
-  CopyMem ((UINT8 *)SmmVariableHeader->Name + SmmVariableHeader->NameSize, Data, DataSize);
+    if (EFI_ERROR (Status)) {
+      Entry->Status = Status;
+      continue;
+    }
+
+    BatchEntry    = (SMM_VARIABLE_COMMUNICATE_BATCH_ENTRY *)((UINT8 *)Batch + Offset);
+    Offset       += BatchEntry->EntrySize;
+    Entry->Status = BatchEntry->ReturnStatus;
+    if (Entry->Operation != EdkiiVariableBatchGetVariable) {
+      continue;
+    }
+
+    if ((Entry->Status == EFI_SUCCESS) || (Entry->Status == EFI_BUFFER_TOO_SMALL)) {
+      Entry->DataSize = BatchEntry->Access.DataSize;
+    }
+
+    Entry->Attributes = BatchEntry->Access.Attributes;
+    if (Entry->Status == EFI_SUCCESS) {
+      if (Entry->Data != NULL) {
+        CopyMem (Entry->Data, (UINT8 *)BatchEntry->Access.Name + BatchEntry->Access.NameSize, BatchEntry->Access.DataSize);
+      } else {
+        Entry->Status = EFI_INVALID_PARAMETER;
+      }
+    }
+  }
+}
+
+/**
+  Get or set a list of variables with one request.
+
+  The entries are packed into SMM_VARIABLE_FUNCTION_BATCH_ACCESS_VARIABLE requests,
+  as many as fit in the communicate buffer, so a batch of N entries costs about one
+  SMI per communicate buffer instead of N SMIs. GetVariable entries are served from
+  the runtime cache when it is enabled, after the entries before them have been sent.
+
+  Caution: This function may receive untrusted input.
+  The data size and data are external input, so this function will validate it carefully to avoid buffer overflow.
+
+  @param[in]      This          The EDKII_VARIABLE_BATCH_PROTOCOL instance.
+  @param[in]      Count         The number of entries in Entries.
+  @param[in, out] Entries       The GetVariable and SetVariable requests to process.
+
+  @retval EFI_SUCCESS           All entries were processed. Check the Status of each entry.
+  @retval EFI_INVALID_PARAMETER Count is not zero and Entries is NULL.
+
+**/
+EFI_STATUS
+EFIAPI
+VariableBatchAccess (
+  IN CONST EDKII_VARIABLE_BATCH_PROTOCOL  *This,
+  IN       UINTN                          Count,
+  IN OUT   EDKII_VARIABLE_BATCH_ENTRY     *Entries
+  )
+{
+  EFI_STATUS                                      Status;
+  EDKII_VARIABLE_BATCH_ENTRY                      *Entry;
+  SMM_VARIABLE_COMMUNICATE_BATCH_ACCESS_VARIABLE  *Batch;
+  SMM_VARIABLE_COMMUNICATE_BATCH_ENTRY            *BatchEntry;
+  UINTN                                           BatchSize;
+  UINTN                                           FirstIndex;
+  UINTN                                           Index;
+  UINTN                                           MaxEntrySize;
+  UINTN                                           EntrySize;
+  UINTN                                           VariableNameSize;
+  UINTN                                           DataSize;
+
+  if (Count == 0) {
+    return EFI_SUCCESS;
+  }
+
+  if (Entries == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
 
   //
-  // Send data to SMM.
+  // The largest entry that fits in a batch on its own.
   //
-  Status = SendCommunicateBuffer (PayloadSize);
+  MaxEntrySize = (mVariableBufferPayloadSize - OFFSET_OF (SMM_VARIABLE_COMMUNICATE_BATCH_ACCESS_VARIABLE, Entry)) & ~(sizeof (UINTN) - 1);
+  Batch        = NULL;
+  BatchSize    = 0;
+  FirstIndex   = 0;
+
+  AcquireLockOnlyAtBootTime (&mVariableServicesLock);
+
+  for (Index = 0; Index < Count; Index++) {
+    Entry = &Entries[Index];
+    if ((Entry->VariableName == NULL) || (Entry->VendorGuid == NULL)) {
+      Entry->Status = EFI_INVALID_PARAMETER;
+      continue;
+    }
+
+    if (Entry->Operation == EdkiiVariableBatchGetVariable) {
+      if (Entry->VariableName[0] == 0) {
+        Entry->Status = EFI_NOT_FOUND;
+        continue;
+      }
+
+      if (mIsRuntimeCacheEnabled) {
+        //
+        // Send the entries before this one first, so it observes their result.
+        //
+        if (BatchSize != 0) {
+          SendVariableBatch (BatchSize, Entries, FirstIndex, Index);
+          BatchSize = 0;
+        }
+
+        Entry->Status = FindVariableInRuntimeCache (
+                          Entry->VariableName,
+                          Entry->VendorGuid,
+                          &Entry->Attributes,
+                          &Entry->DataSize,
+                          Entry->Data
+                          );
+        continue;
+      }
+    } else if (Entry->Operation == EdkiiVariableBatchSetVariable) {
+      if ((Entry->VariableName[0] == 0) || ((Entry->DataSize != 0) && (Entry->Data == NULL))) {
+        Entry->Status = EFI_INVALID_PARAMETER;
+        continue;
+      }
+    } else {
+      Entry->Status = EFI_INVALID_PARAMETER;
+      continue;
+    }
+
+    VariableNameSize = StrSize (Entry->VariableName);
+    DataSize         = Entry->DataSize;
+    if ((Entry->Operation == EdkiiVariableBatchGetVariable) &&
+        (VariableNameSize <= MaxEntrySize - SMM_VARIABLE_BATCH_ENTRY_HEADER_SIZE) &&
+        (DataSize > MaxEntrySize - SMM_VARIABLE_BATCH_ENTRY_HEADER_SIZE - VariableNameSize))
+    {
+      //
+      // If output data buffer exceed SMM payload limit. Trim output buffer to SMM payload size
+      //
+      DataSize = MaxEntrySize - SMM_VARIABLE_BATCH_ENTRY_HEADER_SIZE - VariableNameSize;
+    }
+
+    if ((VariableNameSize > MaxEntrySize - SMM_VARIABLE_BATCH_ENTRY_HEADER_SIZE) ||
+        (DataSize > MaxEntrySize - SMM_VARIABLE_BATCH_ENTRY_HEADER_SIZE - VariableNameSize))
+    {
+      //
+      // The entry does not fit in a batch, send it on its own.
+      //
+      if (BatchSize != 0) {
+        SendVariableBatch (BatchSize, Entries, FirstIndex, Index);
+        BatchSize = 0;
+      }
+
+      if (Entry->Operation == EdkiiVariableBatchGetVariable) {
+        Entry->Status = FindVariableInSmm (
+                          Entry->VariableName,
+                          Entry->VendorGuid,
+                          &Entry->Attributes,
+                          &Entry->DataSize,
+                          Entry->Data
+                          );
+      } else {
+        Entry->Status = SetVariableInSmm (
+                          Entry->VariableName,
+                          Entry->VendorGuid,
+                          Entry->Attributes,
+                          Entry->DataSize,
+                          Entry->Data
+                          );
+      }
+
+      continue;
+    }
+
+    EntrySize = ALIGN_VALUE (SMM_VARIABLE_BATCH_ENTRY_HEADER_SIZE + VariableNameSize + DataSize, sizeof (UINTN));
+    if ((BatchSize != 0) && (EntrySize > mVariableBufferPayloadSize - BatchSize)) {
+      SendVariableBatch (BatchSize, Entries, FirstIndex, Index);
+      BatchSize = 0;
+    }
+
+    if (BatchSize == 0) {
+      Status = InitCommunicateBuffer ((VOID **)&Batch, mVariableBufferPayloadSize, SMM_VARIABLE_FUNCTION_BATCH_ACCESS_VARIABLE);
+      ASSERT_EFI_ERROR (Status);
+      ASSERT (Batch != NULL);
+      Batch->Count = 0;
+      BatchSize    = OFFSET_OF (SMM_VARIABLE_COMMUNICATE_BATCH_ACCESS_VARIABLE, Entry);
+      FirstIndex   = Index;
+    }
+
+    BatchEntry                    = (SMM_VARIABLE_COMMUNICATE_BATCH_ENTRY *)((UINT8 *)Batch + BatchSize);
+    BatchEntry->ReturnStatus      = EFI_NOT_READY;
+    BatchEntry->EntrySize         = EntrySize;
+    BatchEntry->Access.DataSize   = DataSize;
+    BatchEntry->Access.NameSize   = VariableNameSize;
+    BatchEntry->Access.Attributes = 0;
+    CopyGuid (&BatchEntry->Access.Guid, Entry->VendorGuid);
+    CopyMem (BatchEntry->Access.Name, Entry->VariableName, VariableNameSize);
+    if (Entry->Operation == EdkiiVariableBatchGetVariable) {
+      BatchEntry->Function = SMM_VARIABLE_FUNCTION_GET_VARIABLE;
+    } else {
+      BatchEntry->Function          = SMM_VARIABLE_FUNCTION_SET_VARIABLE;
+      BatchEntry->Access.Attributes = Entry->Attributes;
+      CopyMem ((UINT8 *)BatchEntry->Access.Name + VariableNameSize, Entry->Data, DataSize);
+    }
+
+    Batch->Count++;
+    BatchSize    += EntrySize;
+    Entry->Status = EFI_NOT_READY;
+  }
+
+  if (BatchSize != 0) {
+    SendVariableBatch (BatchSize, Entries, FirstIndex, Count);
+  }
 
-Done:
   ReleaseLockOnlyAtBootTime (&mVariableServicesLock);
 
   if (!EfiAtRuntime ()) {
-    if (!EFI_ERROR (Status)) {
-      SecureBootHook (
-        VariableName,
-        VendorGuid
-        );
+    for (Index = 0; Index < Count; Index++) {
+      Entry = &Entries[Index];
+      if ((Entry->Operation == EdkiiVariableBatchSetVariable) && !EFI_ERROR (Entry->Status)) {
+        SecureBootHook (Entry->VariableName, Entry->VendorGuid);
+      }
     }
   }
 
-  return Status;
+  return EFI_SUCCESS;
 }
 
 /**
@@ -1762,6 +2056,15 @@ SmmVariableReady (
                                                      );
   ASSERT_EFI_ERROR (Status);
 
+  mVariableBatch.Access = VariableBatchAccess;
+  Status                = gBS->InstallMultipleProtocolInterfaces (
+                                 &mHandle,
+                                 &gEdkiiVariableBatchProtocolGuid,
+                                 &mVariableBatch,
+                                 NULL
+                                 );
+  ASSERT_EFI_ERROR (Status);
+
   gBS->CloseEvent (Event);
 }
 
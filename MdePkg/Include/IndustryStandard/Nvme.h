@@ -868,8 +868,8 @@ typedef struct {
   //
   UINT8           Opc;       // Opcode
   UINT8           Fuse  : 2; // Fused Operation
-  UINT8           Rsvd1 : 5;
-  UINT8           Psdt  : 1; // PRP or SGL for Data Transfer
+  UINT8           Rsvd1 : 4;
+  UINT8           Psdt  : 2; // PRP or SGL for Data Transfer
   UINT16          Cid;       // Command Identifier
 
   //
@@ -895,6 +895,32 @@ typedef struct {
   NVME_PAYLOAD    Payload;
 } NVME_SQ;
 
+//
+// PRP or SGL for Data Transfer (PSDT)
+//
+#define NVME_PSDT_PRP       0x0     // PRPs are used for the data transfer
+#define NVME_PSDT_SGL_MPTR  0x1     // SGLs are used, Metadata Pointer is the address of a contiguous buffer
+
+//
+// SGL Support (SGLS) in the Identify Controller data
+//
+#define NVME_CTRL_SGLS_SUPPORT_MASK     0x3
+#define NVME_CTRL_SGLS_SUPPORTED        0x1 // SGLs are supported
+#define NVME_CTRL_SGLS_SUPPORTED_DWORD  0x2 // SGLs are supported, Data Blocks shall be Dword aligned
+
+//
+// SGL Descriptor
+//
+typedef struct {
+  UINT64    Address;
+  UINT32    Length;
+  UINT8     Rsvd[3];
+  UINT8     SubType : 4;    // SGL Descriptor Sub Type
+  UINT8     Type    : 4;    // SGL Descriptor Type
+} NVME_SGL_DESCRIPTOR;
+
+#define NVME_SGL_TYPE_DATA_BLOCK  0x0
+
 //
 // Completion Queue
 //
@@ -1504,6 +1504,25 @@ UnitTestHostBaseLibPatchInstructionX86 (
 {
 }
 
+/**
+  Executes a XGETBV instruction
+
+  Executes a XGETBV instruction. This function is only available on IA-32 and
+  x64.
+
+  @param[in] Index        Extended control register index
+
+  @return                 The current value of the extended control register
+**/
+UINT64
+EFIAPI
+UnitTestHostBaseLibAsmXGetBv (
+  IN UINT32  Index
+  )
+{
+  return 0;
+}
+
 /**
   Retrieves CPUID information.
 
@@ -2910,6 +2929,25 @@ PatchInstructionX86 (
   gUnitTestHostBaseLib.X86->PatchInstructionX86 (InstructionEnd, PatchValue, ValueSize);
 }
 
+/**
+  Executes a XGETBV instruction
+
+  Executes a XGETBV instruction. This function is only available on IA-32 and
+  x64.
+
+  @param[in] Index        Extended control register index
+
+  @return                 The current value of the extended control register
+**/
+UINT64
+EFIAPI
+AsmXGetBv (
+  IN UINT32  Index
+  )
+{
+  return gUnitTestHostBaseLib.X86->AsmXGetBv (Index);
+}
+
 ///
 /// Common services
 ///
@@ -2983,7 +3021,8 @@ STATIC UNIT_TEST_HOST_BASE_LIB_X86  mUnitTestHostBaseLibX86 = {
   UnitTestHostBaseLibAsmPrepareAndThunk16,
   UnitTestHostBaseLibAsmWriteTr,
   UnitTestHostBaseLibAsmLfence,
-  UnitTestHostBaseLibPatchInstructionX86
+  UnitTestHostBaseLibPatchInstructionX86,
+  UnitTestHostBaseLibAsmXGetBv
 };
 
 ///
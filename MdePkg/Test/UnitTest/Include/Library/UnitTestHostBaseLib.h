@@ -491,6 +491,19 @@ VOID
   IN  UINTN                    ValueSize
   );
 
+/**
+  Prototype of service that reads an Extended Control Register.
+
+  @param[in] Index        Extended control register index
+
+  @return                 The current value of the extended control register
+**/
+typedef
+UINT64
+(EFIAPI *UNIT_TEST_HOST_BASE_LIB_ASM_XGETBV)(
+  IN UINT32  Index
+  );
+
 ///
 /// Common services
 ///
@@ -565,6 +578,7 @@ typedef struct {
   UNIT_TEST_HOST_BASE_LIB_WRITE_UINT16                   AsmWriteTr;
   UNIT_TEST_HOST_BASE_LIB_VOID                           AsmLfence;
   UNIT_TEST_HOST_BASE_LIB_ASM_PATCH_INSTRUCTION_X86      PatchInstructionX86;
+  UNIT_TEST_HOST_BASE_LIB_ASM_XGETBV                     AsmXGetBv;
 } UNIT_TEST_HOST_BASE_LIB_X86;
 
 ///
@@ -0,0 +1,378 @@
+/** @file
+  Host based unit test for HttpBootRange.c.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+#include <Library/GoogleTestLib.h>
+#include <string>
+
+extern "C" {
+  #include <Uefi.h>
+  #include <Library/BaseLib.h>
+  #include <Library/BaseMemoryLib.h>
+  #include <Library/DebugLib.h>
+  #include "../HttpBootDxe.h"
+
+  EFI_STATUS
+  HttpBootRangeCheckResponse (
+    IN HTTP_BOOT_RANGE_DOWNLOAD    *Download,
+    IN HTTP_BOOT_RANGE_CONNECTION  *Connection,
+    IN EFI_HTTP_MESSAGE            *Message
+    );
+
+  VOID
+  HttpBootRangeClose (
+    IN OUT HTTP_BOOT_RANGE_DOWNLOAD    *Download,
+    IN OUT HTTP_BOOT_RANGE_CONNECTION  *Connection,
+    IN     EFI_STATUS                  Status
+    );
+
+  VOID
+  HttpBootRangeSendRequest (
+    IN OUT HTTP_BOOT_RANGE_DOWNLOAD    *Download,
+    IN OUT HTTP_BOOT_RANGE_CONNECTION  *Connection
+    );
+}
+
+using namespace testing;
+
+///////////////////////////////////////////////////////////////////////////////
+// Definitions
+///////////////////////////////////////////////////////////////////////////////
+
+#define TEST_FILE_SIZE   (10 * SIZE_1MB + 100)
+#define TEST_RANGE_SIZE  SIZE_1MB
+
+///////////////////////////////////////////////////////////////////////////////
+/// Symbol Definitions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+// The Range header of the last request, and the status the next request returns.
+//
+static std::string  mRequestedRange;
+static EFI_STATUS   mRequestStatus;
+
+EFI_STATUS
+EFIAPI
+MockHttpRequest (
+  IN EFI_HTTP_PROTOCOL  *This,
+  IN EFI_HTTP_TOKEN     *Token
+  )
+{
+  EFI_HTTP_HEADER  *Header;
+
+  Header = HttpFindHeader (Token->Message->HeaderCount, Token->Message->Headers, (CHAR8 *)"Range");
+  EXPECT_NE (Header, nullptr);
+  mRequestedRange = (Header != NULL) ? Header->FieldValue : "";
+  return mRequestStatus;
+}
+
+EFI_STATUS
+EFIAPI
+MockSetTimer (
+  IN  EFI_EVENT        Event,
+  IN  EFI_TIMER_DELAY  Type,
+  IN  UINT64           TriggerTime
+  )
+{
+  return EFI_SUCCESS;
+}
+
+// Needed by HttpBootRange.c
+EFI_STATUS
+HttpBootCreateHttpIoInstance (
+  IN     HTTP_BOOT_PRIVATE_DATA  *Private,
+  OUT    HTTP_IO                 *HttpIo
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+EFI_STATUS
+EFIAPI
+HttpBootHttpIoCallback (
+  IN  HTTP_IO_CALLBACK_EVENT  EventType,
+  IN  EFI_HTTP_MESSAGE        *Message,
+  IN  VOID                    *Context
+  )
+{
+  return EFI_SUCCESS;
+}
+
+VOID
+HttpIoDestroyIo (
+  IN HTTP_IO  *HttpIo
+  )
+{
+}
+
+EFI_STATUS
+EFIAPI
+DispatchDpc (
+  VOID
+  )
+{
+  return EFI_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// HttpBootRangeCheckResponse Tests
+///////////////////////////////////////////////////////////////////////////////
+
+class HttpBootRangeCheckResponseTest : public ::testing::Test {
+public:
+  HTTP_BOOT_RANGE_DOWNLOAD    Download;
+  HTTP_BOOT_RANGE_CONNECTION  Connection;
+  EFI_HTTP_RESPONSE_DATA      ResponseData;
+  EFI_HTTP_HEADER             Header;
+  EFI_HTTP_MESSAGE            Message;
+
+protected:
+  void
+  SetUp (
+    ) override
+  {
+    ZeroMem (&Download, sizeof (Download));
+    ZeroMem (&Connection, sizeof (Connection));
+    ZeroMem (&Message, sizeof (Message));
+
+    //
+    // The connection asked for the second MB of a 4 MB file.
+    //
+    Download.FileSize = 4 * SIZE_1MB;
+    Connection.Index  = 1;
+    Connection.Start  = SIZE_1MB;
+    Connection.End    = 2 * SIZE_1MB;
+
+    ResponseData.StatusCode = HTTP_STATUS_206_PARTIAL_CONTENT;
+    Header.FieldName        = (CHAR8 *)HTTP_HEADER_CONTENT_RANGE;
+    Header.FieldValue       = (CHAR8 *)"bytes 1048576-2097151/4194304";
+    Message.Data.Response   = &ResponseData;
+    Message.HeaderCount     = 1;
+    Message.Headers         = &Header;
+  }
+
+public:
+  EFI_STATUS
+  Check (
+    CONST CHAR8  *ContentRange
+    )
+  {
+    Header.FieldValue = (CHAR8 *)ContentRange;
+    return HttpBootRangeCheckResponse (&Download, &Connection, &Message);
+  }
+};
+
+// The requested range of the requested file is accepted.
+TEST_F (HttpBootRangeCheckResponseTest, RequestedRangeIsAccepted) {
+  EXPECT_EQ (Check ("bytes 1048576-2097151/4194304"), EFI_SUCCESS);
+}
+
+// A server that ignores the Range header answers 200 with the whole file.
+TEST_F (HttpBootRangeCheckResponseTest, FullResponseIsRejected) {
+  ResponseData.StatusCode = HTTP_STATUS_200_OK;
+  EXPECT_EQ (Check ("bytes 1048576-2097151/4194304"), EFI_UNSUPPORTED);
+}
+
+TEST_F (HttpBootRangeCheckResponseTest, MissingContentRangeIsRejected) {
+  Message.HeaderCount = 0;
+  EXPECT_EQ (HttpBootRangeCheckResponse (&Download, &Connection, &Message), EFI_UNSUPPORTED);
+}
+
+TEST_F (HttpBootRangeCheckResponseTest, OtherUnitIsRejected) {
+  EXPECT_EQ (Check ("items 1048576-2097151/4194304"), EFI_UNSUPPORTED);
+}
+
+TEST_F (HttpBootRangeCheckResponseTest, OtherRangeIsRejected) {
+  EXPECT_EQ (Check ("bytes 0-2097151/4194304"), EFI_UNSUPPORTED);
+  EXPECT_EQ (Check ("bytes 1048576-2097152/4194304"), EFI_UNSUPPORTED);
+  EXPECT_EQ (Check ("bytes 1048576-1048576/4194304"), EFI_UNSUPPORTED);
+}
+
+// The ranges must come from a file of the size the HEAD request returned.
+TEST_F (HttpBootRangeCheckResponseTest, OtherFileSizeIsRejected) {
+  EXPECT_EQ (Check ("bytes 1048576-2097151/4194305"), EFI_UNSUPPORTED);
+  EXPECT_EQ (Check ("bytes 1048576-2097151/*"), EFI_UNSUPPORTED);
+}
+
+TEST_F (HttpBootRangeCheckResponseTest, MalformedValueIsRejected) {
+  EXPECT_EQ (Check ("bytes 1048576"), EFI_UNSUPPORTED);
+  EXPECT_EQ (Check ("bytes 1048576-2097151"), EFI_UNSUPPORTED);
+  EXPECT_EQ (Check ("bytes"), EFI_UNSUPPORTED);
+  EXPECT_EQ (Check (""), EFI_UNSUPPORTED);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// HttpBootRangeClose and HttpBootRangeSendRequest Tests
+///////////////////////////////////////////////////////////////////////////////
+
+class HttpBootRangeOrphanTest : public ::testing::Test {
+public:
+  HTTP_BOOT_RANGE_DOWNLOAD  Download;
+  EFI_HTTP_PROTOCOL         Http;
+  EFI_BOOT_SERVICES         BootServices;
+  EFI_BOOT_SERVICES         *SavedBootServices;
+
+protected:
+  void
+  SetUp (
+    ) override
+  {
+    UINTN                       Index;
+    HTTP_BOOT_RANGE_CONNECTION  *Connection;
+
+    ZeroMem (&BootServices, sizeof (BootServices));
+    BootServices.SetTimer = MockSetTimer;
+    SavedBootServices     = gBS;
+    gBS                   = &BootServices;
+
+    ZeroMem (&Http, sizeof (Http));
+    Http.Request    = MockHttpRequest;
+    mRequestedRange = "";
+    mRequestStatus  = EFI_SUCCESS;
+
+    //
+    // The first four ranges were handed out to connections 0 to 3, which
+    // are receiving them. Connections 4 and 5 are idle.
+    //
+    ZeroMem (&Download, sizeof (Download));
+    Download.FileSize        = TEST_FILE_SIZE;
+    Download.RangeSize       = TEST_RANGE_SIZE;
+    Download.NextOffset      = 4 * TEST_RANGE_SIZE;
+    Download.ConnectionCount = 6;
+
+    for (Index = 0; Index < Download.ConnectionCount; Index++) {
+      Connection                          = &Download.Connections[Index];
+      Connection->Index                   = Index;
+      Connection->HttpIo.Http             = &Http;
+      Connection->HttpIo.ReqToken.Message = &Connection->HttpIo.ReqMessage;
+      Connection->Header                  = HttpIoCreateHeader (1);
+      ASSERT_NE (Connection->Header, nullptr);
+      ASSERT_EQ (HttpIoSetHeader (Connection->Header, (CHAR8 *)"Range", (CHAR8 *)""), EFI_SUCCESS);
+
+      if (Index < 4) {
+        Connection->State  = HttpBootRangeStateBody;
+        Connection->Start  = Index * TEST_RANGE_SIZE;
+        Connection->End    = Connection->Start + TEST_RANGE_SIZE;
+        Connection->Offset = Connection->Start;
+      } else {
+        Connection->State = HttpBootRangeStateIdle;
+      }
+    }
+  }
+
+  void
+  TearDown (
+    ) override
+  {
+    UINTN  Index;
+
+    for (Index = 0; Index < Download.ConnectionCount; Index++) {
+      HttpBootRangeClose (&Download, &Download.Connections[Index], EFI_SUCCESS);
+    }
+
+    gBS = SavedBootServices;
+  }
+};
+
+// A connection that fails in the middle of a range leaves the rest of it.
+TEST_F (HttpBootRangeOrphanTest, FailedConnectionLeavesRestOfRange) {
+  HTTP_BOOT_RANGE_CONNECTION  *Connection;
+
+  Connection         = &Download.Connections[1];
+  Connection->Offset = Connection->Start + 1000;
+  HttpBootRangeClose (&Download, Connection, EFI_TIMEOUT);
+
+  EXPECT_EQ (Connection->State, HttpBootRangeStateClosed);
+  EXPECT_EQ (Connection->Status, EFI_TIMEOUT);
+  ASSERT_EQ (Download.OrphanCount, (UINTN)1);
+  EXPECT_EQ (Download.Orphans[0].Start, TEST_RANGE_SIZE + 1000);
+  EXPECT_EQ (Download.Orphans[0].End, 2 * TEST_RANGE_SIZE);
+
+  //
+  // Closing it again doesn't leave the range twice.
+  //
+  HttpBootRangeClose (&Download, Connection, EFI_SUCCESS);
+  EXPECT_EQ (Download.OrphanCount, (UINTN)1);
+}
+
+// An idle connection, or one that received all of its range, leaves nothing.
+TEST_F (HttpBootRangeOrphanTest, FinishedConnectionLeavesNothing) {
+  HTTP_BOOT_RANGE_CONNECTION  *Connection;
+
+  HttpBootRangeClose (&Download, &Download.Connections[4], EFI_TIMEOUT);
+  EXPECT_EQ (Download.OrphanCount, (UINTN)0);
+
+  Connection         = &Download.Connections[2];
+  Connection->Offset = Connection->End;
+  HttpBootRangeClose (&Download, Connection, EFI_TIMEOUT);
+  EXPECT_EQ (Download.OrphanCount, (UINTN)0);
+}
+
+// An idle connection takes the range a failed one left before a new one.
+TEST_F (HttpBootRangeOrphanTest, IdleConnectionTakesOrphanFirst) {
+  HTTP_BOOT_RANGE_CONNECTION  *Connection;
+
+  Connection         = &Download.Connections[1];
+  Connection->Offset = Connection->Start + 1000;
+  HttpBootRangeClose (&Download, Connection, EFI_TIMEOUT);
+
+  Connection = &Download.Connections[4];
+  HttpBootRangeSendRequest (&Download, Connection);
+  EXPECT_EQ (Connection->State, HttpBootRangeStateRequest);
+  EXPECT_EQ (Connection->Start, TEST_RANGE_SIZE + 1000);
+  EXPECT_EQ (Connection->End, 2 * TEST_RANGE_SIZE);
+  EXPECT_EQ (Connection->Offset, Connection->Start);
+  EXPECT_EQ (mRequestedRange, "bytes=1049576-2097151");
+  EXPECT_EQ (Download.OrphanCount, (UINTN)0);
+  EXPECT_EQ (Download.NextOffset, 4 * TEST_RANGE_SIZE);
+
+  Connection = &Download.Connections[5];
+  HttpBootRangeSendRequest (&Download, Connection);
+  EXPECT_EQ (Connection->Start, 4 * TEST_RANGE_SIZE);
+  EXPECT_EQ (Connection->End, 5 * TEST_RANGE_SIZE);
+  EXPECT_EQ (mRequestedRange, "bytes=4194304-5242879");
+  EXPECT_EQ (Download.NextOffset, 5 * TEST_RANGE_SIZE);
+}
+
+// A range whose request can't be sent is left for the other connections.
+TEST_F (HttpBootRangeOrphanTest, FailedRequestLeavesRange) {
+  HTTP_BOOT_RANGE_CONNECTION  *Connection;
+
+  mRequestStatus = EFI_DEVICE_ERROR;
+  Connection     = &Download.Connections[4];
+  HttpBootRangeSendRequest (&Download, Connection);
+  EXPECT_EQ (Connection->State, HttpBootRangeStateClosed);
+  EXPECT_EQ (Connection->Status, EFI_DEVICE_ERROR);
+  ASSERT_EQ (Download.OrphanCount, (UINTN)1);
+  EXPECT_EQ (Download.Orphans[0].Start, 4 * TEST_RANGE_SIZE);
+  EXPECT_EQ (Download.Orphans[0].End, 5 * TEST_RANGE_SIZE);
+
+  mRequestStatus = EFI_SUCCESS;
+  Connection     = &Download.Connections[5];
+  HttpBootRangeSendRequest (&Download, Connection);
+  EXPECT_EQ (Connection->Start, 4 * TEST_RANGE_SIZE);
+  EXPECT_EQ (Connection->End, 5 * TEST_RANGE_SIZE);
+  EXPECT_EQ (Download.OrphanCount, (UINTN)0);
+}
+
+// The last range ends with the file, and nothing is asked for after it.
+TEST_F (HttpBootRangeOrphanTest, LastRangeEndsWithFile) {
+  HTTP_BOOT_RANGE_CONNECTION  *Connection;
+
+  Download.NextOffset = 10 * TEST_RANGE_SIZE;
+  Connection          = &Download.Connections[4];
+  HttpBootRangeSendRequest (&Download, Connection);
+  EXPECT_EQ (Connection->Start, 10 * TEST_RANGE_SIZE);
+  EXPECT_EQ (Connection->End, (UINTN)TEST_FILE_SIZE);
+  EXPECT_EQ (mRequestedRange, "bytes=10485760-10485859");
+  EXPECT_EQ (Download.NextOffset, (UINTN)TEST_FILE_SIZE);
+
+  mRequestedRange = "";
+  Connection      = &Download.Connections[5];
+  HttpBootRangeSendRequest (&Download, Connection);
+  EXPECT_EQ (Connection->State, HttpBootRangeStateIdle);
+  EXPECT_EQ (mRequestedRange, "");
+}
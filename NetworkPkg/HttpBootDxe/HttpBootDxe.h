@@ -32,6 +32,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/HiiLib.h>
 #include <Library/PrintLib.h>
 #include <Library/DpcLib.h>
+#include <Library/TimerLib.h>
 
 //
 // UEFI Driver Model Protocols
@@ -108,6 +109,7 @@ typedef enum  {
 #include "HttpBootImpl.h"
 #include "HttpBootSupport.h"
 #include "HttpBootClient.h"
+#include "HttpBootRange.h"
 #include "HttpBootConfig.h"
 
 typedef union {
@@ -216,6 +218,7 @@ struct _HTTP_BOOT_PRIVATE_DATA {
   UINTN                                        BootFileSize;
   UINTN                                        PartialTransferredSize;
   CHAR8                                        *LastModifiedOrEtag;
+  BOOLEAN                                      AcceptRanges;
   BOOLEAN                                      NoGateway;
   HTTP_BOOT_IMAGE_TYPE                         ImageType;
 
@@ -394,6 +394,20 @@ HttpBootGetBootFileCaller (
           return Status;
         }
 
+        //
+        // Download the file over several connections when the server accepts
+        // range requests, and fall back to a single connection if that fails.
+        //
+        if (HttpBootRangeSupported (Private, *BufferSize, Buffer)) {
+          Status = HttpBootGetBootFileRanged (Private, BufferSize, Buffer, ImageType);
+          if (!EFI_ERROR (Status)) {
+            return Status;
+          }
+
+          DEBUG ((DEBUG_WARN, "HttpBootGetBootFileCaller: Ranged download failed - %r, using a single connection.\n", Status));
+          Private->AcceptRanges = FALSE;
+        }
+
         //
         // Load the boot file into Buffer
         //
@@ -584,6 +598,7 @@ HttpBootStop (
   Private->SelectIndex            = 0;
   Private->SelectProxyType        = HttpOfferTypeMax;
   Private->PartialTransferredSize = 0;
+  Private->AcceptRanges           = FALSE;
 
   if (!Private->UsingIpv6) {
     //
@@ -0,0 +1,809 @@
+/** @file
+  Parallel ranged download of the boot file.
+
+  When the server accepts byte range requests, the boot file is cut into
+  ranges that are requested over several HTTP connections at once, each
+  range being received straight into its place in the caller's buffer.
+  A single TCP connection is limited by its window and by the round trip
+  time, several of them fill a high bandwidth-delay product link.
+
+Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "HttpBootDxe.h"
+
+/**
+  Check whether the boot file can be downloaded in ranges over several connections.
+
+  @param[in]  Private         The pointer to the driver's private data.
+  @param[in]  BufferSize      The size of Buffer in bytes.
+  @param[in]  Buffer          The memory buffer to transfer the file to.
+
+  @retval TRUE                HttpBootGetBootFileRanged() can be used.
+  @retval FALSE               The file must be downloaded with HttpBootGetBootFile().
+
+**/
+BOOLEAN
+HttpBootRangeSupported (
+  IN     HTTP_BOOT_PRIVATE_DATA  *Private,
+  IN     UINTN                   BufferSize,
+  IN     VOID                    *Buffer
+  )
+{
+  if ((PcdGet8 (PcdHttpBootRangeConnections) < 2) || !Private->AcceptRanges) {
+    return FALSE;
+  }
+
+  //
+  // The file size must be known and the buffer large enough to hold it.
+  // A file shorter than two ranges isn't worth the extra connections.
+  //
+  if ((Buffer == NULL) || (Private->BootFileSize < 2 * HTTP_BOOT_RANGE_MIN_SIZE) ||
+      (BufferSize < Private->BootFileSize))
+  {
+    return FALSE;
+  }
+
+  //
+  // A resumed download, a file already in the cache, or a connection
+  // established through a proxy keep using the single connection.
+  //
+  if ((Private->PartialTransferredSize != 0) || !IsListEmpty (&Private->CacheList) ||
+      (Private->ProxyUri != NULL))
+  {
+    return FALSE;
+  }
+
+  //
+  // The entity body is reported to the callback out of order. The driver's
+  // own callback only counts it, another one might expect it in order.
+  //
+  if ((Private->HttpBootCallback != NULL) && (Private->HttpBootCallback != &Private->LoadFileCallback)) {
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+  Build the request headers shared by all the range requests of a connection.
+
+  The Range header is added with an empty value, HttpBootRangeSendRequest()
+  updates it before each request.
+
+  @param[in]   Private         The pointer to the driver's private data.
+  @param[out]  Header          The request headers.
+
+  @retval EFI_SUCCESS          The headers were built.
+  @retval EFI_UNSUPPORTED      The server requires an unsupported authentication scheme.
+  @retval Others               Failed to build the headers.
+
+**/
+EFI_STATUS
+HttpBootRangeBuildHeader (
+  IN     HTTP_BOOT_PRIVATE_DATA  *Private,
+  OUT    HTTP_IO_HEADER          **Header
+  )
+{
+  EFI_STATUS      Status;
+  HTTP_IO_HEADER  *HttpIoHeader;
+  UINTN           HeadersCount;
+  CHAR8           *HostName;
+  CHAR8           BaseAuthValue[80];
+
+  //
+  // Host, Accept, User-Agent, Range, [Authorization], [If-Match]|[If-Unmodified-Since]
+  //
+  HeadersCount = 4;
+  if (Private->AuthData != NULL) {
+    HeadersCount++;
+  }
+
+  if (Private->LastModifiedOrEtag != NULL) {
+    HeadersCount++;
+  }
+
+  HttpIoHeader = HttpIoCreateHeader (HeadersCount);
+  if (HttpIoHeader == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  HostName = NULL;
+  Status   = HttpUrlGetHostName (
+               Private->BootFileUri,
+               Private->BootFileUriParser,
+               &HostName
+               );
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  Status = HttpIoSetHeader (HttpIoHeader, HTTP_HEADER_HOST, HostName);
+  FreePool (HostName);
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  Status = HttpIoSetHeader (HttpIoHeader, HTTP_HEADER_ACCEPT, "*/*");
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  Status = HttpIoSetHeader (HttpIoHeader, HTTP_HEADER_USER_AGENT, HTTP_USER_AGENT_EFI_HTTP_BOOT);
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  Status = HttpIoSetHeader (HttpIoHeader, "Range", "");
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  if (Private->AuthData != NULL) {
+    if ((Private->AuthScheme != NULL) && (CompareMem (Private->AuthScheme, "Basic", 5) != 0)) {
+      Status = EFI_UNSUPPORTED;
+      goto ON_ERROR;
+    }
+
+    AsciiSPrint (BaseAuthValue, sizeof (BaseAuthValue), "%a %a", "Basic", Private->AuthData);
+    Status = HttpIoSetHeader (HttpIoHeader, HTTP_HEADER_AUTHORIZATION, BaseAuthValue);
+    if (EFI_ERROR (Status)) {
+      goto ON_ERROR;
+    }
+  }
+
+  //
+  // Make sure all the ranges come from the file the HEAD request described.
+  //
+  if (Private->LastModifiedOrEtag != NULL) {
+    if (Private->LastModifiedOrEtag[0] == '"') {
+      Status = HttpIoSetHeader (HttpIoHeader, HTTP_HEADER_IF_MATCH, Private->LastModifiedOrEtag);
+    } else {
+      Status = HttpIoSetHeader (HttpIoHeader, HTTP_HEADER_IF_UNMODIFIED_SINCE, Private->LastModifiedOrEtag);
+    }
+
+    if (EFI_ERROR (Status)) {
+      goto ON_ERROR;
+    }
+  }
+
+  *Header = HttpIoHeader;
+  return EFI_SUCCESS;
+
+ON_ERROR:
+  HttpIoFreeHeader (HttpIoHeader);
+  return Status;
+}
+
+/**
+  Get the time elapsed between two performance counter values.
+
+  @param[in]  Begin           The earlier performance counter value.
+  @param[in]  End             The later performance counter value.
+
+  @return The elapsed time in microseconds.
+
+**/
+UINT64
+HttpBootRangeElapsed (
+  IN UINT64  Begin,
+  IN UINT64  End
+  )
+{
+  UINT64  StartValue;
+  UINT64  EndValue;
+  UINT64  Ticks;
+
+  GetPerformanceCounterProperties (&StartValue, &EndValue);
+  if (EndValue >= StartValue) {
+    Ticks = End - Begin;
+  } else {
+    Ticks = Begin - End;
+  }
+
+  return DivU64x32 (GetTimeInNanoSecond (Ticks), 1000);
+}
+
+/**
+  Start the timer that limits how long a connection waits for its queued token.
+
+  @param[in]  Connection      The connection.
+
+**/
+VOID
+HttpBootRangeStartTimer (
+  IN HTTP_BOOT_RANGE_CONNECTION  *Connection
+  )
+{
+  gBS->SetTimer (
+         Connection->HttpIo.TimeoutEvent,
+         TimerRelative,
+         MultU64x32 (Connection->HttpIo.Timeout, TICKS_PER_MS)
+         );
+}
+
+/**
+  Close a connection. If it failed while receiving a range, the part of the
+  range it didn't receive is left for the other connections.
+
+  @param[in, out]  Download        The ranged download.
+  @param[in, out]  Connection      The connection to close.
+  @param[in]       Status          Why the connection is closed.
+
+**/
+VOID
+HttpBootRangeClose (
+  IN OUT HTTP_BOOT_RANGE_DOWNLOAD    *Download,
+  IN OUT HTTP_BOOT_RANGE_CONNECTION  *Connection,
+  IN     EFI_STATUS                  Status
+  )
+{
+  HTTP_IO  *HttpIo;
+
+  if (Connection->State == HttpBootRangeStateClosed) {
+    return;
+  }
+
+  if ((Connection->State != HttpBootRangeStateIdle) && (Connection->Offset < Connection->End)) {
+    ASSERT (Download->OrphanCount < HTTP_BOOT_RANGE_MAX_CONNECTIONS);
+    Download->Orphans[Download->OrphanCount].Start = Connection->Offset;
+    Download->Orphans[Download->OrphanCount].End   = Connection->End;
+    Download->OrphanCount++;
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG (
+      (DEBUG_WARN,
+       "HttpBootRangeClose: Connection %d failed at offset %Lu - %r\n",
+       (UINT32)Connection->Index,
+       (UINT64)Connection->Offset,
+       Status)
+      );
+  }
+
+  Connection->State  = HttpBootRangeStateClosed;
+  Connection->Status = Status;
+
+  if (Connection->HttpCreated) {
+    //
+    // Abort the queued tokens while their events are still open, and run
+    // their notify DPCs before the HTTP_IO they point to goes away.
+    //
+    HttpIo = &Connection->HttpIo;
+    gBS->SetTimer (HttpIo->TimeoutEvent, TimerCancel, 0);
+    HttpIo->Http->Cancel (HttpIo->Http, NULL);
+    DispatchDpc ();
+
+    HttpIoDestroyIo (HttpIo);
+    Connection->HttpCreated = FALSE;
+  }
+
+  if (Connection->Header != NULL) {
+    HttpIoFreeHeader (Connection->Header);
+    Connection->Header = NULL;
+  }
+}
+
+/**
+  Request the next range on a connection: a range a failed connection left,
+  or else the next one nobody asked for yet.
+
+  @param[in, out]  Download        The ranged download.
+  @param[in, out]  Connection      An idle connection.
+
+**/
+VOID
+HttpBootRangeSendRequest (
+  IN OUT HTTP_BOOT_RANGE_DOWNLOAD    *Download,
+  IN OUT HTTP_BOOT_RANGE_CONNECTION  *Connection
+  )
+{
+  EFI_STATUS  Status;
+  HTTP_IO     *HttpIo;
+  CHAR8       RangeValue[64];
+
+  ASSERT (Connection->State == HttpBootRangeStateIdle);
+
+  if (Download->OrphanCount != 0) {
+    Download->OrphanCount--;
+    Connection->Start = Download->Orphans[Download->OrphanCount].Start;
+    Connection->End   = Download->Orphans[Download->OrphanCount].End;
+  } else if (Download->NextOffset < Download->FileSize) {
+    Connection->Start    = Download->NextOffset;
+    Connection->End      = MIN (Download->NextOffset + Download->RangeSize, Download->FileSize);
+    Download->NextOffset = Connection->End;
+  } else {
+    return;
+  }
+
+  Connection->Offset = Connection->Start;
+
+  AsciiSPrint (
+    RangeValue,
+    sizeof (RangeValue),
+    "bytes=%Lu-%Lu",
+    (UINT64)Connection->Start,
+    (UINT64)(Connection->End - 1)
+    );
+  Status = HttpIoSetHeader (Connection->Header, "Range", RangeValue);
+  if (EFI_ERROR (Status)) {
+    Connection->State = HttpBootRangeStateRequest;
+    HttpBootRangeClose (Download, Connection, Status);
+    return;
+  }
+
+  HttpIo                                 = &Connection->HttpIo;
+  Connection->RequestData.Method         = HttpMethodGet;
+  Connection->RequestData.Url            = Download->Url;
+  HttpIo->ReqToken.Status                = EFI_NOT_READY;
+  HttpIo->ReqToken.Message->Data.Request = &Connection->RequestData;
+  HttpIo->ReqToken.Message->HeaderCount  = Connection->Header->HeaderCount;
+  HttpIo->ReqToken.Message->Headers      = Connection->Header->Headers;
+  HttpIo->ReqToken.Message->BodyLength   = 0;
+  HttpIo->ReqToken.Message->Body         = NULL;
+
+  //
+  // Only tell the callback about the first request, so the URI is shown once.
+  //
+  if ((Connection->Index == 0) && (Connection->Requests == 0)) {
+    HttpBootHttpIoCallback (HttpIoRequest, HttpIo->ReqToken.Message, Download->Private);
+  }
+
+  Connection->State = HttpBootRangeStateRequest;
+  Connection->Requests++;
+  HttpIo->IsTxDone = FALSE;
+  HttpBootRangeStartTimer (Connection);
+
+  Status = HttpIo->Http->Request (HttpIo->Http, &HttpIo->ReqToken);
+  if (EFI_ERROR (Status)) {
+    HttpBootRangeClose (Download, Connection, Status);
+  }
+}
+
+/**
+  Queue the response token of a connection, to receive either the response
+  header or the rest of the range.
+
+  @param[in, out]  Download        The ranged download.
+  @param[in, out]  Connection      The connection.
+  @param[in]       State           HttpBootRangeStateHeader or HttpBootRangeStateBody.
+
+**/
+VOID
+HttpBootRangeReceive (
+  IN OUT HTTP_BOOT_RANGE_DOWNLOAD    *Download,
+  IN OUT HTTP_BOOT_RANGE_CONNECTION  *Connection,
+  IN     HTTP_BOOT_RANGE_STATE       State
+  )
+{
+  EFI_STATUS  Status;
+  HTTP_IO     *HttpIo;
+
+  HttpIo                                = &Connection->HttpIo;
+  HttpIo->RspToken.Status               = EFI_NOT_READY;
+  HttpIo->RspToken.Message->HeaderCount = 0;
+  HttpIo->RspToken.Message->Headers     = NULL;
+
+  if (State == HttpBootRangeStateHeader) {
+    HttpIo->RspToken.Message->Data.Response = &Connection->ResponseData;
+    HttpIo->RspToken.Message->BodyLength    = 0;
+    HttpIo->RspToken.Message->Body          = NULL;
+  } else {
+    HttpIo->RspToken.Message->Data.Response = NULL;
+    HttpIo->RspToken.Message->BodyLength    = Connection->End - Connection->Offset;
+    HttpIo->RspToken.Message->Body          = Download->Buffer + Connection->Offset;
+  }
+
+  Connection->State = State;
+  HttpIo->IsRxDone  = FALSE;
+  HttpBootRangeStartTimer (Connection);
+
+  Status = HttpIo->Http->Response (HttpIo->Http, &HttpIo->RspToken);
+  if (EFI_ERROR (Status)) {
+    HttpBootRangeClose (Download, Connection, Status);
+  }
+}
+
+/**
+  Check that a response header returns the range the connection asked for,
+  in the form "Content-Range: bytes <start>-<end>/<size>".
+
+  @param[in]  Download        The ranged download.
+  @param[in]  Connection      The connection.
+  @param[in]  Message         The received response header.
+
+  @retval EFI_SUCCESS         The response carries the requested range.
+  @retval EFI_UNSUPPORTED     The server returned something else.
+
+**/
+EFI_STATUS
+HttpBootRangeCheckResponse (
+  IN HTTP_BOOT_RANGE_DOWNLOAD    *Download,
+  IN HTTP_BOOT_RANGE_CONNECTION  *Connection,
+  IN EFI_HTTP_MESSAGE            *Message
+  )
+{
+  EFI_HTTP_HEADER  *HttpHeader;
+  CHAR8            *Value;
+
+  if (Message->Data.Response->StatusCode != HTTP_STATUS_206_PARTIAL_CONTENT) {
+    DEBUG (
+      (DEBUG_WARN,
+       "HttpBootRangeCheckResponse: Connection %d got status code %d instead of a range\n",
+       (UINT32)Connection->Index,
+       Message->Data.Response->StatusCode)
+      );
+    return EFI_UNSUPPORTED;
+  }
+
+  HttpHeader = HttpFindHeader (Message->HeaderCount, Message->Headers, HTTP_HEADER_CONTENT_RANGE);
+  if ((HttpHeader == NULL) || (AsciiStrnCmp (HttpHeader->FieldValue, "bytes ", 6) != 0)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Value = HttpHeader->FieldValue + 6;
+  if (AsciiStrDecimalToUintn (Value) != Connection->Start) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Value = AsciiStrStr (Value, "-");
+  if ((Value == NULL) || (AsciiStrDecimalToUintn (Value + 1) != Connection->End - 1)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Value = AsciiStrStr (Value, "/");
+  if ((Value == NULL) || (AsciiStrDecimalToUintn (Value + 1) != Download->FileSize)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Move a connection to its next state once its queued token completed.
+
+  @param[in, out]  Download        The ranged download.
+  @param[in, out]  Connection      The connection.
+
+  @retval EFI_SUCCESS             The download goes on.
+  @retval Others                  The callback aborted the download.
+
+**/
+EFI_STATUS
+HttpBootRangeProcess (
+  IN OUT HTTP_BOOT_RANGE_DOWNLOAD    *Download,
+  IN OUT HTTP_BOOT_RANGE_CONNECTION  *Connection
+  )
+{
+  EFI_STATUS              Status;
+  HTTP_IO                 *HttpIo;
+  EFI_HTTP_MESSAGE        *Message;
+  HTTP_BOOT_PRIVATE_DATA  *Private;
+  UINTN                   Length;
+
+  HttpIo  = &Connection->HttpIo;
+  Private = Download->Private;
+
+  switch (Connection->State) {
+    case HttpBootRangeStateRequest:
+      if (!HttpIo->IsTxDone) {
+        break;
+      }
+
+      gBS->SetTimer (HttpIo->TimeoutEvent, TimerCancel, 0);
+      if (EFI_ERROR (HttpIo->ReqToken.Status)) {
+        HttpBootRangeClose (Download, Connection, HttpIo->ReqToken.Status);
+        break;
+      }
+
+      HttpBootRangeReceive (Download, Connection, HttpBootRangeStateHeader);
+      break;
+
+    case HttpBootRangeStateHeader:
+      if (!HttpIo->IsRxDone) {
+        break;
+      }
+
+      gBS->SetTimer (HttpIo->TimeoutEvent, TimerCancel, 0);
+      Message = HttpIo->RspToken.Message;
+      Status  = HttpIo->RspToken.Status;
+      if ((Status == EFI_SUCCESS) || (Status == EFI_HTTP_ERROR)) {
+        HttpBootHttpIoCallback (HttpIoResponse, Message, Private);
+        Status = HttpBootRangeCheckResponse (Download, Connection, Message);
+      }
+
+      HttpFreeHeaderFields (Message->Headers, Message->HeaderCount);
+      Message->Headers     = NULL;
+      Message->HeaderCount = 0;
+
+      if (EFI_ERROR (Status)) {
+        HttpBootRangeClose (Download, Connection, Status);
+        break;
+      }
+
+      HttpBootRangeReceive (Download, Connection, HttpBootRangeStateBody);
+      break;
+
+    case HttpBootRangeStateBody:
+      if (!HttpIo->IsRxDone) {
+        break;
+      }
+
+      gBS->SetTimer (HttpIo->TimeoutEvent, TimerCancel, 0);
+      if (EFI_ERROR (HttpIo->RspToken.Status)) {
+        HttpBootRangeClose (Download, Connection, HttpIo->RspToken.Status);
+        break;
+      }
+
+      Length = HttpIo->RspToken.Message->BodyLength;
+      if (Private->HttpBootCallback != NULL) {
+        Status = Private->HttpBootCallback->Callback (
+                                              Private->HttpBootCallback,
+                                              HttpBootHttpEntityBody,
+                                              TRUE,
+                                              (UINT32)Length,
+                                              Download->Buffer + Connection->Offset
+                                              );
+        if (EFI_ERROR (Status)) {
+          return Status;
+        }
+      }
+
+      Connection->Offset        += Length;
+      Connection->BytesReceived += Length;
+      Download->Received        += Length;
+
+      if (Connection->Offset < Connection->End) {
+        HttpBootRangeReceive (Download, Connection, HttpBootRangeStateBody);
+        break;
+      }
+
+      Connection->LastTime = GetPerformanceCounter ();
+      Connection->State    = HttpBootRangeStateIdle;
+      HttpBootRangeSendRequest (Download, Connection);
+      break;
+
+    case HttpBootRangeStateIdle:
+      //
+      // An idle connection picks up the range a failed one left.
+      //
+      HttpBootRangeSendRequest (Download, Connection);
+      break;
+
+    default:
+      break;
+  }
+
+  //
+  // Give up on a token the server doesn't answer in time.
+  //
+  if ((Connection->State != HttpBootRangeStateIdle) && (Connection->State != HttpBootRangeStateClosed) &&
+      !EFI_ERROR (gBS->CheckEvent (HttpIo->TimeoutEvent)))
+  {
+    HttpBootRangeClose (Download, Connection, EFI_TIMEOUT);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Report the throughput of each connection of a ranged download.
+
+  @param[in]  Download        The ranged download.
+  @param[in]  StartTime       Performance counter value when the download started.
+
+**/
+VOID
+HttpBootRangeReport (
+  IN HTTP_BOOT_RANGE_DOWNLOAD  *Download,
+  IN UINT64                    StartTime
+  )
+{
+  HTTP_BOOT_RANGE_CONNECTION  *Connection;
+  UINTN                       Index;
+  UINT64                      Elapsed;
+
+  for (Index = 0; Index < Download->ConnectionCount; Index++) {
+    Connection = &Download->Connections[Index];
+    if (Connection->BytesReceived == 0) {
+      continue;
+    }
+
+    Elapsed = HttpBootRangeElapsed (StartTime, Connection->LastTime);
+    DEBUG (
+      (DEBUG_INFO,
+       "HttpBootRangeReport: Connection %d received %Lu bytes in %d ranges, %Lu KB/s\n",
+       (UINT32)Index,
+       Connection->BytesReceived,
+       Connection->Requests,
+       (Elapsed == 0) ? 0 : DivU64x64Remainder (MultU64x32 (Connection->BytesReceived, 1000), Elapsed, NULL))
+      );
+  }
+
+  Elapsed = HttpBootRangeElapsed (StartTime, GetPerformanceCounter ());
+  DEBUG (
+    (DEBUG_INFO,
+     "HttpBootRangeReport: %Lu of %Lu bytes received over %d connections, %Lu KB/s\n",
+     (UINT64)Download->Received,
+     (UINT64)Download->FileSize,
+     (UINT32)Download->ConnectionCount,
+     (Elapsed == 0) ? 0 : DivU64x64Remainder (MultU64x32 (Download->Received, 1000), Elapsed, NULL))
+    );
+}
+
+/**
+  Download the boot file into Buffer by requesting byte ranges of it over
+  several HTTP connections at once.
+
+  The caller must have checked HttpBootRangeSupported(). When this function
+  fails the content of Buffer is undefined, and the caller should download
+  the file again with HttpBootGetBootFile().
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[in, out]  BufferSize      On input the size of Buffer in bytes. On output with a return
+                                   code of EFI_SUCCESS, the amount of data transferred to Buffer.
+  @param[out]      Buffer          The memory buffer to transfer the file to.
+  @param[out]      ImageType       The image type of the downloaded file.
+
+  @retval EFI_SUCCESS              The file was loaded.
+  @retval EFI_OUT_OF_RESOURCES     Could not allocate needed resources.
+  @retval EFI_UNSUPPORTED          The server didn't return the ranges as requested.
+  @retval Others                   Every connection failed.
+
+**/
+EFI_STATUS
+HttpBootGetBootFileRanged (
+  IN     HTTP_BOOT_PRIVATE_DATA  *Private,
+  IN OUT UINTN                   *BufferSize,
+  OUT UINT8                      *Buffer,
+  OUT HTTP_BOOT_IMAGE_TYPE       *ImageType
+  )
+{
+  EFI_STATUS                  Status;
+  HTTP_BOOT_RANGE_DOWNLOAD    *Download;
+  HTTP_BOOT_RANGE_CONNECTION  *Connection;
+  UINTN                       UrlSize;
+  UINTN                       Index;
+  UINTN                       Count;
+  BOOLEAN                     Busy;
+  UINT64                      StartTime;
+
+  ASSERT (HttpBootRangeSupported (Private, *BufferSize, Buffer));
+
+  Download = AllocateZeroPool (sizeof (HTTP_BOOT_RANGE_DOWNLOAD));
+  if (Download == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  UrlSize       = AsciiStrSize (Private->BootFileUri);
+  Download->Url = AllocatePool (UrlSize * sizeof (CHAR16));
+  if (Download->Url == NULL) {
+    FreePool (Download);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  AsciiStrToUnicodeStrS (Private->BootFileUri, Download->Url, UrlSize);
+
+  //
+  // Use as many connections as the PCD allows, as long as each of them gets
+  // at least one range. Cut the file in a few ranges per connection.
+  //
+  Download->Private   = Private;
+  Download->Buffer    = Buffer;
+  Download->FileSize  = Private->BootFileSize;
+  Count               = MIN (PcdGet8 (PcdHttpBootRangeConnections), HTTP_BOOT_RANGE_MAX_CONNECTIONS);
+  Count               = MIN (Count, Download->FileSize / HTTP_BOOT_RANGE_MIN_SIZE);
+  Download->RangeSize = Download->FileSize / (Count * HTTP_BOOT_RANGE_PER_CONNECTION);
+  Download->RangeSize = MAX (Download->RangeSize, HTTP_BOOT_RANGE_MIN_SIZE);
+  Download->RangeSize = MIN (Download->RangeSize, HTTP_BOOT_RANGE_MAX_SIZE);
+
+  Status = EFI_SUCCESS;
+  for (Index = 0; Index < Count; Index++) {
+    Connection        = &Download->Connections[Download->ConnectionCount];
+    Connection->Index = Index;
+    Connection->State = HttpBootRangeStateClosed;
+
+    Status = HttpBootCreateHttpIoInstance (Private, &Connection->HttpIo);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    Connection->HttpCreated = TRUE;
+    Connection->State       = HttpBootRangeStateIdle;
+    Download->ConnectionCount++;
+
+    Status = HttpBootRangeBuildHeader (Private, &Connection->Header);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+  }
+
+  if (EFI_ERROR (Status) && (Download->ConnectionCount < 2)) {
+    goto ON_EXIT;
+  }
+
+  DEBUG (
+    (DEBUG_INFO,
+     "HttpBootGetBootFileRanged: %Lu bytes over %d connections in ranges of %Lu bytes\n",
+     (UINT64)Download->FileSize,
+     (UINT32)Download->ConnectionCount,
+     (UINT64)Download->RangeSize)
+    );
+
+  //
+  // Queue a request on each connection, then poll them all and move each
+  // connection on as its tokens complete. A connection that finished its
+  // range asks for the next one, until nothing is left to ask for.
+  //
+  StartTime = GetPerformanceCounter ();
+  for (Index = 0; Index < Download->ConnectionCount; Index++) {
+    Connection = &Download->Connections[Index];
+    if (Connection->Header == NULL) {
+      HttpBootRangeClose (Download, Connection, EFI_OUT_OF_RESOURCES);
+      continue;
+    }
+
+    HttpBootRangeSendRequest (Download, Connection);
+  }
+
+  Status = EFI_SUCCESS;
+  do {
+    Busy = FALSE;
+    for (Index = 0; Index < Download->ConnectionCount; Index++) {
+      Connection = &Download->Connections[Index];
+      if ((Connection->State != HttpBootRangeStateIdle) && (Connection->State != HttpBootRangeStateClosed)) {
+        Connection->HttpIo.Http->Poll (Connection->HttpIo.Http);
+      }
+    }
+
+    for (Index = 0; Index < Download->ConnectionCount; Index++) {
+      Connection = &Download->Connections[Index];
+      Status     = HttpBootRangeProcess (Download, Connection);
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+
+      if ((Connection->State != HttpBootRangeStateIdle) && (Connection->State != HttpBootRangeStateClosed)) {
+        Busy = TRUE;
+      }
+    }
+
+    //
+    // A connection that failed late in the pass may have left a range
+    // the idle ones haven't seen yet.
+    //
+    for (Index = 0; Index < Download->ConnectionCount && !Busy && (Download->OrphanCount != 0); Index++) {
+      Busy = (BOOLEAN)(Download->Connections[Index].State == HttpBootRangeStateIdle);
+    }
+  } while (Busy && !EFI_ERROR (Status));
+
+  HttpBootRangeReport (Download, StartTime);
+
+  if (!EFI_ERROR (Status) && (Download->Received != Download->FileSize)) {
+    //
+    // Every connection failed, report why the last one did.
+    //
+    Status = EFI_DEVICE_ERROR;
+    for (Index = 0; Index < Download->ConnectionCount; Index++) {
+      if (EFI_ERROR (Download->Connections[Index].Status)) {
+        Status = Download->Connections[Index].Status;
+      }
+    }
+  }
+
+  if (!EFI_ERROR (Status)) {
+    *BufferSize = Download->FileSize;
+    *ImageType  = Private->ImageType;
+  }
+
+ON_EXIT:
+  for (Index = 0; Index < Download->ConnectionCount; Index++) {
+    HttpBootRangeClose (Download, &Download->Connections[Index], EFI_SUCCESS);
+  }
+
+  FreePool (Download->Url);
+  FreePool (Download);
+  return Status;
+}
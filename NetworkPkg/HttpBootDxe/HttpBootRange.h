@@ -0,0 +1,141 @@
+/** @file
+  Declaration of the parallel ranged boot file download.
+
+Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __EFI_HTTP_BOOT_RANGE_H__
+#define __EFI_HTTP_BOOT_RANGE_H__
+
+//
+// Most connections a ranged download opens, whatever PcdHttpBootRangeConnections says.
+//
+#define HTTP_BOOT_RANGE_MAX_CONNECTIONS  8
+
+//
+// Smallest range requested on a connection. A file shorter than two ranges
+// is downloaded over one connection.
+//
+#define HTTP_BOOT_RANGE_MIN_SIZE  SIZE_1MB
+
+//
+// Largest range requested on a connection. The file is cut into about
+// HTTP_BOOT_RANGE_PER_CONNECTION ranges per connection so a fast connection
+// takes over the ranges a slow one doesn't get to.
+//
+#define HTTP_BOOT_RANGE_MAX_SIZE        SIZE_64MB
+#define HTTP_BOOT_RANGE_PER_CONNECTION  4
+
+typedef enum {
+  HttpBootRangeStateIdle,     ///< No request outstanding, ready for the next range.
+  HttpBootRangeStateRequest,  ///< The GET request token is queued.
+  HttpBootRangeStateHeader,   ///< The response token for the header is queued.
+  HttpBootRangeStateBody,     ///< The response token for the body is queued.
+  HttpBootRangeStateClosed    ///< Nothing left to do, or the connection failed.
+} HTTP_BOOT_RANGE_STATE;
+
+///
+/// One of the connections of a ranged download.
+///
+typedef struct {
+  UINTN                     Index;
+  HTTP_IO                   HttpIo;
+  BOOLEAN                   HttpCreated;
+  HTTP_BOOT_RANGE_STATE     State;
+  EFI_STATUS                Status;     ///< Why the connection was closed.
+
+  //
+  // The range being received, Offset is the next byte to write.
+  //
+  UINTN                     Start;
+  UINTN                     End;
+  UINTN                     Offset;
+
+  HTTP_IO_HEADER            *Header;
+  EFI_HTTP_REQUEST_DATA     RequestData;
+  EFI_HTTP_RESPONSE_DATA    ResponseData;
+
+  //
+  // Statistics reported when the download ends.
+  //
+  UINT64                    BytesReceived;
+  UINT32                    Requests;
+  UINT64                    LastTime;   ///< Performance counter value when the last range was received.
+} HTTP_BOOT_RANGE_CONNECTION;
+
+///
+/// A range whose connection failed before receiving all of it.
+///
+typedef struct {
+  UINTN    Start;
+  UINTN    End;
+} HTTP_BOOT_RANGE;
+
+///
+/// The state shared by the connections of a ranged download.
+///
+typedef struct {
+  HTTP_BOOT_PRIVATE_DATA        *Private;
+  UINT8                         *Buffer;
+  UINTN                         FileSize;
+  UINTN                         RangeSize;
+  UINTN                         NextOffset;   ///< First byte no connection has asked for yet.
+  UINTN                         Received;
+  CHAR16                        *Url;
+
+  HTTP_BOOT_RANGE               Orphans[HTTP_BOOT_RANGE_MAX_CONNECTIONS];
+  UINTN                         OrphanCount;
+
+  UINTN                         ConnectionCount;
+  HTTP_BOOT_RANGE_CONNECTION    Connections[HTTP_BOOT_RANGE_MAX_CONNECTIONS];
+} HTTP_BOOT_RANGE_DOWNLOAD;
+
+/**
+  Check whether the boot file can be downloaded in ranges over several connections.
+
+  @param[in]  Private         The pointer to the driver's private data.
+  @param[in]  BufferSize      The size of Buffer in bytes.
+  @param[in]  Buffer          The memory buffer to transfer the file to.
+
+  @retval TRUE                HttpBootGetBootFileRanged() can be used.
+  @retval FALSE               The file must be downloaded with HttpBootGetBootFile().
+
+**/
+BOOLEAN
+HttpBootRangeSupported (
+  IN     HTTP_BOOT_PRIVATE_DATA  *Private,
+  IN     UINTN                   BufferSize,
+  IN     VOID                    *Buffer
+  );
+
+/**
+  Download the boot file into Buffer by requesting byte ranges of it over
+  several HTTP connections at once.
+
+  The caller must have checked HttpBootRangeSupported(). When this function
+  fails the content of Buffer is undefined, and the caller should download
+  the file again with HttpBootGetBootFile().
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[in, out]  BufferSize      On input the size of Buffer in bytes. On output with a return
+                                   code of EFI_SUCCESS, the amount of data transferred to Buffer.
+  @param[out]      Buffer          The memory buffer to transfer the file to.
+  @param[out]      ImageType       The image type of the downloaded file.
+
+  @retval EFI_SUCCESS              The file was loaded.
+  @retval EFI_OUT_OF_RESOURCES     Could not allocate needed resources.
+  @retval EFI_UNSUPPORTED          The server didn't return the ranges as requested.
+  @retval Others                   Every connection failed.
+
+**/
+EFI_STATUS
+HttpBootGetBootFileRanged (
+  IN     HTTP_BOOT_PRIVATE_DATA  *Private,
+  IN OUT UINTN                   *BufferSize,
+  OUT UINT8                      *Buffer,
+  OUT HTTP_BOOT_IMAGE_TYPE       *ImageType
+  );
+
+#endif
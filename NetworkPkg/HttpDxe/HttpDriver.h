@@ -53,6 +53,7 @@
 #include <Protocol/HttpCallback.h>
 
 #include <Guid/ImageAuthentication.h>
+#include <Guid/NetworkStatistics.h>
 //
 // Produced Protocols
 //
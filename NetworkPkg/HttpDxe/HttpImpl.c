@@ -1430,6 +1430,9 @@ HttpResponseWorker (
         }
       }
 
+      HttpInstance->Stats.BodyBytes       += HttpMsg->BodyLength;
+      HttpInstance->Stats.BodyCopiedBytes += HttpMsg->BodyLength;
+
       //
       // Return since we already received required data.
       //
@@ -1537,6 +1540,9 @@ HttpResponseWorker (
       HttpMsg->BodyLength = HttpInstance->NextMsg - (CHAR8 *)HttpMsg->Body;
     }
 
+    HttpInstance->Stats.BodyBytes       += HttpMsg->BodyLength;
+    HttpInstance->Stats.BodyCopiedBytes += HttpMsg->BodyLength;
+
     HttpInstance->CacheLen = Fragment.Len - HttpMsg->BodyLength;
     if (HttpInstance->CacheLen != 0) {
       if (HttpInstance->CacheBody != NULL) {
@@ -11,6 +11,11 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "HttpDriver.h"
 
+//
+// The HttpStatsXXXX variable the next statistics are published in.
+//
+STATIC UINT16  mHttpStatisticsIndex = 0;
+
 /**
   The common notify function used in HTTP driver.
 
@@ -237,6 +242,8 @@ HttpTcpReceiveNotifyDpc (
     }
   }
 
+  HttpInstance->Stats.BodyBytes += Wrap->HttpToken->Message->BodyLength;
+
   Item = NetMapFindKey (&Wrap->HttpInstance->RxTokens, Wrap->HttpToken);
   if (Item != NULL) {
     NetMapRemoveItem (&Wrap->HttpInstance->RxTokens, Item, NULL);
@@ -811,6 +818,45 @@ ON_ERROR:
   return EFI_UNSUPPORTED;
 }
 
+/**
+  Publish the receive statistics of an HTTP child in the next HttpStatsXXXX
+  variable, see Guid/NetworkStatistics.h.
+
+  @param[in, out]  HttpInstance       The HTTP child.
+
+**/
+VOID
+HttpPublishStatistics (
+  IN OUT HTTP_PROTOCOL  *HttpInstance
+  )
+{
+  HTTP_STATISTICS  *Stats;
+  CHAR16           Index[sizeof ("XXXX")];
+
+  Stats = &HttpInstance->Stats;
+
+  //
+  // Nothing to publish if the child never returned a message-body.
+  //
+  if (Stats->BodyBytes == 0) {
+    return;
+  }
+
+  DEBUG (
+    (DEBUG_NET,
+     "HttpPublishStatistics: %Lu body bytes received, %Lu of them copied from the cache or TLS records.\n",
+     Stats->BodyBytes,
+     Stats->BodyCopiedBytes)
+    );
+
+  UnicodeSPrint (Index, sizeof (Index), L"%04x", mHttpStatisticsIndex);
+  NetLibPublishStatistics (EDKII_HTTP_STATISTICS_VARIABLE_PREFIX, Index, Stats, sizeof (HTTP_STATISTICS));
+
+  mHttpStatisticsIndex = (UINT16)((mHttpStatisticsIndex + 1) % HTTP_STATISTICS_VARIABLES);
+
+  ZeroMem (Stats, sizeof (HTTP_STATISTICS));
+}
+
 /**
   Clean up the HTTP child, release all the resources used by it.
 
@@ -831,6 +877,8 @@ HttpCleanProtocol (
     HttpInstance->TimeoutEvent = NULL;
   }
 
+  HttpPublishStatistics (HttpInstance);
+
   if (HttpInstance->CacheBody != NULL) {
     FreePool (HttpInstance->CacheBody);
     HttpInstance->CacheBody = NULL;
@@ -49,6 +49,12 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #define HTTP_URL_BUFFER_LEN  4096
 
+//
+// Number of HttpStatsXXXX variables the statistics of cleaned up
+// children are published in, round robin.
+//
+#define HTTP_STATISTICS_VARIABLES  16
+
 typedef struct _HTTP_SERVICE {
   UINT32                          Signature;
   EFI_SERVICE_BINDING_PROTOCOL    ServiceBinding;
@@ -148,6 +154,13 @@ typedef struct _HTTP_PROTOCOL {
   UINTN                             CacheLen;
   UINTN                             CacheOffset;
 
+  //
+  // Message-body bytes returned to the caller, and how many of them
+  // were copied from the cache or a TLS record rather than received
+  // by TCP straight into the caller's buffer.
+  //
+  HTTP_STATISTICS                   Stats;
+
   //
   // HTTP message-body parser.
   //
@@ -332,6 +345,18 @@ HttpInitProtocol (
   IN     BOOLEAN        IpVersion
   );
 
+/**
+  Publish the receive statistics of an HTTP child in the next HttpStatsXXXX
+  variable, see Guid/NetworkStatistics.h.
+
+  @param[in, out]  HttpInstance       The HTTP child.
+
+**/
+VOID
+HttpPublishStatistics (
+  IN OUT HTTP_PROTOCOL  *HttpInstance
+  );
+
 /**
   Clean up the HTTP child, release all the resources used by it.
 
@@ -0,0 +1,113 @@
+/** @file
+  This file defines the vendor GUID and the layout of the volatile variables
+  the network drivers publish their statistics in.
+
+  The variables have EFI_VARIABLE_BOOTSERVICE_ACCESS only, and can be dumped
+  from the shell with "dmpstore -guid 1791c12b-e952-4b46-bc19-1921112b5343".
+  Each variable is named by the prefix of its layout followed by the instance
+  the statistics belong to.
+
+Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __NETWORK_STATISTICS_H__
+#define __NETWORK_STATISTICS_H__
+
+#define EDKII_NETWORK_STATISTICS_GUID \
+  { \
+    0x1791c12b, 0xe952, 0x4b46, { 0xbc, 0x19, 0x19, 0x21, 0x11, 0x2b, 0x53, 0x43 } \
+  }
+
+//
+// TcpStatsXXXX, the statistics of a closed TCP connection. XXXX is a
+// four digit hexadecimal index, the variables are reused round robin.
+//
+#define EDKII_TCP_STATISTICS_VARIABLE_PREFIX  L"TcpStats"
+
+///
+/// Statistics of one TCP connection.
+///
+typedef struct _TCP_STATISTICS {
+  EFI_IP_ADDRESS    LocalIp;           ///< Local IP address.
+  EFI_IP_ADDRESS    RemoteIp;          ///< Remote IP address.
+  UINT16            LocalPort;         ///< Local port, in host byte order.
+  UINT16            RemotePort;        ///< Remote port, in host byte order.
+  UINT8             IpVersion;         ///< 4 for IPv4, 6 for IPv6.
+  UINT8             CongestionControl; ///< 0 for NewReno, 1 for CUBIC.
+  BOOLEAN           Sack;              ///< TRUE if SACK was used.
+  UINT8             Reserved;
+  UINT64            SegmentsSent;      ///< Segments sent, including retransmits.
+  UINT64            SegmentsReceived;  ///< Segments received for this connection.
+  UINT64            BytesSent;         ///< Data bytes sent, including retransmits.
+  UINT64            BytesReceived;     ///< Data bytes received.
+  UINT64            BytesCopied;       ///< Data bytes copied to the application's buffers.
+  UINT32            Retransmits;       ///< Segments retransmitted.
+  UINT32            FastRetransmits;   ///< Fast recoveries entered.
+  UINT32            SackRetransmits;   ///< Holes retransmitted from the scoreboard.
+  UINT32            Timeouts;          ///< Retransmission timeouts.
+  UINT32            SRtt;              ///< Smoothed RTT, in milliseconds.
+  UINT32            RttVar;            ///< RTT variance, in milliseconds.
+  UINT32            CWnd;              ///< Congestion window, in bytes.
+  UINT32            MaxCWnd;           ///< Largest congestion window, in bytes.
+  UINT32            Ssthresh;          ///< Slow start threshold, in bytes.
+} TCP_STATISTICS;
+
+//
+// MnpStats followed by the MAC address string, the receive statistics of
+// an MNP device.
+//
+#define EDKII_MNP_STATISTICS_VARIABLE_PREFIX  L"MnpStats"
+
+///
+/// Receive statistics of one MNP device, gathered from its start until its
+/// last child is unconfigured.
+///
+typedef struct {
+  UINT64    RxPackets;           ///< Frames received from the SNP.
+  UINT64    RxBytes;             ///< Bytes the SNP copied into the receive buffers.
+  UINT64    RxQueueDrops;        ///< Frames dropped because a child's receive queue was full.
+  UINT64    RxTimeoutDrops;      ///< Frames dropped because the receive queue timeout expired.
+  UINT64    SystemPolls;         ///< Runs of the system poll timer.
+  UINT64    IdlePolls;           ///< System polls that found no frame.
+  UINT32    MaxBatch;            ///< Most frames drained by one system poll.
+  UINT32    MinPollInterval;     ///< Shortest system poll interval used, in 100ns units.
+} MNP_STATISTICS;
+
+//
+// Ip4Stats followed by the MAC address string, the receive statistics of
+// an IP4 service.
+//
+#define EDKII_IP4_STATISTICS_VARIABLE_PREFIX  L"Ip4Stats"
+
+///
+/// Receive statistics of an IP4 service. They show how much of the
+/// delivered data had to be copied because several children shared it.
+///
+typedef struct {
+  UINT64    RxPackets;       ///< Packets delivered to the children.
+  UINT64    RxBytes;         ///< Bytes delivered to the children.
+  UINT64    RxSharedPackets; ///< Deliveries of a packet shared with other children.
+  UINT64    RxCopiedBytes;   ///< Bytes copied to deliver the shared packets.
+} IP4_STATISTICS;
+
+//
+// HttpStatsXXXX, the receive statistics of a cleaned up HTTP child. XXXX
+// is a four digit hexadecimal index, the variables are reused round robin.
+//
+#define EDKII_HTTP_STATISTICS_VARIABLE_PREFIX  L"HttpStats"
+
+///
+/// Receive statistics of one HTTP child. They show how much of the
+/// message-body had to be copied rather than received by TCP straight
+/// into the caller's buffer.
+///
+typedef struct {
+  UINT64    BodyBytes;       ///< Message-body bytes returned to the caller.
+  UINT64    BodyCopiedBytes; ///< Bytes of them copied from the cache or a TLS record.
+} HTTP_STATISTICS;
+
+extern EFI_GUID  gEdkiiNetworkStatisticsGuid;
+
+#endif
@@ -411,6 +411,8 @@ Ip4CleanService (
 
   IpSb->State = IP4_SERVICE_DESTROY;
 
+  Ip4PublishStatistics (IpSb);
+
   if (IpSb->Timer != NULL) {
     gBS->SetTimer (IpSb->Timer, TimerCancel, 0);
     gBS->CloseEvent (IpSb->Timer);
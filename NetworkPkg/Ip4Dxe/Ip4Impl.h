@@ -24,6 +24,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include <IndustryStandard/Dhcp.h>
 
+#include <Guid/NetworkStatistics.h>
+
 #include <Library/DebugLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
 #include <Library/UefiDriverEntryPoint.h>
@@ -216,6 +218,8 @@ struct _IP4_SERVICE {
 
   UINT32                             MaxPacketSize;
   UINT32                             OldMaxPacketSize; ///< The MTU before IPsec enable.
+
+  IP4_STATISTICS                     Stats;
 };
 
 #define IP4_INSTANCE_FROM_PROTOCOL(Ip4) \
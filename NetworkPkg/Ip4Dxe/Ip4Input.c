@@ -1285,7 +1285,11 @@ Ip4InstanceDeliverPacket (
       RemoveEntryList (&Packet->List);
     } else {
       //
-      // Create a duplicated packet if this packet is shared
+      // Create a private view of the packet if it is shared. Only the IP
+      // head is converted in place by Ip4WrapRxData, so the new NET_BUF
+      // gets its own copy of the head and shares the payload blocks with
+      // the other instances. A packet without payload can't be viewed
+      // by NetbufGetFragment, duplicate it instead.
       //
       if (IpInstance->ConfigData.RawData) {
         HeadLen = 0;
@@ -1293,12 +1297,21 @@ Ip4InstanceDeliverPacket (
         HeadLen = IP4_MAX_HEADLEN;
       }
 
-      Dup = NetbufDuplicate (Packet, NULL, HeadLen);
+      if (Packet->TotalSize == 0) {
+        Dup = NetbufDuplicate (Packet, NULL, HeadLen);
+      } else {
+        Dup = NetbufGetFragment (Packet, 0, Packet->TotalSize, HeadLen);
+        if (Dup != NULL) {
+          CopyMem (Dup->ProtoData, Packet->ProtoData, NET_PROTO_DATA);
+        }
+      }
 
       if (Dup == NULL) {
         return EFI_OUT_OF_RESOURCES;
       }
 
+      IpInstance->Service->Stats.RxSharedPackets++;
+
       if (!IpInstance->ConfigData.RawData) {
         //
         // Copy the IP head over. The packet to deliver up is
@@ -1312,6 +1325,8 @@ Ip4InstanceDeliverPacket (
 
         CopyMem (Head, Packet->Ip.Ip4, Packet->Ip.Ip4->HeadLen << 2);
         NetbufTrim (Dup, IP4_MAX_HEADLEN, TRUE);
+
+        IpInstance->Service->Stats.RxCopiedBytes += Packet->Ip.Ip4->HeadLen << 2;
       }
 
       Wrap = Ip4WrapRxData (IpInstance, Dup);
@@ -1339,6 +1354,9 @@ Ip4InstanceDeliverPacket (
     Token->Status        = IP4_GET_CLIP_INFO (Packet)->Status;
     Token->Packet.RxData = &Wrap->RxData;
 
+    IpInstance->Service->Stats.RxPackets++;
+    IpInstance->Service->Stats.RxBytes += Packet->TotalSize;
+
     gBS->SignalEvent (Token->Event);
   }
 
@@ -1604,3 +1622,38 @@ Ip4PacketTimerTicking (
     NetMapIterate (&IpInstance->TxTokens, Ip4SentPacketTicking, NULL);
   }
 }
+
+/**
+  Publish the receive statistics of an IP4 service in the Ip4Stats variable
+  of its MAC address string, see Guid/NetworkStatistics.h.
+
+  @param[in, out]  IpSb          The IP4 service instance.
+
+**/
+VOID
+Ip4PublishStatistics (
+  IN OUT IP4_SERVICE  *IpSb
+  )
+{
+  IP4_STATISTICS  *Stats;
+
+  Stats = &IpSb->Stats;
+
+  if ((Stats->RxPackets == 0) || (IpSb->MacString == NULL)) {
+    return;
+  }
+
+  DEBUG (
+    (DEBUG_NET,
+     "Ip4PublishStatistics: %S delivered %Lu bytes in %Lu packets, %Lu shared, %Lu bytes copied.\n",
+     IpSb->MacString,
+     Stats->RxBytes,
+     Stats->RxPackets,
+     Stats->RxSharedPackets,
+     Stats->RxCopiedBytes)
+    );
+
+  NetLibPublishStatistics (EDKII_IP4_STATISTICS_VARIABLE_PREFIX, IpSb->MacString, Stats, sizeof (IP4_STATISTICS));
+
+  ZeroMem (Stats, sizeof (IP4_STATISTICS));
+}
@@ -243,4 +243,16 @@ Ip4IpSecProcessPacket (
   IN     VOID                   *Context
   );
 
+/**
+  Publish the receive statistics of an IP4 service in the Ip4Stats variable
+  of its MAC address string, see Guid/NetworkStatistics.h.
+
+  @param[in, out]  IpSb          The IP4 service instance.
+
+**/
+VOID
+Ip4PublishStatistics (
+  IN OUT IP4_SERVICE  *IpSb
+  );
+
 #endif
@@ -21,6 +21,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Protocol/ComponentName2.h>
 
 #include <Guid/SmBios.h>
+#include <Guid/NetworkStatistics.h>
 
 #include <Library/NetLib.h>
 #include <Library/BaseLib.h>
@@ -3474,3 +3475,55 @@ NetLibCreateDnsQName (
 
   return QueryName;
 }
+
+/**
+  Publish the statistics of a network driver in a volatile variable with the
+  gEdkiiNetworkStatisticsGuid vendor GUID, so they can be dumped from the
+  shell with dmpstore. The variable is named by Prefix followed by Instance.
+
+  If Prefix, Instance or Statistics is NULL, then ASSERT().
+
+  @param[in]  Prefix            The variable name prefix of the statistics layout,
+                                see Guid/NetworkStatistics.h.
+  @param[in]  Instance          The instance the statistics belong to, such as
+                                a MAC address string.
+  @param[in]  Statistics        The statistics to publish.
+  @param[in]  StatisticsSize    The size of Statistics in bytes.
+
+  @retval EFI_SUCCESS           The statistics were published.
+  @retval EFI_OUT_OF_RESOURCES  Failed to allocate the variable name.
+  @return Others                The status of SetVariable().
+
+**/
+EFI_STATUS
+EFIAPI
+NetLibPublishStatistics (
+  IN CONST CHAR16  *Prefix,
+  IN CONST CHAR16  *Instance,
+  IN CONST VOID    *Statistics,
+  IN UINTN         StatisticsSize
+  )
+{
+  EFI_STATUS  Status;
+  CHAR16      *VariableName;
+
+  ASSERT (Prefix != NULL);
+  ASSERT (Instance != NULL);
+  ASSERT (Statistics != NULL);
+
+  VariableName = CatSPrint (NULL, L"%s%s", Prefix, Instance);
+  if (VariableName == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = gRT->SetVariable (
+                  VariableName,
+                  &gEdkiiNetworkStatisticsGuid,
+                  EFI_VARIABLE_BOOTSERVICE_ACCESS,
+                  StatisticsSize,
+                  (VOID *)Statistics
+                  );
+
+  FreePool (VariableName);
+  return Status;
+}
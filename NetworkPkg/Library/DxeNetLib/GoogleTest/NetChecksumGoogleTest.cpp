@@ -0,0 +1,443 @@
+/** @file
+  Host based unit test and benchmark for the checksum kernels in NetChecksum.c.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+extern "C" {
+  #include <Uefi.h>
+  #include <Library/BaseLib.h>
+  #include <Library/DebugLib.h>
+  #include <Library/NetLib.h>
+  #include <Library/UnitTestHostBaseLib.h>
+  #include "../NetChecksum.h"
+}
+
+//
+// MDE_CPU_X64 comes from ProcessorBind.h, so the intrinsics can only be
+// selected once Uefi.h has been included.
+//
+#if defined (MDE_CPU_X64)
+  #if defined (_MSC_VER)
+    #include <intrin.h>
+  #else
+    #include <cpuid.h>
+  #endif
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//
+// The largest buffer the kernels are compared on. The reference adds into
+// a 32-bit accumulator, which stays exact up to 128 KB.
+//
+#define CHECKSUM_MAX_LEN  (64 * 1024 + 64)
+
+//
+// The buffers are offset by up to this many bytes to cover every alignment
+// of the vector loads.
+//
+#define CHECKSUM_MAX_OFFSET  32
+
+//
+// Bytes summed by each kernel for each length in the benchmark.
+//
+#define CHECKSUM_BENCHMARK_BYTES  (8 * 1024 * 1024)
+
+typedef UINT64 (EFIAPI *CHECKSUM_KERNEL)(
+  IN CONST UINT8  *Bulk,
+  IN UINTN        Len
+  );
+
+typedef struct {
+  const char         *Name;
+  CHECKSUM_KERNEL    Kernel;
+  UINTN              BlockSize;
+} CHECKSUM_KERNEL_ENTRY;
+
+////////////////////////////////////////////////////////////////////////////////
+// Helpers
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined (MDE_CPU_X64)
+
+/**
+  Execute CPUID on the host, so that the AVX2 probe sees the real processor
+  instead of the UnitTestHostBaseLib emulation.
+**/
+static
+UINT32
+EFIAPI
+HostAsmCpuidEx (
+  IN  UINT32  Index,
+  IN  UINT32  SubIndex,
+  OUT UINT32  *Eax OPTIONAL,
+  OUT UINT32  *Ebx OPTIONAL,
+  OUT UINT32  *Ecx OPTIONAL,
+  OUT UINT32  *Edx OPTIONAL
+  )
+{
+  UINT32  Regs[4];
+
+ #if defined (_MSC_VER)
+  __cpuidex ((int *)Regs, (int)Index, (int)SubIndex);
+ #else
+  __cpuid_count (Index, SubIndex, Regs[0], Regs[1], Regs[2], Regs[3]);
+ #endif
+
+  if (Eax != NULL) {
+    *Eax = Regs[0];
+  }
+
+  if (Ebx != NULL) {
+    *Ebx = Regs[1];
+  }
+
+  if (Ecx != NULL) {
+    *Ecx = Regs[2];
+  }
+
+  if (Edx != NULL) {
+    *Edx = Regs[3];
+  }
+
+  return Index;
+}
+
+static
+UINT32
+EFIAPI
+HostAsmCpuid (
+  IN  UINT32  Index,
+  OUT UINT32  *Eax OPTIONAL,
+  OUT UINT32  *Ebx OPTIONAL,
+  OUT UINT32  *Ecx OPTIONAL,
+  OUT UINT32  *Edx OPTIONAL
+  )
+{
+  return HostAsmCpuidEx (Index, 0, Eax, Ebx, Ecx, Edx);
+}
+
+/**
+  Execute XGETBV on the host. The probe only calls it once CPUID reported
+  OSXSAVE, so the instruction is always available.
+**/
+static
+UINT64
+EFIAPI
+HostAsmXGetBv (
+  IN UINT32  Index
+  )
+{
+ #if defined (_MSC_VER)
+  return _xgetbv (Index);
+ #else
+  UINT32  Low;
+  UINT32  High;
+
+  __asm__ __volatile__ ("xgetbv" : "=a" (Low), "=d" (High) : "c" (Index));
+  return ((UINT64)High << 32) | Low;
+ #endif
+}
+
+#endif
+
+/**
+  The word-by-word NetblockChecksum the kernels replaced.
+**/
+static
+UINT16
+ReferenceChecksum (
+  IN UINT8   *Bulk,
+  IN UINT32  Len
+  )
+{
+  UINT32  Sum;
+
+  Sum = 0;
+
+  if (Len % 2 != 0) {
+    Sum += *(Bulk + Len - 1);
+  }
+
+  while (Len > 1) {
+    Sum  += ReadUnaligned16 ((UINT16 *)Bulk);
+    Bulk += 2;
+    Len  -= 2;
+  }
+
+  while ((Sum >> 16) != 0) {
+    Sum = (Sum & 0xffff) + (Sum >> 16);
+  }
+
+  return (UINT16)Sum;
+}
+
+/**
+  Run one kernel the way InternalNetChecksum does: the kernel sums the
+  whole blocks and the portable kernel sums the rest.
+**/
+static
+UINT16
+KernelChecksum (
+  IN CONST CHECKSUM_KERNEL_ENTRY  *Entry,
+  IN UINT8                        *Bulk,
+  IN UINT32                       Len
+  )
+{
+  UINTN   Head;
+  UINT64  Sum;
+  UINT64  Tail;
+
+  if (Entry->BlockSize == 0) {
+    return InternalNetChecksumFold (Entry->Kernel (Bulk, Len));
+  }
+
+  Head = Len & ~(Entry->BlockSize - 1);
+  Sum  = Entry->Kernel (Bulk, Head);
+  Tail = InternalNetChecksum64 (Bulk + Head, Len - Head);
+  Sum += Tail;
+  if (Sum < Tail) {
+    Sum++;
+  }
+
+  return InternalNetChecksumFold (Sum);
+}
+
+/**
+  List the kernels this processor can run.
+**/
+static
+std::vector<CHECKSUM_KERNEL_ENTRY>
+AvailableKernels (
+  )
+{
+  std::vector<CHECKSUM_KERNEL_ENTRY>  Kernels;
+
+  Kernels.push_back ({ "C64", InternalNetChecksum64, 0 });
+ #if defined (MDE_CPU_X64)
+  Kernels.push_back ({ "SSE2", InternalNetChecksumSse2, NET_CHECKSUM_SSE2_BLOCK });
+  if (InternalNetChecksumAvx2Supported ()) {
+    Kernels.push_back ({ "AVX2", InternalNetChecksumAvx2, NET_CHECKSUM_AVX2_BLOCK });
+  }
+ #elif defined (MDE_CPU_AARCH64)
+  Kernels.push_back ({ "NEON", InternalNetChecksumNeon, NET_CHECKSUM_NEON_BLOCK });
+ #endif
+  return Kernels;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// NetblockChecksum Tests
+////////////////////////////////////////////////////////////////////////////////
+
+class NetChecksumTest : public ::testing::Test {
+protected:
+  std::vector<UINT8> Buffer;
+  std::vector<CHECKSUM_KERNEL_ENTRY> Kernels;
+ #if defined (MDE_CPU_X64)
+  UNIT_TEST_HOST_BASE_LIB_X86 SavedX86;
+ #endif
+
+  virtual void
+  SetUp (
+    )
+  {
+ #if defined (MDE_CPU_X64)
+    //
+    // Probe the host processor, and have NetblockChecksum probe it again,
+    // so that the AVX2 kernel runs wherever the host supports it.
+    //
+    SavedX86                             = *gUnitTestHostBaseLib.X86;
+    gUnitTestHostBaseLib.X86->AsmCpuid   = HostAsmCpuid;
+    gUnitTestHostBaseLib.X86->AsmCpuidEx = HostAsmCpuidEx;
+    gUnitTestHostBaseLib.X86->AsmXGetBv  = HostAsmXGetBv;
+    mNetChecksumAvx2                     = NET_CHECKSUM_AVX2_UNKNOWN;
+ #endif
+    Buffer.resize (CHECKSUM_MAX_LEN + CHECKSUM_MAX_OFFSET);
+    Kernels = AvailableKernels ();
+  }
+
+  virtual void
+  TearDown (
+    )
+  {
+ #if defined (MDE_CPU_X64)
+    *gUnitTestHostBaseLib.X86 = SavedX86;
+    mNetChecksumAvx2          = NET_CHECKSUM_AVX2_UNKNOWN;
+ #endif
+  }
+
+  void
+  FillRandom (
+    UINT32  Seed
+    )
+  {
+    for (size_t Index = 0; Index < Buffer.size (); Index++) {
+      Seed          = Seed * 1103515245 + 12345;
+      Buffer[Index] = (UINT8)(Seed >> 16);
+    }
+  }
+
+  void
+  FillPattern (
+    UINT8  Value
+    )
+  {
+    std::fill (Buffer.begin (), Buffer.end (), Value);
+  }
+
+  void
+  CompareAll (
+    UINT32  Len
+    )
+  {
+    for (UINT32 Offset = 0; Offset < CHECKSUM_MAX_OFFSET; Offset++) {
+      UINT16  Expected = ReferenceChecksum (&Buffer[Offset], Len);
+
+      ASSERT_EQ (NetblockChecksum (&Buffer[Offset], Len), Expected) << "Len " << Len << " Offset " << Offset;
+      for (const CHECKSUM_KERNEL_ENTRY &Entry : Kernels) {
+        ASSERT_EQ (KernelChecksum (&Entry, &Buffer[Offset], Len), Expected) << Entry.Name << " Len " << Len << " Offset " << Offset;
+      }
+    }
+  }
+};
+
+// Every length up to a few vector blocks, on random data
+TEST_F (NetChecksumTest, ShortBuffersMatchReference) {
+  FillRandom (1);
+  for (UINT32 Len = 0; Len <= 1024; Len++) {
+    CompareAll (Len);
+  }
+}
+
+// Packet sized buffers, on random data
+TEST_F (NetChecksumTest, LongBuffersMatchReference) {
+  static const UINT32  Lens[] = { 1499, 1500, 4095, 4096, 9000, 9001, 32768, 65535, 65536, CHECKSUM_MAX_LEN };
+
+  FillRandom (2);
+  for (UINT32 Len : Lens) {
+    CompareAll (Len);
+  }
+}
+
+// All-ones data carries out of every word
+TEST_F (NetChecksumTest, AllOnesMatchReference) {
+  FillPattern (0xff);
+  for (UINT32 Len = 0; Len <= 256; Len++) {
+    CompareAll (Len);
+  }
+
+  CompareAll (65535);
+  CompareAll (CHECKSUM_MAX_LEN);
+}
+
+// The sum of all-zero data must stay 0, not become 0xffff
+TEST_F (NetChecksumTest, AllZerosMatchReference) {
+  FillPattern (0);
+  for (UINT32 Len = 0; Len <= 256; Len++) {
+    CompareAll (Len);
+  }
+
+  CompareAll (CHECKSUM_MAX_LEN);
+}
+
+// The vector kernels flush their narrow lanes every 0x8000 blocks
+TEST_F (NetChecksumTest, KernelsDoNotOverflow) {
+  std::vector<UINT8>  Large (4 * 1024 * 1024 + 7, 0xff);
+  UINT64              Sum;
+  UINT32              Len;
+
+  Len = (UINT32)Large.size ();
+  Sum = InternalNetChecksum64 (&Large[0], Len);
+  for (const CHECKSUM_KERNEL_ENTRY &Entry : Kernels) {
+    EXPECT_EQ (KernelChecksum (&Entry, &Large[0], Len), InternalNetChecksumFold (Sum)) << Entry.Name;
+  }
+
+  EXPECT_EQ (NetblockChecksum (&Large[0], Len), InternalNetChecksumFold (Sum));
+}
+
+#if defined (MDE_CPU_X64) && (defined (__GNUC__) || defined (__clang__))
+
+// The probe must agree with the compiler's view of the host processor
+TEST_F (NetChecksumTest, Avx2ProbeMatchesHost) {
+  __builtin_cpu_init ();
+  EXPECT_EQ (InternalNetChecksumAvx2Supported (), __builtin_cpu_supports ("avx2") != 0);
+}
+
+#endif
+
+#if defined (MDE_CPU_X64)
+
+// NetblockChecksum falls back to SSE2 when AVX2 is disabled or in use
+TEST_F (NetChecksumTest, DispatchWithoutAvx2MatchesReference) {
+  FillRandom (3);
+
+  mNetChecksumAvx2 = NET_CHECKSUM_AVX2_DISABLED;
+  CompareAll (1500);
+  CompareAll (CHECKSUM_MAX_LEN);
+
+  mNetChecksumAvx2     = NET_CHECKSUM_AVX2_UNKNOWN;
+  mNetChecksumAvx2Busy = TRUE;
+  CompareAll (1500);
+  CompareAll (CHECKSUM_MAX_LEN);
+  mNetChecksumAvx2Busy = FALSE;
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Benchmark
+////////////////////////////////////////////////////////////////////////////////
+
+class NetChecksumBenchmark : public NetChecksumTest {
+};
+
+// Reports the throughput of each kernel, it doesn't fail on slow results.
+// Each column sums CHECKSUM_BENCHMARK_BYTES, so the test stays short.
+TEST_F (NetChecksumBenchmark, Throughput) {
+  static const UINT32  Lens[] = { 64, 256, 1024, 1500, 4096, 16384, 65536 };
+  volatile UINT16      Sink;
+
+  FillPattern (0x5a);
+  Sink = 0;
+
+  std::printf ("%8s %10s", "Bytes", "Reference");
+  for (const CHECKSUM_KERNEL_ENTRY &Entry : Kernels) {
+    std::printf (" %10s", Entry.Name);
+  }
+
+  std::printf (" %10s  (GB/s)\n", "Dispatch");
+
+  for (UINT32 Len : Lens) {
+    UINT32  Iterations = CHECKSUM_BENCHMARK_BYTES / Len;
+
+    std::printf ("%8u", Len);
+    for (size_t Index = 0; Index < Kernels.size () + 2; Index++) {
+      auto  Start = std::chrono::steady_clock::now ();
+
+      for (UINT32 Round = 0; Round < Iterations; Round++) {
+        if (Index == 0) {
+          Sink = Sink + ReferenceChecksum (&Buffer[0], Len);
+        } else if (Index <= Kernels.size ()) {
+          Sink = Sink + KernelChecksum (&Kernels[Index - 1], &Buffer[0], Len);
+        } else {
+          Sink = Sink + NetblockChecksum (&Buffer[0], Len);
+        }
+      }
+
+      std::chrono::duration<double>  Elapsed = std::chrono::steady_clock::now () - Start;
+
+      std::printf (" %10.2f", (double)Iterations * Len / Elapsed.count () / 1e9);
+    }
+
+    std::printf ("\n");
+  }
+}
@@ -0,0 +1,226 @@
+/** @file
+  Internet checksum kernels used by NetblockChecksum.
+
+  The portable kernel adds 32-bit words into a 64-bit accumulator, which
+  has the same one's complement sum as adding 16-bit words since 2^16 is
+  1 modulo 0xFFFF. On X64 the bulk of the buffer is summed with SSE2, or
+  with AVX2 when the processor supports it, and on AARCH64 with NEON.
+
+Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+
+#if defined (MDE_CPU_X64)
+  #include <Register/Intel/Cpuid.h>
+#endif
+
+#include "NetChecksum.h"
+
+#if defined (MDE_CPU_X64)
+
+//
+// Whether the AVX2 kernel may be used, probed on the first call.
+//
+UINT8  mNetChecksumAvx2 = NET_CHECKSUM_AVX2_UNKNOWN;
+
+//
+// The exception handlers only save the XMM state, so a checksum computed
+// by an event that interrupts the AVX2 kernel would corrupt the upper half
+// of its YMM accumulators. Such a nested call uses the SSE2 kernel instead.
+//
+volatile BOOLEAN  mNetChecksumAvx2Busy = FALSE;
+
+/**
+  Check whether the processor and the firmware allow AVX2 instructions.
+
+  @retval TRUE     AVX2 is supported and the YMM state is enabled in XCR0.
+  @retval FALSE    AVX2 can't be used.
+
+**/
+BOOLEAN
+InternalNetChecksumAvx2Supported (
+  VOID
+  )
+{
+  UINT32                                       MaxLeaf;
+  CPUID_VERSION_INFO_ECX                       VersionEcx;
+  CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS_EBX  ExtendedEbx;
+
+  AsmCpuid (CPUID_SIGNATURE, &MaxLeaf, NULL, NULL, NULL);
+  if (MaxLeaf < CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS) {
+    return FALSE;
+  }
+
+  AsmCpuid (CPUID_VERSION_INFO, NULL, NULL, &VersionEcx.Uint32, NULL);
+  if (VersionEcx.Bits.OSXSAVE == 0) {
+    return FALSE;
+  }
+
+  //
+  // XCR0 must enable both the SSE (bit 1) and the AVX (bit 2) state.
+  //
+  if ((AsmXGetBv (0) & (BIT1 | BIT2)) != (BIT1 | BIT2)) {
+    return FALSE;
+  }
+
+  AsmCpuidEx (
+    CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS,
+    CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS_SUB_LEAF_INFO,
+    NULL,
+    &ExtendedEbx.Uint32,
+    NULL,
+    NULL
+    );
+
+  return (BOOLEAN)(ExtendedEbx.Bits.AVX2 != 0);
+}
+
+#endif
+
+/**
+  Sum a buffer as little-endian 16-bit words into a 64-bit accumulator.
+
+  A trailing odd byte is added as the low-order byte of a word, the same
+  as the original word-by-word NetblockChecksum.
+
+  @param[in]   Bulk                  Pointer to the data, any alignment.
+  @param[in]   Len                   Length of the data, in bytes.
+
+  @return    The unfolded 64-bit sum.
+
+**/
+UINT64
+EFIAPI
+InternalNetChecksum64 (
+  IN CONST UINT8  *Bulk,
+  IN UINTN        Len
+  )
+{
+  UINT64  Sum;
+
+  Sum = 0;
+
+  //
+  // Each addend is below 2^32, so the accumulator can't overflow for any
+  // buffer shorter than 16 GB.
+  //
+  while (Len >= 4 * sizeof (UINT32)) {
+    Sum  += ReadUnaligned32 ((UINT32 *)Bulk);
+    Sum  += ReadUnaligned32 ((UINT32 *)(Bulk + 4));
+    Sum  += ReadUnaligned32 ((UINT32 *)(Bulk + 8));
+    Sum  += ReadUnaligned32 ((UINT32 *)(Bulk + 12));
+    Bulk += 4 * sizeof (UINT32);
+    Len  -= 4 * sizeof (UINT32);
+  }
+
+  while (Len >= sizeof (UINT32)) {
+    Sum  += ReadUnaligned32 ((UINT32 *)Bulk);
+    Bulk += sizeof (UINT32);
+    Len  -= sizeof (UINT32);
+  }
+
+  if (Len >= sizeof (UINT16)) {
+    Sum  += ReadUnaligned16 ((UINT16 *)Bulk);
+    Bulk += sizeof (UINT16);
+    Len  -= sizeof (UINT16);
+  }
+
+  //
+  // Add left-over byte, if any
+  //
+  if (Len != 0) {
+    Sum += *Bulk;
+  }
+
+  return Sum;
+}
+
+/**
+  Fold a 64-bit one's complement sum to 16 bits.
+
+  @param[in]   Sum                   The unfolded sum.
+
+  @return    The folded 16-bit sum.
+
+**/
+UINT16
+InternalNetChecksumFold (
+  IN UINT64  Sum
+  )
+{
+  UINT32  Sum32;
+
+  Sum   = (Sum & MAX_UINT32) + RShiftU64 (Sum, 32);
+  Sum   = (Sum & MAX_UINT32) + RShiftU64 (Sum, 32);
+  Sum32 = (UINT32)Sum;
+
+  while ((Sum32 >> 16) != 0) {
+    Sum32 = (Sum32 & 0xffff) + (Sum32 >> 16);
+  }
+
+  return (UINT16)Sum32;
+}
+
+/**
+  Sum a buffer with the fastest kernel available on this processor.
+
+  @param[in]   Bulk                  Pointer to the data, any alignment.
+  @param[in]   Len                   Length of the data, in bytes.
+
+  @return    The unfolded 64-bit sum.
+
+**/
+UINT64
+InternalNetChecksum (
+  IN CONST UINT8  *Bulk,
+  IN UINTN        Len
+  )
+{
+  UINTN   Head;
+  UINT64  Sum;
+  UINT64  Tail;
+
+  if (Len < NET_CHECKSUM_VECTOR_THRESHOLD) {
+    return InternalNetChecksum64 (Bulk, Len);
+  }
+
+ #if defined (MDE_CPU_X64)
+  if (mNetChecksumAvx2 == NET_CHECKSUM_AVX2_UNKNOWN) {
+    mNetChecksumAvx2 = InternalNetChecksumAvx2Supported () ?
+                       NET_CHECKSUM_AVX2_ENABLED : NET_CHECKSUM_AVX2_DISABLED;
+  }
+
+  if ((mNetChecksumAvx2 == NET_CHECKSUM_AVX2_ENABLED) && !mNetChecksumAvx2Busy) {
+    mNetChecksumAvx2Busy = TRUE;
+    Head                 = Len & ~((UINTN)NET_CHECKSUM_AVX2_BLOCK - 1);
+    Sum                  = InternalNetChecksumAvx2 (Bulk, Head);
+    mNetChecksumAvx2Busy = FALSE;
+  } else {
+    Head = Len & ~((UINTN)NET_CHECKSUM_SSE2_BLOCK - 1);
+    Sum  = InternalNetChecksumSse2 (Bulk, Head);
+  }
+ #elif defined (MDE_CPU_AARCH64)
+  Head = Len & ~((UINTN)NET_CHECKSUM_NEON_BLOCK - 1);
+  Sum  = InternalNetChecksumNeon (Bulk, Head);
+ #else
+  Head = 0;
+  Sum  = 0;
+ #endif
+
+  //
+  // Head is a multiple of the block size, so the tail starts on an even
+  // offset and its words line up with the ones of the head. Add the two
+  // sums with an end-around carry.
+  //
+  Tail = InternalNetChecksum64 (Bulk + Head, Len - Head);
+  Sum += Tail;
+  if (Sum < Tail) {
+    Sum++;
+  }
+
+  return Sum;
+}
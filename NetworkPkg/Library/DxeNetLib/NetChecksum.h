@@ -0,0 +1,152 @@
+/** @file
+  Internal definitions of the Internet checksum kernels used by NetblockChecksum.
+
+Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef __NET_CHECKSUM_H__
+#define __NET_CHECKSUM_H__
+
+//
+// Buffers shorter than this are summed by the portable kernel. The
+// vector kernels only pay off once there are several blocks to add.
+//
+#define NET_CHECKSUM_VECTOR_THRESHOLD  64
+
+//
+// Number of bytes the vector kernels consume per iteration. They only
+// sum the leading multiple of this size, the caller sums the rest.
+//
+#define NET_CHECKSUM_SSE2_BLOCK  16
+#define NET_CHECKSUM_AVX2_BLOCK  32
+#define NET_CHECKSUM_NEON_BLOCK  32
+
+/**
+  Sum a buffer as little-endian 16-bit words into a 64-bit accumulator.
+
+  A trailing odd byte is added as the low-order byte of a word, the same
+  as the original word-by-word NetblockChecksum.
+
+  @param[in]   Bulk                  Pointer to the data, any alignment.
+  @param[in]   Len                   Length of the data, in bytes.
+
+  @return    The unfolded 64-bit sum.
+
+**/
+UINT64
+EFIAPI
+InternalNetChecksum64 (
+  IN CONST UINT8  *Bulk,
+  IN UINTN        Len
+  );
+
+/**
+  Fold a 64-bit one's complement sum to 16 bits.
+
+  @param[in]   Sum                   The unfolded sum.
+
+  @return    The folded 16-bit sum.
+
+**/
+UINT16
+InternalNetChecksumFold (
+  IN UINT64  Sum
+  );
+
+/**
+  Sum a buffer with the fastest kernel available on this processor.
+
+  @param[in]   Bulk                  Pointer to the data, any alignment.
+  @param[in]   Len                   Length of the data, in bytes.
+
+  @return    The unfolded 64-bit sum.
+
+**/
+UINT64
+InternalNetChecksum (
+  IN CONST UINT8  *Bulk,
+  IN UINTN        Len
+  );
+
+#if defined (MDE_CPU_X64)
+
+//
+// Values of mNetChecksumAvx2.
+//
+#define NET_CHECKSUM_AVX2_UNKNOWN   0
+#define NET_CHECKSUM_AVX2_ENABLED   1
+#define NET_CHECKSUM_AVX2_DISABLED  2
+
+extern UINT8             mNetChecksumAvx2;
+extern volatile BOOLEAN  mNetChecksumAvx2Busy;
+
+/**
+  Sum the leading NET_CHECKSUM_SSE2_BLOCK multiple of a buffer with SSE2.
+
+  @param[in]   Bulk                  Pointer to the data, any alignment.
+  @param[in]   Len                   Length of the data, in bytes.
+
+  @return    The unfolded 64-bit sum of the blocks.
+
+**/
+UINT64
+EFIAPI
+InternalNetChecksumSse2 (
+  IN CONST UINT8  *Bulk,
+  IN UINTN        Len
+  );
+
+/**
+  Sum the leading NET_CHECKSUM_AVX2_BLOCK multiple of a buffer with AVX2.
+
+  The caller must have checked InternalNetChecksumAvx2Supported().
+
+  @param[in]   Bulk                  Pointer to the data, any alignment.
+  @param[in]   Len                   Length of the data, in bytes.
+
+  @return    The unfolded 64-bit sum of the blocks.
+
+**/
+UINT64
+EFIAPI
+InternalNetChecksumAvx2 (
+  IN CONST UINT8  *Bulk,
+  IN UINTN        Len
+  );
+
+/**
+  Check whether the processor and the firmware allow AVX2 instructions.
+
+  @retval TRUE     AVX2 is supported and the YMM state is enabled in XCR0.
+  @retval FALSE    AVX2 can't be used.
+
+**/
+BOOLEAN
+InternalNetChecksumAvx2Supported (
+  VOID
+  );
+
+#endif
+
+#if defined (MDE_CPU_AARCH64)
+
+/**
+  Sum the leading NET_CHECKSUM_NEON_BLOCK multiple of a buffer with NEON.
+
+  @param[in]   Bulk                  Pointer to the data, any alignment.
+  @param[in]   Len                   Length of the data, in bytes.
+
+  @return    The unfolded 64-bit sum of the blocks.
+
+**/
+UINT64
+EFIAPI
+InternalNetChecksumNeon (
+  IN CONST UINT8  *Bulk,
+  IN UINTN        Len
+  );
+
+#endif
+
+#endif
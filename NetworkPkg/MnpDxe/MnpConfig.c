@@ -515,6 +515,8 @@ MnpInitializeDeviceData (
   //
   // Create the system poll timer.
   //
+  MnpDeviceData->AdaptivePoll = PcdGetBool (PcdMnpAdaptivePolling);
+
   Status = gBS->CreateEvent (
                   EVT_NOTIFY_SIGNAL | EVT_TIMER,
                   TPL_CALLBACK,
@@ -1220,6 +1222,14 @@ MnpStart (
         goto ErrorExit;
       }
 
+      //
+      // Start over the statistics and the WaitForPacket probing, the
+      // SNP creates a new event each time it is initialized.
+      //
+      ZeroMem (&MnpDeviceData->Stats, sizeof (MNP_STATISTICS));
+      MnpDeviceData->Stats.MinPollInterval = MNP_SYS_POLL_INTERVAL;
+      MnpDeviceData->WaitForPacketState    = MNP_WAIT_FOR_PACKET_UNKNOWN;
+
       //
       // Start the timeout timer.
       //
@@ -1263,7 +1273,9 @@ MnpStart (
     // The EnableSystemPoll differs with the current state, disable or enable
     // the system poll.
     //
-    TimerOpType = EnableSystemPoll ? TimerPeriodic : TimerCancel;
+    TimerOpType                  = EnableSystemPoll ? TimerPeriodic : TimerCancel;
+    MnpDeviceData->PollInterval  = MNP_SYS_POLL_INTERVAL;
+    MnpDeviceData->IdlePollCount = 0;
 
     Status = gBS->SetTimer (MnpDeviceData->PollTimer, TimerOpType, MNP_SYS_POLL_INTERVAL);
     if (EFI_ERROR (Status)) {
@@ -1344,6 +1356,11 @@ MnpStop (
   //
   Status = gBS->SetTimer (MnpDeviceData->MediaDetectTimer, TimerCancel, 0);
 
+  //
+  // Publish the receive statistics gathered since the device was started.
+  //
+  MnpPublishStatistics (MnpDeviceData);
+
   //
   // Stop the simple network.
   //
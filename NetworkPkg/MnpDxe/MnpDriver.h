@@ -16,6 +16,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Protocol/ServiceBinding.h>
 #include <Protocol/VlanConfig.h>
 
+#include <Guid/NetworkStatistics.h>
+
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
@@ -27,6 +29,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/UefiRuntimeServicesTableLib.h>
 #include <Library/DevicePathLib.h>
 #include <Library/PrintLib.h>
+#include <Library/PcdLib.h>
 
 #include "ComponentName.h"
 
@@ -70,6 +73,14 @@ typedef struct {
   EFI_EVENT                      PollTimer;
   BOOLEAN                        EnableSystemPoll;
 
+  //
+  // State of the adaptive system poll, see MnpSystemPoll().
+  //
+  BOOLEAN                        AdaptivePoll;
+  UINT64                         PollInterval;
+  UINT32                         IdlePollCount;
+  UINT8                          WaitForPacketState;
+
   EFI_EVENT                      TimeoutCheckTimer;
   EFI_EVENT                      MediaDetectTimer;
 
@@ -85,6 +96,8 @@ typedef struct {
   UINT32                         BufferLength;
   UINT32                         PaddingSize;
   NET_BUF                        *RxNbufCache;
+
+  MNP_STATISTICS                 Stats;
 } MNP_DEVICE_DATA;
 
 #define MNP_DEVICE_DATA_FROM_THIS(a) \
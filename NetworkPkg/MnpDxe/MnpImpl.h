@@ -14,6 +14,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define NET_ETHER_FCS_SIZE  4
 
 #define MNP_SYS_POLL_INTERVAL        (10 * TICKS_PER_MS)    // 10 milliseconds
+#define MNP_SYS_POLL_MIN_INTERVAL    (1 * TICKS_PER_MS)     // 1 millisecond
+#define MNP_SYS_POLL_MAX_INTERVAL    (40 * TICKS_PER_MS)    // 40 milliseconds
 #define MNP_TIMEOUT_CHECK_INTERVAL   (50 * TICKS_PER_MS)    // 50 milliseconds
 #define MNP_MEDIA_DETECT_INTERVAL    (500 * TICKS_PER_MS)   // 500 milliseconds
 #define MNP_TX_TIMEOUT_TIME          (500 * TICKS_PER_MS)   // 500 milliseconds
@@ -25,6 +27,22 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #define MNP_MAX_RCVD_PACKET_QUE_SIZE  256
 
+//
+// The adaptive system poll drains up to MNP_SYS_POLL_BATCH_SIZE frames per
+// run. It halves its interval when a run drains a full batch, and doubles
+// it after MNP_SYS_POLL_IDLE_BACKOFF runs in a row find no frame.
+//
+#define MNP_SYS_POLL_BATCH_SIZE    32
+#define MNP_SYS_POLL_IDLE_BACKOFF  8
+
+//
+// Whether the SNP WaitForPacket event reports pending frames. It is only
+// trusted after it has been seen signaled.
+//
+#define MNP_WAIT_FOR_PACKET_UNKNOWN   0
+#define MNP_WAIT_FOR_PACKET_USABLE    1
+#define MNP_WAIT_FOR_PACKET_UNUSABLE  2
+
 #define MNP_RECEIVE_UNICAST    0x01
 #define MNP_RECEIVE_BROADCAST  0x02
 
@@ -430,6 +448,38 @@ MnpReceivePacket (
   IN OUT MNP_DEVICE_DATA  *MnpDeviceData
   );
 
+/**
+  Receive and deliver up to MaxPackets packets, dispatching the DPCs queued
+  by the receive tokens after each of them.
+
+  @param[in, out]  MnpDeviceData        Pointer to the mnp device context data.
+  @param[in]       MaxPackets           The most packets to receive.
+  @param[out]      Received             The number of packets received.
+
+  @retval EFI_SUCCESS           At least one packet was received.
+  @retval Others                The status of MnpReceivePacket() when no packet
+                                was received.
+
+**/
+EFI_STATUS
+MnpReceivePackets (
+  IN OUT MNP_DEVICE_DATA  *MnpDeviceData,
+  IN     UINT32           MaxPackets,
+  OUT    UINT32           *Received
+  );
+
+/**
+  Publish the receive statistics of a device in the MnpStats variable of its
+  MAC address string, see Guid/NetworkStatistics.h.
+
+  @param[in, out]  MnpDeviceData        Pointer to the mnp device context data.
+
+**/
+VOID
+MnpPublishStatistics (
+  IN OUT MNP_DEVICE_DATA  *MnpDeviceData
+  );
+
 /**
   Allocate a free NET_BUF from MnpDeviceData->FreeNbufQue. If there is none
   in the queue, first try to allocate some and add them into the queue, then
@@ -521,6 +571,9 @@ MnpCheckMediaStatus (
   Poll to receive the packets from Snp. This function is either called by upperlayer
   protocols/applications or the system poll timer notify mechanism.
 
+  In the adaptive mode, each run drains a batch of packets and retunes the
+  poll timer to the receive load.
+
   @param[in]  Event        The event this notify function registered to.
   @param[in]  Context      Pointer to the context data registered to the event.
 
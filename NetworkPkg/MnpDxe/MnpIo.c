@@ -472,6 +472,7 @@ MnpQueueRcvdPacket (
   )
 {
   MNP_RXDATA_WRAP  *OldRxDataWrap;
+  MNP_STATISTICS   *Stats;
 
   NET_CHECK_SIGNATURE (Instance, MNP_INSTANCE_DATA_SIGNATURE);
 
@@ -480,7 +481,20 @@ MnpQueueRcvdPacket (
   // from the head.
   //
   if (Instance->RcvdPacketQueueSize == MNP_MAX_RCVD_PACKET_QUE_SIZE) {
-    DEBUG ((DEBUG_WARN, "MnpQueueRcvdPacket: Drop one packet bcz queue size limit reached.\n"));
+    Stats = &Instance->MnpServiceData->MnpDeviceData->Stats;
+    Stats->RxQueueDrops++;
+
+    //
+    // Only report the first drop and then every power of two, a consumer
+    // that stopped receiving would otherwise flood the debug output.
+    //
+    if ((Stats->RxQueueDrops & (Stats->RxQueueDrops - 1)) == 0) {
+      DEBUG (
+        (DEBUG_WARN,
+         "MnpQueueRcvdPacket: Drop one packet bcz queue size limit reached, %Lu dropped.\n",
+         Stats->RxQueueDrops)
+        );
+    }
 
     //
     // Get the oldest packet.
@@ -903,6 +917,9 @@ MnpReceivePacket (
     return EFI_DEVICE_ERROR;
   }
 
+  MnpDeviceData->Stats.RxPackets++;
+  MnpDeviceData->Stats.RxBytes += BufLen;
+
   Trimmed = 0;
   if (Nbuf->TotalSize != BufLen) {
     //
@@ -1044,6 +1061,7 @@ MnpCheckPacketTimeout (
           DEBUG ((DEBUG_WARN, "MnpCheckPacketTimeout: Received packet timeout.\n"));
           MnpRecycleRxData (NULL, RxDataWrap);
           Instance->RcvdPacketQueueSize--;
+          MnpDeviceData->Stats.RxTimeoutDrops++;
         }
       }
 
@@ -1083,10 +1101,90 @@ MnpCheckMediaStatus (
   }
 }
 
+/**
+  Receive and deliver up to MaxPackets packets, dispatching the DPCs queued
+  by the receive tokens after each of them.
+
+  @param[in, out]  MnpDeviceData        Pointer to the mnp device context data.
+  @param[in]       MaxPackets           The most packets to receive.
+  @param[out]      Received             The number of packets received.
+
+  @retval EFI_SUCCESS           At least one packet was received.
+  @retval Others                The status of MnpReceivePacket() when no packet
+                                was received.
+
+**/
+EFI_STATUS
+MnpReceivePackets (
+  IN OUT MNP_DEVICE_DATA  *MnpDeviceData,
+  IN     UINT32           MaxPackets,
+  OUT    UINT32           *Received
+  )
+{
+  EFI_STATUS  Status;
+
+  Status    = EFI_NOT_READY;
+  *Received = 0;
+
+  while (*Received < MaxPackets) {
+    Status = MnpReceivePacket (MnpDeviceData);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    (*Received)++;
+
+    //
+    // Dispatch the DPC queued by the NotifyFunction of rx token's events,
+    // so the consumers can queue their next token before the next packet.
+    //
+    DispatchDpc ();
+  }
+
+  return (*Received > 0) ? EFI_SUCCESS : Status;
+}
+
+/**
+  Check the SNP WaitForPacket event to see whether a frame is pending.
+
+  @param[in, out]  MnpDeviceData        Pointer to the mnp device context data.
+
+  @retval TRUE     A frame may be pending, or the event can't tell.
+  @retval FALSE    The UNDI reports no pending frame.
+
+**/
+STATIC
+BOOLEAN
+MnpIsPacketPending (
+  IN OUT MNP_DEVICE_DATA  *MnpDeviceData
+  )
+{
+  EFI_SIMPLE_NETWORK_PROTOCOL  *Snp;
+
+  Snp = MnpDeviceData->Snp;
+  if ((Snp->WaitForPacket == NULL) || (MnpDeviceData->WaitForPacketState == MNP_WAIT_FOR_PACKET_UNUSABLE)) {
+    return TRUE;
+  }
+
+  //
+  // Checking the event runs its notify function, which asks the UNDI for
+  // the length of the next frame without receiving it.
+  //
+  if (!EFI_ERROR (gBS->CheckEvent (Snp->WaitForPacket))) {
+    MnpDeviceData->WaitForPacketState = MNP_WAIT_FOR_PACKET_USABLE;
+    return TRUE;
+  }
+
+  return (BOOLEAN)(MnpDeviceData->WaitForPacketState != MNP_WAIT_FOR_PACKET_USABLE);
+}
+
 /**
   Poll to receive the packets from Snp. This function is either called by upperlayer
   protocols/applications or the system poll timer notify mechanism.
 
+  In the adaptive mode, each run drains a batch of packets and retunes the
+  poll timer to the receive load.
+
   @param[in]  Event        The event this notify function registered to.
   @param[in]  Context      Pointer to the context data registered to the event.
 
@@ -1099,17 +1197,109 @@ MnpSystemPoll (
   )
 {
   MNP_DEVICE_DATA  *MnpDeviceData;
+  MNP_STATISTICS   *Stats;
+  UINT64           Interval;
+  UINT32           Received;
+  BOOLEAN          Pending;
 
   MnpDeviceData = (MNP_DEVICE_DATA *)Context;
   NET_CHECK_SIGNATURE (MnpDeviceData, MNP_DEVICE_DATA_SIGNATURE);
 
-  //
-  // Try to receive packets from Snp.
-  //
-  MnpReceivePacket (MnpDeviceData);
+  if (!MnpDeviceData->AdaptivePoll) {
+    //
+    // Try to receive packets from Snp.
+    //
+    MnpReceivePacket (MnpDeviceData);
+
+    //
+    // Dispatch the DPC queued by the NotifyFunction of rx token's events.
+    //
+    DispatchDpc ();
+    return;
+  }
+
+  Stats = &MnpDeviceData->Stats;
+  Stats->SystemPolls++;
 
   //
-  // Dispatch the DPC queued by the NotifyFunction of rx token's events.
+  // After an idle run, ask the UNDI whether a frame is pending before
+  // preparing a buffer and issuing a receive.
   //
-  DispatchDpc ();
+  Received = 0;
+  Pending  = (MnpDeviceData->IdlePollCount == 0) || MnpIsPacketPending (MnpDeviceData);
+  if (Pending) {
+    MnpReceivePackets (MnpDeviceData, MNP_SYS_POLL_BATCH_SIZE, &Received);
+  }
+
+  if ((Received != 0) && (MnpDeviceData->IdlePollCount != 0) &&
+      (MnpDeviceData->WaitForPacketState == MNP_WAIT_FOR_PACKET_UNKNOWN) &&
+      (MnpDeviceData->Snp->WaitForPacket != NULL))
+  {
+    //
+    // A frame was received although the event wasn't signaled, so this
+    // UNDI doesn't report pending frames.
+    //
+    MnpDeviceData->WaitForPacketState = MNP_WAIT_FOR_PACKET_UNUSABLE;
+  }
+
+  Stats->MaxBatch = MAX (Stats->MaxBatch, Received);
+
+  Interval = MnpDeviceData->PollInterval;
+  if (Received == MNP_SYS_POLL_BATCH_SIZE) {
+    //
+    // More frames are probably waiting, poll faster.
+    //
+    MnpDeviceData->IdlePollCount = 0;
+    Interval                     = MAX (DivU64x32 (Interval, 2), MNP_SYS_POLL_MIN_INTERVAL);
+  } else if (Received != 0) {
+    //
+    // Traffic resumed, come back from the idle back-off at once.
+    //
+    MnpDeviceData->IdlePollCount = 0;
+    Interval                     = MIN (Interval, MNP_SYS_POLL_INTERVAL);
+  } else {
+    Stats->IdlePolls++;
+    MnpDeviceData->IdlePollCount++;
+    if (MnpDeviceData->IdlePollCount % MNP_SYS_POLL_IDLE_BACKOFF == 0) {
+      Interval = MIN (MultU64x32 (Interval, 2), MNP_SYS_POLL_MAX_INTERVAL);
+    }
+  }
+
+  if (Interval != MnpDeviceData->PollInterval) {
+    MnpDeviceData->PollInterval = Interval;
+    Stats->MinPollInterval      = (UINT32)MIN (Stats->MinPollInterval, Interval);
+    gBS->SetTimer (MnpDeviceData->PollTimer, TimerPeriodic, Interval);
+  }
+}
+
+/**
+  Publish the receive statistics of a device in the MnpStats variable of its
+  MAC address string, see Guid/NetworkStatistics.h.
+
+  @param[in, out]  MnpDeviceData        Pointer to the mnp device context data.
+
+**/
+VOID
+MnpPublishStatistics (
+  IN OUT MNP_DEVICE_DATA  *MnpDeviceData
+  )
+{
+  MNP_STATISTICS  *Stats;
+
+  Stats = &MnpDeviceData->Stats;
+
+  if ((Stats->RxPackets == 0) || (MnpDeviceData->MacString == NULL)) {
+    return;
+  }
+
+  DEBUG (
+    (DEBUG_NET,
+     "MnpPublishStatistics: %S received %Lu frames, %Lu dropped on queue overflow, %Lu on timeout.\n",
+     MnpDeviceData->MacString,
+     Stats->RxPackets,
+     Stats->RxQueueDrops,
+     Stats->RxTimeoutDrops)
+    );
+
+  NetLibPublishStatistics (EDKII_MNP_STATISTICS_VARIABLE_PREFIX, MnpDeviceData->MacString, Stats, sizeof (MNP_STATISTICS));
 }
@@ -755,7 +755,9 @@ MnpPoll (
 {
   EFI_STATUS         Status;
   MNP_INSTANCE_DATA  *Instance;
+  MNP_DEVICE_DATA    *MnpDeviceData;
   EFI_TPL            OldTpl;
+  UINT32             Received;
 
   if (This == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -770,10 +772,16 @@ MnpPoll (
     goto ON_EXIT;
   }
 
+  MnpDeviceData = Instance->MnpServiceData->MnpDeviceData;
+
   //
-  // Try to receive packets.
+  // Try to receive packets, a whole batch of them in the adaptive mode.
   //
-  Status = MnpReceivePacket (Instance->MnpServiceData->MnpDeviceData);
+  if (MnpDeviceData->AdaptivePoll) {
+    Status = MnpReceivePackets (MnpDeviceData, MNP_SYS_POLL_BATCH_SIZE, &Received);
+  } else {
+    Status = MnpReceivePacket (MnpDeviceData);
+  }
 
   //
   // Dispatch the DPC queued by the NotifyFunction of rx token's events.
@@ -0,0 +1,252 @@
+/** @file
+  Host based unit test for the CUBIC congestion control in TcpInput.c.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+#include <gtest/gtest.h>
+#include <cmath>
+
+extern "C" {
+  #include <Uefi.h>
+  #include <Library/BaseLib.h>
+  #include <Library/DebugLib.h>
+  #include "../TcpMain.h"
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+#define TCP_TEST_MSS  1000
+
+//
+// C in RFC8312, in segments per second cubed.
+//
+#define TCP_TEST_CUBIC_C  0.4
+
+////////////////////////////////////////////////////////////////////////////////
+// TcpComputeSsthresh Tests
+////////////////////////////////////////////////////////////////////////////////
+
+class TcpSsthreshTest : public ::testing::Test {
+protected:
+  TCP_CB Tcb;
+
+  virtual void
+  SetUp (
+    )
+  {
+    ZeroMem (&Tcb, sizeof (Tcb));
+    Tcb.SndMss     = TCP_TEST_MSS;
+    Tcb.CubicEpoch = 1;
+  }
+
+  UINT32
+  Loss (
+    UINT32  FlightSize
+    )
+  {
+    Tcb.SndUna = 0xfffff000;
+    Tcb.SndNxt = Tcb.SndUna + FlightSize;
+    return TcpComputeSsthresh (&Tcb);
+  }
+};
+
+// NewReno halves the flight size
+TEST_F (TcpSsthreshTest, NewReno) {
+  Tcb.CongestionControl = TCP_CC_NEWRENO;
+
+  EXPECT_EQ (Loss (20 * TCP_TEST_MSS), (UINT32)(10 * TCP_TEST_MSS));
+  EXPECT_EQ (Loss (3 * TCP_TEST_MSS), (UINT32)(2 * TCP_TEST_MSS));
+  EXPECT_EQ (Tcb.CubicWMax, (UINT32)0);
+}
+
+// CUBIC reduces the flight size by beta and remembers it as Wmax
+TEST_F (TcpSsthreshTest, Cubic) {
+  Tcb.CongestionControl = TCP_CC_CUBIC;
+
+  EXPECT_EQ (Loss (100 * TCP_TEST_MSS), (UINT32)(70 * TCP_TEST_MSS));
+  EXPECT_EQ (Tcb.CubicWMax, (UINT32)(100 * TCP_TEST_MSS));
+  EXPECT_EQ (Tcb.CubicEpoch, (UINT32)0);
+
+  EXPECT_EQ (Loss (2 * TCP_TEST_MSS), (UINT32)(2 * TCP_TEST_MSS));
+}
+
+// A loss below the previous Wmax plateaus lower
+TEST_F (TcpSsthreshTest, CubicFastConvergence) {
+  Tcb.CongestionControl = TCP_CC_CUBIC;
+
+  Loss (100 * TCP_TEST_MSS);
+  EXPECT_EQ (Loss (80 * TCP_TEST_MSS), (UINT32)(56 * TCP_TEST_MSS));
+  EXPECT_EQ (Tcb.CubicWMax, (UINT32)(68 * TCP_TEST_MSS));
+
+  EXPECT_EQ (Loss (90 * TCP_TEST_MSS), (UINT32)(63 * TCP_TEST_MSS));
+  EXPECT_EQ (Tcb.CubicWMax, (UINT32)(90 * TCP_TEST_MSS));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// TcpCubicIncrease Tests
+////////////////////////////////////////////////////////////////////////////////
+
+class TcpCubicIncreaseTest : public ::testing::Test {
+protected:
+  TCP_CB Tcb;
+  UINT32 SavedTick;
+
+  virtual void
+  SetUp (
+    )
+  {
+    ZeroMem (&Tcb, sizeof (Tcb));
+    Tcb.CongestionControl = TCP_CC_CUBIC;
+    Tcb.SndMss            = TCP_TEST_MSS;
+
+    SavedTick = mTcpTick;
+    mTcpTick  = 1000;
+  }
+
+  virtual void
+  TearDown (
+    )
+  {
+    mTcpTick = SavedTick;
+  }
+
+  //
+  // Start an epoch with the window reduced from WMax to CWnd.
+  //
+  UINT32
+  StartEpoch (
+    UINT32  WMax,
+    UINT32  CWnd
+    )
+  {
+    Tcb.CubicWMax  = WMax;
+    Tcb.CubicEpoch = 0;
+    Tcb.CWnd       = CWnd;
+    return TcpCubicIncrease (&Tcb);
+  }
+
+  //
+  // K and W(t) as defined in RFC8312, in milliseconds and bytes.
+  //
+  double
+  CubicK (
+    UINT32  WMax,
+    UINT32  CWnd
+    )
+  {
+    return cbrt ((double)(WMax - CWnd) / TCP_TEST_MSS / TCP_TEST_CUBIC_C) * 1000;
+  }
+
+  double
+  CubicIncrease (
+    UINT32  WMax,
+    UINT32  CWnd,
+    double  Ms
+    )
+  {
+    double  Target;
+
+    Target = WMax + TCP_TEST_CUBIC_C * pow ((Ms - CubicK (WMax, CWnd)) / 1000, 3) * TCP_TEST_MSS;
+    return (Target - CWnd) * TCP_TEST_MSS / CWnd;
+  }
+};
+
+// K is the time W(t) takes to get back to Wmax
+TEST_F (TcpCubicIncreaseTest, ComputesK) {
+  static const UINT32  Segments[] = { 1, 7, 30, 300, 1000, 40000 };
+
+  for (UINTN Index = 0; Index < ARRAY_SIZE (Segments); Index++) {
+    UINT32  WMax;
+
+    WMax = 50000 * TCP_TEST_MSS;
+    StartEpoch (WMax, WMax - Segments[Index] * TCP_TEST_MSS);
+
+    EXPECT_EQ (Tcb.CubicEpoch, mTcpTick);
+    EXPECT_EQ (Tcb.CubicOrigin, WMax);
+    EXPECT_NEAR (Tcb.CubicK, CubicK (WMax, Tcb.CWnd), 1) << Segments[Index] << " segments";
+  }
+}
+
+// Above Wmax there is no plateau to get back to
+TEST_F (TcpCubicIncreaseTest, NoKAboveWMax) {
+  StartEpoch (70 * TCP_TEST_MSS, 100 * TCP_TEST_MSS);
+
+  EXPECT_EQ (Tcb.CubicK, (UINT32)0);
+  EXPECT_EQ (Tcb.CubicOrigin, (UINT32)(100 * TCP_TEST_MSS));
+}
+
+// W(t) is concave before K and convex after it
+TEST_F (TcpCubicIncreaseTest, FollowsCubicWindow) {
+  UINT32  WMax;
+  UINT32  CWnd;
+
+  WMax = 100 * TCP_TEST_MSS;
+  CWnd = 70 * TCP_TEST_MSS;
+  StartEpoch (WMax, CWnd);
+
+  //
+  // 2 seconds into the epoch, before K of about 4.2 seconds.
+  //
+  mTcpTick += 2000 / TCP_TICK;
+  EXPECT_NEAR (TcpCubicIncrease (&Tcb), CubicIncrease (WMax, CWnd, 2000), 1);
+
+  //
+  // 6 seconds into the epoch, after K.
+  //
+  mTcpTick += 4000 / TCP_TICK;
+  EXPECT_NEAR (TcpCubicIncrease (&Tcb), CubicIncrease (WMax, CWnd, 6000), 1);
+}
+
+// W(t + RTT) is used, not W(t)
+TEST_F (TcpCubicIncreaseTest, LooksOneRttAhead) {
+  UINT32  WMax;
+  UINT32  CWnd;
+
+  WMax = 100 * TCP_TEST_MSS;
+  CWnd = 70 * TCP_TEST_MSS;
+
+  Tcb.SRtt = (1000 / TCP_TICK) << TCP_RTT_SHIFT;
+  StartEpoch (WMax, CWnd);
+
+  mTcpTick += 1000 / TCP_TICK;
+  EXPECT_NEAR (TcpCubicIncrease (&Tcb), CubicIncrease (WMax, CWnd, 2000), 1);
+}
+
+// The window never grows more than half of it per RTT
+TEST_F (TcpCubicIncreaseTest, CapsTargetAtHalfWindow) {
+  StartEpoch (100 * TCP_TEST_MSS, 10 * TCP_TEST_MSS);
+
+  mTcpTick += 60000 / TCP_TICK;
+  EXPECT_EQ (TcpCubicIncrease (&Tcb), (UINT32)(TCP_TEST_MSS / 2));
+
+  //
+  // The elapsed time is bounded, a stale epoch does not overflow.
+  //
+  mTcpTick += 0x80000000;
+  EXPECT_EQ (TcpCubicIncrease (&Tcb), (UINT32)(TCP_TEST_MSS / 2));
+}
+
+// On the plateau CUBIC still grows as fast as an AIMD flow would
+TEST_F (TcpCubicIncreaseTest, TcpFriendlyMinimum) {
+  EXPECT_EQ (StartEpoch (10 * TCP_TEST_MSS, 10 * TCP_TEST_MSS), (UINT32)(TCP_TEST_MSS / 10 / 2));
+  EXPECT_EQ (StartEpoch (20000 * TCP_TEST_MSS, 20000 * TCP_TEST_MSS), (UINT32)1);
+}
+
+// A loss ends the epoch, the next ACK starts a new one
+TEST_F (TcpCubicIncreaseTest, LossRestartsEpoch) {
+  StartEpoch (100 * TCP_TEST_MSS, 70 * TCP_TEST_MSS);
+
+  mTcpTick   += 10;
+  Tcb.SndUna  = 0;
+  Tcb.SndNxt  = 120 * TCP_TEST_MSS;
+  Tcb.CWnd    = TcpComputeSsthresh (&Tcb);
+  EXPECT_EQ (Tcb.CubicEpoch, (UINT32)0);
+
+  TcpCubicIncrease (&Tcb);
+  EXPECT_EQ (Tcb.CubicEpoch, mTcpTick);
+  EXPECT_EQ (Tcb.CubicOrigin, (UINT32)(120 * TCP_TEST_MSS));
+  EXPECT_NEAR (Tcb.CubicK, CubicK (120 * TCP_TEST_MSS, 84 * TCP_TEST_MSS), 1);
+}
@@ -0,0 +1,42 @@
+/** @file
+  Acts as the main entry point for the tests for the TcpDxe module.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+#include <gtest/gtest.h>
+
+extern "C" {
+  #include <Uefi.h>
+  #include <Library/MemoryAllocationLib.h>
+  #include <Library/UefiBootServicesTableLib.h>
+}
+
+//
+// NetLib releases the blocks of a NET_BUF with gBS->FreePool(), which
+// the host boot services table does not implement.
+//
+EFI_STATUS
+EFIAPI
+TestFreePool (
+  IN VOID  *Buffer
+  )
+{
+  FreePool (Buffer);
+  return EFI_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Run the tests
+////////////////////////////////////////////////////////////////////////////////
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  gBS->FreePool = TestFreePool;
+
+  testing::InitGoogleTest (&argc, argv);
+  return RUN_ALL_TESTS ();
+}
@@ -0,0 +1,489 @@
+/** @file
+  Host based unit test for the SACK options in TcpOption.c.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+#include <gtest/gtest.h>
+
+extern "C" {
+  #include <Uefi.h>
+  #include <Library/BaseLib.h>
+  #include <Library/DebugLib.h>
+  #include "../TcpMain.h"
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//
+// The options are followed by this byte, so that an option cut off at the
+// end of the header reads a plausible length.
+//
+#define TCP_TEST_TRAILER  10
+
+#define TCP_TEST_MSS  1460
+
+////////////////////////////////////////////////////////////////////////////////
+// Helpers
+////////////////////////////////////////////////////////////////////////////////
+
+static
+VOID
+WriteBe32 (
+  OUT UINT8   *Buffer,
+  IN  UINT32  Value
+  )
+{
+  Buffer[0] = (UINT8)(Value >> 24);
+  Buffer[1] = (UINT8)(Value >> 16);
+  Buffer[2] = (UINT8)(Value >> 8);
+  Buffer[3] = (UINT8)Value;
+}
+
+static
+UINT32
+ReadBe32 (
+  IN CONST UINT8  *Buffer
+  )
+{
+  return ((UINT32)Buffer[0] << 24) | ((UINT32)Buffer[1] << 16) | ((UINT32)Buffer[2] << 8) | Buffer[3];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// TcpParseOption Tests
+////////////////////////////////////////////////////////////////////////////////
+
+class TcpParseOptionTest : public ::testing::Test {
+protected:
+  UINT8 Packet[sizeof (TCP_HEAD) + TCP_OPTION_MAX_LEN + 4];
+  TCP_HEAD *Head;
+  UINT8 *Options;
+  TCP_OPTION Option;
+
+  virtual void
+  SetUp (
+    )
+  {
+    ZeroMem (Packet, sizeof (Packet));
+    ZeroMem (&Option, sizeof (Option));
+    Head    = (TCP_HEAD *)Packet;
+    Options = Packet + sizeof (TCP_HEAD);
+  }
+
+  //
+  // Parse the first OptionLen bytes of Options, OptionLen is a multiple of 4.
+  //
+  INTN
+  Parse (
+    UINT8  OptionLen
+    )
+  {
+    Options[OptionLen] = TCP_TEST_TRAILER;
+    Head->HeadLen      = (UINT8)((sizeof (TCP_HEAD) + OptionLen) / 4);
+    return TcpParseOption (Head, &Option);
+  }
+
+  //
+  // Put NOP NOP SACK at Offset, with Count blocks of 1000 bytes each
+  // starting at sequence number Seq, every other 1000 bytes.
+  //
+  UINT8
+  PutSack (
+    UINT8   Offset,
+    UINT8   Count,
+    UINT32  Seq
+    )
+  {
+    Options[Offset]     = TCP_OPTION_NOP;
+    Options[Offset + 1] = TCP_OPTION_NOP;
+    Options[Offset + 2] = TCP_OPTION_SACK;
+    Options[Offset + 3] = (UINT8)(2 + Count * TCP_OPTION_SACK_BLOCK_LEN);
+    for (UINT8 Index = 0; Index < Count; Index++) {
+      WriteBe32 (&Options[Offset + 4 + Index * TCP_OPTION_SACK_BLOCK_LEN], Seq + Index * 2000);
+      WriteBe32 (&Options[Offset + 8 + Index * TCP_OPTION_SACK_BLOCK_LEN], Seq + Index * 2000 + 1000);
+    }
+
+    return (UINT8)(Offset + 4 + Count * TCP_OPTION_SACK_BLOCK_LEN);
+  }
+};
+
+// One to four blocks are parsed in the order they are sent
+TEST_F (TcpParseOptionTest, ParsesSackBlocks) {
+  for (UINT8 Count = 1; Count <= TCP_OPTION_MAX_SACK; Count++) {
+    SetUp ();
+    ASSERT_EQ (Parse (PutSack (0, Count, 0xfffff000)), 0) << "Count " << (int)Count;
+    EXPECT_TRUE (TCP_FLG_ON (Option.Flag, TCP_OPTION_RCVD_SACK));
+    ASSERT_EQ (Option.SackCount, Count);
+    for (UINT8 Index = 0; Index < Count; Index++) {
+      EXPECT_EQ (Option.Sack[Index].Left, (UINT32)(0xfffff000 + Index * 2000));
+      EXPECT_EQ (Option.Sack[Index].Right, (UINT32)(0xfffff000 + Index * 2000 + 1000));
+    }
+  }
+}
+
+// Three blocks fill the option space left by a timestamp
+TEST_F (TcpParseOptionTest, ParsesSackAfterTimestamp) {
+  Options[0] = TCP_OPTION_NOP;
+  Options[1] = TCP_OPTION_NOP;
+  Options[2] = TCP_OPTION_TS;
+  Options[3] = TCP_OPTION_TS_LEN;
+  WriteBe32 (&Options[4], 0x12345678);
+  WriteBe32 (&Options[8], 0x9abcdef0);
+
+  ASSERT_EQ (Parse (PutSack (TCP_OPTION_TS_ALIGNED_LEN, 3, 5000)), 0);
+  EXPECT_TRUE (TCP_FLG_ON (Option.Flag, TCP_OPTION_RCVD_TS));
+  EXPECT_TRUE (TCP_FLG_ON (Option.Flag, TCP_OPTION_RCVD_SACK));
+  EXPECT_EQ (Option.TSVal, (UINT32)0x12345678);
+  EXPECT_EQ (Option.SackCount, 3);
+  EXPECT_EQ (Option.Sack[2].Left, (UINT32)9000);
+  EXPECT_EQ (Option.Sack[2].Right, (UINT32)10000);
+}
+
+// Only 2 + 8 * N lengths with 1 <= N <= 4 are accepted
+TEST_F (TcpParseOptionTest, RejectsMalformedSackLength) {
+  for (UINT32 Len = 0; Len <= MAX_UINT8; Len++) {
+    BOOLEAN  Valid;
+
+    SetUp ();
+    Options[0] = TCP_OPTION_SACK;
+    Options[1] = (UINT8)Len;
+    for (UINT8 Index = 2; Index < TCP_OPTION_MAX_LEN; Index++) {
+      Options[Index] = TCP_OPTION_NOP;
+    }
+
+    Valid = (BOOLEAN)((Len >= 10) && (Len <= 34) && ((Len - 2) % TCP_OPTION_SACK_BLOCK_LEN == 0));
+    EXPECT_EQ (Parse (TCP_OPTION_MAX_LEN), Valid ? 0 : -1) << "Len " << Len;
+    if (Valid) {
+      EXPECT_EQ (Option.SackCount, (Len - 2) / TCP_OPTION_SACK_BLOCK_LEN);
+    }
+  }
+}
+
+// A SACK option that runs past the end of the header is rejected
+TEST_F (TcpParseOptionTest, RejectsTruncatedSack) {
+  for (UINT8 Count = 1; Count <= TCP_OPTION_MAX_SACK; Count++) {
+    for (UINT8 OptionLen = 4; OptionLen <= TCP_OPTION_MAX_LEN; OptionLen += 4) {
+      SetUp ();
+      PutSack (0, Count, 1000);
+      EXPECT_EQ (Parse (OptionLen), (OptionLen >= 4 + Count * TCP_OPTION_SACK_BLOCK_LEN) ? 0 : -1)
+        << "Count " << (int)Count << " OptionLen " << (int)OptionLen;
+    }
+  }
+
+  //
+  // Only the kind fits, the length is the byte after the header.
+  //
+  SetUp ();
+  Options[0] = TCP_OPTION_NOP;
+  Options[1] = TCP_OPTION_NOP;
+  Options[2] = TCP_OPTION_NOP;
+  Options[3] = TCP_OPTION_SACK;
+  EXPECT_EQ (Parse (4), -1);
+}
+
+// SACK-permitted must be exactly 2 bytes and fit in the header
+TEST_F (TcpParseOptionTest, ParsesSackPermitted) {
+  Options[0] = TCP_OPTION_NOP;
+  Options[1] = TCP_OPTION_NOP;
+  Options[2] = TCP_OPTION_SACK_PERM;
+  Options[3] = TCP_OPTION_SACK_PERM_LEN;
+  ASSERT_EQ (Parse (4), 0);
+  EXPECT_TRUE (TCP_FLG_ON (Option.Flag, TCP_OPTION_RCVD_SACK_PERM));
+
+  SetUp ();
+  Options[0] = TCP_OPTION_SACK_PERM;
+  Options[1] = TCP_OPTION_SACK_PERM_LEN + 1;
+  EXPECT_EQ (Parse (4), -1);
+
+  SetUp ();
+  Options[0] = TCP_OPTION_NOP;
+  Options[1] = TCP_OPTION_NOP;
+  Options[2] = TCP_OPTION_NOP;
+  Options[3] = TCP_OPTION_SACK_PERM;
+  EXPECT_EQ (Parse (4), -1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// SACK Option Build Tests
+////////////////////////////////////////////////////////////////////////////////
+
+class TcpBuildSackTest : public ::testing::Test {
+protected:
+  TCP_CB Tcb;
+  NET_BUF *Nbuf;
+
+  virtual void
+  SetUp (
+    )
+  {
+    ZeroMem (&Tcb, sizeof (Tcb));
+    InitializeListHead (&Tcb.RcvQue);
+    TCP_SET_FLG (Tcb.CtrlFlag, TCP_CTRL_RCVD_SACK);
+    TCP_SET_FLG (Tcb.CtrlFlag, TCP_CTRL_NO_TS);
+    TCP_SET_FLG (Tcb.CtrlFlag, TCP_CTRL_NO_WS);
+    Tcb.RcvNxt = 1000;
+    Tcb.SndMss = TCP_TEST_MSS;
+    Tcb.RcvMss = TCP_TEST_MSS;
+
+    Nbuf = NewSegment (0);
+  }
+
+  virtual void
+  TearDown (
+    )
+  {
+    while (!IsListEmpty (&Tcb.RcvQue)) {
+      NET_BUF  *Queued;
+
+      Queued = NET_LIST_HEAD (&Tcb.RcvQue, NET_BUF, List);
+      RemoveEntryList (&Queued->List);
+      NetbufFree (Queued);
+    }
+
+    NetbufFree (Nbuf);
+  }
+
+  //
+  // Allocate an outgoing segment with DataLen bytes of data.
+  //
+  NET_BUF *
+  NewSegment (
+    UINT32  DataLen
+    )
+  {
+    NET_BUF  *Segment;
+
+    Segment = NetbufAlloc (TCP_MAX_HEAD + DataLen + 1);
+    EXPECT_NE (Segment, (NET_BUF *)NULL);
+    NetbufReserve (Segment, TCP_MAX_HEAD);
+    if (DataLen != 0) {
+      EXPECT_NE (NetbufAllocSpace (Segment, DataLen, NET_BUF_TAIL), (UINT8 *)NULL);
+    }
+
+    TCPSEG_NETBUF (Segment)->Flag = TCP_FLG_ACK;
+    return Segment;
+  }
+
+  //
+  // Queue out of order data [Seq, End) in the RcvQue, which is kept
+  // sorted by TcpQueueData().
+  //
+  void
+  QueueData (
+    TCP_SEQNO  Seq,
+    TCP_SEQNO  End
+    )
+  {
+    NET_BUF  *Queued;
+
+    Queued                      = NetbufAlloc (1);
+    TCPSEG_NETBUF (Queued)->Seq = Seq;
+    TCPSEG_NETBUF (Queued)->End = End;
+    InsertTailList (&Tcb.RcvQue, &Queued->List);
+  }
+
+  //
+  // Build the options of Nbuf, then parse them back as a peer would.
+  //
+  UINT16
+  BuildAndParse (
+    TCP_OPTION  *Option
+    )
+  {
+    UINT8     Packet[sizeof (TCP_HEAD) + TCP_OPTION_MAX_LEN];
+    TCP_HEAD  *Head;
+    UINT16    Len;
+
+    Len = TcpBuildOption (&Tcb, Nbuf);
+    EXPECT_EQ (Len % 4, 0);
+    EXPECT_LE (Len, TCP_OPTION_MAX_LEN);
+
+    ZeroMem (Packet, sizeof (Packet));
+    Head          = (TCP_HEAD *)Packet;
+    Head->HeadLen = (UINT8)((sizeof (TCP_HEAD) + Len) / 4);
+    NetbufCopy (Nbuf, 0, Len, (UINT8 *)(Head + 1));
+
+    ZeroMem (Option, sizeof (TCP_OPTION));
+    EXPECT_EQ (TcpParseOption (Head, Option), 0);
+    return Len;
+  }
+};
+
+// Nothing is added while no out of order data is queued
+TEST_F (TcpBuildSackTest, NoSackWithoutOutOfOrderData) {
+  EXPECT_EQ (TcpBuildOption (&Tcb, Nbuf), 0);
+  EXPECT_EQ (Nbuf->TotalSize, 0);
+}
+
+// Nothing is added when the peer did not permit SACK
+TEST_F (TcpBuildSackTest, NoSackWhenNotPermitted) {
+  QueueData (2000, 3000);
+  TCP_CLEAR_FLG (Tcb.CtrlFlag, TCP_CTRL_RCVD_SACK);
+  EXPECT_EQ (TcpBuildOption (&Tcb, Nbuf), 0);
+}
+
+// Nothing is added to a reset
+TEST_F (TcpBuildSackTest, NoSackOnReset) {
+  QueueData (2000, 3000);
+  TCPSEG_NETBUF (Nbuf)->Flag = TCP_FLG_RST;
+  EXPECT_EQ (TcpBuildOption (&Tcb, Nbuf), 0);
+}
+
+// The wire format is NOP NOP SACK length, then the blocks in network order
+TEST_F (TcpBuildSackTest, EncodesBlocks) {
+  UINT8  *Data;
+
+  QueueData (2000, 3000);
+  QueueData (4000, 5000);
+  Tcb.SackRecent = 4000;
+
+  ASSERT_EQ (TcpBuildOption (&Tcb, Nbuf), 4 + 2 * TCP_OPTION_SACK_BLOCK_LEN);
+  Data = NetbufGetByte (Nbuf, 0, NULL);
+  ASSERT_NE (Data, (UINT8 *)NULL);
+  EXPECT_EQ (Data[0], TCP_OPTION_NOP);
+  EXPECT_EQ (Data[1], TCP_OPTION_NOP);
+  EXPECT_EQ (Data[2], TCP_OPTION_SACK);
+  EXPECT_EQ (Data[3], 2 + 2 * TCP_OPTION_SACK_BLOCK_LEN);
+  EXPECT_EQ (ReadBe32 (Data + 4), (UINT32)4000);
+  EXPECT_EQ (ReadBe32 (Data + 8), (UINT32)5000);
+  EXPECT_EQ (ReadBe32 (Data + 12), (UINT32)2000);
+  EXPECT_EQ (ReadBe32 (Data + 16), (UINT32)3000);
+}
+
+// Abutting and overlapping segments are reported as one block
+TEST_F (TcpBuildSackTest, MergesContiguousSegments) {
+  TCP_OPTION  Option;
+
+  QueueData (2000, 3000);
+  QueueData (3000, 4000);
+  QueueData (3500, 4500);
+  QueueData (6000, 7000);
+  Tcb.SackRecent = 3500;
+
+  BuildAndParse (&Option);
+  ASSERT_EQ (Option.SackCount, 2);
+  EXPECT_EQ (Option.Sack[0].Left, (UINT32)2000);
+  EXPECT_EQ (Option.Sack[0].Right, (UINT32)4500);
+  EXPECT_EQ (Option.Sack[1].Left, (UINT32)6000);
+  EXPECT_EQ (Option.Sack[1].Right, (UINT32)7000);
+}
+
+// The block of the most recent segment comes first, the others in order
+TEST_F (TcpBuildSackTest, MostRecentBlockFirst) {
+  TCP_OPTION  Option;
+
+  QueueData (2000, 3000);
+  QueueData (4000, 5000);
+  QueueData (6000, 7000);
+  QueueData (8000, 9000);
+  Tcb.SackRecent = 6000;
+
+  BuildAndParse (&Option);
+  ASSERT_EQ (Option.SackCount, 4);
+  EXPECT_EQ (Option.Sack[0].Left, (UINT32)6000);
+  EXPECT_EQ (Option.Sack[1].Left, (UINT32)2000);
+  EXPECT_EQ (Option.Sack[2].Left, (UINT32)4000);
+  EXPECT_EQ (Option.Sack[3].Left, (UINT32)8000);
+}
+
+// With more holes than fit, the most recent block and the lowest ones are sent
+TEST_F (TcpBuildSackTest, LimitsBlocksToOptionSpace) {
+  TCP_OPTION  Option;
+
+  for (UINT32 Seq = 2000; Seq < 12000; Seq += 2000) {
+    QueueData (Seq, Seq + 1000);
+  }
+
+  Tcb.SackRecent = 10000;
+  EXPECT_EQ (BuildAndParse (&Option), 4 + 4 * TCP_OPTION_SACK_BLOCK_LEN);
+  ASSERT_EQ (Option.SackCount, 4);
+  EXPECT_EQ (Option.Sack[0].Left, (UINT32)10000);
+  EXPECT_EQ (Option.Sack[1].Left, (UINT32)2000);
+  EXPECT_EQ (Option.Sack[2].Left, (UINT32)4000);
+  EXPECT_EQ (Option.Sack[3].Left, (UINT32)6000);
+
+  //
+  // A timestamp leaves room for three blocks.
+  //
+  NetbufFree (Nbuf);
+  Nbuf = NewSegment (0);
+  TCP_CLEAR_FLG (Tcb.CtrlFlag, TCP_CTRL_NO_TS);
+  TCP_SET_FLG (Tcb.CtrlFlag, TCP_CTRL_SND_TS);
+  EXPECT_EQ (BuildAndParse (&Option), TCP_OPTION_MAX_LEN);
+  EXPECT_TRUE (TCP_FLG_ON (Option.Flag, TCP_OPTION_RCVD_TS));
+  ASSERT_EQ (Option.SackCount, 3);
+  EXPECT_EQ (Option.Sack[0].Left, (UINT32)10000);
+  EXPECT_EQ (Option.Sack[2].Left, (UINT32)4000);
+}
+
+// The option never pushes a data segment over the MSS
+TEST_F (TcpBuildSackTest, LimitsBlocksToMss) {
+  TCP_OPTION  Option;
+
+  for (UINT32 Seq = 2000; Seq < 12000; Seq += 2000) {
+    QueueData (Seq, Seq + 1000);
+  }
+
+  Tcb.SackRecent = 2000;
+
+  NetbufFree (Nbuf);
+  Nbuf = NewSegment (TCP_TEST_MSS - 4 - 2 * TCP_OPTION_SACK_BLOCK_LEN);
+  BuildAndParse (&Option);
+  EXPECT_EQ (Option.SackCount, 2);
+  EXPECT_LE (Nbuf->TotalSize, (UINT32)TCP_TEST_MSS);
+
+  NetbufFree (Nbuf);
+  Nbuf = NewSegment (TCP_TEST_MSS - 4 - TCP_OPTION_SACK_BLOCK_LEN + 1);
+  EXPECT_EQ (TcpBuildOption (&Tcb, Nbuf), 0);
+
+  NetbufFree (Nbuf);
+  Nbuf = NewSegment (TCP_TEST_MSS);
+  EXPECT_EQ (TcpBuildOption (&Tcb, Nbuf), 0);
+}
+
+// Data at or below RcvNxt is not reported
+TEST_F (TcpBuildSackTest, SkipsDataBelowRcvNxt) {
+  TCP_OPTION  Option;
+
+  QueueData (1000, 1500);
+  QueueData (3000, 4000);
+  Tcb.SackRecent = 3000;
+
+  BuildAndParse (&Option);
+  ASSERT_EQ (Option.SackCount, 1);
+  EXPECT_EQ (Option.Sack[0].Left, (UINT32)3000);
+  EXPECT_EQ (Option.Sack[0].Right, (UINT32)4000);
+}
+
+// SACK-permitted is offered in an active SYN unless SACK is disabled
+TEST_F (TcpBuildSackTest, SynOffersSackPermitted) {
+  UINT8       Packet[sizeof (TCP_HEAD) + TCP_OPTION_MAX_LEN];
+  TCP_HEAD    *Head;
+  TCP_OPTION  Option;
+  UINT16      Len;
+
+  TCPSEG_NETBUF (Nbuf)->Flag = TCP_FLG_SYN;
+  Len                        = TcpSynBuildOption (&Tcb, Nbuf);
+
+  ZeroMem (Packet, sizeof (Packet));
+  Head          = (TCP_HEAD *)Packet;
+  Head->HeadLen = (UINT8)((sizeof (TCP_HEAD) + Len) / 4);
+  NetbufCopy (Nbuf, 0, Len, (UINT8 *)(Head + 1));
+  ASSERT_EQ (TcpParseOption (Head, &Option), 0);
+  EXPECT_TRUE (TCP_FLG_ON (Option.Flag, TCP_OPTION_RCVD_SACK_PERM));
+  EXPECT_TRUE (TCP_FLG_ON (Option.Flag, TCP_OPTION_RCVD_MSS));
+
+  NetbufFree (Nbuf);
+  Nbuf                       = NewSegment (0);
+  TCPSEG_NETBUF (Nbuf)->Flag = TCP_FLG_SYN;
+  TCP_SET_FLG (Tcb.CtrlFlag, TCP_CTRL_NO_SACK);
+  Len = TcpSynBuildOption (&Tcb, Nbuf);
+
+  ZeroMem (Packet, sizeof (Packet));
+  Head->HeadLen = (UINT8)((sizeof (TCP_HEAD) + Len) / 4);
+  NetbufCopy (Nbuf, 0, Len, (UINT8 *)(Head + 1));
+  ASSERT_EQ (TcpParseOption (Head, &Option), 0);
+  EXPECT_FALSE (TCP_FLG_ON (Option.Flag, TCP_OPTION_RCVD_SACK_PERM));
+}
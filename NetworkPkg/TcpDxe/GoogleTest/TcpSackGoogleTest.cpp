@@ -0,0 +1,549 @@
+/** @file
+  Host based unit test for the SACK scoreboard in TcpInput.c and the SACK
+  retransmission in TcpOutput.c.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+#include <gtest/gtest.h>
+#include <vector>
+
+extern "C" {
+  #include <Uefi.h>
+  #include <Library/BaseLib.h>
+  #include <Library/DebugLib.h>
+  #include "../TcpMain.h"
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+#define TCP_TEST_MSS       1000
+#define TCP_TEST_SND_UNA   0xfffff000
+#define TCP_TEST_SEGMENTS  10
+
+typedef struct {
+  TCP_SEQNO    Seq;
+  UINT32       Len;
+} SENT_SEGMENT;
+
+static std::vector<SENT_SEGMENT>  mSentSegments;
+
+////////////////////////////////////////////////////////////////////////////////
+// Symbol Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+extern "C" {
+  // Needed by TcpInput.c
+  UINT32  mTcpTick = 1000;
+
+  CHAR16  *mTcpStateName[] = {
+    (CHAR16 *)L"TCP_CLOSED"
+  };
+
+  EFI_STATUS
+  EFIAPI
+  IpIoGetIcmpErrStatus (
+    IN  UINT8    IcmpError,
+    IN  UINT8    IpVersion,
+    OUT BOOLEAN  *IsHard  OPTIONAL,
+    OUT BOOLEAN  *Notify  OPTIONAL
+    )
+  {
+    return EFI_SUCCESS;
+  }
+
+  VOID
+  SockDataRcvd (
+    IN OUT SOCKET   *Sock,
+    IN OUT NET_BUF  *NetBuffer,
+    IN     UINT32   UrgLen
+    )
+  {
+  }
+
+  VOID
+  SockNoMoreData (
+    IN OUT SOCKET  *Sock
+    )
+  {
+  }
+
+  EFI_STATUS
+  Tcp6RefreshNeighbor (
+    IN TCP_CB          *Tcb,
+    IN EFI_IP_ADDRESS  *Neighbor,
+    IN UINT32          Timeout
+    )
+  {
+    return EFI_SUCCESS;
+  }
+
+  VOID
+  TcpClearAllTimer (
+    IN OUT TCP_CB  *Tcb
+    )
+  {
+  }
+
+  TCP_CB *
+  TcpCloneTcb (
+    IN TCP_CB  *Tcb
+    )
+  {
+    return NULL;
+  }
+
+  VOID
+  TcpClose (
+    IN OUT TCP_CB  *Tcb
+    )
+  {
+  }
+
+  TCP_SEG *
+  TcpFormatNetbuf (
+    IN     TCP_CB   *Tcb,
+    IN OUT NET_BUF  *Nbuf
+    )
+  {
+    return NULL;
+  }
+
+  EFI_STATUS
+  TcpInitTcbLocal (
+    IN OUT TCP_CB  *Tcb
+    )
+  {
+    return EFI_SUCCESS;
+  }
+
+  VOID
+  TcpInitTcbPeer (
+    IN OUT TCP_CB      *Tcb,
+    IN     TCP_SEG     *Seg,
+    IN     TCP_OPTION  *Opt
+    )
+  {
+  }
+
+  INTN
+  TcpInsertTcb (
+    IN TCP_CB  *Tcb
+    )
+  {
+    return 0;
+  }
+
+  TCP_CB *
+  TcpLocateTcb (
+    IN TCP_PORTNO      LocalPort,
+    IN EFI_IP_ADDRESS  *LocalIp,
+    IN TCP_PORTNO      RemotePort,
+    IN EFI_IP_ADDRESS  *RemoteIp,
+    IN UINT8           Version,
+    IN BOOLEAN         Syn
+    )
+  {
+    return NULL;
+  }
+
+  VOID
+  TcpSetKeepaliveTimer (
+    IN OUT TCP_CB  *Tcb
+    )
+  {
+  }
+
+  VOID
+  TcpSetState (
+    IN TCP_CB  *Tcb,
+    IN UINT8   State
+    )
+  {
+    Tcb->State = State;
+  }
+
+  // Needed by TcpInput.c and TcpOutput.c
+  VOID
+  TcpClearTimer (
+    IN OUT TCP_CB  *Tcb,
+    IN     UINT16  Timer
+    )
+  {
+  }
+
+  VOID
+  TcpSetTimer (
+    IN OUT TCP_CB  *Tcb,
+    IN     UINT16  Timer,
+    IN     UINT32  TimeOut
+    )
+  {
+  }
+
+  // Needed by TcpOutput.c
+  VOID
+  SockDataSent (
+    IN OUT SOCKET  *Sock,
+    IN     UINT32  Count
+    )
+  {
+  }
+
+  UINT32
+  SockGetDataToSend (
+    IN  SOCKET  *Sock,
+    IN  UINT32  Offset,
+    IN  UINT32  Len,
+    OUT UINT8   *Dest
+    )
+  {
+    return 0;
+  }
+
+  UINT32
+  SockGetFreeSpace (
+    IN SOCKET  *Sock,
+    IN UINT32  Which
+    )
+  {
+    return 0;
+  }
+
+  UINT16
+  TcpChecksum (
+    IN NET_BUF  *Nbuf,
+    IN UINT16   HeadSum
+    )
+  {
+    return 0;
+  }
+
+  VOID
+  TcpSetProbeTimer (
+    IN OUT TCP_CB  *Tcb
+    )
+  {
+  }
+
+  //
+  // Record the sequence number and the data length of each segment
+  // instead of sending it.
+  //
+  INTN
+  TcpSendIpPacket (
+    IN TCP_CB          *Tcb,
+    IN NET_BUF         *Nbuf,
+    IN EFI_IP_ADDRESS  *Src,
+    IN EFI_IP_ADDRESS  *Dest,
+    IN UINT8           Version
+    )
+  {
+    SENT_SEGMENT  Sent;
+
+    Sent.Seq = NTOHL (Nbuf->Tcp->Seq);
+    Sent.Len = Nbuf->TotalSize - (Nbuf->Tcp->HeadLen << 2);
+    mSentSegments.push_back (Sent);
+    return 0;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// TcpSackUpdate Tests
+////////////////////////////////////////////////////////////////////////////////
+
+class TcpSackUpdateTest : public ::testing::Test {
+protected:
+  TCP_CB Tcb;
+  TCP_OPTION Option;
+
+  virtual void
+  SetUp (
+    )
+  {
+    ZeroMem (&Tcb, sizeof (Tcb));
+    Tcb.SndUna = 1000;
+    Tcb.SndNxt = 1000 + 100 * TCP_TEST_MSS;
+  }
+
+  //
+  // Receive an ACK with the blocks in Sack, each one a [Left, Right) pair.
+  //
+  void
+  Receive (
+    TCP_SEQNO                                           Ack,
+    std::initializer_list<std::pair<UINT32, UINT32> >  Sack
+    )
+  {
+    ZeroMem (&Option, sizeof (Option));
+    if (Sack.size () != 0) {
+      TCP_SET_FLG (Option.Flag, TCP_OPTION_RCVD_SACK);
+    }
+
+    for (const std::pair<UINT32, UINT32> &Block : Sack) {
+      Option.Sack[Option.SackCount].Left  = Block.first;
+      Option.Sack[Option.SackCount].Right = Block.second;
+      Option.SackCount++;
+    }
+
+    TcpSackUpdate (&Tcb, Ack, &Option);
+  }
+
+  void
+  ExpectBoard (
+    std::initializer_list<std::pair<UINT32, UINT32> >  Expected
+    )
+  {
+    UINT8  Index;
+
+    ASSERT_EQ ((size_t)Tcb.SackCount, Expected.size ());
+    Index = 0;
+    for (const std::pair<UINT32, UINT32> &Block : Expected) {
+      EXPECT_EQ (Tcb.SackBoard[Index].Left, Block.first) << "Block " << (int)Index;
+      EXPECT_EQ (Tcb.SackBoard[Index].Right, Block.second) << "Block " << (int)Index;
+      Index++;
+    }
+  }
+};
+
+// Blocks received in any order are kept sorted
+TEST_F (TcpSackUpdateTest, KeepsBlocksSorted) {
+  Receive (1000, { { 7000, 8000 }, { 3000, 4000 } });
+  Receive (1000, { { 5000, 6000 } });
+  ExpectBoard ({ { 3000, 4000 }, { 5000, 6000 }, { 7000, 8000 } });
+}
+
+// Overlapping and abutting blocks are merged
+TEST_F (TcpSackUpdateTest, MergesBlocks) {
+  Receive (1000, { { 3000, 4000 }, { 6000, 7000 }, { 9000, 10000 } });
+  Receive (1000, { { 4000, 5000 } });
+  ExpectBoard ({ { 3000, 5000 }, { 6000, 7000 }, { 9000, 10000 } });
+
+  Receive (1000, { { 4500, 9500 } });
+  ExpectBoard ({ { 3000, 10000 } });
+
+  Receive (1000, { { 3000, 4000 } });
+  ExpectBoard ({ { 3000, 10000 } });
+}
+
+// The cumulative ACK drops the blocks below it and trims the first one
+TEST_F (TcpSackUpdateTest, PrunesWithCumulativeAck) {
+  Receive (1000, { { 3000, 4000 }, { 5000, 6000 }, { 7000, 8000 } });
+  Receive (4000, {});
+  ExpectBoard ({ { 5000, 6000 }, { 7000, 8000 } });
+
+  Receive (5500, {});
+  ExpectBoard ({ { 5500, 6000 }, { 7000, 8000 } });
+
+  Receive (8000, {});
+  ExpectBoard ({});
+}
+
+// D-SACK blocks, empty blocks and blocks above SndNxt are ignored
+TEST_F (TcpSackUpdateTest, IgnoresInvalidBlocks) {
+  Receive (3000, { { 1000, 2000 } });
+  Receive (3000, { { 2000, 4000 } });
+  Receive (3000, { { 5000, 5000 } });
+  Receive (3000, { { 6000, 5000 } });
+  Receive (3000, { { Tcb.SndNxt - 1000, Tcb.SndNxt + 1 } });
+  ExpectBoard ({});
+
+  Receive (3000, { { Tcb.SndNxt - 1000, Tcb.SndNxt } });
+  ExpectBoard ({ { Tcb.SndNxt - 1000, Tcb.SndNxt } });
+}
+
+// Sequence numbers that wrap around are ordered correctly
+TEST_F (TcpSackUpdateTest, HandlesWrapAround) {
+  Tcb.SndUna = TCP_TEST_SND_UNA;
+  Tcb.SndNxt = TCP_TEST_SND_UNA + 100 * TCP_TEST_MSS;
+
+  Receive (TCP_TEST_SND_UNA, { { 0x1000, 0x2000 }, { 0xfffff800, 0x800 } });
+  ExpectBoard ({ { 0xfffff800, 0x800 }, { 0x1000, 0x2000 } });
+
+  Receive (0x400, {});
+  ExpectBoard ({ { 0x400, 0x800 }, { 0x1000, 0x2000 } });
+}
+
+// A full scoreboard forgets its highest block for a lower one
+TEST_F (TcpSackUpdateTest, FullScoreboardDropsHighestBlock) {
+  for (UINT32 Index = 0; Index < TCP_SACK_SCOREBOARD_SIZE; Index++) {
+    Receive (1000, { { 3000 + Index * 2000, 4000 + Index * 2000 } });
+  }
+
+  ASSERT_EQ (Tcb.SackCount, TCP_SACK_SCOREBOARD_SIZE);
+
+  //
+  // A block above the highest one is dropped.
+  //
+  Receive (1000, { { 3000 + TCP_SACK_SCOREBOARD_SIZE * 2000, 4000 + TCP_SACK_SCOREBOARD_SIZE * 2000 } });
+  ASSERT_EQ (Tcb.SackCount, TCP_SACK_SCOREBOARD_SIZE);
+  EXPECT_EQ (Tcb.SackBoard[TCP_SACK_SCOREBOARD_SIZE - 1].Left, (UINT32)(3000 + (TCP_SACK_SCOREBOARD_SIZE - 1) * 2000));
+
+  //
+  // A block below the lowest one replaces the highest one.
+  //
+  Receive (1000, { { 1500, 2000 } });
+  ASSERT_EQ (Tcb.SackCount, TCP_SACK_SCOREBOARD_SIZE);
+  EXPECT_EQ (Tcb.SackBoard[0].Left, (UINT32)1500);
+  EXPECT_EQ (Tcb.SackBoard[TCP_SACK_SCOREBOARD_SIZE - 1].Left, (UINT32)(3000 + (TCP_SACK_SCOREBOARD_SIZE - 2) * 2000));
+
+  //
+  // A block that merges with one frees a slot.
+  //
+  Receive (1000, { { 2000, 3000 } });
+  EXPECT_EQ (Tcb.SackCount, TCP_SACK_SCOREBOARD_SIZE - 1);
+  EXPECT_EQ (Tcb.SackBoard[0].Left, (UINT32)1500);
+  EXPECT_EQ (Tcb.SackBoard[0].Right, (UINT32)4000);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// TcpSackRetransmit Tests
+////////////////////////////////////////////////////////////////////////////////
+
+class TcpSackRetransmitTest : public ::testing::Test {
+protected:
+  TCP_CB Tcb;
+  SOCKET Sk;
+
+  virtual void
+  SetUp (
+    )
+  {
+    ZeroMem (&Tcb, sizeof (Tcb));
+    ZeroMem (&Sk, sizeof (Sk));
+
+    Sk.IpVersion            = IP_VERSION_4;
+    Sk.SndBuffer.DataQueue  = NetbufQueAlloc ();
+    Sk.RcvBuffer.DataQueue  = NetbufQueAlloc ();
+    Sk.RcvBuffer.HighWater  = 64 * TCP_TEST_MSS;
+    Tcb.Sk                  = &Sk;
+    Tcb.SndMss              = TCP_TEST_MSS;
+    Tcb.SndUna              = TCP_TEST_SND_UNA;
+    Tcb.SndNxt              = TCP_TEST_SND_UNA + TCP_TEST_SEGMENTS * TCP_TEST_MSS;
+    Tcb.SndWl2              = Tcb.SndUna;
+    Tcb.SndWnd              = 64 * TCP_TEST_MSS;
+    Tcb.RetxmitSeqMax       = Tcb.SndNxt;
+    Tcb.CongestState        = TCP_CONGEST_RECOVER;
+    TCP_SET_FLG (Tcb.CtrlFlag, TCP_CTRL_RCVD_SACK);
+    InitializeListHead (&Tcb.SndQue);
+    InitializeListHead (&Tcb.RcvQue);
+
+    for (UINT32 Index = 0; Index < TCP_TEST_SEGMENTS; Index++) {
+      NET_BUF  *Nbuf;
+      TCP_SEG  *Seg;
+
+      Nbuf = NetbufAlloc (TCP_MAX_HEAD + TCP_TEST_MSS);
+      ASSERT_NE (Nbuf, (NET_BUF *)NULL);
+      NetbufReserve (Nbuf, TCP_MAX_HEAD);
+      SetMem (NetbufAllocSpace (Nbuf, TCP_TEST_MSS, NET_BUF_TAIL), TCP_TEST_MSS, (UINT8)Index);
+
+      Seg       = TCPSEG_NETBUF (Nbuf);
+      Seg->Seq  = Tcb.SndUna + Index * TCP_TEST_MSS;
+      Seg->End  = Seg->Seq + TCP_TEST_MSS;
+      Seg->Flag = TCP_FLG_ACK;
+      InsertTailList (&Tcb.SndQue, &Nbuf->List);
+    }
+
+    //
+    // The fast retransmission has resent the first segment.
+    //
+    Tcb.SackRexmitNxt = Tcb.SndUna + TCP_TEST_MSS;
+    mSentSegments.clear ();
+  }
+
+  virtual void
+  TearDown (
+    )
+  {
+    while (!IsListEmpty (&Tcb.SndQue)) {
+      NET_BUF  *Nbuf;
+
+      Nbuf = NET_LIST_HEAD (&Tcb.SndQue, NET_BUF, List);
+      RemoveEntryList (&Nbuf->List);
+      NetbufFree (Nbuf);
+    }
+
+    NetbufQueFree (Sk.SndBuffer.DataQueue);
+    NetbufQueFree (Sk.RcvBuffer.DataQueue);
+  }
+
+  //
+  // Add the SACKed block [SndUna + First * MSS, SndUna + End * MSS).
+  //
+  void
+  Sacked (
+    UINT32  First,
+    UINT32  End
+    )
+  {
+    TCP_OPTION  Option;
+
+    ZeroMem (&Option, sizeof (Option));
+    TCP_SET_FLG (Option.Flag, TCP_OPTION_RCVD_SACK);
+    Option.SackCount     = 1;
+    Option.Sack[0].Left  = Tcb.SndUna + First * TCP_TEST_MSS;
+    Option.Sack[0].Right = Tcb.SndUna + End * TCP_TEST_MSS;
+    TcpSackUpdate (&Tcb, Tcb.SndUna, &Option);
+  }
+
+  //
+  // Retransmit the next hole and return the index of the segment sent,
+  // or -1 if none was.
+  //
+  INT32
+  RetransmitNext (
+    TCP_SEQNO  Ack
+    )
+  {
+    mSentSegments.clear ();
+    if (TcpSackRetransmit (&Tcb, Ack) != 1) {
+      EXPECT_TRUE (mSentSegments.empty ());
+      return -1;
+    }
+
+    EXPECT_EQ (mSentSegments.size (), (size_t)1);
+    EXPECT_EQ (mSentSegments[0].Len, (UINT32)TCP_TEST_MSS);
+    return (INT32)(TCP_SUB_SEQ (mSentSegments[0].Seq, TCP_TEST_SND_UNA) / TCP_TEST_MSS);
+  }
+};
+
+// The holes below the highest SACKed block are resent once each, in order
+TEST_F (TcpSackRetransmitTest, ResendsEachHoleOnce) {
+  Sacked (2, 4);
+  Sacked (6, 7);
+
+  EXPECT_EQ (RetransmitNext (Tcb.SndUna), 1);
+  EXPECT_EQ (RetransmitNext (Tcb.SndUna), 4);
+  EXPECT_EQ (RetransmitNext (Tcb.SndUna), 5);
+  EXPECT_EQ (RetransmitNext (Tcb.SndUna), -1);
+  EXPECT_EQ (Tcb.Stats.SackRetransmits, (UINT32)3);
+}
+
+// Data above the highest SACKed block may still be in flight
+TEST_F (TcpSackRetransmitTest, DoesNotResendAboveHighestBlock) {
+  Sacked (1, 2);
+
+  EXPECT_EQ (RetransmitNext (Tcb.SndUna), -1);
+
+  Sacked (8, 9);
+  EXPECT_EQ (RetransmitNext (Tcb.SndUna), 2);
+}
+
+// A partial ACK above the next hole moves the retransmission up to it
+TEST_F (TcpSackRetransmitTest, StartsAtPartialAck) {
+  Sacked (2, 3);
+  Sacked (8, 9);
+
+  EXPECT_EQ (RetransmitNext (Tcb.SndUna + 5 * TCP_TEST_MSS), 5);
+  EXPECT_EQ (RetransmitNext (Tcb.SndUna + 5 * TCP_TEST_MSS), 6);
+  EXPECT_EQ (RetransmitNext (Tcb.SndUna + 5 * TCP_TEST_MSS), 7);
+  EXPECT_EQ (RetransmitNext (Tcb.SndUna + 5 * TCP_TEST_MSS), -1);
+}
+
+// Without a scoreboard there is nothing to retransmit
+TEST_F (TcpSackRetransmitTest, EmptyScoreboard) {
+  EXPECT_EQ (RetransmitNext (Tcb.SndUna), -1);
+  EXPECT_EQ (Tcb.Stats.SackRetransmits, (UINT32)0);
+}
@@ -217,6 +217,7 @@ SockSetTcpRxData (
     Fragment->FragmentLength = CopyBytes;
     RcvdBytes               -= CopyBytes;
     OffSet                  += CopyBytes;
+    Sock->RcvCopiedBytes    += CopyBytes;
   }
 }
 
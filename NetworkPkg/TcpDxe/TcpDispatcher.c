@@ -564,6 +564,15 @@ TcpConfigurePcb (
 
   Tcb->CongestState = TCP_CONGEST_OPEN;
 
+  Tcb->CongestionControl = PcdGet8 (PcdTcpCongestionControl);
+  if (Tcb->CongestionControl != TCP_CC_CUBIC) {
+    Tcb->CongestionControl = TCP_CC_NEWRENO;
+  }
+
+  if (!PcdGetBool (PcdTcpSackEnable)) {
+    TCP_SET_FLG (Tcb->CtrlFlag, TCP_CTRL_NO_SACK);
+  }
+
   Tcb->KeepAliveIdle   = TCP_KEEPALIVE_IDLE_MIN;
   Tcb->KeepAlivePeriod = TCP_KEEPALIVE_PERIOD;
   Tcb->MaxKeepAlive    = TCP_MAX_KEEPALIVE;
@@ -564,6 +564,11 @@ TcpDestroyService (
     //
     TcpDestroyTimer ();
 
+    //
+    // Publish the statistics the heartbeat timer has not written yet.
+    //
+    TcpPublishStatistics ();
+
     //
     // Release the TCP service data
     //
@@ -157,6 +157,28 @@ TcpSetState (
   IN UINT8   State
   );
 
+/**
+  Record the statistics of a closed connection in the next slot of
+  mTcpStatistics, TcpPublishStatistics() later writes it to its variable.
+
+  @param[in]  Tcb                   Pointer to the TCP_CB of this TCP instance.
+
+**/
+VOID
+TcpRecordStatistics (
+  IN TCP_CB  *Tcb
+  );
+
+/**
+  Publish the statistics recorded since the last call in their TcpStatsXXXX
+  variables, see Guid/NetworkStatistics.h.
+
+**/
+VOID
+TcpPublishStatistics (
+  VOID
+  );
+
 /**
   Compute the TCP segment's checksum.
 
@@ -354,6 +376,24 @@ TcpRetransmit (
   IN TCP_SEQNO  Seq
   );
 
+/**
+  Retransmit the first hole in the SACK scoreboard, at or above Ack, that
+  has not been retransmitted during the current fast recovery.
+
+  @param[in, out]  Tcb     Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Ack     The sequence number acknowledged by the peer.
+
+  @retval 1       A hole was retransmitted.
+  @retval 0       There is no hole left to retransmit.
+  @retval -1      An error condition occurred.
+
+**/
+INTN
+TcpSackRetransmit (
+  IN OUT TCP_CB     *Tcb,
+  IN     TCP_SEQNO  Ack
+  );
+
 /**
   Check whether to send data/SYN/FIN and piggyback an ACK.
 
@@ -449,6 +489,50 @@ TcpVerifySegment (
 // Functions from TcpInput.c
 //
 
+/**
+  Compute the slow start threshold after a loss, and prepare the
+  congestion control algorithm for the reduced window.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+  @return The new slow start threshold.
+
+**/
+UINT32
+TcpComputeSsthresh (
+  IN OUT TCP_CB  *Tcb
+  );
+
+/**
+  Compute how much CUBIC grows the congestion window in congestion
+  avoidance for one ACK, as defined in RFC8312.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+  @return The number of bytes to add to the congestion window.
+
+**/
+UINT32
+TcpCubicIncrease (
+  IN OUT TCP_CB  *Tcb
+  );
+
+/**
+  Update the SACK scoreboard with a received ACK. The blocks the ACK
+  covers are dropped, the blocks in its SACK option are merged in.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Ack      The acknowledge sequence number of the segment.
+  @param[in]       Option   The options of the segment.
+
+**/
+VOID
+TcpSackUpdate (
+  IN OUT TCP_CB      *Tcb,
+  IN     TCP_SEQNO   Ack,
+  IN     TCP_OPTION  *Option
+  );
+
 /**
   Process the received ICMP error messages for TCP.
 
@@ -29,6 +29,258 @@ TcpSeqAcceptable (
           TCP_SEQ_LT (Seg->Seq, Tcb->RcvWl2 + Tcb->RcvWnd));
 }
 
+/**
+  Compute the integer cube root of a 64-bit value.
+
+  @param[in]  Value    The value to compute the cube root of.
+
+  @return The largest integer whose cube is less than or equal to Value.
+
+**/
+STATIC
+UINT32
+TcpCubeRoot (
+  IN UINT64  Value
+  )
+{
+  UINT32  Root;
+  UINT64  Next;
+  INTN    Shift;
+
+  Root = 0;
+  for (Shift = 63; Shift >= 0; Shift -= 3) {
+    Root <<= 1;
+    Next   = MultU64x32 (MultU64x32 (Root, Root + 1), 3) + 1;
+    if (RShiftU64 (Value, Shift) >= Next) {
+      Value -= LShiftU64 (Next, Shift);
+      Root++;
+    }
+  }
+
+  return Root;
+}
+
+/**
+  Compute the slow start threshold after a loss, and prepare the
+  congestion control algorithm for the reduced window.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+  @return The new slow start threshold.
+
+**/
+UINT32
+TcpComputeSsthresh (
+  IN OUT TCP_CB  *Tcb
+  )
+{
+  UINT32  FlightSize;
+
+  FlightSize = TCP_SUB_SEQ (Tcb->SndNxt, Tcb->SndUna);
+
+  if (Tcb->CongestionControl != TCP_CC_CUBIC) {
+    return MAX (FlightSize >> 1, (UINT32)(2 * Tcb->SndMss));
+  }
+
+  //
+  // CUBIC fast convergence: if the window did not get back to
+  // where the previous loss happened, another flow likely took
+  // the bandwidth, so plateau lower and let it have its share.
+  //
+  if (FlightSize < Tcb->CubicWMax) {
+    Tcb->CubicWMax = (UINT32)DivU64x32 (
+                               MultU64x32 (FlightSize, TCP_CUBIC_BETA_DEN + TCP_CUBIC_BETA_NUM),
+                               2 * TCP_CUBIC_BETA_DEN
+                               );
+  } else {
+    Tcb->CubicWMax = FlightSize;
+  }
+
+  Tcb->CubicEpoch = 0;
+
+  return MAX (
+           (UINT32)DivU64x32 (MultU64x32 (FlightSize, TCP_CUBIC_BETA_NUM), TCP_CUBIC_BETA_DEN),
+           (UINT32)(2 * Tcb->SndMss)
+           );
+}
+
+/**
+  Compute how much CUBIC grows the congestion window in congestion
+  avoidance for one ACK, as defined in RFC8312.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+  @return The number of bytes to add to the congestion window.
+
+**/
+UINT32
+TcpCubicIncrease (
+  IN OUT TCP_CB  *Tcb
+  )
+{
+  UINT32  Elapsed;
+  UINT32  Delta;
+  UINT64  Offset;
+  UINT64  Target;
+  UINT32  Increase;
+
+  //
+  // Start a new epoch on the first ACK after a loss. K is the time
+  // W(t) takes to get back to the window before the loss, in
+  // milliseconds: K = cubic_root ((Wmax - cwnd) / C) seconds.
+  //
+  if (Tcb->CubicEpoch == 0) {
+    Tcb->CubicEpoch = mTcpTick;
+    if (Tcb->CWnd < Tcb->CubicWMax) {
+      Tcb->CubicK      = TcpCubeRoot (MultU64x32 ((Tcb->CubicWMax - Tcb->CWnd) / Tcb->SndMss, 2500000000U));
+      Tcb->CubicOrigin = Tcb->CubicWMax;
+    } else {
+      Tcb->CubicK      = 0;
+      Tcb->CubicOrigin = Tcb->CWnd;
+    }
+  }
+
+  //
+  // W(t + RTT) = C * (t + RTT - K)^3 + Wmax, in bytes with t in
+  // milliseconds. It is concave below Wmax and convex above.
+  //
+  Elapsed  = MIN (TCP_SUB_TIME (mTcpTick, Tcb->CubicEpoch), 2 * TCP_CUBIC_MAX_TIME / TCP_TICK) * TCP_TICK;
+  Elapsed += (Tcb->SRtt * TCP_TICK) >> TCP_RTT_SHIFT;
+
+  if (Elapsed < Tcb->CubicK) {
+    Delta = MIN (Tcb->CubicK - Elapsed, TCP_CUBIC_MAX_TIME);
+  } else {
+    Delta = MIN (Elapsed - Tcb->CubicK, TCP_CUBIC_MAX_TIME);
+  }
+
+  Offset = MultU64x32 (MultU64x32 (Delta, Delta), Delta);
+  Offset = DivU64x32 (MultU64x32 (DivU64x32 (Offset, 2500000), Tcb->SndMss), 1000);
+
+  if (Elapsed < Tcb->CubicK) {
+    Target = (Offset < Tcb->CubicOrigin) ? Tcb->CubicOrigin - Offset : 0;
+  } else {
+    Target = Tcb->CubicOrigin + Offset;
+  }
+
+  //
+  // Grow by at most half the window per RTT.
+  //
+  Target = MIN (Target, (UINT64)Tcb->CWnd + (Tcb->CWnd >> 1));
+
+  if (Target > Tcb->CWnd) {
+    Increase = (UINT32)DivU64x32 (MultU64x32 (Target - Tcb->CWnd, Tcb->SndMss), Tcb->CWnd);
+  } else {
+    Increase = Tcb->SndMss * Tcb->SndMss / Tcb->CWnd / 100;
+  }
+
+  //
+  // TCP friendly region: never grow slower than an AIMD flow with
+  // the same average rate as NewReno does, which adds about half
+  // a segment per RTT with a decrease factor of 0.7.
+  //
+  Increase = MAX (Increase, Tcb->SndMss * Tcb->SndMss / Tcb->CWnd / 2);
+
+  return MAX (Increase, 1);
+}
+
+/**
+  Update the SACK scoreboard with a received ACK. The blocks the ACK
+  covers are dropped, the blocks in its SACK option are merged in.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Ack      The acknowledge sequence number of the segment.
+  @param[in]       Option   The options of the segment.
+
+**/
+VOID
+TcpSackUpdate (
+  IN OUT TCP_CB      *Tcb,
+  IN     TCP_SEQNO   Ack,
+  IN     TCP_OPTION  *Option
+  )
+{
+  TCP_SACK_BLOCK  *Board;
+  TCP_SEQNO       Left;
+  TCP_SEQNO       Right;
+  UINT8           First;
+  UINT8           Last;
+  UINT8           Block;
+
+  Board = Tcb->SackBoard;
+
+  //
+  // Drop what the cumulative ACK covers.
+  //
+  for (First = 0; (First < Tcb->SackCount) && TCP_SEQ_LEQ (Board[First].Right, Ack); First++) {
+  }
+
+  if (First != 0) {
+    Tcb->SackCount = (UINT8)(Tcb->SackCount - First);
+    CopyMem (Board, Board + First, Tcb->SackCount * sizeof (TCP_SACK_BLOCK));
+  }
+
+  if ((Tcb->SackCount != 0) && TCP_SEQ_LT (Board[0].Left, Ack)) {
+    Board[0].Left = Ack;
+  }
+
+  if (!TCP_FLG_ON (Option->Flag, TCP_OPTION_RCVD_SACK)) {
+    return;
+  }
+
+  for (Block = 0; Block < Option->SackCount; Block++) {
+    Left  = Option->Sack[Block].Left;
+    Right = Option->Sack[Block].Right;
+
+    //
+    // Ignore the blocks below the ACK, such as D-SACK blocks, and
+    // the blocks of data that was never sent.
+    //
+    if (!TCP_SEQ_LT (Left, Right) || TCP_SEQ_LT (Left, Ack) || TCP_SEQ_GT (Right, Tcb->SndNxt)) {
+      continue;
+    }
+
+    //
+    // Board[First, Last) are the blocks that overlap or abut the
+    // new block, they are merged into one.
+    //
+    for (First = 0; (First < Tcb->SackCount) && TCP_SEQ_LT (Board[First].Right, Left); First++) {
+    }
+
+    for (Last = First; (Last < Tcb->SackCount) && TCP_SEQ_LEQ (Board[Last].Left, Right); Last++) {
+      if (TCP_SEQ_LT (Board[Last].Left, Left)) {
+        Left = Board[Last].Left;
+      }
+
+      if (TCP_SEQ_GT (Board[Last].Right, Right)) {
+        Right = Board[Last].Right;
+      }
+    }
+
+    if (Last == First) {
+      //
+      // Insert a new block. When the scoreboard is full, forget the
+      // highest block: it only delays the retransmission of holes.
+      //
+      if (First == TCP_SACK_SCOREBOARD_SIZE) {
+        continue;
+      }
+
+      if (Tcb->SackCount == TCP_SACK_SCOREBOARD_SIZE) {
+        Tcb->SackCount--;
+      }
+
+      CopyMem (Board + First + 1, Board + First, (Tcb->SackCount - First) * sizeof (TCP_SACK_BLOCK));
+      Tcb->SackCount++;
+    } else {
+      CopyMem (Board + First + 1, Board + Last, (Tcb->SackCount - Last) * sizeof (TCP_SACK_BLOCK));
+      Tcb->SackCount = (UINT8)(Tcb->SackCount - (Last - First - 1));
+    }
+
+    Board[First].Left  = Left;
+    Board[First].Right = Right;
+  }
+}
+
 /**
   NewReno fast recovery defined in RFC3782.
 
@@ -52,9 +304,7 @@ TcpFastRecover (
     //
     // Step 1A: Invoking fast retransmission.
     //
-    FlightSize = TCP_SUB_SEQ (Tcb->SndNxt, Tcb->SndUna);
-
-    Tcb->Ssthresh = MAX (FlightSize >> 1, (UINT32)(2 * Tcb->SndMss));
+    Tcb->Ssthresh = TcpComputeSsthresh (Tcb);
     Tcb->Recover  = Tcb->SndNxt;
 
     Tcb->CongestState = TCP_CONGEST_RECOVER;
@@ -64,7 +314,9 @@ TcpFastRecover (
     // Step 2: Entering fast retransmission
     //
     TcpRetransmit (Tcb, Tcb->SndUna);
-    Tcb->CWnd = Tcb->Ssthresh + 3 * Tcb->SndMss;
+    Tcb->CWnd          = Tcb->Ssthresh + 3 * Tcb->SndMss;
+    Tcb->SackRexmitNxt = Tcb->SndUna + Tcb->SndMss;
+    Tcb->Stats.FastRetransmits++;
 
     DEBUG (
       (DEBUG_NET,
@@ -87,7 +339,13 @@ TcpFastRecover (
     // Step 4 is skipped here only to be executed later
     // by TcpToSendData
     //
-    Tcb->CWnd += Tcb->SndMss;
+    // With SACK, the segment that left the network is
+    // replaced by the next hole in the scoreboard instead.
+    //
+    if (!TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK) || (TcpSackRetransmit (Tcb, Seg->Ack) <= 0)) {
+      Tcb->CWnd += Tcb->SndMss;
+    }
+
     DEBUG (
       (DEBUG_NET,
        "TcpFastRecover: received another duplicated ACK (%d) for TCB %p\n",
@@ -119,9 +377,15 @@ TcpFastRecover (
       //
       // Step 5 - Partial ACK:
       // fast retransmit the first unacknowledge field
-      // , then deflate the CWnd
+      // , then deflate the CWnd. With SACK, retransmit
+      // the next hole that is not retransmitted yet.
       //
-      TcpRetransmit (Tcb, Seg->Ack);
+      if (!TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK) || (Tcb->SackCount == 0)) {
+        TcpRetransmit (Tcb, Seg->Ack);
+      } else {
+        TcpSackRetransmit (Tcb, Seg->Ack);
+      }
+
       Acked = TCP_SUB_SEQ (Seg->Ack, Tcb->SndUna);
 
       //
@@ -607,6 +871,7 @@ TcpQueueData (
   InsertHeadList (Prev, &Nbuf->List);
 
   TCP_SET_FLG (Tcb->CtrlFlag, TCP_CTRL_ACK_NOW);
+  Tcb->SackRecent = Seg->Seq;
 
   //
   // Check the segments after the insert point.
@@ -808,6 +1073,9 @@ TcpInput (
   NetbufTrim (Nbuf, (Head->HeadLen << 2), NET_BUF_HEAD);
   Nbuf->Tcp = NULL;
 
+  Tcb->Stats.SegmentsReceived++;
+  Tcb->Stats.BytesReceived += Nbuf->TotalSize;
+
   //
   // Process the segment in LISTEN state.
   //
@@ -1213,6 +1481,10 @@ TcpInput (
     TcpSetTimer (Tcb, TCP_TIMER_REXMIT, Tcb->Rto);
   }
 
+  if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK)) {
+    TcpSackUpdate (Tcb, Seg->Ack, &Option);
+  }
+
   //
   // Count duplicate acks.
   //
@@ -1235,11 +1507,14 @@ TcpInput (
     if (TCP_SEQ_GT (Seg->Ack, Tcb->SndUna)) {
       if (Tcb->CWnd < Tcb->Ssthresh) {
         Tcb->CWnd += Tcb->SndMss;
+      } else if (Tcb->CongestionControl == TCP_CC_CUBIC) {
+        Tcb->CWnd += TcpCubicIncrease (Tcb);
       } else {
         Tcb->CWnd += MAX (Tcb->SndMss * Tcb->SndMss / Tcb->CWnd, 1);
       }
 
-      Tcb->CWnd = MIN (Tcb->CWnd, TCP_MAX_WIN << Tcb->SndWndScale);
+      Tcb->CWnd          = MIN (Tcb->CWnd, TCP_MAX_WIN << Tcb->SndWndScale);
+      Tcb->Stats.MaxCWnd = MAX (Tcb->Stats.MaxCWnd, Tcb->CWnd);
     }
 
     if (Tcb->CongestState == TCP_CONGEST_LOSS) {
@@ -14,9 +14,11 @@
 #include <Protocol/ServiceBinding.h>
 #include <Protocol/DriverBinding.h>
 #include <Protocol/Hash2.h>
+#include <Guid/NetworkStatistics.h>
 #include <Library/IpIoLib.h>
 #include <Library/DevicePathLib.h>
 #include <Library/PrintLib.h>
+#include <Library/PcdLib.h>
 
 #include "Socket.h"
 #include "TcpProto.h"
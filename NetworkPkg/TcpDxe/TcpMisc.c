@@ -26,6 +26,15 @@ LIST_ENTRY  mTcpListenQue = {
 //
 TCP_SEQNO  mTcpGlobalSecret;
 
+//
+// Statistics of the last closed connections, mTcpStatisticsIndex is the
+// slot the next one is recorded in. Bit N of mTcpStatisticsPending is set
+// while slot N has not been published in its TcpStatsXXXX variable yet.
+//
+TCP_STATISTICS  mTcpStatistics[TCP_STATISTICS_VARIABLES];
+UINT16          mTcpStatisticsIndex   = 0;
+UINT32          mTcpStatisticsPending = 0;
+
 //
 // Union to hold either an IPv4 or IPv6 address
 // This is used to simplify the ISN hash computation
@@ -142,6 +151,17 @@ TcpInitTcbLocal (
 
   Tcb->ProbeTimerOn = FALSE;
 
+  //
+  // SACK is only used if the peer permits it in its SYN.
+  //
+  TCP_CLEAR_FLG (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK);
+  Tcb->SackCount = 0;
+
+  Tcb->CubicWMax  = 0;
+  Tcb->CubicEpoch = 0;
+
+  ZeroMem (&Tcb->Stats, sizeof (Tcb->Stats));
+
   return EFI_SUCCESS;
 }
 
@@ -221,6 +241,10 @@ TcpInitTcbPeer (
     //
     Tcb->SndMss -= TCP_OPTION_TS_ALIGNED_LEN;
   }
+
+  if (TCP_FLG_ON (Opt->Flag, TCP_OPTION_RCVD_SACK_PERM) && !TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_SACK)) {
+    TCP_SET_FLG (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK);
+  }
 }
 
 /**
@@ -833,6 +857,7 @@ TcpSetState (
 
     case TCP_CLOSED:
 
+      TcpRecordStatistics (Tcb);
       SockConnClosed (Tcb->Sk);
 
       break;
@@ -841,6 +866,96 @@ TcpSetState (
   }
 }
 
+/**
+  Record the statistics of a closed connection in the next slot of
+  mTcpStatistics, TcpPublishStatistics() later writes it to its variable.
+
+  @param[in]  Tcb                   Pointer to the TCP_CB of this TCP instance.
+
+**/
+VOID
+TcpRecordStatistics (
+  IN TCP_CB  *Tcb
+  )
+{
+  TCP_STATISTICS  *Stats;
+
+  Stats = &Tcb->Stats;
+
+  //
+  // Nothing to publish if the connection never sent anything,
+  // such as a listening one.
+  //
+  if (Stats->SegmentsSent == 0) {
+    return;
+  }
+
+  CopyMem (&Stats->LocalIp, &Tcb->LocalEnd.Ip, sizeof (EFI_IP_ADDRESS));
+  CopyMem (&Stats->RemoteIp, &Tcb->RemoteEnd.Ip, sizeof (EFI_IP_ADDRESS));
+  Stats->LocalPort         = NTOHS (Tcb->LocalEnd.Port);
+  Stats->RemotePort        = NTOHS (Tcb->RemoteEnd.Port);
+  Stats->IpVersion         = Tcb->Sk->IpVersion;
+  Stats->CongestionControl = Tcb->CongestionControl;
+  Stats->Sack              = TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK);
+  Stats->SRtt              = (Tcb->SRtt * TCP_TICK) >> TCP_RTT_SHIFT;
+  Stats->RttVar            = (Tcb->RttVar * TCP_TICK) >> TCP_RTT_SHIFT;
+  Stats->CWnd              = Tcb->CWnd;
+  Stats->MaxCWnd           = MAX (Stats->MaxCWnd, Tcb->CWnd);
+  Stats->Ssthresh          = Tcb->Ssthresh;
+  Stats->BytesCopied       = Tcb->Sk->RcvCopiedBytes;
+
+  DEBUG (
+    (DEBUG_NET,
+     "TcpRecordStatistics: TCB %p sent %d segments, %d retransmitted, %d timeouts, SRTT %dms\n",
+     Tcb,
+     (UINT32)Stats->SegmentsSent,
+     Stats->Retransmits,
+     Stats->Timeouts,
+     Stats->SRtt)
+    );
+
+  CopyMem (&mTcpStatistics[mTcpStatisticsIndex], Stats, sizeof (TCP_STATISTICS));
+  mTcpStatisticsPending |= 1U << mTcpStatisticsIndex;
+  mTcpStatisticsIndex    = (UINT16)((mTcpStatisticsIndex + 1) % TCP_STATISTICS_VARIABLES);
+
+  ZeroMem (Stats, sizeof (TCP_STATISTICS));
+  Tcb->Sk->RcvCopiedBytes = 0;
+}
+
+/**
+  Publish the statistics recorded since the last call in their TcpStatsXXXX
+  variables, see Guid/NetworkStatistics.h.
+
+  It is called from the heartbeat timer every TCP_STATISTICS_PUBLISH_TICKS
+  ticks and when a TCP service is destroyed, so that closing connections
+  does not write a variable each.
+
+**/
+VOID
+TcpPublishStatistics (
+  VOID
+  )
+{
+  UINT16  Slot;
+  CHAR16  Index[sizeof ("XXXX")];
+
+  for (Slot = 0; (Slot < TCP_STATISTICS_VARIABLES) && (mTcpStatisticsPending != 0); Slot++) {
+    if ((mTcpStatisticsPending & (1U << Slot)) == 0) {
+      continue;
+    }
+
+    mTcpStatisticsPending &= ~(1U << Slot);
+
+    UnicodeSPrint (Index, sizeof (Index), L"%04x", Slot);
+    NetLibPublishStatistics (
+      EDKII_TCP_STATISTICS_VARIABLE_PREFIX,
+      Index,
+      &mTcpStatistics[Slot],
+      sizeof (TCP_STATISTICS)
+      );
+  }
+}
+
 /**
   Compute the TCP segment's checksum.
 
@@ -160,6 +160,28 @@ TcpSynBuildOption (
     TcpPutUint32 (Data, TCP_OPTION_WS_FAST | TcpComputeScale (Tcb));
   }
 
+  //
+  // Build SACK permitted option, only when SACK is not
+  // disabled, and either we are doing active open or
+  // we have received SACK permitted option from peer.
+  //
+  if (!TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_SACK) &&
+      (!TCP_FLG_ON (TCPSEG_NETBUF (Nbuf)->Flag, TCP_FLG_ACK) ||
+       TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK))
+      )
+  {
+    Data = NetbufAllocSpace (
+             Nbuf,
+             TCP_OPTION_SACK_PERM_ALIGNED_LEN,
+             NET_BUF_HEAD
+             );
+
+    ASSERT (Data != NULL);
+
+    Len += TCP_OPTION_SACK_PERM_ALIGNED_LEN;
+    TcpPutUint32 (Data, TCP_OPTION_SACK_PERM_FAST);
+  }
+
   //
   // Build the MSS option.
   //
@@ -172,6 +194,91 @@ TcpSynBuildOption (
   return Len;
 }
 
+/**
+  Collect the blocks of out of order data queued in the RcvQue, for the
+  SACK option. The block holding the most recently received segment comes
+  first as RFC2018 requires, the others follow in sequence order.
+
+  @param[in]   Tcb        Pointer to the TCP_CB of this TCP instance.
+  @param[out]  Blocks     Pointer to the array to store the blocks.
+  @param[in]   MaxBlocks  The number of entries in Blocks.
+
+  @return                 The number of blocks stored in Blocks.
+
+**/
+UINT8
+TcpGetSackBlocks (
+  IN  TCP_CB          *Tcb,
+  OUT TCP_SACK_BLOCK  *Blocks,
+  IN  UINT8           MaxBlocks
+  )
+{
+  LIST_ENTRY  *Entry;
+  TCP_SEG     *Seg;
+  TCP_SEQNO   Left;
+  TCP_SEQNO   Right;
+  UINT8       Count;
+  BOOLEAN     Last;
+
+  Count = 1;
+  Left  = 0;
+  Right = 0;
+  Entry = Tcb->RcvQue.ForwardLink;
+
+  ZeroMem (Blocks, sizeof (TCP_SACK_BLOCK));
+
+  //
+  // Walk the RcvQue one more time past its end to flush
+  // the last block. Slot 0 is kept for the block that
+  // holds the most recently received segment.
+  //
+  do {
+    Last = (BOOLEAN)(Entry == &Tcb->RcvQue);
+    Seg  = Last ? NULL : TCPSEG_NETBUF (NET_LIST_USER_STRUCT (Entry, NET_BUF, List));
+
+    if ((Seg != NULL) && TCP_SEQ_LEQ (Seg->Seq, Tcb->RcvNxt)) {
+      Entry = Entry->ForwardLink;
+      continue;
+    }
+
+    if ((Seg != NULL) && (Left != Right) && TCP_SEQ_LEQ (Seg->Seq, Right)) {
+      if (TCP_SEQ_GT (Seg->End, Right)) {
+        Right = Seg->End;
+      }
+
+      Entry = Entry->ForwardLink;
+      continue;
+    }
+
+    if (Left != Right) {
+      if (TCP_SEQ_LEQ (Left, Tcb->SackRecent) && TCP_SEQ_LT (Tcb->SackRecent, Right)) {
+        Blocks[0].Left  = Left;
+        Blocks[0].Right = Right;
+      } else if (Count < MaxBlocks) {
+        Blocks[Count].Left  = Left;
+        Blocks[Count].Right = Right;
+        Count++;
+      }
+    }
+
+    if (Seg != NULL) {
+      Left  = Seg->Seq;
+      Right = Seg->End;
+      Entry = Entry->ForwardLink;
+    }
+  } while (!Last);
+
+  if (Blocks[0].Left != Blocks[0].Right) {
+    return Count;
+  }
+
+  //
+  // No block holds the most recent segment, close the gap.
+  //
+  CopyMem (Blocks, Blocks + 1, (Count - 1) * sizeof (TCP_SACK_BLOCK));
+  return (UINT8)(Count - 1);
+}
+
 /**
   Build the TCP option in synchronized states.
 
@@ -187,8 +294,13 @@ TcpBuildOption (
   IN NET_BUF  *Nbuf
   )
 {
-  UINT8   *Data;
-  UINT16  Len;
+  UINT8           *Data;
+  UINT16          Len;
+  UINT32          Room;
+  UINT8           MaxBlocks;
+  UINT8           Count;
+  UINT8           Index;
+  TCP_SACK_BLOCK  Blocks[TCP_OPTION_MAX_SACK];
 
   ASSERT ((Tcb != NULL) && (Nbuf != NULL) && (Nbuf->Tcp == NULL));
   Len = 0;
@@ -214,6 +326,45 @@ TcpBuildOption (
     TcpPutUint32 (Data + 8, Tcb->TsRecent);
   }
 
+  //
+  // Build the SACK option if out of order data is queued. The
+  // option must not push a segment with data over the MSS, and
+  // it takes all the option space that is left at most.
+  //
+  if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK) &&
+      !TCP_FLG_ON (TCPSEG_NETBUF (Nbuf)->Flag, TCP_FLG_RST) &&
+      !IsListEmpty (&Tcb->RcvQue) &&
+      (Nbuf->TotalSize < Tcb->SndMss)
+      )
+  {
+    Room      = MIN (Tcb->SndMss - Nbuf->TotalSize, TCP_OPTION_MAX_LEN - Len);
+    Count     = 0;
+    MaxBlocks = (UINT8)MIN (
+                         TCP_OPTION_MAX_SACK,
+                         (Room >= 4 + TCP_OPTION_SACK_BLOCK_LEN) ? (Room - 4) / TCP_OPTION_SACK_BLOCK_LEN : 0
+                         );
+    if (MaxBlocks != 0) {
+      Count = TcpGetSackBlocks (Tcb, Blocks, MaxBlocks);
+    }
+
+    if (Count != 0) {
+      Data = NetbufAllocSpace (
+               Nbuf,
+               4 + Count * TCP_OPTION_SACK_BLOCK_LEN,
+               NET_BUF_HEAD
+               );
+
+      ASSERT (Data != NULL);
+      Len = (UINT16)(Len + 4 + Count * TCP_OPTION_SACK_BLOCK_LEN);
+
+      TcpPutUint32 (Data, TCP_OPTION_SACK_FAST | (2 + Count * TCP_OPTION_SACK_BLOCK_LEN));
+      for (Index = 0; Index < Count; Index++) {
+        TcpPutUint32 (Data + 4 + Index * TCP_OPTION_SACK_BLOCK_LEN, Blocks[Index].Left);
+        TcpPutUint32 (Data + 8 + Index * TCP_OPTION_SACK_BLOCK_LEN, Blocks[Index].Right);
+      }
+    }
+  }
+
   return Len;
 }
 
@@ -239,6 +390,7 @@ TcpParseOption (
   UINT8  Cur;
   UINT8  Type;
   UINT8  Len;
+  UINT8  Index;
 
   ASSERT ((Tcp != NULL) && (Option != NULL));
 
@@ -311,6 +463,40 @@ TcpParseOption (
         Cur += TCP_OPTION_TS_LEN;
         break;
 
+      case TCP_OPTION_SACK_PERM:
+        Len = Head[Cur + 1];
+
+        if ((Len != TCP_OPTION_SACK_PERM_LEN) || (TotalLen - Cur < TCP_OPTION_SACK_PERM_LEN)) {
+          return -1;
+        }
+
+        TCP_SET_FLG (Option->Flag, TCP_OPTION_RCVD_SACK_PERM);
+
+        Cur += TCP_OPTION_SACK_PERM_LEN;
+        break;
+
+      case TCP_OPTION_SACK:
+        Len = Head[Cur + 1];
+
+        if ((Len < 2 + TCP_OPTION_SACK_BLOCK_LEN) ||
+            (Len > 2 + TCP_OPTION_MAX_SACK * TCP_OPTION_SACK_BLOCK_LEN) ||
+            ((Len - 2) % TCP_OPTION_SACK_BLOCK_LEN != 0) ||
+            (TotalLen - Cur < Len))
+        {
+          return -1;
+        }
+
+        Option->SackCount = (UINT8)((Len - 2) / TCP_OPTION_SACK_BLOCK_LEN);
+        for (Index = 0; Index < Option->SackCount; Index++) {
+          Option->Sack[Index].Left  = TcpGetUint32 (&Head[Cur + 2 + Index * TCP_OPTION_SACK_BLOCK_LEN]);
+          Option->Sack[Index].Right = TcpGetUint32 (&Head[Cur + 6 + Index * TCP_OPTION_SACK_BLOCK_LEN]);
+        }
+
+        TCP_SET_FLG (Option->Flag, TCP_OPTION_RCVD_SACK);
+
+        Cur = (UINT8)(Cur + Len);
+        break;
+
       case TCP_OPTION_NOP:
         Cur++;
         break;
@@ -374,6 +374,9 @@ TcpTransmitSegment (
   //
   Tcb->DelayedAck = 0;
 
+  Tcb->Stats.SegmentsSent++;
+  Tcb->Stats.BytesSent += DataLen;
+
   return TcpSendIpPacket (Tcb, Nbuf, &Tcb->LocalEnd.Ip, &Tcb->RemoteEnd.Ip, Tcb->Sk->IpVersion);
 }
 
@@ -692,6 +695,8 @@ TcpRetransmit (
     Tcb->RetxmitSeqMax = Seq;
   }
 
+  Tcb->Stats.Retransmits++;
+
   //
   // The retransmitted buffer may be on the SndQue,
   // trim TCP head because all the buffers on SndQue
@@ -712,6 +717,66 @@ OnError:
   return -1;
 }
 
+/**
+  Retransmit the first hole in the SACK scoreboard, at or above Ack, that
+  has not been retransmitted during the current fast recovery.
+
+  @param[in, out]  Tcb     Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Ack     The sequence number acknowledged by the peer.
+
+  @retval 1       A hole was retransmitted.
+  @retval 0       There is no hole left to retransmit.
+  @retval -1      An error condition occurred.
+
+**/
+INTN
+TcpSackRetransmit (
+  IN OUT TCP_CB     *Tcb,
+  IN     TCP_SEQNO  Ack
+  )
+{
+  TCP_SACK_BLOCK  *Block;
+  TCP_SEQNO       Seq;
+  UINT8           Index;
+
+  Seq = TCP_SEQ_GT (Tcb->SackRexmitNxt, Ack) ? Tcb->SackRexmitNxt : Ack;
+
+  //
+  // Only the data below the highest SACKed block is
+  // considered lost, the rest may still be in flight.
+  //
+  for (Index = 0; Index < Tcb->SackCount; Index++) {
+    Block = &Tcb->SackBoard[Index];
+
+    if (TCP_SEQ_LEQ (Block->Right, Seq)) {
+      continue;
+    }
+
+    if (TCP_SEQ_GEQ (Seq, Block->Left)) {
+      Seq = Block->Right;
+      continue;
+    }
+
+    if (TcpRetransmit (Tcb, Seq) != 0) {
+      return -1;
+    }
+
+    DEBUG (
+      (DEBUG_NET,
+       "TcpSackRetransmit: retransmit hole %d - %d for TCB %p\n",
+       Seq,
+       Block->Left,
+       Tcb)
+      );
+
+    Tcb->SackRexmitNxt = Seq + MIN (TCP_SUB_SEQ (Block->Left, Seq), Tcb->SndMss);
+    Tcb->Stats.SackRetransmits++;
+    return 1;
+  }
+
+  return 0;
+}
+
 /**
   Verify that all the segments in SndQue are in good shape.
 
@@ -70,6 +70,39 @@
 #define TCP_CTRL_TIMER_ON      0x1000   ///< At least one of the timer is on.
 #define TCP_CTRL_RTT_ON        0x2000   ///< The RTT measurement is on.
 #define TCP_CTRL_ACK_NOW       0x4000   ///< Send the ACK now, don't delay.
+#define TCP_CTRL_NO_SACK       0x8000   ///< Disable SACK option.
+#define TCP_CTRL_RCVD_SACK     0x10000  ///< Received a SACK-permitted option in syn.
+
+//
+// Congestion control algorithms, selected by PcdTcpCongestionControl.
+//
+#define TCP_CC_NEWRENO  0           ///< NewReno, RFC5681 and RFC6582.
+#define TCP_CC_CUBIC    1           ///< CUBIC, RFC8312.
+
+//
+// CUBIC parameters, the multiplicative decrease factor Beta is 0.7
+// and the scaling constant C is 0.4.
+//
+#define TCP_CUBIC_BETA_NUM  7
+#define TCP_CUBIC_BETA_DEN  10
+#define TCP_CUBIC_MAX_TIME  100000  ///< Max milliseconds to K used in W(t).
+
+//
+// Number of SACKed blocks the sender keeps in its scoreboard.
+//
+#define TCP_SACK_SCOREBOARD_SIZE  16
+
+//
+// Number of TcpStatsXXXX variables the statistics of closed
+// connections are published in, round robin.
+//
+#define TCP_STATISTICS_VARIABLES  16
+
+//
+// Statistics of closed connections are kept in memory and written to
+// their variables at most every TCP_STATISTICS_PUBLISH_TICKS ticks.
+//
+#define TCP_STATISTICS_PUBLISH_TICKS  (10 * TCP_TICK_HZ)
 
 //
 // Timer related values
@@ -216,6 +249,14 @@ typedef struct _TCP_SEG {
   UINT32       Wnd;  ///< TCP window size field.
 } TCP_SEG;
 
+///
+/// A block of contiguous sequence space, as carried in a SACK option.
+///
+typedef struct _TCP_SACK_BLOCK {
+  TCP_SEQNO    Left;  ///< The first sequence number of the block.
+  TCP_SEQNO    Right; ///< The sequence number right after the block.
+} TCP_SACK_BLOCK;
+
 ///
 /// Network endpoint, IP plus Port structure.
 ///
@@ -306,6 +347,23 @@ struct _TCP_CONTROL_BLOCK {
   UINT8               LossTimes;    ///< Number of retxmit timeouts in a row.
   TCP_SEQNO           LossRecover;  ///< Recover point for retxmit.
 
+  //
+  // RFC8312 CUBIC congestion control variables.
+  //
+  UINT8               CongestionControl; ///< TCP_CC_NEWRENO or TCP_CC_CUBIC.
+  UINT32              CubicWMax;         ///< Window before the last reduction.
+  UINT32              CubicOrigin;       ///< Window at the plateau of W(t).
+  UINT32              CubicK;            ///< Milliseconds to reach the plateau.
+  UINT32              CubicEpoch;        ///< When the current epoch started, 0 if none.
+
+  //
+  // RFC2018 SACK variables.
+  //
+  TCP_SEQNO           SackRecent;                          ///< Seq of the last out of order segment.
+  TCP_SACK_BLOCK      SackBoard[TCP_SACK_SCOREBOARD_SIZE]; ///< SACKed blocks above SndUna, sorted.
+  UINT8               SackCount;                           ///< Number of blocks in SackBoard.
+  TCP_SEQNO           SackRexmitNxt;                       ///< Next seq to retransmit in recovery.
+
   //
   // RFC7323
   // Addressing Window Retraction for TCP Window Scale Option.
@@ -335,6 +393,8 @@ struct _TCP_CONTROL_BLOCK {
   BOOLEAN             RemoteIpZero; ///< RemoteEnd.Ip is ZERO when configured.
   IP_IO_IP_INFO       *IpInfo;      ///< Pointer reference to Ip used to send pkt
   UINT32              Tick;         ///< 1 tick = 200ms
+
+  TCP_STATISTICS      Stats; ///< Statistics of this connection.
 };
 
 #endif
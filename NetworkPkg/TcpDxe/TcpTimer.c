@@ -180,8 +180,6 @@ TcpRexmitTimeout (
   IN OUT TCP_CB  *Tcb
   )
 {
-  UINT32  FlightSize;
-
   DEBUG (
     (DEBUG_WARN,
      "TcpRexmitTimeout: transmission timeout for TCB %p\n",
@@ -189,16 +187,22 @@ TcpRexmitTimeout (
     );
 
   //
-  // Set the congestion window. FlightSize is the
-  // amount of data that has been sent but not
-  // yet ACKed.
+  // Set the congestion window. The slow start threshold
+  // is computed from the amount of data that has been
+  // sent but not yet ACKed.
   //
-  FlightSize    = TCP_SUB_SEQ (Tcb->SndNxt, Tcb->SndUna);
-  Tcb->Ssthresh = MAX ((UINT32)(2 * Tcb->SndMss), FlightSize / 2);
+  Tcb->Ssthresh = TcpComputeSsthresh (Tcb);
 
   Tcb->CWnd        = Tcb->SndMss;
   Tcb->LossRecover = Tcb->SndNxt;
 
+  //
+  // RFC2018 requires to ignore the SACK information after
+  // a timeout, the peer may have discarded the data.
+  //
+  Tcb->SackCount = 0;
+  Tcb->Stats.Timeouts++;
+
   Tcb->LossTimes++;
   if ((Tcb->LossTimes > Tcb->MaxRexmit) && !TCP_TIMER_ON (Tcb->EnabledTimer, TCP_TIMER_CONNECT)) {
     DEBUG (
@@ -549,6 +553,10 @@ TcpTickingDpc (
       TcpUpdateTimer (Tcb);
     }
   }
+
+  if ((mTcpTick % TCP_STATISTICS_PUBLISH_TICKS) == 0) {
+    TcpPublishStatistics ();
+  }
 }
 
 /**